@@ -44,7 +44,7 @@ public:
 
   void load();
   void loadImage( const Image &img );
-  void loadImages( const std::vector<Image> images );
+  void loadImages( const std::vector<Image>& images );
 
   void unload();
 
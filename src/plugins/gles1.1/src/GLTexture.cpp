@@ -155,7 +155,7 @@ void GLTexture::loadImage( const Image& img ) {
   images.clear();
 }
 
-void GLTexture::loadImages( const std::vector<Image> images ) {
+void GLTexture::loadImages( const std::vector<Image>& images ) {
   bool useSoftwareMipmaps = true;
 
   if( mIsLoaded ) {
@@ -233,31 +233,12 @@ void GLTexture::load() {
     createRenderTexture();
     mIsLoaded = true;
   } else {
-    if(mTextureType == TEX_TYPE_2D) {
-      Image img;
-      img.load( mName );
-
-      loadImage( img );
-    } else if (mTextureType == TEX_TYPE_CUBE_MAP) {
-      Image img;
-      String baseName, ext;
-      std::vector<Image> images;
-      String suffixes[6] = {"_rt", "_lf", "_up", "_dn", "_bk", "_fr"};// "_fr", "_bk"};
-
-      for(unsigned int i = 0; i < 6; i++) {
-        size_t pos = mName.find_last_of(".");
-        baseName = mName.substr(0, pos);
-        ext = mName.substr(pos);
-        String fullName = baseName + suffixes[i] + ext;
-
-        img.load( fullName );
-        images.push_back(img);
-      }
-
-      loadImages( images );
-      images.clear();
-    } else
-      Except( Exception::UNIMPLEMENTED_FEATURE, "**** Unknown texture type ****", "GLTexture::load" );
+    // Read & decode the images, unless done in the background already
+    if( mPreparedImages.empty() )
+      prepare();
+
+    loadImages( mPreparedImages );
+    mPreparedImages.clear();
   }
 }
 
@@ -75,6 +75,13 @@ public:
   /** See ParticleAffector. */
   void _affectParticles(ParticleSystem* pSystem, Real timeElapsed);
 
+  /** See ParticleAffector. */
+  bool isBatched(void) const;
+
+  /** See ParticleAffector. */
+  void _affectParticleBatch(ParticleSystem* pSystem,
+                            const ParticleData::Batch& batch, Real timeElapsed);
+
   /** Sets the colour adjustment to be made per second to particles.
   @param red, green, blue, alpha
       Sets the adjustment to be made to each of the colour components per second. These
@@ -73,6 +73,13 @@ public:
   /** See ParticleAffector. */
   void _affectParticles(ParticleSystem* pSystem, Real timeElapsed);
 
+  /** See ParticleAffector. */
+  bool isBatched(void) const;
+
+  /** See ParticleAffector. */
+  void _affectParticleBatch(ParticleSystem* pSystem,
+                            const ParticleData::Batch& batch, Real timeElapsed);
+
 
   /** Sets the force vector to apply to the particles in a system. */
   void setForceVector(const Vector3& force);
@@ -53,6 +53,13 @@ public:
   /** See ParticleAffector. */
   void _affectParticles(ParticleSystem* pSystem, Real timeElapsed);
 
+  /** See ParticleAffector. */
+  bool isBatched(void) const;
+
+  /** See ParticleAffector. */
+  void _affectParticleBatch(ParticleSystem* pSystem,
+                            const ParticleData::Batch& batch, Real timeElapsed);
+
   /** Sets the scale adjustment to be made per second to particles.
   @param Rate
       Sets the adjustment to be made to the x and y scale components per second. These
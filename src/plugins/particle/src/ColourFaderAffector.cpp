@@ -26,6 +26,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "ParticleSystem.h"
 #include "StringConverter.h"
 #include "Particle.h"
+#include "SIMDHelper.h"
 
 
 namespace renderer {
@@ -63,8 +64,17 @@ ColourFaderAffector::ColourFaderAffector() {
 }
 //-----------------------------------------------------------------------
 void ColourFaderAffector::_affectParticles(ParticleSystem* pSystem, Real timeElapsed) {
-  ParticleIterator pi = pSystem->_getIterator();
-  Particle *p;
+  ParticleData& data = pSystem->_getParticleData();
+  _affectParticleBatch(pSystem, data.getBatch(0, data.size()), timeElapsed);
+}
+//-----------------------------------------------------------------------
+bool ColourFaderAffector::isBatched(void) const {
+  return true;
+}
+//-----------------------------------------------------------------------
+void ColourFaderAffector::_affectParticleBatch(ParticleSystem* pSystem,
+    const ParticleData::Batch& batch, Real timeElapsed) {
+  ColourValue* colours = batch.colours;
   Real dr, dg, db, da;
 
   // Scale adjustments by time
@@ -73,12 +83,23 @@ void ColourFaderAffector::_affectParticles(ParticleSystem* pSystem, Real timeEla
   db = mBlueAdj * timeElapsed;
   da = mAlphaAdj * timeElapsed;
 
-  while (!pi.end()) {
-    p = pi.getNext();
-    applyAdjustWithClamp(&p->mColour.r, dr);
-    applyAdjustWithClamp(&p->mColour.g, dg);
-    applyAdjustWithClamp(&p->mColour.b, db);
-    applyAdjustWithClamp(&p->mColour.a, da);
+  size_t i = 0;
+#if OGRE_HAVE_SSE
+  // One colour per register, clamped to [0, 1] with min / max
+  __m128 adj = _mm_setr_ps(dr, dg, db, da);
+  __m128 zero = _mm_setzero_ps();
+  __m128 one = _mm_set1_ps(1.0f);
+  for (; i < batch.count; ++i) {
+    Real* p = &colours[i].r;
+    __m128 c = _mm_add_ps(_mm_loadu_ps(p), adj);
+    _mm_storeu_ps(p, _mm_min_ps(_mm_max_ps(c, zero), one));
+  }
+#endif
+  for (; i < batch.count; ++i) {
+    applyAdjustWithClamp(&colours[i].r, dr);
+    applyAdjustWithClamp(&colours[i].g, dg);
+    applyAdjustWithClamp(&colours[i].b, db);
+    applyAdjustWithClamp(&colours[i].a, da);
   }
 
 }
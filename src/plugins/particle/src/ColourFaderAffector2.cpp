@@ -26,6 +26,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "ParticleSystem.h"
 #include "StringConverter.h"
 #include "Particle.h"
+#include "SIMDHelper.h"
 
 
 namespace renderer {
@@ -94,8 +95,18 @@ ColourFaderAffector2::ColourFaderAffector2() {
 }
 //-----------------------------------------------------------------------
 void ColourFaderAffector2::_affectParticles(ParticleSystem* pSystem, Real timeElapsed) {
-  ParticleIterator pi = pSystem->_getIterator();
-  Particle *p;
+  ParticleData& data = pSystem->_getParticleData();
+  _affectParticleBatch(pSystem, data.getBatch(0, data.size()), timeElapsed);
+}
+//-----------------------------------------------------------------------
+bool ColourFaderAffector2::isBatched(void) const {
+  return true;
+}
+//-----------------------------------------------------------------------
+void ColourFaderAffector2::_affectParticleBatch(ParticleSystem* pSystem,
+    const ParticleData::Batch& batch, Real timeElapsed) {
+  ColourValue* colours = batch.colours;
+  const Real* ttl = batch.timeToLive;
   Real dr1, dg1, db1, da1;
   Real dr2, dg2, db2, da2;
 
@@ -111,19 +122,30 @@ void ColourFaderAffector2::_affectParticles(ParticleSystem* pSystem, Real timeEl
   db2 = mBlueAdj2  * timeElapsed;
   da2 = mAlphaAdj2 * timeElapsed;
 
-  while (!pi.end()) {
-    p = pi.getNext();
-
-    if( p->mTimeToLive > StateChangeVal ) {
-      applyAdjustWithClamp(&p->mColour.r, dr1);
-      applyAdjustWithClamp(&p->mColour.g, dg1);
-      applyAdjustWithClamp(&p->mColour.b, db1);
-      applyAdjustWithClamp(&p->mColour.a, da1);
+  size_t i = 0;
+#if OGRE_HAVE_SSE
+  // One colour per register, clamped to [0, 1] with min / max
+  __m128 adj1 = _mm_setr_ps(dr1, dg1, db1, da1);
+  __m128 adj2 = _mm_setr_ps(dr2, dg2, db2, da2);
+  __m128 zero = _mm_setzero_ps();
+  __m128 one = _mm_set1_ps(1.0f);
+  for (; i < batch.count; ++i) {
+    Real* p = &colours[i].r;
+    __m128 c = _mm_add_ps(_mm_loadu_ps(p), ttl[i] > StateChangeVal ? adj1 : adj2);
+    _mm_storeu_ps(p, _mm_min_ps(_mm_max_ps(c, zero), one));
+  }
+#endif
+  for (; i < batch.count; ++i) {
+    if( ttl[i] > StateChangeVal ) {
+      applyAdjustWithClamp(&colours[i].r, dr1);
+      applyAdjustWithClamp(&colours[i].g, dg1);
+      applyAdjustWithClamp(&colours[i].b, db1);
+      applyAdjustWithClamp(&colours[i].a, da1);
     } else {
-      applyAdjustWithClamp(&p->mColour.r, dr2);
-      applyAdjustWithClamp(&p->mColour.g, dg2);
-      applyAdjustWithClamp(&p->mColour.b, db2);
-      applyAdjustWithClamp(&p->mColour.a, da2);
+      applyAdjustWithClamp(&colours[i].r, dr2);
+      applyAdjustWithClamp(&colours[i].g, dg2);
+      applyAdjustWithClamp(&colours[i].b, db2);
+      applyAdjustWithClamp(&colours[i].a, da2);
     }
   }
 
@@ -81,9 +81,12 @@ void HollowEllipsoidEmitter::_initParticle(Particle* pParticle) {
   // ellipsoid and the outer sphere (radius 1.0)
   // with alpha and beta we select on point on this random ellipsoid
   // and calculate the 3D coordinates of this point
-  x = a * Math::Cos(alpha) * Math::Sin(beta);
-  y = b * Math::Sin(alpha) * Math::Sin(beta);
-  z = c * Math::Cos(beta);
+  Real sinAlpha, cosAlpha, sinBeta, cosBeta;
+  Math::SinCos(alpha, sinAlpha, cosAlpha);
+  Math::SinCos(beta, sinBeta, cosBeta);
+  x = a * cosAlpha * sinBeta;
+  y = b * sinAlpha * sinBeta;
+  z = c * cosBeta;
 
   // scale the found point to the ellipsoid's size and move it
   // relatively to the center of the emitter point
@@ -26,6 +26,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "ParticleSystem.h"
 #include "Particle.h"
 #include "StringConverter.h"
+#include "SIMDHelper.h"
 
 
 namespace renderer {
@@ -61,23 +62,59 @@ LinearForceAffector::LinearForceAffector() {
 }
 //-----------------------------------------------------------------------
 void LinearForceAffector::_affectParticles(ParticleSystem* pSystem, Real timeElapsed) {
-  ParticleIterator pi = pSystem->_getIterator();
-  Particle *p;
-
-  Vector3 scaledVector;
+  ParticleData& data = pSystem->_getParticleData();
+  _affectParticleBatch(pSystem, data.getBatch(0, data.size()), timeElapsed);
+}
+//-----------------------------------------------------------------------
+bool LinearForceAffector::isBatched(void) const {
+  return true;
+}
+//-----------------------------------------------------------------------
+void LinearForceAffector::_affectParticleBatch(ParticleSystem* pSystem,
+    const ParticleData::Batch& batch, Real timeElapsed) {
+  Vector3* dir = batch.directions;
+  size_t i = 0;
 
-  // Precalc scaled force for optimisation
   if (mForceApplication == FA_ADD) {
-    // Scale force by time
-    scaledVector = mForceVector * timeElapsed;
-  }
-
-  while (!pi.end()) {
-    p = pi.getNext();
-    if (mForceApplication == FA_ADD) {
-      p->mDirection += scaledVector;
-    } else { // FA_AVERAGE
-      p->mDirection = (p->mDirection + mForceVector) / 2;
+    // Precalc scaled force for optimisation
+    Vector3 scaledVector = mForceVector * timeElapsed;
+#if OGRE_HAVE_SSE
+    // The directions are packed as x y z x y z..., so 4 of them fill 3
+    // registers, with the force vector repeating across the 3
+    const Real& x = scaledVector.x;
+    const Real& y = scaledVector.y;
+    const Real& z = scaledVector.z;
+    __m128 f0 = _mm_setr_ps(x, y, z, x);
+    __m128 f1 = _mm_setr_ps(y, z, x, y);
+    __m128 f2 = _mm_setr_ps(z, x, y, z);
+    for (; i + 4 <= batch.count; i += 4) {
+      Real* p = &dir[i].x;
+      _mm_storeu_ps(p,     _mm_add_ps(_mm_loadu_ps(p),     f0));
+      _mm_storeu_ps(p + 4, _mm_add_ps(_mm_loadu_ps(p + 4), f1));
+      _mm_storeu_ps(p + 8, _mm_add_ps(_mm_loadu_ps(p + 8), f2));
+    }
+#endif
+    for (; i < batch.count; ++i) {
+      dir[i] += scaledVector;
+    }
+  } else { // FA_AVERAGE
+#if OGRE_HAVE_SSE
+    const Real& x = mForceVector.x;
+    const Real& y = mForceVector.y;
+    const Real& z = mForceVector.z;
+    __m128 f0 = _mm_setr_ps(x, y, z, x);
+    __m128 f1 = _mm_setr_ps(y, z, x, y);
+    __m128 f2 = _mm_setr_ps(z, x, y, z);
+    __m128 half = _mm_set1_ps(0.5f);
+    for (; i + 4 <= batch.count; i += 4) {
+      Real* p = &dir[i].x;
+      _mm_storeu_ps(p,     _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(p),     f0), half));
+      _mm_storeu_ps(p + 4, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(p + 4), f1), half));
+      _mm_storeu_ps(p + 8, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(p + 8), f2), half));
+    }
+#endif
+    for (; i < batch.count; ++i) {
+      dir[i] = (dir[i] + mForceVector) / 2;
     }
   }
 
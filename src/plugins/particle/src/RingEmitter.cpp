@@ -65,8 +65,10 @@ void RingEmitter::_initParticle(Particle* pParticle) {
   // ellipse and the outer circle (radius 1.0)
   // with alpha, and a and b we select a random point on this ellipse
   // and calculate it's coordinates
-  x = a * Math::Sin(alpha);
-  y = b * Math::Cos(alpha);
+  Real sinAlpha, cosAlpha;
+  Math::SinCos(alpha, sinAlpha, cosAlpha);
+  x = a * sinAlpha;
+  y = b * cosAlpha;
   // the height is simple running from 0 to 1
   z = Math::UnitRandom();     // 0..1
 
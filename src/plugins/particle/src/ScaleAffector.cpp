@@ -26,6 +26,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "ParticleSystem.h"
 #include "StringConverter.h"
 #include "Particle.h"
+#include "SIMDHelper.h"
 
 
 namespace renderer {
@@ -49,25 +50,57 @@ ScaleAffector::ScaleAffector() {
 }
 //-----------------------------------------------------------------------
 void ScaleAffector::_affectParticles(ParticleSystem* pSystem, Real timeElapsed) {
-  ParticleIterator pi = pSystem->_getIterator();
-  Particle *p;
+  ParticleData& data = pSystem->_getParticleData();
+  _affectParticleBatch(pSystem, data.getBatch(0, data.size()), timeElapsed);
+}
+//-----------------------------------------------------------------------
+bool ScaleAffector::isBatched(void) const {
+  return true;
+}
+//-----------------------------------------------------------------------
+void ScaleAffector::_affectParticleBatch(ParticleSystem* pSystem,
+    const ParticleData::Batch& batch, Real timeElapsed) {
+  Real* widths = batch.widths;
+  Real* heights = batch.heights;
+  unsigned char* ownDims = batch.ownDimensions;
   Real ds;
 
   // Scale adjustments by time
   ds = mScaleAdj * timeElapsed;
 
-  Real NewWide, NewHigh;
-
-  while (!pi.end()) {
-    p = pi.getNext();
-
-    if( p->hasOwnDimensions() == false ) {
-      p->setDimensions( pSystem->getDefaultWidth() , pSystem->getDefaultHeight() );
+  Real defaultWidth = pSystem->getDefaultWidth();
+  Real defaultHeight = pSystem->getDefaultHeight();
+
+  size_t i = 0;
+#if OGRE_HAVE_SSE
+  // Particles without their own size start from the default size, the
+  // others grow; 4 at a time, with the own size flags widened to a mask
+  __m128 vds = _mm_set1_ps(ds);
+  __m128 vWidth = _mm_set1_ps(defaultWidth);
+  __m128 vHeight = _mm_set1_ps(defaultHeight);
+  __m128i zero = _mm_setzero_si128();
+  for (; i + 4 <= batch.count; i += 4) {
+    int flags;
+    memcpy(&flags, ownDims + i, sizeof(flags));
+    __m128i f = _mm_cvtsi32_si128(flags);
+    f = _mm_unpacklo_epi16(_mm_unpacklo_epi8(f, zero), zero);
+    __m128 own = _mm_castsi128_ps(_mm_cmpgt_epi32(f, zero));
+
+    __m128 w = _mm_loadu_ps(widths + i);
+    __m128 h = _mm_loadu_ps(heights + i);
+    _mm_storeu_ps(widths + i, sse_select(own, _mm_add_ps(w, vds), vWidth));
+    _mm_storeu_ps(heights + i, sse_select(own, _mm_add_ps(h, vds), vHeight));
+    memset(ownDims + i, 1, 4);
+  }
+#endif
+  for (; i < batch.count; ++i) {
+    if( !ownDims[i] ) {
+      widths[i] = defaultWidth;
+      heights[i] = defaultHeight;
+      ownDims[i] = 1;
     } else {
-      NewWide = p->getOwnWidth()  + ds;
-      NewHigh = p->getOwnHeight() + ds;
-
-      p->setDimensions( NewWide, NewHigh );
+      widths[i] += ds;
+      heights[i] += ds;
     }
   }
 
@@ -0,0 +1,56 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __AllocatorPolicy_H__
+#define __AllocatorPolicy_H__
+
+#include "Prerequisites.h"
+
+namespace renderer {
+
+/** Interface for the memory source of a class of engine objects.
+    @remarks
+        Classes which are created and destroyed in large numbers, such as
+        SceneNode, Entity, SubEntity and Billboard, get their memory through
+        an AllocatorPolicy rather than straight from the heap. By default
+        each of them uses a PoolAllocator of its own; a subsystem with other
+        needs, an arena released all at once at the end of a level for
+        instance, can set its own policy on the class.
+    @par
+        deallocate is always called with the size which was passed to
+        allocate.
+*/
+class _RendererExport AllocatorPolicy {
+public:
+  virtual ~AllocatorPolicy() {}
+
+  /** Allocates size bytes, aligned for any type. Must not return null. */
+  virtual void* allocate(size_t size) = 0;
+
+  /** Frees memory from allocate. */
+  virtual void deallocate(void* p, size_t size) = 0;
+};
+}
+
+#endif
@@ -104,6 +104,20 @@ public:
   */
   void apply(Real timePos, Real weight = 1.0, bool accumulate = false);
 
+  /** Applies an animation at the time position and weight of an AnimationState.
+  @remarks
+      Gives the same result as the other form of apply, but each track remembers,
+      in the state, where it found its keys last time. Since an animation normally
+      advances by a small step per frame, finding the keys for the new time is then
+      a constant time operation instead of a search through the whole track.
+  @param state The playback state; its per-track key positions are updated.
+  @param accumulate Whether to add to the existing transforms rather than blending.
+  @param pSkipTracks If supplied, tracks whose handle is flagged true in this
+      are not applied. Handles beyond the end of it are applied.
+  */
+  void apply(const AnimationState& state, bool accumulate = false,
+             const std::vector<bool>* pSkipTracks = 0);
+
 
   /** Tells the animation how to interpolate between keyframes.
   @remarks
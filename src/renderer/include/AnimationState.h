@@ -29,6 +29,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Prerequisites.h"
 
 #include "MyString.h"
+#include "StringId.h"
 #include "Controller.h"
 
 namespace renderer {
@@ -55,6 +56,8 @@ public:
   String getAnimationName() const;
   /// Sets the name of the animation to which this state applies
   void setAnimationName(const String& name);
+  /// Gets the interned name of the animation, for fast lookups
+  const StringId& getAnimationNameId(void) const;
   /// Gets the time position for this animation
   Real getTimePosition(void) const;
   /// Sets the time position for this animation
@@ -86,14 +89,25 @@ public:
   /** ControllerValue implementation. */
   void setValue(Real value);
 
+  /** Gets the index of the key each track of the animation was last evaluated at.
+  @remarks
+      Internal use by Animation::apply, which keeps these up to date so that the
+      next evaluation can start its key search where the last one ended. They are
+      a cache only, and take no part in comparisons.
+  */
+  std::vector<unsigned short>& _getTrackCursors(void) const;
+
 
 protected:
   String mAnimationName;
+  StringId mAnimationNameId;
   Real mTimePos;
   Real mLength;
   Real mInvLength;
   Real mWeight;
   bool mEnabled;
+  // Last key index per track, mutable since it's updated when the state is applied
+  mutable std::vector<unsigned short> mTrackCursors;
 
 };
 
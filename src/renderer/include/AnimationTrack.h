@@ -29,6 +29,8 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Prerequisites.h"
 #include "SimpleSpline.h"
 #include "RotationalSpline.h"
+#include "Vector3.h"
+#include "Quaternion.h"
 
 namespace renderer {
 /** A 'track' in an animation sequence, ie a sequence of keyframes which affect a
@@ -133,6 +135,66 @@ public:
   /** As the 'apply' method but applies to a specified Node instead of associated node. */
   void applyToNode(Node* node, Real timePos, Real weight = 1.0, bool accumulate = false);
 
+  /** Applies the track to its associated node, starting the key search from a cursor.
+  @remarks
+      Internal method used by Animation::apply. cursor holds the index of the key found by
+      the previous call for the same playback, and is updated on return. While time moves
+      forward, as it does in normal playback, the keys are found without any searching; a
+      jump falls back to a binary search. Keys are read from packed arrays rather than the
+      KeyFrame objects, so no temporary KeyFrame is created either.
+  */
+  void _apply(Real timePos, Real weight, bool accumulate, unsigned short& cursor);
+
+  /** Evaluates the track at a time position, without applying it to any node.
+  @remarks
+      Internal method. Finds the keys from a cursor as _apply does, and returns the
+      interpolated transform. Only cursor is written, so once the track has been
+      prepared with _prepare this can be called from several threads at once, each
+      with its own cursor.
+  @returns false if the track has no keys
+  */
+  bool _evaluate(Real timePos, unsigned short& cursor, Vector3& translate,
+                 Quaternion& rotation, Vector3& scale) const;
+
+  /** Builds the packed keys and splines now, rather than the first time they
+      are needed by _apply or _evaluate. */
+  void _prepare(void) const;
+
+  /** Tells the track that the values of its keyframes have been changed.
+  @remarks
+      The track keeps a packed copy of its keys (and the interpolation splines) which is
+      built the first time it is played. Adding or removing keyframes updates it
+      automatically, but if you alter a KeyFrame's transform after the track has been
+      played you must call this for the change to be seen.
+  */
+  void _keyFrameDataChanged(void) const;
+
+  /** Compresses the keys of this track, to save memory.
+  @remarks
+      The keys are replaced by a CompressedKeyFrames, which is decoded as the track
+      is played. Keys which can be rebuilt from their neighbours within the
+      tolerances are dropped. Once compressed the track has no KeyFrame objects;
+      getNumKeyFrames returns 0 and getKeyFramesAtTime can't be used. Adding or
+      removing a keyframe decompresses the track first.
+  @param translateTolerance Largest error allowed in the translation, in world units
+  @param rotateTolerance Largest error allowed in the rotation, in radians
+  @param scaleTolerance Largest error allowed in each component of the scale
+  */
+  void compress(Real translateTolerance, Real rotateTolerance, Real scaleTolerance);
+
+  /** Turns compressed keys back into KeyFrame objects. */
+  void decompress(void);
+
+  /** Returns whether the keys of this track are compressed. */
+  bool isCompressed(void) const;
+
+  /** Gets the compressed keys of this track, or null if it isn't compressed. */
+  const CompressedKeyFrames* _getCompressedKeyFrames(void) const;
+
+  /** Replaces the keys of this track with compressed ones, which the track takes
+      ownership of. Used when loading compressed tracks. */
+  void _setCompressedKeyFrames(CompressedKeyFrames* keys);
+
 
 protected:
   typedef std::vector<KeyFrame*> KeyFrameList;
@@ -141,8 +203,34 @@ protected:
   Animation* mParent;
   Node* mTargetNode;
 
+  /// Key transform, packed next to the others for fast evaluation
+  struct KeySample {
+    Quaternion rotation;
+    Vector3 translate;
+    Vector3 scale;
+  };
+
+  /// Wraps a time index into the length of the parent animation
+  Real wrapTime(Real timePos) const;
+  /** Finds the index of the last key at or before timePos (or 0 if there is none),
+      checking the segment at cursor and the one after it before searching. */
+  unsigned short findKeyIndex(Real timePos, unsigned short cursor) const;
+  /// Applies an evaluated transform to a node
+  void applyTransform(Node* node, Real weight, bool accumulate, const Vector3& translate,
+                      const Quaternion& rotation, const Vector3& scale) const;
+
   // Flag indicating we need to rebuild the splines next time
   void buildInterpolationSplines(void) const;
+  // Copies the keyframes into the packed arrays
+  void buildKeyCache(void) const;
+
+  // Packed key times and transforms, in time order; rebuilt lazily like the splines
+  mutable bool mKeyCacheBuildNeeded;
+  mutable std::vector<Real> mKeyTimes;
+  mutable std::vector<KeySample> mKeySamples;
+
+  // Compressed keys, replacing the KeyFrames when set
+  CompressedKeyFrames* mCompressedKeys;
 
   // Prebuilt splines, must be mutable since lazy-update in const method
   mutable bool mSplineBuildNeeded;
@@ -107,6 +107,11 @@ public:
 
   /** Reads the contents of a file within the archive and copies it in the
       passed DataChunk.
+      @remarks
+          Resources are prepared on worker threads, so this and fileTest
+          may be called from several threads at once and must be safe to.
+          The chunk doesn't have to own a copy of the data; it may map it
+          instead (see DataChunk::map).
       @param
           strFile The name of the file to read from the archive.
       @param
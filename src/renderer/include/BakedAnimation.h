@@ -0,0 +1,117 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __BakedAnimation_H__
+#define __BakedAnimation_H__
+
+#include "Prerequisites.h"
+#include "Resource.h"
+
+namespace renderer {
+
+/** A skeletal animation sampled at a fixed rate into a table of bone matrices.
+    @remarks
+        Playing an animation normally means finding and interpolating the keys
+        of every track, blending, then concatenating the bone transforms down
+        the hierarchy, for every entity every frame. A baked animation does that
+        once per sample when it is loaded; playing it back is then a copy of one
+        sample's bone matrices, or a blend of the two samples either side of the
+        time position.
+    @par
+        This suits crowds of background characters playing a few looping
+        clips, where the memory for the table (48 bytes per bone per sample) is
+        a better deal than the CPU time. Samples are taken with the bones which
+        are under manual control held where they were at the time; changes made
+        to them afterwards are not seen.
+    @par
+        Baked animations are resources, managed by BakedAnimationManager, so
+        they can be paged out to stay within a memory budget and are baked
+        again the next time they are loaded.
+*/
+class _RendererExport BakedAnimation : public Resource {
+public:
+  /** Constructor, don't call directly, use BakedAnimationManager.
+      @param name Unique name of the resource
+      @param skeleton The skeleton the animation belongs to
+      @param animName The animation to bake
+      @param sampleRate Number of samples per second of animation
+  */
+  BakedAnimation(const String& name, Skeleton* skeleton, const String& animName,
+                 Real sampleRate);
+  ~BakedAnimation();
+
+  /** Samples the animation, see Resource. */
+  void load(void);
+
+  /** Frees the samples, see Resource. */
+  void unload(void);
+
+  /** Gets the skeleton the animation belongs to. */
+  Skeleton* getSkeleton(void) const;
+
+  /** Gets the name of the animation baked. */
+  const String& getAnimationName(void) const;
+
+  /** Gets the number of samples per second of animation. */
+  Real getSampleRate(void) const;
+
+  /** Gets the number of samples taken; one more would be back at the start. */
+  size_t getNumSamples(void) const;
+
+  /** Fills a bone matrix palette for a time position.
+      @remarks
+          Internal use only. The time position wraps around the length of the
+          animation, as AnimationState does. May be called from several threads
+          at once.
+      @param timePos Time position in the animation
+      @param interpolate If true, blends the two nearest samples; if false
+          takes the nearest sample before timePos
+      @param pMatrices Array to fill, the same layout as Skeleton::_getBoneMatrices
+  */
+  void _getBoneMatrices(Real timePos, bool interpolate, Matrix4* pMatrices) const;
+
+  /** Computes a hash identifying the palette _getBoneMatrices gives.
+      @remarks
+          When not interpolating, every time position within a sample gives
+          the same hash, so entities playing the same sample can share their
+          skinned vertices.
+  */
+  uint64 _getPoseHash(Real timePos, bool interpolate) const;
+
+protected:
+  /// Finds the sample before timePos, and how far it is towards the next
+  void findSample(Real timePos, size_t& sample, Real& t) const;
+
+  Skeleton* mSkeleton;
+  String mAnimationName;
+  Real mSampleRate;
+  Real mLength;
+  size_t mNumSamples;
+  unsigned short mNumBones;
+  /// Top three rows of each bone matrix, mNumBones per sample
+  std::vector<Real> mSamples;
+};
+}
+
+#endif
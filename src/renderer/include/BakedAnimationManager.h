@@ -0,0 +1,75 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __BakedAnimationManager_H__
+#define __BakedAnimationManager_H__
+
+#include "Prerequisites.h"
+
+#include "ResourceManager.h"
+#include "Singleton.h"
+
+namespace renderer {
+
+/** Keeps the baked animations (see BakedAnimation) in use.
+    @remarks
+        Each animation is baked once per skeleton and sample rate, however
+        many entities play it.
+*/
+class _RendererExport BakedAnimationManager : public ResourceManager,
+  public Singleton<BakedAnimationManager> {
+public:
+  BakedAnimationManager();
+
+  /** Gets an animation of a skeleton baked at a sample rate, baking it if need be.
+      @remarks
+          If the baked animation was paged out, it is baked again.
+      @param skeleton The skeleton the animation belongs to
+      @param animName The animation to bake
+      @param sampleRate Number of samples per second of animation
+      @param priority Priority of the resource
+  */
+  BakedAnimation* load(Skeleton* skeleton, const String& animName,
+                       Real sampleRate = 30, int priority = 1);
+
+  /** Not supported; a baked animation can't be created from a name alone,
+      use load instead. */
+  Resource* create(const String& name);
+
+  /** Override standard Singleton retrieval.
+      @remarks
+          Why do we do this? Well, it's because the Singleton implementation is in a .h file,
+          which means it gets compiled into anybody who includes it. This is needed for the Singleton
+          template to work, but we actually only want it compiled into the implementation of the
+          class based on the Singleton, not all of them. If we don't change this, we get link errors
+          when trying to use the Singleton-based class from an outside dll.
+      @par
+          This method just delegates to the template version anyway, but the implementation stays in this
+          single compilation unit, preventing link errors.
+  */
+  static BakedAnimationManager& getSingleton(void);
+};
+}
+
+#endif
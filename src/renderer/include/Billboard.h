@@ -56,6 +56,7 @@ namespace renderer {
 
 class _RendererExport Billboard {
   friend class BillboardSet;
+  friend class ParticleData;
 protected:
   bool mOwnDimensions;
   Real mWidth;
@@ -77,6 +78,24 @@ public:
   */
   ~Billboard();
 
+  /** Allocates Billboards and Particles from their pool; see setAllocatorPolicy.
+      @remarks
+          Particles may be deleted through Billboard pointers, so the
+          two classes share one pool with blocks big enough for a
+          Particle, and a block of that size is always requested. Classes
+          derived from Billboard must not be bigger than Particle.
+  */
+  static void* operator new(size_t size);
+  /** Returns the memory of a Billboard or Particle to its pool. */
+  static void operator delete(void* p);
+  /** Sets the AllocatorPolicy Billboards and Particles are allocated from.
+      @remarks
+          By default they come from a PoolAllocator of their own. Only
+          change this while no Billboards or Particles exist; pass null to
+          go back to the default pool.
+  */
+  static void setAllocatorPolicy(AllocatorPolicy* policy);
+
   /** Normal constructor as called by BillboardSet.
   */
   Billboard(const Vector3& position, BillboardSet* owner, const ColourValue& colour = ColourValue::White);
@@ -143,14 +143,18 @@ protected:
   BillboardPool mBillboardPool;
 
 
-  /// The vertex position data for all billboards in this set.
-  Real* mpPositions;
+  /// Number of Reals in each vertex of mpVertexData
+  enum { VERTEX_SIZE = 6 };
 
-  /// The vertex colour data for all billboards in this set
-  RGBA* mpColours;
-
-  /// The texture coordinates for all billboards in this set
-  Real* mpTexCoords;
+  /** The interleaved vertex data for all billboards in this set.
+      @remarks
+          Each vertex is position x, y, z, the packed colour, then texture
+          coordinates u, v. The texture coordinates never change, so they
+          are written when the buffer is allocated; each frame only the
+          first 4 Reals of a vertex are written, which is a single store
+          with SSE. Assumes single precision Reals.
+  */
+  Real* mpVertexData;
 
   /// The vertex index data for all billboards in this set (1 set only)
   unsigned short* mpIndexes;
@@ -158,19 +162,87 @@ protected:
   /// Flag indicating whether each billboard should be culled separately (default: false)
   bool mCullIndividual;
 
+  /// Flag indicating whether billboards are sorted back to front (default: false)
+  bool mSortingEnabled;
+
   /// The type of billboard to render
   BillboardType mBillboardType;
 
   /// Common direction for billboards of type BBT_ORIENTED_COMMON
   Vector3 mCommonDirection;
 
-  /// Internal method for culling individual billboards
-  inline bool billboardVisible(Camera* cam, ActiveBillboardList::iterator bill);
+  /** The attributes of billboards to build quads for, as contiguous arrays.
+      @remarks
+          directions is only read for BBT_ORIENTED_SELF; ownDimensions
+          (with widths and heights) and rotations may be null, meaning all
+          default size and unrotated. Every size, default or own, is
+          multiplied by sizeScale.
+  */
+  struct BillboardArrays {
+    size_t count;
+    const Vector3* positions;
+    const Vector3* directions;
+    const ColourValue* colours;
+    const Real* widths;
+    const Real* heights;
+    const unsigned char* ownDimensions;
+    const Real* rotations;
+    Real sizeScale;
+  };
+
+  /// Per-camera values shared by all the quads built by genQuads
+  struct QuadSetup {
+    Real leftOff, rightOff, topOff, bottomOff;
+    Vector3 camX, camY;
+    /// Corner offsets for default sized billboards, x y z 0
+    Real defaultOffsets[4][4];
+    bool selfOriented;
+  };
+
+  /// A billboard which passed culling, and its distance for sorting
+  struct VisibleBillboard {
+    Real depth;
+    unsigned int index;
+  };
+
+  /// Visible billboards, reused every frame when sorting
+  std::vector<VisibleBillboard> mVisible;
+
+  /// Gathered attributes of the active billboards, reused every frame
+  std::vector<Vector3> mGatherPositions;
+  std::vector<Vector3> mGatherDirections;
+  std::vector<ColourValue> mGatherColours;
+  std::vector<Real> mGatherWidths;
+  std::vector<Real> mGatherHeights;
+  std::vector<unsigned char> mGatherOwnDimensions;
+
+  /** Internal method for culling individual billboards.
+  @param worldPos Position of the billboard in world space
+  */
+  bool billboardVisible(Camera* cam, const Vector3& worldPos,
+                        const BillboardArrays& arrays, size_t index);
+
+  /** Builds the quads of the visible billboards into mpVertexData.
+  @remarks
+      Culling (if enabled) happens in the same pass as the quads are
+      built; when sorting, a first pass culls and finds the distances,
+      then the quads are built in sorted order. Sets mNumVisibleBillboards.
+  */
+  void genQuads(Camera* cam, const BillboardArrays& arrays);
+
+  /** Writes the 4 vertices of one billboard to *ppDest, and moves it on. */
+  void genQuad(Camera& cam, const QuadSetup& setup,
+               const BillboardArrays& arrays, size_t index, Real** ppDest);
 
   // Number of visible billboards (will be == getNumBillboards if mCullIndividual == false)
   unsigned short mNumVisibleBillboards;
 
-  /// Internal method for increasing pool size
+  /** Internal method for increasing pool size.
+      @remarks
+          Subclasses overriding this are also responsible for making the
+          new instances available, and for reporting the new size through
+          getPoolSize.
+  */
   virtual void increasePool(unsigned int size);
 
 
@@ -182,22 +254,13 @@ protected:
   //-----------------------------------------------------------------------
   /** Internal method for generating billboard corners.
   @remarks
-      Optional parameter pBill is only present for type BBT_ORIENTED_SELF
+      Optional parameter pDirection, the direction of the billboard, is only present for type BBT_ORIENTED_SELF
   */
-  virtual void genBillboardAxes(Camera& cam, Vector3* pX, Vector3 *pY, const Billboard* pBill = 0);
+  virtual void genBillboardAxes(Camera& cam, Vector3* pX, Vector3 *pY, const Vector3* pDirection = 0);
 
   /** Internal method, generates parametric offsets based on origin.
   */
-  inline void getParametricOffsets(Real& left, Real& right, Real& top, Real& bottom);
-
-  /** Internal method for generating vertex data.
-  @param pPos Pointer to pointer to vertex positions, will be updated
-  @param pCol Pointer to pointer to vertex colours, will be updated
-  @param offsets Array of 4 Vector3 offsets
-  @param pBillboard Pointer to billboard
-  @returns new vertex index
-  */
-  inline void genVertices(Real **pPos, RGBA** pCol, const Vector3* offsets, const Billboard* pBillboard);
+  void getParametricOffsets(Real& left, Real& right, Real& top, Real& bottom);
 
   /** Internal method generates vertex offsets.
   @remarks
@@ -206,9 +269,9 @@ protected:
       Fills output array of 4 vectors with vector offsets
       from origin for left-top, right-top, left-bottom, right-bottom corners.
   */
-  inline void genVertOffsets(Real inleft, Real inright, Real intop, Real inbottom,
-                             Real width, Real height,
-                             const Vector3& x, const Vector3& y, Vector3* pDestVec);
+  void genVertOffsets(Real inleft, Real inright, Real intop, Real inbottom,
+                      Real width, Real height,
+                      const Vector3& x, const Vector3& y, Vector3* pDestVec);
 
   /// Shared class-level name for Movable type
   static String msMovableType;
@@ -472,6 +535,17 @@ public:
   */
   virtual void setCullIndividually(bool cullIndividual);
 
+  /** Returns whether billboards in this set are sorted back to front. */
+  virtual bool getSortingEnabled(void) const;
+  /** Sets whether billboards in this set are sorted back to front.
+  @remarks
+      Transparent billboards which are not additively blended only look
+      right when drawn furthest first. Sorting happens every time the set
+      is rendered, by distance from the camera, so only enable it when
+      it's needed. The default is not to sort.
+  */
+  virtual void setSortingEnabled(bool sortingEnabled);
+
   /** Sets the type of billboard to render.
   @remarks
       The default sort of billboard (BBT_POINT), always has both x and y axes parallel to
@@ -82,15 +82,27 @@ public:
   /** Sets whether or not this bone is manually controlled.
   @remarks
       Manually controlled bones can be altered by the application at runtime,
-      and their positions will not be reset by the animation routines. Note
-      that you should also make sure that there are no AnimationTrack objects
-      referencing this bone, or if there are, you should delete them using
+      and their positions will not be reset by the animation routines.
+      AnimationTrack objects referencing this bone are ignored when the
+      skeleton is animated; to drop them for good, delete them using
       pAnimation->destroyTrack(pBone->getHandle());
   */
   void setManuallyControlled(bool manuallyControlled);
 
   /** Getter for mManuallyControlled Flag */
-  bool isManuallyControlled();
+  bool isManuallyControlled() const;
+
+  /** Sets whether this is a minor bone.
+  @remarks
+      Minor bones are those whose movement can't be made out from a distance,
+      like fingers or facial bones. Entities can be told to leave them in
+      their binding pose when far from the camera, see
+      Entity::addAnimationLodLevel.
+  */
+  void setMinor(bool minor);
+
+  /** Returns whether this is a minor bone. */
+  bool isMinor(void) const;
 
 
   /** Gets the inverse transform which takes bone space to origin from the binding pose.
@@ -99,13 +111,30 @@ public:
   */
   Matrix4 _getBindingPoseInverseTransform(void);
 
+  /** Overridden from Node to tell the skeleton its hierarchy has changed. */
+  void addChild(Node* child);
+
+  /** Overridden from Node.
+  @remarks
+      The skeleton updates all of its bones in one pass (see Skeleton::_getBoneMatrices),
+      so there is no need to queue this bone for update with its parent; the skeleton
+      is just told something has moved.
+  */
+  void needUpdate();
+
 protected:
+  /// The skeleton reads and writes the transforms directly when updating its bones
+  friend class Skeleton;
+
   /// The numeric handle of this bone
   unsigned short mHandle;
 
   /** Bones set as manuallyControlled are not reseted in Skeleton::reset() */
   bool mManuallyControlled;
 
+  /// Whether the animation of this bone can be skipped at a distance
+  bool mMinor;
+
   /** See Node. */
   Node* createChildImpl(void);
   /** See Node. */
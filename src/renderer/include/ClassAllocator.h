@@ -0,0 +1,66 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __ClassAllocator_H__
+#define __ClassAllocator_H__
+
+#include "Prerequisites.h"
+#include "PoolAllocator.h"
+
+namespace renderer {
+
+/** Routes the allocations of one class through an AllocatorPolicy.
+    @remarks
+        A pooled class keeps one of these, and forwards its class specific
+        operator new and delete to it. Unless told otherwise the
+        ClassAllocator uses a PoolAllocator sized for the class.
+*/
+class _RendererExport ClassAllocator {
+public:
+  /** Constructor.
+      @param blockSize Size of the class
+  */
+  ClassAllocator(size_t blockSize);
+
+  void* allocate(size_t size);
+  void deallocate(void* p, size_t size);
+
+  /** Sets the policy to allocate from.
+      @remarks
+          Only change this while there are no live objects of the class;
+          memory must go back to the policy it came from. Pass null to go
+          back to the default pool.
+  */
+  void setPolicy(AllocatorPolicy* policy);
+
+  /** Gets the policy allocated from. */
+  AllocatorPolicy* getPolicy(void) const;
+
+protected:
+  PoolAllocator mDefaultPool;
+  AllocatorPolicy* mPolicy;
+};
+}
+
+#endif
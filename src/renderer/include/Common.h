@@ -127,6 +127,14 @@ enum SceneDetailLevel {
   SDL_SOLID = 3
 };
 
+/** The way skinned vertices are blended between the bones influencing them. */
+enum SkinningMethod {
+  /// Weighted sum of the bone matrices; cheapest, but joints lose volume when twisted.
+  SKIN_LINEAR,
+  /// Weighted sum of the bone transforms as dual quaternions; keeps volume, ignores bone scaling.
+  SKIN_DUAL_QUATERNION
+};
+
 /** The pixel format used for textures. */
 enum PixelFormat {
   /// Unknown pixel format.
@@ -0,0 +1,131 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __CompressedKeyFrames_H__
+#define __CompressedKeyFrames_H__
+
+#include "Prerequisites.h"
+#include "Vector3.h"
+#include "Quaternion.h"
+
+namespace renderer {
+
+/** Compact storage for the keys of an AnimationTrack.
+@remarks
+    KeyFrame objects hold their transforms as full precision floats, one heap
+    allocation per key. This class stores the same keys in a fraction of the
+    space, and is decoded on the fly while the animation plays:
+    <ul>
+    <li>Key times are 16 bit fractions of the animation length.</li>
+    <li>Rotations use 'smallest three' quantisation in 48 bits: the largest
+        component is dropped (it can be recovered since the quaternion has unit
+        length) and the other three are stored with 15 bits each.</li>
+    <li>Translations and scales are quantised to 16 bits per component over
+        the range the track actually covers.</li>
+    <li>A channel which doesn't change over the track within the tolerance
+        is stored as a single value.</li>
+    <li>Keys which can be reproduced by interpolating their neighbours within
+        the tolerance are removed.</li>
+    </ul>
+@par
+    Compressed keys are always interpolated linearly, whatever the interpolation
+    mode of the animation.
+*/
+class _RendererExport CompressedKeyFrames {
+public:
+  /// Flags for channels which hold a single value for the whole track
+  enum ConstantChannel {
+    CC_ROTATION = 0x1,
+    CC_TRANSLATE = 0x2,
+    CC_SCALE = 0x4
+  };
+
+  CompressedKeyFrames();
+  ~CompressedKeyFrames();
+
+  /** Builds the compressed keys from the KeyFrames of a track.
+  @param track The track to compress; must have at least one keyframe
+  @param length Length of the animation the track belongs to
+  @param translateTolerance Largest error allowed in the translation, in world units
+  @param rotateTolerance Largest error allowed in the rotation, in radians
+  @param scaleTolerance Largest error allowed in each component of the scale
+  */
+  void build(const AnimationTrack* track, Real length, Real translateTolerance,
+             Real rotateTolerance, Real scaleTolerance);
+
+  /** Evaluates the transform at a time position.
+  @param timePos The time, already wrapped into the length of the animation
+  @param cursor The key index found by the previous call for the same playback;
+      updated on return. See AnimationTrack::_apply.
+  */
+  void evaluate(Real timePos, unsigned short& cursor, Vector3& translate,
+                Quaternion& rotation, Vector3& scale) const;
+
+  /** Returns the number of keys kept. */
+  unsigned short getNumKeys(void) const;
+
+  /** Returns the time of a key, in seconds. */
+  Real getKeyTime(unsigned short index) const;
+
+  /** Decodes the transform of a single key. */
+  void getKey(unsigned short index, Vector3& translate, Quaternion& rotation,
+              Vector3& scale) const;
+
+  /** Returns the memory used by the keys, in bytes. */
+  size_t getMemoryUsage(void) const;
+
+protected:
+  /// Gives the serializer direct access to the packed data
+  friend class SkeletonSerializer;
+
+  unsigned short findKeyIndex(Real time, unsigned short cursor) const;
+  void decodeRotation(unsigned short index, Quaternion& rotation) const;
+  void decodeTranslate(unsigned short index, Vector3& translate) const;
+  void decodeScale(unsigned short index, Vector3& scale) const;
+
+  /// Sets up mTimeScale from the animation length
+  void setLength(Real length);
+
+  Real mLength;
+  /// Converts seconds into quantised time
+  Real mTimeScale;
+  /// Combination of ConstantChannel flags
+  unsigned short mConstantChannels;
+
+  /// Quantisation ranges
+  Vector3 mTranslateMin;
+  Vector3 mTranslateExtent;
+  Vector3 mScaleMin;
+  Vector3 mScaleExtent;
+
+  /// Key times in 1/65535ths of the animation length
+  std::vector<uint16> mTimes;
+  /// 3 values per key, or just 3 for a constant channel
+  std::vector<uint16> mRotations;
+  std::vector<uint16> mTranslates;
+  std::vector<uint16> mScales;
+};
+}
+
+#endif
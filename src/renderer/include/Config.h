@@ -45,6 +45,11 @@ http://www.gnu.org/copyleft/lesser.txt.
 */
 #define OGRE_DOUBLE_PRECISION 0
 
+/** If set to 1, the vectorised maths kernels use SSE2 intrinsics when the
+    target supports them. Set to 0 to force the portable scalar fallbacks.
+*/
+#define OGRE_USE_SSE 1
+
 /** If set to 1, the strings are transforned to Unicode, and char is replaced
     with wchar_t when having to do with strings of any kind.
 */
@@ -27,6 +27,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 
 #include "Prerequisites.h"
 #include "MyString.h"
+#include "MappedFile.h"
 
 namespace renderer {
 /** Wraps a chunk of memory, storing both size and a pointer to the data.
@@ -47,6 +48,10 @@ namespace renderer {
   @par
     If you need a DataChunk that frees the allocated memory on
     destruction, use SDDataChunk instead.
+  @par
+    A chunk may also wrap a memory mapped file (see map). That memory is
+    reference counted rather than owned, so every copy of the chunk keeps
+    the file mapped until it is cleared or destroyed.
   @see
     SDDataChunk
 */
@@ -56,6 +61,13 @@ protected:
   uchar* mPos;
   uchar* mEnd;
   size_t mSize;
+  /// Set if the data is a mapped file rather than allocated
+  scoped_refptr<MappedFile> mMapping;
+
+  /// Releases the data, however it was obtained
+  void release(void);
+  /// Number of bytes from the read pointer to the first delimiter or the end
+  size_t scanUpTo(const char* delim) const;
 
 public:
   /** Default constructor.
@@ -68,15 +80,31 @@ public:
 
   /** Default destructor.
     @note
-      The destructor <b>DOES NOT FREE</b> memory.
+      The destructor <b>DOES NOT FREE</b> allocated memory. A mapped
+      file is released though, since it is shared.
   */
-  virtual ~DataChunk() {}
+  virtual ~DataChunk();
 
   /** Allocates the passed number of bytes.
   */
   uchar * allocate( size_t size, const uchar * ptr = NULL );
 
-  /** Frees all internally allocated memory.
+  /** Wraps a mapped file, taking a reference to it.
+    @remarks
+      Any memory previously allocated is freed. The file data can be
+      modified, without affecting the file itself.
+  */
+  void map( MappedFile* file );
+
+  /** Wraps part of a mapped file, taking a reference to the whole file.
+  */
+  void map( MappedFile* file, size_t offset, size_t size );
+
+  /** Returns true if the data is a mapped file.
+  */
+  bool isMapped() const;
+
+  /** Frees all internally allocated memory, or releases the mapped file.
   */
   DataChunk & clear();
 
@@ -30,6 +30,8 @@ http://www.gnu.org/copyleft/lesser.txt.
 
 #include "MyString.h"
 #include "MovableObject.h"
+#include "Mesh.h"
+#include "Skeleton.h"
 #include "AnimationState.h"
 #include "Quaternion.h"
 #include "Vector3.h"
@@ -109,9 +111,74 @@ private:
   /// Cached bone matrices, including any world transform
   Matrix4 *mBoneMatrices;
   unsigned short mNumBoneMatrices;
+  /// Bone matrices in model space, as last evaluated
+  Matrix4 *mBoneModelMatrices;
+  /// Mesh mBoneModelMatrices were evaluated for, null if they need evaluating
+  Mesh* mBoneModelMesh;
+  /// Whether minor bones were skipped in mBoneModelMatrices
+  bool mBonesSkippedMinor;
+  /// Pose hash of mBoneModelMatrices, see Skeleton::_getPoseHash
+  uint64 mBonePoseHash;
+  /// Whether mBoneDualQuats holds the same pose as mBoneModelMatrices
+  bool mBoneDualQuatsValid;
+  /// Working storage for evaluating the skeleton
+  Skeleton::PoseBuffer mPoseBuffer;
+  /// Whether _updateAnimation has evaluated the bones ahead of rendering
+  bool mBonesPrepared;
+  /// Frame number mBonesPrepared was set in
+  unsigned long mBonesPreparedFrame;
+  /// Frame number this entity was last queued for rendering in
+  unsigned long mLastVisibleFrame;
+
+  /// A level of animation detail, see addAnimationLodLevel
+  struct AnimationLodLevel {
+    Real fromDepthSquared;
+    unsigned short updateInterval;
+    bool skipMinorBones;
+  };
+  typedef std::vector<AnimationLodLevel> AnimationLodLevelList;
+  /// Animation LOD levels, nearest first
+  AnimationLodLevelList mAnimationLodLevels;
+  /// Index of the animation LOD level in use or -1 for full detail, calculated by _notifyCurrentCamera
+  int mAnimationLodIndex;
+  /// Frame offset of throttled bone updates
+  unsigned short mAnimationPhase;
+  /// Phase to give the next entity created
+  static unsigned short msNextAnimationPhase;
+
+  /// An animation played from a baked table, see bakeAnimation
+  struct BakedAnimationUsage {
+    BakedAnimation* baked;
+    bool interpolate;
+  };
+  typedef std::map<String, BakedAnimationUsage> BakedAnimationList;
+  BakedAnimationList mBakedAnimations;
+  /** Finds the baked animation which can stand in for the animation state, if
+      there is one, and the time position to play it at. */
+  const BakedAnimationUsage* findBakedAnimation(Mesh* theMesh, Real& timePos) const;
 
   /// Private method to cache bone matrices from skeleton
   void cacheBoneMatrices(void);
+  /// Gets the mesh (maybe a manual LOD) whose skeleton animates this entity, or null
+  Mesh* getSkeletonMesh(void) const;
+  /** Evaluates the bones into mBoneModelMatrices, unless animation LOD lets the
+      last ones be reused or the pose hasn't changed. */
+  void evaluateBones(Mesh* theMesh);
+
+  /** Skinned vertices for the current pose, shared with other entities in
+      the same pose; null unless skinning in software. World transforms are
+      not included, SubEntity applies them when rendering.
+  */
+  Mesh::SkinnedPose* mSkinnedPose;
+  /// The mesh (maybe a manual LOD) which owns mSkinnedPose
+  Mesh* mSkinnedPoseMesh;
+  /// Bone palette for dual quaternion skinning, 8 Reals per bone
+  Real* mBoneDualQuats;
+  /// Skinning method, if overridden for this entity
+  SkinningMethod mSkinningMethod;
+  bool mSkinningMethodOverridden;
+  /// Releases mSkinnedPose
+  void releaseSkinnedPose(void);
 
   /// Flag determines whether or not to display skeleton
   bool mDisplaySkeleton;
@@ -158,6 +225,18 @@ public:
   */
   ~Entity();
 
+  /** Allocates Entities from their pool; see setAllocatorPolicy. */
+  static void* operator new(size_t size);
+  /** Returns the memory of a Entity to its pool. */
+  static void operator delete(void* p, size_t size);
+  /** Sets the AllocatorPolicy Entities are allocated from.
+      @remarks
+          By default they come from a PoolAllocator of their own. Only
+          change this while no Entities exist; pass null to go back to the
+          default pool.
+  */
+  static void setAllocatorPolicy(AllocatorPolicy* policy);
+
   /** Gets the Mesh that this Entity is based on.
   */
   Mesh* getMesh(void);
@@ -211,6 +290,29 @@ public:
   */
   void _updateRenderQueue(RenderQueue* queue);
 
+  /** Gets the skeleton to prepare before calling _updateAnimation, or null
+      if this entity should be left to animate when it is rendered.
+  @remarks
+      Internal use only. Entities without a skeleton, or which weren't
+      rendered in the current or the previous frame, return null. So do
+      entities with objects attached to their bones, since the tag points
+      follow the Bone objects of the shared skeleton, which can only hold one
+      entity's pose at a time.
+  */
+  Skeleton* _getSkeletonToAnimate(void) const;
+
+  /** Evaluates the skeletal animation of this entity ahead of rendering.
+  @remarks
+      Internal method called by SceneManager before the scene is culled, for
+      entities returning a skeleton from _getSkeletonToAnimate, once that
+      skeleton has been through Skeleton::_prepareForEvaluation. Only data
+      belonging to this entity is written, so different entities may be
+      updated on different threads at once. If the entity is rendered this
+      frame, it uses the bones evaluated here rather than evaluating them
+      again.
+  */
+  void _updateAnimation(void);
+
   /** Overridden from MovableObject */
   const String& getName(void) const;
 
@@ -232,6 +334,15 @@ public:
   */
   AnimationStateSet* getAllAnimationStates(void);
 
+  /** Sets how this entity's vertices are blended between bones.
+  @remarks
+      Overrides the Mesh setting (see Mesh::setSkinningMethod) for this
+      entity alone, e.g. to use dual quaternion skinning on a close-up hero
+      character while the crowd using the same mesh stays linear.
+  */
+  void setSkinningMethod(SkinningMethod method);
+  /** Gets how this entity's vertices are blended between bones. */
+  SkinningMethod getSkinningMethod(void) const;
   /** Tells the Entity whether or not it should display it's skeleton, if it has one.
   */
   void setDisplaySkeleton(bool display);
@@ -265,6 +376,48 @@ public:
   */
   void setLodBias(Real factor = 1.0, ushort maxDetailIndex = 0, ushort minDetailIndex = 99);
 
+  /** Adds a level of animation detail, used beyond a given distance from the camera.
+  @remarks
+      Evaluating the skeleton of an entity costs the same however small it is on
+      screen. Beyond fromDepth the bones of this entity are only evaluated every
+      updateInterval frames, and the last result is reused in between. Each
+      entity updates on a different phase, so the updates of a crowd are spread
+      evenly over the frames. Bones flagged as minor (see Bone::setMinor) can
+      also be left in their binding pose.
+  @par
+      The distance is adjusted by the LOD bias of the entity and the camera, as
+      for mesh LOD. Entities with objects attached to their bones always update
+      every frame, since the attached objects follow the bones directly. Frames
+      are counted by Root::RunFrame.
+  @param fromDepth Distance from the camera at which this level starts
+  @param updateInterval Number of frames from one update to the next, e.g. 2 or 4
+  @param skipMinorBones Whether minor bones are left unanimated at this level
+  */
+  void addAnimationLodLevel(Real fromDepth, unsigned short updateInterval,
+                            bool skipMinorBones = false);
+
+  /** Removes all the animation LOD levels, so the entity is fully animated at any distance. */
+  void removeAllAnimationLodLevels(void);
+
+  /** Plays an animation from a table of baked bone matrices, rather than by
+      evaluating the skeleton.
+  @remarks
+      See BakedAnimation. The table is shared with every entity baking the
+      same animation at the same rate, and is used whenever that animation
+      is the only one enabled (at full weight if the skeleton blends
+      cumulatively). Entities with objects attached to their bones always
+      evaluate the skeleton, since the tag points follow the bones.
+  @param animName Name of the animation
+  @param sampleRate Number of samples per second of animation
+  @param interpolate Whether to blend between the two nearest samples. If
+      not, entities on the same sample also share skinned vertices when
+      skinning is done in software.
+  */
+  void bakeAnimation(const String& animName, Real sampleRate = 30, bool interpolate = true);
+
+  /** Goes back to evaluating an animation given to bakeAnimation. */
+  void removeBakedAnimation(const String& animName);
+
   /** Sets the rendering detail of this entire entity (solid, wireframe etc) */
   void setRenderDetail(SceneDetailLevel renderDetail);
 
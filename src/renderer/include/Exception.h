@@ -30,6 +30,8 @@ http://www.gnu.org/copyleft/lesser.txt.
 
 #include "MyString.h"
 
+#include "base/threading/platform_thread.h"
+
 #define Except( num, desc, src ) throw( renderer::Exception( num, desc, src, __FILE__, __LINE__ ) )
 
 // Stack unwinding options
@@ -98,6 +100,8 @@ protected:
 
   static OgreChar msFunctionStack[ OGRE_CALL_STACK_DEPTH ][ 256 ];
   static ushort   msStackDepth;
+  /// The thread whose calls are kept on the stack
+  static base::PlatformThreadId msStackThread;
 public:
   /** Static definitions of error codes.
       @todo
@@ -155,6 +159,9 @@ public:
   static Exception* getLastException(void) throw();
 
   /** Pushes a function on the stack.
+      @remarks
+          The stack is only kept for the thread which started the
+          application; calls from worker threads are ignored.
   */
   static void _pushFunction( const String& strFuncName ) throw();
   /** Pops a function from the stack.
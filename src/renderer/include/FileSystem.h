@@ -47,16 +47,14 @@ public:
   }
 
 private:
-  void setPath() const;
-  void unsetPath() const;
-  void recursDeleDir( bool bRecursive );
+  /// Returns the absolute path of a file in this archive
+  String getFullPath( const String& strFile ) const;
+  void recursDeleDir( const String& strDir, bool bRecursive );
 
+  /// Absolute, resolved when loaded
   String mstrBasePath;
-  mutable char mszTempPath[261];
 };
 
-#define retunset( a ) { unsetPath(); return a; }
-
 }
 
 #endif
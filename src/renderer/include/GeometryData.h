@@ -73,6 +73,10 @@ struct GeometryData {
   */
   RenderOperation::VertexBlendData* pBlendingWeights;
 
+  /** Compacted form of pBlendingWeights used for software skinning, built
+      when bone assignments are compiled. Null if there are no weights.
+  */
+  VertexInfluenceStream* pInfluences;
 
 };
 
@@ -0,0 +1,260 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __IdHashMap_H__
+#define __IdHashMap_H__
+
+#include "Prerequisites.h"
+#include "StringId.h"
+
+namespace renderer {
+
+/** Hash map from StringId to T, using open addressing.
+    @remarks
+        The entries are kept in one flat array and found by linear probing
+        from the id, so a lookup is a couple of integer compares in memory
+        which is usually already in cache, instead of the string compares
+        and pointer chasing of a std::map keyed by String.
+    @par
+        The interface is a subset of the standard associative containers,
+        and since StringId converts from String, code written against a
+        std::map<String, T> mostly works unchanged. The differences:
+        <ul>
+        <li>Iteration order is arbitrary, and changes when the map grows.</li>
+        <li>Inserting may move every entry, so pointers and iterators to
+            entries are invalidated by insert and operator[]. Erasing leaves
+            the other entries where they are.</li>
+        </ul>
+*/
+template <typename T>
+class IdHashMap {
+public:
+  typedef StringId key_type;
+  typedef T mapped_type;
+  typedef std::pair<StringId, T> value_type;
+
+protected:
+  enum {
+    SLOT_EMPTY,
+    SLOT_USED,
+    /// Erased; keeps probe sequences running through it intact
+    SLOT_DELETED
+  };
+
+  /** Iterator over the used slots. */
+  template <typename MapType, typename ValueType>
+  class IteratorImpl {
+  public:
+    IteratorImpl() : mMap(0), mIndex(0) {}
+    IteratorImpl(MapType* map, size_t index) : mMap(map), mIndex(index) {}
+    /// Allows iterator to const_iterator conversion
+    template <typename OtherMap, typename OtherValue>
+    IteratorImpl(const IteratorImpl<OtherMap, OtherValue>& rhs)
+      : mMap(rhs.mMap), mIndex(rhs.mIndex) {}
+
+    ValueType& operator*() const {
+      return mMap->mValues[mIndex];
+    }
+    ValueType* operator->() const {
+      return &mMap->mValues[mIndex];
+    }
+    IteratorImpl& operator++() {
+      mIndex = mMap->nextUsed(mIndex + 1);
+      return *this;
+    }
+    IteratorImpl operator++(int) {
+      IteratorImpl ret = *this;
+      ++*this;
+      return ret;
+    }
+    bool operator==(const IteratorImpl& rhs) const {
+      return mIndex == rhs.mIndex && mMap == rhs.mMap;
+    }
+    bool operator!=(const IteratorImpl& rhs) const {
+      return !(*this == rhs);
+    }
+
+    MapType* mMap;
+    size_t mIndex;
+  };
+
+public:
+  typedef IteratorImpl<IdHashMap, value_type> iterator;
+  typedef IteratorImpl<const IdHashMap, const value_type> const_iterator;
+
+  IdHashMap() : mSize(0), mDeleted(0) {}
+
+  iterator begin(void) {
+    return iterator(this, nextUsed(0));
+  }
+  const_iterator begin(void) const {
+    return const_iterator(this, nextUsed(0));
+  }
+  iterator end(void) {
+    return iterator(this, mStates.size());
+  }
+  const_iterator end(void) const {
+    return const_iterator(this, mStates.size());
+  }
+
+  size_t size(void) const {
+    return mSize;
+  }
+  bool empty(void) const {
+    return mSize == 0;
+  }
+
+  iterator find(const StringId& key) {
+    return iterator(this, findSlot(key));
+  }
+  const_iterator find(const StringId& key) const {
+    return const_iterator(this, findSlot(key));
+  }
+
+  /** Inserts an entry, unless one with the same key is already there.
+      @returns the entry with the key, and whether it was inserted
+  */
+  std::pair<iterator, bool> insert(const value_type& val) {
+    // Keep at most 3/4 of the slots in use, counting erased ones
+    if ((mSize + mDeleted + 1) * 4 > mStates.size() * 3) {
+      // Only grow if the live entries need it; otherwise just sweep out
+      // the erased slots
+      size_t capacity = mStates.empty() ? 16 : mStates.size();
+      if ((mSize + 1) * 2 > capacity) {
+        capacity *= 2;
+      }
+      rehash(capacity);
+    }
+
+    size_t mask = mStates.size() - 1;
+    size_t slot = val.first.getId() & mask;
+    size_t target = mStates.size();
+    while (mStates[slot] != SLOT_EMPTY) {
+      if (mStates[slot] == SLOT_USED) {
+        if (mValues[slot].first == val.first) {
+          return std::pair<iterator, bool>(iterator(this, slot), false);
+        }
+      } else if (target == mStates.size()) {
+        target = slot;
+      }
+      slot = (slot + 1) & mask;
+    }
+    if (target == mStates.size()) {
+      target = slot;
+    } else {
+      --mDeleted;
+    }
+
+    mStates[target] = SLOT_USED;
+    mValues[target] = val;
+    ++mSize;
+    return std::pair<iterator, bool>(iterator(this, target), true);
+  }
+
+  /** Gets the value with the key, inserting a default one if needed. */
+  T& operator[](const StringId& key) {
+    return insert(value_type(key, T())).first->second;
+  }
+
+  void erase(iterator i) {
+    assert(i.mMap == this && mStates[i.mIndex] == SLOT_USED);
+    mStates[i.mIndex] = SLOT_DELETED;
+    mValues[i.mIndex] = value_type();
+    --mSize;
+    ++mDeleted;
+  }
+
+  /** Erases the entry with the key, if any.
+      @returns the number of entries erased
+  */
+  size_t erase(const StringId& key) {
+    size_t slot = findSlot(key);
+    if (slot == mStates.size()) {
+      return 0;
+    }
+    erase(iterator(this, slot));
+    return 1;
+  }
+
+  /** Removes all entries, keeping the memory. */
+  void clear(void) {
+    std::fill(mStates.begin(), mStates.end(), static_cast<unsigned char>(SLOT_EMPTY));
+    std::fill(mValues.begin(), mValues.end(), value_type());
+    mSize = 0;
+    mDeleted = 0;
+  }
+
+protected:
+  /// Gets the slot holding key, or mStates.size() if there is none
+  size_t findSlot(const StringId& key) const {
+    if (mSize == 0) {
+      return mStates.size();
+    }
+    size_t mask = mStates.size() - 1;
+    size_t slot = key.getId() & mask;
+    while (mStates[slot] != SLOT_EMPTY) {
+      if (mStates[slot] == SLOT_USED && mValues[slot].first == key) {
+        return slot;
+      }
+      slot = (slot + 1) & mask;
+    }
+    return mStates.size();
+  }
+
+  /// Gets the first used slot at or after index
+  size_t nextUsed(size_t index) const {
+    while (index < mStates.size() && mStates[index] != SLOT_USED) {
+      ++index;
+    }
+    return index;
+  }
+
+  /// Moves all entries into a table with the given number of slots
+  void rehash(size_t capacity) {
+    std::vector<unsigned char> states(capacity, static_cast<unsigned char>(SLOT_EMPTY));
+    std::vector<value_type> values(capacity);
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < mStates.size(); ++i) {
+      if (mStates[i] == SLOT_USED) {
+        size_t slot = mValues[i].first.getId() & mask;
+        while (states[slot] != SLOT_EMPTY) {
+          slot = (slot + 1) & mask;
+        }
+        states[slot] = SLOT_USED;
+        values[slot] = mValues[i];
+      }
+    }
+    mStates.swap(states);
+    mValues.swap(values);
+    mDeleted = 0;
+  }
+
+  std::vector<unsigned char> mStates;
+  std::vector<value_type> mValues;
+  size_t mSize;
+  size_t mDeleted;
+};
+}
+
+#endif
@@ -30,6 +30,10 @@ http://www.gnu.org/copyleft/lesser.txt.
 
 #include "MyString.h"
 
+namespace base {
+class Lock;
+}
+
 namespace renderer {
 
 // LogMessageLevel + LoggingLevel > LOG_THRESHOLD = message logged
@@ -54,12 +58,17 @@ enum LogMessageLevel {
 /** Log class for writing debug/log data to files.
     @note
         <br>Should not be used directly, but trough the LogManager class.
+    @par
+        Messages may be logged from worker threads.
 */
 class _RendererExport Log {
 protected:
   std::ofstream mfpLog;
   LoggingLevel mLogLevel;
   bool mDebugOut;
+  /// Keeps messages from different threads whole; a pointer so this header
+  /// doesn't drag the platform headers in with it
+  base::Lock* mLock;
 
 public:
   /** Usual constructor - called by LogManager.
@@ -0,0 +1,75 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __MappedFile_H__
+#define __MappedFile_H__
+
+#include "Prerequisites.h"
+
+#include "base/memory/ref_counted.h"
+
+namespace renderer {
+
+/** A whole file mapped into memory.
+    @remarks
+        Used by the file system archive so that file data can be parsed in
+        place, leaving the OS page cache to do the reading, instead of
+        copying every file into a freshly allocated buffer.
+    @par
+        The mapping is private and copy-on-write, so code which modifies
+        the data it has been given still works, without touching the file.
+        It is reference counted, and unmapped when the last DataChunk
+        referring to it is cleared or destroyed; see DataChunk::map.
+*/
+class _RendererExport MappedFile : public base::RefCountedThreadSafe<MappedFile> {
+public:
+  /** Maps the named file.
+      @param path Full path of the file
+      @returns The new mapping, or 0 if the file can't be opened or is
+          empty
+  */
+  static MappedFile* open(const String& path);
+
+  /** Returns a pointer to the start of the file data. */
+  uchar* getPtr(void) const {
+    return mData;
+  }
+  /** Returns the size of the file in bytes. */
+  size_t getSize(void) const {
+    return mSize;
+  }
+
+private:
+  friend class base::RefCountedThreadSafe<MappedFile>;
+
+  MappedFile(uchar* data, size_t size) : mData(data), mSize(size) {}
+  ~MappedFile();
+
+  uchar* mData;
+  size_t mSize;
+};
+
+}
+
+#endif
@@ -31,6 +31,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "ResourceManager.h"
 #include "Material.h"
 #include "StringVector.h"
+#include "ScriptCache.h"
 
 namespace renderer {
 
@@ -54,11 +55,12 @@ typedef void (*TEXLAYER_ATTRIB_PARSER)(StringVector::iterator&, int, Material*,
     @par
         For a definition of the material script format, see the Tutorials/MaterialScript.html file.
 */
-class _RendererExport MaterialManager : public ResourceManager, public Singleton<MaterialManager> {
+class _RendererExport MaterialManager : public ResourceManager, public Singleton<MaterialManager>,
+  public ScriptCache::Compiler {
 protected:
-  void parseNewTextureLayer( DataChunk& chunk, Material* pMat );
-  void parseAttrib( const String& line, Material* pMat);
-  void parseLayerAttrib( const String& line, Material* pMat, Material::TextureLayer* pLayer );
+  void compileTextureLayer( DataChunk& chunk, ScriptNode& layer );
+  void parseAttrib( const StringVector& tokens, Material* pMat);
+  void parseLayerAttrib( const StringVector& tokens, Material* pMat, Material::TextureLayer* pLayer );
 
   /// Keyword-mapped attribute parsers.
   //typedef std::map<String, MATERIAL_ATTRIB_PARSER> MatAttribParserList;
@@ -80,6 +82,9 @@ protected:
   /// default maxAnisotropy
   int mDefAniso;
 
+  /// Compiled material scripts from previous runs
+  ScriptCache mScriptCache;
+
 public:
   /** Default constructor.
   */
@@ -113,10 +118,33 @@ public:
   */
   void parseScript(DataChunk& chunk);
 
+  /** Breaks a Material script down into tokenised lines, without creating anything.
+      @see
+          ScriptCache::Compiler
+  */
+  void compileScript(DataChunk& chunk, ScriptNodeList& nodes);
+
+  /** Creates the Materials defined by a compiled script.
+  */
+  void applyScript(const ScriptNodeList& nodes);
+
   /** Parses all material script files in resource folders & archives.
+      @remarks
+          If a script cache file has been set, scripts unchanged since the
+          last run are read from there rather than parsed again.
   */
   void parseAllSources(const String& extension = ".material");
 
+  /** Sets the file compiled material scripts are cached in between runs.
+      @remarks
+          Must be set before parseAllSources to have any effect; an empty
+          name (the default) disables the cache. The location must be
+          writable.
+  */
+  void setScriptCacheFile(const String& filename);
+  /// Gets the file compiled material scripts are cached in
+  const String& getScriptCacheFile(void) const;
+
   /** Create implementation required by ResourceManager.
   */
   Resource* create( const String& name );
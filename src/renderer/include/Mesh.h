@@ -28,6 +28,8 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Prerequisites.h"
 
 #include "Resource.h"
+#include "Common.h"
+#include "DataChunk.h"
 #include "GeometryData.h"
 #include "AxisAlignedBox.h"
 #include "VertexBoneAssignment.h"
@@ -85,6 +87,10 @@ public:
   Mesh(String name);
   ~Mesh();
 
+  /** Reads the mesh file, ready for load; safe on a worker thread.
+  */
+  virtual void prepare(void);
+
   /** Generic load - called by MeshManager.
   */
   virtual void load(void);
@@ -249,8 +255,10 @@ public:
       Internal use only.
       The array pointed to by the passed in Matrix4 pointer must have enough 'slots' for the number
       of bone matrices required (see _getNumBoneMatrices).
+      If skipMinorBones is true, bones flagged as minor stay in their binding pose.
   */
-  void _getBoneMatrices(const AnimationStateSet& animSet, Matrix4* pMatrices);
+  void _getBoneMatrices(const AnimationStateSet& animSet, Matrix4* pMatrices,
+                        bool skipMinorBones = false);
 
   /** Internal notification, used to tell the Mesh which Skeleton to use without loading it.
   @remarks
@@ -260,6 +268,73 @@ public:
   */
   void _notifySkeleton(Skeleton* pSkel);
 
+  /** Skinned vertices for one geometry buffer of this mesh. */
+  struct SkinnedGeometry {
+    /// The source geometry
+    const GeometryData* geometry;
+    /// Blended positions, packed x/y/z
+    std::vector<Real> positions;
+    /// Blended normals, packed x/y/z; empty if the geometry has none
+    std::vector<Real> normals;
+  };
+
+  /** A skinned copy of this mesh's geometry for one pose.
+  @remarks
+      Vertices are blended into model space, so every entity using the mesh
+      in the same pose (as identified by Skeleton::_getPoseHash) can share
+      one copy and apply its own world transform. Poses are reference
+      counted and owned by the Mesh.
+  */
+  struct SkinnedPose {
+    /// Pose hash this was (or is to be) skinned for
+    uint64 hash;
+    /// Number of entities using this pose
+    unsigned int refCount;
+    /// False until the vertices have been blended for this pose
+    bool skinned;
+    /// One entry per skinned geometry buffer
+    std::vector<SkinnedGeometry> geometry;
+  };
+
+  /** Swaps an entity's skinned pose for the one matching poseHash.
+  @remarks
+      Internal use only. Releases pCurrent (which may be null) and returns a
+      pose with the given hash, shared with any other entity already using
+      it. If the returned pose is not yet skinned, the caller must call
+      _skinPose on it. A pose with no other users is reused in place to
+      avoid reallocating its buffers.
+  */
+  SkinnedPose* _updateSkinnedPose(SkinnedPose* pCurrent, uint64 poseHash,
+                                  SkinningMethod method);
+
+  /** Releases a pose obtained from _updateSkinnedPose. */
+  void _releaseSkinnedPose(SkinnedPose* pPose);
+
+  /** Blends all skinned geometry of this mesh into a pose.
+  @param pPose The pose to fill in
+  @param pMatrices Bone matrices in model space, see _getBoneMatrices
+  @param pDualQuats If not null, the same bones as dual quaternions (see
+      Skeleton::_getBoneDualQuaternions); these are then blended instead of
+      the matrices
+  */
+  void _skinPose(SkinnedPose* pPose, const Matrix4* pMatrices,
+                 const Real* pDualQuats = 0);
+
+  /** Sets how vertices of this mesh are blended between bones.
+  @remarks
+      Dual quaternion skinning keeps the volume of twisting joints (elbows,
+      wrists) which linear blending collapses, but can't represent scaled
+      bones. Only applies when skinning in software; the default is
+      SKIN_LINEAR. Entities may override this, see Entity::setSkinningMethod.
+  */
+  void setSkinningMethod(SkinningMethod method);
+  /** Gets how vertices of this mesh are blended between bones. */
+  SkinningMethod getSkinningMethod(void) const;
+
+  /** Finds the skinned copy of a geometry buffer in a pose, or null. */
+  const SkinnedGeometry* _getSkinnedGeometry(const SkinnedPose* pPose,
+      const GeometryData* geometry) const;
+
   /// Multimap of vertex bone assignments (orders by vertex index)
   typedef std::multimap<unsigned short, VertexBoneAssignment> VertexBoneAssignmentList;
   typedef MapIterator<VertexBoneAssignmentList> BoneAssignmentIterator;
@@ -392,6 +467,9 @@ private:
 
   bool mManuallyDefined;
 
+  /// File contents read by prepare
+  DataChunk mPreparedData;
+
   /** Internal method used by clone().
   */
   void cloneGeometry(GeometryData& source, GeometryData& dest);
@@ -411,6 +489,12 @@ private:
   /** Must be called once to compile bone assignments into geometry buffer. */
   void compileBoneAssignments(void);
 
+  /// Skinned poses currently in use by entities, by pose hash
+  typedef std::map<uint64, SkinnedPose*> SkinnedPoseMap;
+  SkinnedPoseMap mSkinnedPoses;
+
+  SkinningMethod mSkinningMethod;
+
   bool mIsLodManual;
   ushort mNumLods;
   typedef std::vector<MeshLodUsage> MeshLodUsageList;
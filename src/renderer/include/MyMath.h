@@ -54,24 +54,10 @@ protected:
   // angle units used by the api
   static AngleUnit msAngleUnit;
 
-  /// Size of the trig tables as determined by constructor.
-  static int mTrigTableSize;
-
-  /// Radian -> index factor value ( mTrigTableSize / 2 * PI )
-  static Real mTrigTableFactor;
-  static Real* mSinTable;
-  static Real* mTanTable;
-
-  /** Private function to build trig tables.
-  */
-  void buildTrigTables();
 public:
   /** Default constructor.
-      @param
-          trigTableSize Optional parameter to set the size of the
-          tables used to implement Sin, Cos, Tan
   */
-  Math(unsigned int trigTableSize = 4096);
+  Math();
 
   /** Default destructor.
   */
@@ -86,19 +72,30 @@ public:
   static Real ACos (Real fValue);
   static Real ASin (Real fValue);
   static Real ATan (Real fValue);
-  static Real ATan2 (Real fY, Real fX);
+  /** Arc tangent of fY / fX, using the signs of both to find the quadrant.
+      @param
+          fast If true, uses the polynomial approximation rather than
+          the C runtime - faster, accurate to about 1e-7 radians.
+  */
+  static Real ATan2 (Real fY, Real fX, bool fast = false);
   static Real Ceil (Real fValue);
 
   /** Cosine function.
       @param
           fValue Angle in radians
       @param
-          useTables If true, uses lookup tables rather than
-          calculation - faster but less accurate.
+          fast If true, uses the minimax polynomial approximation rather
+          than the C runtime - faster, accurate to about 1e-7 for
+          angles up to a few thousand radians.
   */
-  static Real Cos (Real fValue, bool useTables = false);
+  static Real Cos (Real fValue, bool fast = false);
 
-  static Real Exp (Real fValue);
+  /** Exponential function.
+      @param
+          fast If true, uses the polynomial approximation rather than
+          the C runtime - faster, relative error about 1e-7.
+  */
+  static Real Exp (Real fValue, bool fast = false);
 
   static Real Floor (Real fValue);
 
@@ -112,10 +109,16 @@ public:
       @param
           fValue Angle in radians
       @param
-          useTables If true, uses lookup tables rather than
-          calculation - faster but less accurate.
+          fast If true, uses the minimax polynomial approximation rather
+          than the C runtime - faster, accurate to about 1e-7 for
+          angles up to a few thousand radians.
+  */
+  static Real Sin (Real fValue, bool fast = false);
+
+  /** Sine and cosine of the same angle, using the polynomial
+      approximation. Costs about the same as a single fast Sin.
   */
-  static Real Sin (Real fValue, bool useTables = false);
+  static void SinCos (Real fValue, Real& fSin, Real& fCos);
 
   static Real Sqr (Real fValue);
 
@@ -123,8 +126,11 @@ public:
 
   /** Inverse square root i.e. 1 / Sqrt(x), good for vector
       normalisation.
+      @param
+          fast If true, uses the hardware estimate refined by one
+          Newton-Raphson step where available.
   */
-  static Real InvSqrt(Real fValue);
+  static Real InvSqrt(Real fValue, bool fast = false);
 
   static Real UnitRandom ();  // in [0,1]
 
@@ -136,10 +142,30 @@ public:
       @param
           fValue Angle in radians
       @param
-          useTables If true, uses lookup tables rather than
-          calculation - faster but less accurate.
+          fast If true, uses the minimax polynomial approximation rather
+          than the C runtime - faster, accurate to about 1e-7 for
+          angles up to a few thousand radians.
+  */
+  static Real Tan (Real fValue, bool fast = false);
+
+  /** @name Batch forms
+      @remarks
+          These evaluate the same polynomial approximations as the 'fast'
+          scalar forms above on four values at once, using SSE where the
+          target supports it. Pointers need not be aligned, and the
+          results may alias the inputs. The SSE and plain versions give
+          the same results. Exp4 clamps its inputs to about [-87.3, 88.4],
+          so it never returns 0 or infinity.
   */
-  static Real Tan (Real fValue, bool useTables = false);
+  //@{
+  static void Sin4 (const Real* fValues, Real* fResults);
+  static void Cos4 (const Real* fValues, Real* fResults);
+  static void SinCos4 (const Real* fValues, Real* fSin, Real* fCos);
+  static void Tan4 (const Real* fValues, Real* fResults);
+  static void ATan2_4 (const Real* fY, const Real* fX, Real* fResults);
+  static void Exp4 (const Real* fValues, Real* fResults);
+  static void InvSqrt4 (const Real* fValues, Real* fResults);
+  //@}
 
   static Real DegreesToRadians(Real degrees);
   static Real RadiansToDegrees(Real radians);
@@ -85,7 +85,7 @@ protected:
   bool mInheritScale;
 
   /// Only available internally - notification of parent.
-  void setParent(Node* parent);
+  virtual void setParent(Node* parent);
 
   /** Cached combined orientation.
       @par
@@ -0,0 +1,106 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __PackFile_H__
+#define __PackFile_H__
+
+#include "Prerequisites.h"
+
+#include "ArchiveEx.h"
+#include "MappedFile.h"
+#include "PackFileFormat.h"
+
+namespace renderer {
+
+/** Archive codec for the engine's own .ipak pack files.
+    @remarks
+        Packs are built offline by the packer tool; see PackFileFormat.h
+        for the layout. Loading one just maps it and checks the header, the
+        table of contents is used where it lies, so mounting is immediate
+        however many files the pack holds. Names are not case sensitive.
+    @par
+        Nothing is changed after loading, so any number of threads can read
+        at once. Stored entries are returned without copying, so every read
+        of one shares the same memory and must not modify it. Compressed
+        entries are decompressed into a buffer of their own, spreading the
+        chunks of large ones over the WorkQueue.
+*/
+class _RendererExport PackFile : public ArchiveEx {
+public:
+  PackFile();
+  PackFile( const String& name );
+  ~PackFile();
+
+  void load();
+  void unload();
+
+  bool fileOpen( const String& strFile, FILE** ppFile ) const;
+  bool fileRead( const String& strFile, DataChunk** ppChunk ) const;
+
+  bool fileSave( FILE* pFile, const String& strPath, bool bOverwrite = false );
+  bool fileWrite( const DataChunk& refChunk, const String& strPath, bool bOverwrite = false );
+
+  bool fileDele( const String& strFile );
+  bool fileMove( const String& strSrc, const String& strDest, bool bOverwrite );
+
+  bool fileInfo( const String& strFile, FileInfo** ppInfo ) const;
+  bool fileCopy( const String& strSrc, const String& strDest, bool bOverwrite );
+
+  bool fileTest( const String& strFile ) const;
+
+  std::vector<String> dirGetFiles( const String& strDir ) const;
+  std::vector<String> dirGetSubs( const String& strDir ) const;
+
+  bool dirDele( const String& strDir, bool bRecursive );
+  bool dirMove( const String& strSrc, const String& strDest, bool bOverwrite );
+
+  bool dirInfo( const String& strDir, FileInfo** ppInfo ) const;
+  bool dirCopy( const String& strSrc, const String& strDest, bool bOverwrite );
+
+  bool dirTest( const String& strDir ) const;
+
+  std::vector<String> getAllNamesLike( const String& strStartPath, const String& strPattern, bool bRecursive=true );
+
+  bool _allowFileCaching() const {
+    return true;
+  }
+
+private:
+  /// Finds a file's entry by binary search on the hash, or returns 0
+  const PackEntry* findEntry( const String& strFile ) const;
+  /// Whether the entry's name lies within the name table
+  bool hasValidName( const PackEntry& entry ) const;
+  /// Decompresses a PACK_DEFLATED entry; returns false if it is corrupt
+  bool inflateEntry( const PackEntry& entry, uchar* pDest ) const;
+
+  scoped_refptr<MappedFile> mFile;
+  /// These all point into the mapping
+  const PackHeader* mHeader;
+  const PackEntry* mEntries;
+  const char* mNames;
+};
+
+}
+
+#endif
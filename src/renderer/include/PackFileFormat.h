@@ -0,0 +1,110 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __PackFileFormat_H__
+#define __PackFileFormat_H__
+
+#include "Prerequisites.h"
+
+namespace renderer {
+
+/** Definition of the engine .ipak pack file format
+
+    A pack holds a whole tree of resource files, laid out so it can be
+    memory mapped and used without parsing anything up front. All values are
+    little endian. The file is arranged as:
+
+        PackHeader                 : at offset 0
+        PackEntry[numEntries]      : the table of contents, straight after the
+                                     header, sorted by hash and then by name
+        char names[namesSize]      : file names, at namesOffset
+        ...                        : the file data
+
+    File names are relative to the packed directory, use '/' as the separator
+    and are lower case, so lookups are not case sensitive.
+
+    Each entry's data starts at a multiple of PACK_ALIGNMENT, or of
+    PACK_PAGE_ALIGNMENT for large stored entries, so those can be used in
+    place straight out of the mapping.
+
+    Stored entries (PACK_STORED) are the file's bytes as they are. Compressed
+    entries (PACK_DEFLATED) are split into chunks of chunkSize uncompressed
+    bytes, each compressed on its own with zlib, so any part of the file can
+    be decompressed without the rest, and the chunks in parallel. The entry
+    data starts with a table of numChunks + 1 uint64 offsets, relative to
+    the start of the entry data; chunk i runs from offset i to offset i + 1.
+*/
+const uint32 PACK_MAGIC = 0x4B415049; // "IPAK"
+const uint32 PACK_VERSION = 1;
+/// Alignment of all entry data
+const size_t PACK_ALIGNMENT = 16;
+/// Alignment of stored entries of at least PACK_PAGE_ALIGN_SIZE bytes
+const size_t PACK_PAGE_ALIGNMENT = 4096;
+const size_t PACK_PAGE_ALIGN_SIZE = 64 * 1024;
+
+enum PackMethod {
+  PACK_STORED = 0,
+  PACK_DEFLATED = 1
+};
+
+struct PackHeader {
+  uint32 magic;
+  uint32 version;
+  uint32 numEntries;
+  /// Uncompressed size of each chunk of a compressed entry
+  uint32 chunkSize;
+  uint64 namesOffset;
+  uint64 namesSize;
+};
+
+struct PackEntry {
+  /// packNameHash of the name
+  uint32 hash;
+  /// Of the name, relative to namesOffset; names are not null terminated
+  uint32 nameOffset;
+  uint32 nameLength;
+  /// One of PackMethod
+  uint32 method;
+  /// Of the entry data, from the start of the file
+  uint64 offset;
+  /// Of the entry data in the pack, including any chunk table
+  uint64 size;
+  uint64 uncompressedSize;
+  /// time_t of the source file
+  uint64 lastModified;
+};
+
+/** Hashes a (lower case) name for the table of contents; 32 bit FNV-1a. */
+inline uint32 packNameHash(const char* name, size_t length) {
+  uint32 h = 2166136261U;
+  for (size_t i = 0; i < length; ++i) {
+    h ^= static_cast<uchar>(name[i]);
+    h *= 16777619U;
+  }
+  return h;
+}
+
+}
+
+#endif
@@ -40,9 +40,11 @@ public:
   // Current direction: now derived
   /// Time to live, number of seconds left of particles natural life
   Real mTimeToLive;
+  /// Rotation in radians around the view axis
+  Real mRotation;
 
   Particle()
-    : mTimeToLive(10) {
+    : mTimeToLive(10), mRotation(0) {
   }
 
 
@@ -28,6 +28,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Prerequisites.h"
 #include "MyString.h"
 #include "StringInterface.h"
+#include "ParticleData.h"
 
 
 namespace renderer {
@@ -82,6 +83,38 @@ public:
       timeElapsed The number of seconds which have elapsed since the last call.
   */
   virtual void _affectParticles(ParticleSystem* pSystem, Real timeElapsed) = 0;
+
+  /** Returns true if this affector implements _affectParticleBatch.
+  @remarks
+      The system runs batch affectors itself, on blocks of particles small
+      enough to stay in the cache: every batch affector in a row is applied
+      to a block before moving on to the next, so the particle data is read
+      from memory once for all of them rather than once per affector.
+      _affectParticles is not called on batch affectors by the system.
+  @par
+      The blocks of large systems are processed on several threads at
+      once, so _affectParticleBatch must not change anything but the
+      particles in the batch it is given.
+  */
+  virtual bool isBatched(void) const {
+    return false;
+  }
+
+  /** Applies the affector to a block of particles.
+  @remarks
+      Only called if isBatched returns true. The affector must only touch
+      the particles in the batch, and must not depend on particles outside
+      it, since the rest of the system may not have been affected yet.
+  @param
+      pSystem Pointer to the ParticleSystem the particles belong to.
+  @param
+      batch The attribute arrays of the particles to affect.
+  @param
+      timeElapsed The number of seconds which have elapsed since the last call.
+  */
+  virtual void _affectParticleBatch(ParticleSystem* pSystem,
+                                    const ParticleData::Batch& batch, Real timeElapsed) {
+  }
   /** Returns the name of the type of affector.
   @remarks
       This property is useful for determining the type of affector procedurally so another
@@ -0,0 +1,162 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __ParticleData_H__
+#define __ParticleData_H__
+
+#include "Prerequisites.h"
+
+#include "Vector3.h"
+#include "ColourValue.h"
+
+namespace renderer {
+
+/** Structure-of-arrays storage for the live particles of a ParticleSystem.
+    @remarks
+        Every particle attribute is kept in an array of its own, and the
+        live particles are always packed into the first size() slots of
+        those arrays. Expiring a particle moves the last live particle into
+        its slot (so particle order is not stable), emitting one writes the
+        next free slot. Nothing is allocated while the system runs; the
+        arrays are only resized when the quota grows.
+    @par
+        Affectors should loop over the arrays directly, e.g.
+        getDirections()[i] for i in [0, size()), which touches only the
+        data they actually use. The per-particle Particle view given by
+        ParticleIterator still works, but copies each particle in and out.
+*/
+class _RendererExport ParticleData {
+public:
+  /** The attribute arrays of a contiguous range of particles.
+      @remarks
+          Each pointer points at the first particle of the range; all of
+          them are valid for count elements.
+  */
+  struct Batch {
+    size_t count;
+    Vector3* positions;
+    Vector3* directions;
+    ColourValue* colours;
+    Real* timeToLive;
+    Real* widths;
+    Real* heights;
+    unsigned char* ownDimensions;
+    Real* rotations;
+  };
+
+  ParticleData();
+
+  /** Returns the number of live particles. */
+  size_t size(void) const {
+    return mSize;
+  }
+  /** Returns true if there are no live particles. */
+  bool empty(void) const {
+    return mSize == 0;
+  }
+  /** Returns the maximum number of live particles (the quota). */
+  size_t getCapacity(void) const {
+    return mCapacity;
+  }
+  /** Grows the arrays so they can hold the given number of particles.
+      @remarks
+          Never shrinks. Pointers previously returned by the array
+          accessors are invalidated if the capacity changes.
+  */
+  void reserve(size_t capacity);
+
+  /** Adds a particle with the attributes of the one given.
+      @returns The index of the new particle
+  */
+  size_t append(const Particle& p);
+  /** Removes a particle by moving the last live particle into its slot.
+      @remarks
+          When looping over the particles and removing some, don't move on
+          to the next index after a removal: the slot now holds the
+          particle which used to be last.
+  */
+  void swapRemove(size_t index);
+  /** Removes all particles. */
+  void clear(void);
+
+  /** Gets the arrays of the particles [start, start + count). */
+  Batch getBatch(size_t start, size_t count);
+
+  /** Copies the attributes of a particle into a Particle. */
+  void _readParticle(size_t index, Particle* p) const;
+  /** Copies the attributes of a Particle into a particle. */
+  void _writeParticle(size_t index, const Particle& p);
+
+  /// World space positions
+  Vector3* getPositions(void) {
+    return mCapacity ? &mPositions[0] : 0;
+  }
+  /// World space directions (velocity, in units per second)
+  Vector3* getDirections(void) {
+    return mCapacity ? &mDirections[0] : 0;
+  }
+  /// Colours
+  ColourValue* getColours(void) {
+    return mCapacity ? &mColours[0] : 0;
+  }
+  /// Seconds left to live
+  Real* getTimeToLive(void) {
+    return mCapacity ? &mTimeToLive[0] : 0;
+  }
+  /// Own widths, only valid where getOwnDimensions() is non-zero
+  Real* getWidths(void) {
+    return mCapacity ? &mWidths[0] : 0;
+  }
+  /// Own heights, only valid where getOwnDimensions() is non-zero
+  Real* getHeights(void) {
+    return mCapacity ? &mHeights[0] : 0;
+  }
+  /** Non-zero where a particle has its own size rather than the default
+      size of the system. Affectors setting widths or heights must set
+      this too.
+  */
+  unsigned char* getOwnDimensions(void) {
+    return mCapacity ? &mOwnDimensions[0] : 0;
+  }
+  /// Rotations in radians around the view axis
+  Real* getRotations(void) {
+    return mCapacity ? &mRotations[0] : 0;
+  }
+
+protected:
+  size_t mSize;
+  size_t mCapacity;
+
+  std::vector<Vector3> mPositions;
+  std::vector<Vector3> mDirections;
+  std::vector<ColourValue> mColours;
+  std::vector<Real> mTimeToLive;
+  std::vector<Real> mWidths;
+  std::vector<Real> mHeights;
+  std::vector<unsigned char> mOwnDimensions;
+  std::vector<Real> mRotations;
+};
+}
+
+#endif
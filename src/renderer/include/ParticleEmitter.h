@@ -126,6 +126,9 @@ protected:
   /// Repeat delay left
   Real mRepeatDelayRemain;
 
+  /// Fraction of a particle carried over between constant rate emissions
+  Real mEmissionRemainder;
+
 
 
   // NB Method below here are to help out people implementing emitters by providing the
@@ -26,23 +26,38 @@ http://www.gnu.org/copyleft/lesser.txt.
 #define __ParticleIterator_H__
 
 #include "Prerequisites.h"
+#include "Particle.h"
 
 namespace renderer {
 
 
 /** Convenience class to make it easy to step through all particles in a ParticleSystem.
+@remarks
+    Particles are stored as arrays of attributes (see ParticleData), so
+    getNext copies the particle into a Particle held by the iterator, and
+    any changes are copied back when the iterator moves on, reaches the
+    end or is destroyed. Affectors which care about speed should use the
+    arrays from ParticleSystem::_getParticleData instead.
 */
 class _RendererExport ParticleIterator {
   friend class ParticleSystem;
 protected:
-  std::list<Billboard*>::iterator mPos;
-  std::list<Billboard*>::iterator mStart;
-  std::list<Billboard*>::iterator mEnd;
+  ParticleData* mData;
+  size_t mPos;
+  /// Index of the particle copied into mCurrent, or mPos if there is none
+  size_t mLoaded;
+  /// Copy of the particle returned by the last getNext
+  Particle mCurrent;
 
   /// Protected constructor, only available from ParticleSystem::getIterator
-  ParticleIterator(std::list<Billboard*>::iterator start, std::list<Billboard*>::iterator end);
+  ParticleIterator(ParticleData* data, BillboardSet* owner);
+
+  /// Copies mCurrent back into the particle it came from
+  void flush(void);
 
 public:
+  ~ParticleIterator();
+
   // Returns true when at the end of the particle list
   bool end(void);
 
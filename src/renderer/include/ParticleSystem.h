@@ -32,6 +32,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "MyString.h"
 #include "AxisAlignedBox.h"
 #include "ParticleIterator.h"
+#include "ParticleData.h"
 #include "StringInterface.h"
 
 namespace renderer {
@@ -71,6 +72,12 @@ public:
     String doGet(void* target);
     void doSet(void* target, const String& val);
   };
+  /** Command object for sorted (see ParamCommand).*/
+  class CmdSorted : public ParamCommand {
+  public:
+    String doGet(void* target);
+    void doSet(void* target, const String& val);
+  };
   /** Command object for particle_width (see ParamCommand).*/
   class CmdWidth : public ParamCommand {
   public:
@@ -95,6 +102,12 @@ public:
     String doGet(void* target);
     void doSet(void* target, const String& val);
   };
+  /** Command object for lod_transition_time (see ParamCommand).*/
+  class CmdLodTransitionTime : public ParamCommand {
+  public:
+    String doGet(void* target);
+    void doSet(void* target, const String& val);
+  };
 
   /// Default constructor required for STL creation in manager
   ParticleSystem();
@@ -196,6 +209,9 @@ public:
   */
   unsigned int getNumParticles(void) const;
 
+  /** Overridden from BillboardSet, returns the number of particles. */
+  int getNumBillboards(void) const;
+
   /** Returns the maximum number of particles this system is allowed to have active at once.
   @remarks
       See ParticleSystem::setParticleQuota for more info.
@@ -214,6 +230,9 @@ public:
   */
   void setParticleQuota(unsigned int quota);
 
+  /** Overridden from BillboardSet, returns the particle quota. */
+  unsigned int getPoolSize(void) const;
+
 
   /** Assignment operator for copying.
   @remarks
@@ -230,6 +249,59 @@ public:
   */
   void _update(Real timeElapsed);
 
+  /** Updates the particles in the system, without notifying the parent node.
+  @remarks
+      This is _update minus telling the parent node that the bounds have
+      changed, which is the only part touching anything outside the
+      system; different systems can be updated by this on different
+      threads at once. The caller must call needUpdate on the parent node
+      afterwards.
+  @param
+      parentOrientation, parentPosition The derived transform of the parent
+      node. Deriving it may update the node from its parents, which isn't
+      safe off the main thread, so the caller gets it beforehand.
+  */
+  void _updateParticles(Real timeElapsed, const Quaternion& parentOrientation,
+                        const Vector3& parentPosition);
+
+  /** Applies the batch affectors [firstAffector, endAffector) to the particles [start, end).
+  @remarks
+      Internal method; start must be a multiple of AFFECTOR_BLOCK_SIZE.
+      Different ranges may be processed on different threads at once.
+  @param
+      applyMotion If true the particles are moved after the affectors are applied.
+  */
+  void _affectParticleRange(size_t start, size_t end,
+                            size_t firstAffector, size_t endAffector,
+                            bool applyMotion, Real timeElapsed);
+
+  /** Returns the number of the last frame in which the system was seen by a camera.
+  @see
+      Root::getCurrentFrameNumber
+  */
+  unsigned long _getLastVisibleFrame(void) const;
+
+  /** Returns true if the system is asleep, i.e. not being updated because it can't be seen. */
+  bool isAsleep(void) const;
+
+  /** Skips a frame's update because the system is not being seen.
+  @remarks
+      Called by the ParticleSystemManager instead of _update. The time is
+      added up, and caught up on by _wake when the system is seen again.
+  */
+  void _sleep(Real timeElapsed);
+
+  /** Wakes the system up, catching up on the time it was asleep.
+  @remarks
+      Called when an asleep system is seen by a camera. The system is
+      fast-forwarded by the time it slept, in steps of
+      ParticleSystemManager::getCatchUpInterval. If it slept for longer
+      than ParticleSystemManager::getMaxCatchUpTime, the particles are
+      thrown away and the system is re-seeded by fast-forwarding it by
+      the maximum catch up time instead.
+  */
+  void _wake(void);
+
   /** Returns an iterator for stepping through all particles in this system.
   @remarks
       This method is designed to be used by people providing new ParticleAffector subclasses,
@@ -238,6 +310,23 @@ public:
   */
   ParticleIterator _getIterator(void);
 
+  /** Returns the arrays holding the attributes of every live particle.
+  @remarks
+      This is the fast way for ParticleAffector subclasses to modify
+      particles: loop over the index range [0, size()) of the arrays
+      they need. Particles must not be added or removed by affectors.
+  */
+  ParticleData& _getParticleData(void);
+
+  /** Overridden from BillboardSet to build the vertices from the particle arrays
+  */
+  void _notifyCurrentCamera(Camera* cam);
+
+  /** Overridden from MovableObject to count the system as seen when attached,
+      so that it isn't put to sleep before a camera has had a chance to see it
+  */
+  void _notifyAttached(Node* parent);
+
   /** Overridden from MovableObject
       @see
           MovableObject
@@ -248,6 +337,9 @@ public:
   */
   void _updateBounds(void);
 
+  /// Number of particles in a block processed by the batch affectors
+  enum { AFFECTOR_BLOCK_SIZE = 256 };
+
   /** Fast-forwards this system by the required number of seconds.
   @remarks
       This method allows you to fast-forward a system so that it effectively looks like
@@ -261,16 +353,60 @@ public:
       is the more realistic the fast-forward, but it takes more iterations to do it.
   */
   void fastForward(Real time, Real interval = 0.1);
+
+  /// Affector mask of a LOD level which keeps all the affectors
+  static const unsigned int ALL_AFFECTORS = 0xFFFFFFFF;
+
+  /** Adds a level of detail, used from the given distance from the camera on.
+  @remarks
+      A system far away costs as much to update as one right in front of the
+      camera, though it covers far fewer pixels. Beyond fromDepth this system
+      emits fewer particles, may have fewer particles at once and may leave
+      out some of its affectors. Changes of emission rate and size are
+      blended in over the LOD transition time, and particles over a lowered
+      quota die off naturally, so switching levels does not pop.
+  @par
+      The distance is adjusted by the LOD bias of the camera, as for mesh LOD.
+      The level is chosen in _notifyCurrentCamera and used by the next update.
+  @param fromDepth Distance from the camera at which this level starts
+  @param emissionScale Multiplier applied to the emission rate of every emitter, 0 to 1
+  @param quota Maximum number of particles at this level, 0 to keep the system quota
+  @param affectorMask Bit n set keeps affector n; affectors from index 32 on are always kept
+  @param sizeCompensation If true particles are made bigger as fewer are emitted,
+      so the effect still covers about the same area
+  */
+  void addLodLevel(Real fromDepth, Real emissionScale, unsigned int quota = 0,
+                   unsigned int affectorMask = ALL_AFFECTORS,
+                   bool sizeCompensation = false);
+
+  /** Returns the number of LOD levels of this system. */
+  unsigned short getNumLodLevels(void) const;
+
+  /** Removes all the LOD levels, so the system is at full detail at any distance. */
+  void removeAllLodLevels(void);
+
+  /** Sets the time over which emission rate and size changes are blended in
+      when the LOD level changes. The default is 1 second. */
+  void setLodTransitionTime(Real seconds);
+
+  /** Gets the time over which LOD changes are blended in. */
+  Real getLodTransitionTime(void) const;
+
+  /** Returns the index of the LOD level in use, or -1 for full detail. */
+  int _getLodIndex(void) const;
+
 protected:
 
   /// Command objects
   static CmdCull msCullCmd;
+  static CmdSorted msSortedCmd;
   static CmdHeight msHeightCmd;
   static CmdMaterial msMaterialCmd;
   static CmdQuota msQuotaCmd;
   static CmdWidth msWidthCmd;
   static CmdBillboardType msBillboardTypeCmd;
   static CmdCommonDirection msCommonDirectionCmd;
+  static CmdLodTransitionTime msLodTransitionTimeCmd;
 
 
   /// Name of the particle system instance
@@ -284,29 +420,77 @@ protected:
   /// List of particle affectors, ie modifiers of particles
   ParticleAffectorList mAffectors;
 
+  /// The live particles
+  ParticleData mParticles;
+
+  /// Number of particles requested by each emitter, reused every update
+  std::vector<unsigned> mRequested;
+
+  /// Frame number the system was last seen in, or created or attached in
+  unsigned long mLastVisibleFrame;
+  /// True while the system is not being updated because it can't be seen
+  bool mAsleep;
+  /// Time which has passed while asleep
+  Real mSleepTime;
+
+  /// A level of detail, see addLodLevel
+  struct LodLevel {
+    Real fromDepthSquared;
+    Real emissionScale;
+    unsigned int quota;
+    unsigned int affectorMask;
+    bool sizeCompensation;
+  };
+  typedef std::vector<LodLevel> LodLevelList;
+  /// LOD levels, nearest first
+  LodLevelList mLodLevels;
+  /// Index of the LOD level in use or -1 for full detail, calculated by _notifyCurrentCamera
+  int mLodIndex;
+  /// Time over which LOD changes are blended in
+  Real mLodTransitionTime;
+  /// Emission rate multiplier, moving towards that of the current level
+  Real mLodEmissionScale;
+  /// Particle size multiplier, moving towards that of the current level
+  Real mLodSizeScale;
+  /// Fractions of particles left over from scaling the emission, per emitter
+  std::vector<Real> mLodEmissionRemainders;
+
+  /** Blends the LOD emission and size scales towards the current level. */
+  void _updateLod(Real timeElapsed);
+
+  /** Returns true if the affector with the given index is used at the current LOD level. */
+  bool isAffectorActive(size_t index) const;
+
   /** Internal method used to expire dead particles. */
   void _expire(Real timeElapsed);
 
   /** Spawn new particles based on free quota and emitter requirements. */
-  void _triggerEmitters(Real timeElapsed);
+  void _triggerEmitters(Real timeElapsed, const Quaternion& parentOrientation,
+                        const Vector3& parentPosition);
 
-  /** Updates existing particle based on their momentum. */
-  void _applyMotion(Real timeElapsed);
+  /** Updates a block of particles based on their momentum. */
+  void _applyMotion(const ParticleData::Batch& batch, Real timeElapsed);
 
-  /** Applies the effects of affectors. */
+  /** Applies the effects of affectors, then moves the particles.
+  @remarks
+      Runs of batch affectors are applied block by block, and motion is
+      applied in the same pass as the last run, so each block is only
+      pulled into the cache once for all of them. The blocks of large
+      systems are shared out over the WorkQueue.
+  */
   void _triggerAffectors(Real timeElapsed);
 
-  /** Overridden from BillboardSet to create Particle instead of Billboard */
-  void increasePool(unsigned int size);
+  /** Works out the bounds of the particles, in parent node space. */
+  void _calculateBounds(const Quaternion& parentOrientation, const Vector3& parentPosition);
 
-  /** Internal method for adding a new active particle.*/
-  Particle* addParticle(void);
+  /** Overridden from BillboardSet to grow the particle arrays instead of creating Billboards */
+  void increasePool(unsigned int size);
 
   /** Overidden from BillboardSet
       @see
           BillboardSet
   */
-  void genBillboardAxes(Camera& cam, Vector3* pX, Vector3 *pY, const Billboard* pBill = 0);
+  void genBillboardAxes(Camera& cam, Vector3* pX, Vector3 *pY, const Vector3* pDirection = 0);
 
   /** Internal method for initialising string interface. */
   void initParameters(void);
@@ -28,6 +28,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 
 #include "Prerequisites.h"
 #include "ParticleSystem.h"
+#include "ScriptCache.h"
 
 namespace renderer {
 
@@ -49,7 +50,8 @@ namespace renderer {
     describing named particle system templates. Instances of particle systems using these templates can
     then be created easily through the createParticleSystem method.
 */
-class _RendererExport ParticleSystemManager: public Singleton<ParticleSystemManager>{//, public FrameListener {
+class _RendererExport ParticleSystemManager: public Singleton<ParticleSystemManager>,
+  public ScriptCache::Compiler {//, public FrameListener {
 protected:
   typedef std::map<String, ParticleSystem> ParticleTemplateMap;
   /// Templates based on scripts
@@ -70,16 +72,34 @@ protected:
   /// Controls time
   Real mTimeFactor;
 
+  /// Frames a system must go unseen before it is put to sleep (0 = never)
+  unsigned int mSleepFrames;
+  /// Longest sleep a waking system replays; beyond this it is re-seeded
+  Real mMaxCatchUpTime;
+  /// Step used when catching up
+  Real mCatchUpInterval;
+
+  /// Systems to update this frame, reused every frame
+  std::vector<ParticleSystem*> mAwakeSystems;
+
+  /// Compiled particle scripts from previous runs
+  ScriptCache mScriptCache;
+
+  /** Internal script compiling method; reads the lines of a block, splitting
+      each at most maxSplit times (0 for no limit). */
+  void compileBlock(DataChunk& chunk, ScriptNode& node, unsigned int maxSplit);
+  /** Internal script parsing method. */
+  void parseNewEmitter(const ScriptNode& node, ParticleSystem* sys);
   /** Internal script parsing method. */
-  void parseNewEmitter(const String& type, DataChunk& chunk, ParticleSystem* sys);
+  void parseNewAffector(const ScriptNode& node, ParticleSystem* sys);
   /** Internal script parsing method. */
-  void parseNewAffector(const String& type, DataChunk& chunk, ParticleSystem* sys);
+  void parseNewLodLevel(const ScriptNode& node, ParticleSystem* sys);
   /** Internal script parsing method. */
-  void parseAttrib(const String& line, ParticleSystem* sys);
+  void parseAttrib(const StringVector& tokens, ParticleSystem* sys);
   /** Internal script parsing method. */
-  void parseEmitterAttrib(const String& line, ParticleEmitter* sys);
+  void parseEmitterAttrib(const StringVector& tokens, ParticleEmitter* sys);
   /** Internal script parsing method. */
-  void parseAffectorAttrib(const String& line, ParticleAffector* sys);
+  void parseAffectorAttrib(const StringVector& tokens, ParticleAffector* sys);
   /** Internal script parsing method. */
   void skipToNextCloseBrace(DataChunk& chunk);
   /** Internal script parsing method. */
@@ -268,7 +288,13 @@ public:
   */
   void _destroyAffector(ParticleAffector* affector);
 
-  /** Frame event */
+  /** Frame event.
+  @remarks
+      Updates every particle system which has been seen in the last
+      getSleepFrames frames; the others are put to sleep (see
+      ParticleSystem::_sleep). The systems are updated in parallel on the
+      WorkQueue, one task per system.
+  */
   bool RunFrame(Real t);
 
   /** Frame event */
@@ -297,10 +323,33 @@ public:
   */
   void parseScript(DataChunk& chunk);
 
+  /** Breaks a particle system script down into tokenised lines, without creating anything.
+      @see
+          ScriptCache::Compiler
+  */
+  void compileScript(DataChunk& chunk, ScriptNodeList& nodes);
+
+  /** Creates the particle system templates defined by a compiled script.
+  */
+  void applyScript(const ScriptNodeList& nodes);
+
   /** Parses all particle system script files in resource folders & archives.
+      @remarks
+          If a script cache file has been set, scripts unchanged since the
+          last run are read from there rather than parsed again.
   */
   void parseAllSources(const String& extension = ".particle");
 
+  /** Sets the file compiled particle scripts are cached in between runs.
+      @remarks
+          Must be set before the manager is initialised to have any effect;
+          an empty name (the default) disables the cache. The location must
+          be writable.
+  */
+  void setScriptCacheFile(const String& filename);
+  /// Gets the file compiled particle scripts are cached in
+  const String& getScriptCacheFile(void) const;
+
   /** Return relative speed of time as perceived by particle systems.
       @remarks
           See setTimeFactor for full information on the meaning of this value.
@@ -317,6 +366,36 @@ public:
   */
   void setTimeFactor(Real tf);
 
+  /** Sets how many frames a particle system can go unseen before it is put to sleep.
+      @remarks
+          Asleep systems are not updated; when one is seen again it catches
+          up on the time it slept, see setMaxCatchUpTime. 0 means systems
+          never sleep. The default is 30.
+  */
+  void setSleepFrames(unsigned int frames);
+
+  /** Gets how many frames a particle system can go unseen before it is put to sleep. */
+  unsigned int getSleepFrames(void) const;
+
+  /** Sets the longest time a waking particle system catches up on.
+      @remarks
+          A system which slept for up to this long is fast-forwarded by the
+          time it slept. One which slept for longer is emptied and
+          fast-forwarded by this time instead, which is cheaper and looks
+          the same for any system whose particles live shorter than this.
+          The default is 2 seconds.
+  */
+  void setMaxCatchUpTime(Real time);
+
+  /** Gets the longest time a waking particle system catches up on. */
+  Real getMaxCatchUpTime(void) const;
+
+  /** Sets the step used when a waking particle system catches up (default 0.1 seconds). */
+  void setCatchUpInterval(Real interval);
+
+  /** Gets the step used when a waking particle system catches up. */
+  Real getCatchUpInterval(void) const;
+
 };
 
 }
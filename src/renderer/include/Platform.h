@@ -78,6 +78,17 @@ http://www.gnu.org/copyleft/lesser.txt.
 #   define FORCEINLINE __inline
 #endif
 
+/* Finds whether SSE2 intrinsics can be used. They only apply to single
+   precision Reals.
+*/
+#if OGRE_USE_SSE == 1 && OGRE_DOUBLE_PRECISION == 0 && \
+    ( defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) || \
+      defined( __SSE2__ ) )
+#   define OGRE_HAVE_SSE 1
+#else
+#   define OGRE_HAVE_SSE 0
+#endif
+
 /* Finds the current platform */
 
 #if defined( __WIN32__ ) || defined( _WIN32 )
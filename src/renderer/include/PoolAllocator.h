@@ -0,0 +1,93 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __PoolAllocator_H__
+#define __PoolAllocator_H__
+
+#include "Prerequisites.h"
+#include "AllocatorPolicy.h"
+
+#include "base/synchronization/lock.h"
+
+namespace renderer {
+
+/** An AllocatorPolicy handing out fixed size blocks from large slabs.
+    @remarks
+        Memory is taken from the heap a slab of many blocks at a time, and
+        freed blocks go on a free list to be handed out again, so creating
+        and destroying objects doesn't fragment the heap, and objects
+        created together end up next to each other in memory. Slabs are
+        only returned to the heap when the pool is destroyed.
+    @par
+        Requests larger than the block size, such as those for a subclass
+        with extra members, are passed on to the heap.
+    @par
+        A pool created thread safe takes a lock on every call; otherwise it
+        must only be used from one thread at a time.
+*/
+class _RendererExport PoolAllocator : public AllocatorPolicy {
+public:
+  /** Constructor.
+      @param blockSize Size of the blocks handed out; rounded up to a
+          multiple of 16 so blocks stay aligned.
+      @param blocksPerSlab Number of blocks taken from the heap at once
+      @param threadSafe Whether to lock around each call
+  */
+  PoolAllocator(size_t blockSize, size_t blocksPerSlab = 256, bool threadSafe = true);
+  /** Frees all the slabs; any blocks still in use become invalid. */
+  ~PoolAllocator();
+
+  /** See AllocatorPolicy. */
+  void* allocate(size_t size);
+  /** See AllocatorPolicy. */
+  void deallocate(void* p, size_t size);
+
+  /** Gets the size of the blocks. */
+  size_t getBlockSize(void) const;
+  /** Gets the number of blocks in use. */
+  size_t getNumAllocated(void) const;
+  /** Gets the number of bytes taken from the heap for slabs. */
+  size_t getReservedSize(void) const;
+
+protected:
+  /// Overlays the first bytes of a free block
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  /// Takes another slab from the heap and puts its blocks on the free list
+  void addSlab(void);
+
+  size_t mBlockSize;
+  size_t mBlocksPerSlab;
+  bool mThreadSafe;
+  FreeBlock* mFreeList;
+  std::vector<char*> mSlabs;
+  size_t mNumAllocated;
+  /// Mutable so the getters can take it too
+  mutable base::Lock mLock;
+};
+}
+
+#endif
@@ -120,13 +120,18 @@ class AnimationState;
 class ArchiveEx;
 class ArchiveManager;
 class ArchiveFactory;
+class AllocatorPolicy;
 class AxisAlignedBox;
+class BakedAnimation;
+class BakedAnimationManager;
 class Billboard;
 class BillboardSet;
 class Bone;
 class Camera;
+class ClassAllocator;
 class Codec;
 class ColourValue;
+class CompressedKeyFrames;
 class ControllerManager;
 class Controller;
 class Cursor;
@@ -142,6 +147,7 @@ class ListSelectionEvent;
 class ListSelectionListener;
 class ListSelectionTarget;
 class LogManager;
+class MappedFile;
 class Material;
 class MaterialManager;
 class Math;
@@ -155,10 +161,12 @@ class Node;
 class Particle;
 class ParticleAffector;
 class ParticleAffectorFactory;
+class ParticleData;
 class ParticleEmitter;
 class ParticleEmitterFactory;
 class ParticleSystem;
 class ParticleSystemManager;
+class PoolAllocator;
 class Plane;
 class Quaternion;
 class Ray;
@@ -172,25 +180,31 @@ class RenderTarget;
 class RenderTargetListener;
 class RenderWindow;
 class Resource;
+class ResourceBackgroundQueue;
 class ResourceManager;
 class SceneManager;
 class SceneManagerEnumerator;
 class SceneNode;
+class ScriptCache;
 class SDDataChunk;
 class SimpleRenderable;
 class Skeleton;
 class SkeletonManager;
 class Sphere;
 //class String;
+class StringId;
 class StringInterface;
 class SubEntity;
 class SubMesh;
 class TagPoint;
 class Timer;
+class TransformStore;
 class UserDefinedObject;
 class Vector3;
+class VertexInfluenceStream;
 class Viewport;
 class WireBoundingBox;
+class WorkQueue;
 struct GeometryData;
 }
 
@@ -167,6 +167,11 @@ public:
   */
   VertexBlendData* pBlendingWeights;
 
+  /** Optional compacted copy of pBlendingWeights; if present, software
+      vertex blending uses this instead.
+  */
+  const VertexInfluenceStream* pInfluences;
+
   /** Pointer to a list of vertex indexes describing faces (only used if useIndexes is true).
       @note
           Each group of 3 describes a face (anticlockwise winding order).
@@ -195,6 +200,7 @@ public:
     pDiffuseColour = 0;
     pSpecularColour = 0;
     pBlendingWeights = 0;
+    pInfluences = 0;
   }
 };
 
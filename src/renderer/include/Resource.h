@@ -46,13 +46,27 @@ namespace renderer {
             This constructor must set mName and optionally mSize.
             2. The load() and unload() methods - mSize must be set after load()
             Each must check & update the mIsLoaded flag.
+    @par
+        A resource which is loaded, not in use and has a non-zero priority
+        may be unloaded by its manager when over budget (paged out), and is
+        loaded again when next retrieved from the manager. Objects which
+        keep a pointer to a resource rather than looking it up by name each
+        time must hold a reference to it while they do.
 */
 class _RendererExport Resource {
+  friend class ResourceManager;
 protected:
   String mName;
   bool   mIsLoaded;
-  time_t mLastAccess;
+  /// Frame number of the last use
+  unsigned long mLastAccess;
   size_t mSize;
+  /// Paging priority; lower is paged out first, 0 never
+  int mPriority;
+  /// Number of objects holding a pointer to this resource
+  unsigned int mRefCount;
+  /// True if unloaded by the manager to stay within budget
+  bool mIsPagedOut;
 
 public:
   /** Basic constructor.
@@ -60,7 +74,8 @@ public:
           Subclasses must init mName and mSize!
   */
   Resource()
-    : mIsLoaded( false ), mSize( 0 ) {
+    : mIsLoaded( false ), mLastAccess( 0 ), mSize( 0 ), mPriority( 1 ),
+      mRefCount( 0 ), mIsPagedOut( false ) {
   }
 
   /** Virtual destructor. Shouldn't need to be overloaded, as the resource
@@ -73,6 +88,14 @@ public:
       unload();
   }
 
+  /** Does the part of loading which needs neither the render system nor
+      any manager's lists, such as reading and decoding files.
+      @remarks
+          May be called on a worker thread before load, which then uses
+          whatever was prepared. The default does nothing.
+  */
+  virtual void prepare() {}
+
   /** Loads the resource, if it is not already.
   */
   virtual void load() = 0;
@@ -88,17 +111,58 @@ public:
   }
 
   /** 'Touches' the resource to indicate it has been used.
+      @remarks
+          A resource touched during the current frame is never paged out.
   */
-  void touch(void) {
-    mLastAccess = time(NULL);
-  }
+  void touch(void);
 
-  /** Gets the last time the resource was 'touched'.
+  /** Gets the frame number the resource was last 'touched' in.
   */
-  time_t getLastAccess(void) const {
+  unsigned long getLastAccess(void) const {
     return mLastAccess;
   }
 
+  /** Gets the paging priority of the resource.
+      @remarks
+          Resources of lower priority are paged out first. A priority of 0
+          or less means the resource is never paged out, for resources which
+          can't simply be loaded again.
+  */
+  int getPriority(void) const {
+    return mPriority;
+  }
+
+  /** Sets the paging priority of the resource; normally passed to ResourceManager::load.
+  */
+  void setPriority(int priority) {
+    mPriority = priority;
+  }
+
+  /** Notes that an object is holding a pointer to this resource, which
+      stops it being paged out until the matching removeReference.
+  */
+  void addReference(void) {
+    ++mRefCount;
+  }
+
+  /** Releases a reference added with addReference.
+  */
+  void removeReference(void) {
+    assert(mRefCount > 0 && "Resource reference count underflow");
+    --mRefCount;
+  }
+
+  /** Returns true if the resource is referenced or has been touched this frame.
+  */
+  bool isInUse(void) const;
+
+  /** Returns true if the resource has been unloaded to stay within a
+      memory budget, and will be loaded again when next retrieved.
+  */
+  bool isPagedOut(void) const {
+    return mIsPagedOut;
+  }
+
   /** Gets resource name.
   */
   const String& getName(void) const {
@@ -0,0 +1,166 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __ResourceBackgroundQueue_H__
+#define __ResourceBackgroundQueue_H__
+
+#include "Prerequisites.h"
+#include "Singleton.h"
+#include "WorkQueue.h"
+
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+
+namespace renderer {
+
+/** Loads resources in the background.
+    @remarks
+        Reading and decoding resource files (Resource::prepare) is done on
+        the WorkQueue, as background tasks. Whatever is left, like uploading
+        a texture to the render system and adding the resource to its
+        manager, is done on the main thread by _processCompleted, which
+        Root calls once a frame; listeners are told about completed
+        requests from there too.
+    @par
+        Requests of higher priority are started first. The priority is
+        also passed on to ResourceManager::load, so it decides how readily
+        the resource is paged out later as well.
+*/
+class _RendererExport ResourceBackgroundQueue : public Singleton<ResourceBackgroundQueue> {
+public:
+  /// Identifies a request
+  typedef unsigned long Ticket;
+
+  /** Receives notice of completed requests. */
+  class _RendererExport Listener {
+  public:
+    virtual ~Listener() {}
+    /** Called on the main thread once a request is done.
+        @param ticket The ticket returned when the request was made
+        @param resource The loaded resource, or 0 if loading failed
+    */
+    virtual void operationCompleted(Ticket ticket, Resource* resource) = 0;
+  };
+
+  ResourceBackgroundQueue();
+  ~ResourceBackgroundQueue();
+
+  /** Loads a resource by name in the background.
+      @remarks
+          The resource is created with ResourceManager::create. If the
+          manager already has a resource of this name, that is what the
+          listener receives, without loading anything.
+      @param manager The manager to load the resource with
+      @param name Name of the resource
+      @param priority Requests of higher priority are done first
+      @param listener Told when the request is done; may be 0
+  */
+  Ticket load(ResourceManager* manager, const String& name, int priority = 1,
+              Listener* listener = 0);
+
+  /** Loads a resource which has been created, but not loaded, in the background.
+      @remarks
+          Use this to set up the resource before it is loaded. The queue
+          owns the resource until it is handed to the manager; if loading
+          fails, or another resource of the same name was loaded first, it
+          is destroyed.
+  */
+  Ticket load(ResourceManager* manager, Resource* res, int priority = 1,
+              Listener* listener = 0);
+
+  /** Returns true once the listener of a request has been called. */
+  bool isProcessComplete(Ticket ticket) const;
+
+  /** Gets the number of requests which haven't completed yet. */
+  size_t getNumPending(void) const;
+
+  /** Finishes loading the resources prepared since the last call, and
+      notifies their listeners; called by Root once a frame.
+  */
+  void _processCompleted(void);
+
+  /** Override standard Singleton retrieval.
+      @remarks
+          Why do we do this? Well, it's because the Singleton
+          implementation is in a .h file, which means it gets compiled
+          into anybody who includes it. This is needed for the
+          Singleton template to work, but we actually only want it
+          compiled into the implementation of the class based on the
+          Singleton, not all of them. If we don't change this, we get
+          link errors when trying to use the Singleton-based class from
+          an outside dll.
+      @par
+          This method just delegates to the template version anyway,
+          but the implementation stays in this single compilation unit,
+          preventing link errors.
+  */
+  static ResourceBackgroundQueue& getSingleton(void);
+
+protected:
+  /// One request; run on a worker to prepare the resource
+  class Request : public WorkQueue::Task {
+  public:
+    void run(void);
+
+    ResourceBackgroundQueue* queue;
+    Ticket ticket;
+    ResourceManager* manager;
+    Resource* resource;
+    int priority;
+    Listener* listener;
+    /// True if the resource was already loaded, so only needs reporting
+    bool loaded;
+    /// Description of the error if prepare failed, empty otherwise
+    String error;
+  };
+
+  /// Queues a request, starting it if there is room
+  Ticket add(Request* req);
+  /** Takes as many waiting requests as may be started now, and updates
+      mIdle; the lock must be held. */
+  void takePending(std::vector<Request*>& start);
+  /// Hands requests from takePending to the WorkQueue
+  static void startRequests(const std::vector<Request*>& start);
+  /// Called by a request once prepared, on the thread which ran it
+  void prepared(Request* req);
+
+  /// Waiting to be started, highest priority first
+  std::list<Request*> mPending;
+  /// Prepared, waiting for _processCompleted
+  std::deque<Request*> mCompleted;
+  /// Tickets of requests not yet reported
+  std::set<Ticket> mOpenTickets;
+  /// Number of requests being prepared
+  size_t mInFlight;
+  Ticket mNextTicket;
+
+  /// Protects everything above
+  mutable base::Lock mLock;
+  /// Signalled while no requests are in flight
+  base::WaitableEvent mIdle;
+};
+
+}
+
+#endif
@@ -45,9 +45,9 @@ namespace renderer {
     @par
         Resource managers use a priority system to determine what can
         be unloaded, and a Least Recently Used (LRU) policy within
-        resources of the same priority.
-    @todo
-        Implement priorities.
+        resources of the same priority. Only resources which are not in
+        use (see Resource::isInUse) are unloaded. Memory is tracked per
+        manager and across all managers, each with its own budget.
 */
 class _RendererExport ResourceManager {
 public:
@@ -63,6 +63,25 @@ public:
   */
   virtual void setMemoryBudget( size_t bytes);
 
+  /** Gets the limit on the amount of memory this resource handler may use. */
+  size_t getMemoryBudget(void) const;
+
+  /** Gets the amount of memory used by the loaded resources of this manager. */
+  size_t getMemoryUsage(void) const;
+
+  /** Set a limit on the amount of memory used by the resources of all managers together.
+      @remarks
+          When exceeded, the least recently used resources of any manager
+          are paged out, in priority order, as with setMemoryBudget.
+  */
+  static void setGlobalMemoryBudget( size_t bytes );
+
+  /** Gets the limit on the memory used by the resources of all managers. */
+  static size_t getGlobalMemoryBudget(void);
+
+  /** Gets the amount of memory used by the loaded resources of all managers. */
+  static size_t getGlobalMemoryUsage(void);
+
   /** Creates a new blank resource, compatible with this manager.
       @remarks
           Resource managers handle disparate types of resources. This method returns a pointer to a
@@ -74,6 +93,9 @@ public:
   virtual Resource* create( const String& name ) = 0;
 
   /** Load a resource. Resources will be subclasses.
+      @param priority
+          Resources of lower priority are paged out first when over budget;
+          0 or less stops the resource being paged out at all.
   */
   virtual void load( Resource *res, int priority );
 
@@ -96,9 +118,16 @@ public:
   virtual void unloadAndDestroyAll(void);
 
   /** Retrieves a pointer to a resource by name, or null if the resource does not exist.
+      @remarks
+          The resource is touched, and loaded again if it had been paged out.
   */
   virtual Resource* getByName(const String& name);
 
+  /** Retrieves a pointer to a resource by its interned name, or null if the
+      resource does not exist.
+  */
+  virtual Resource* getByName(const StringId& name);
+
   /** Adds a relative path to search for resources of this type.
       @remarks
           This method adds the supplied path to the list of relative locations that that will be searched for
@@ -134,6 +163,9 @@ public:
   static void addCommonArchiveEx( const String& strName, const String& strDriverName );
 
   /** Internal method, used for locating resource data in the file system / archives.
+      @remarks
+          May be called from a worker thread (see Resource::prepare), as
+          long as no archives are being added at the same time.
       @param
           filename File to find
       @param
@@ -182,6 +214,14 @@ public:
   */
   static bool _findCommonResourceData( const String& filename, DataChunk& refChunk );
 
+  /** Internal method, finds the common archive a file would be loaded from.
+      @remarks
+          Searches in the same order as _findCommonResourceData.
+      @returns
+          The archive, or 0 if the file is not found
+  */
+  static ArchiveEx* _findCommonArchive( const String& filename );
+
 protected:
 
   typedef HashMap< String, ArchiveEx *, _StringHash > FileMap;
@@ -191,12 +231,28 @@ protected:
   ResourceMap mResources;
 
   size_t mMemoryBudget; // In bytes
-  size_t mMemoryUsage; // In bytes, at last checkUsage() call
+  size_t mMemoryUsage; // In bytes, of the loaded resources
+
+  static size_t msGlobalMemoryBudget;
+  static size_t msGlobalMemoryUsage;
+  /// Every manager, for paging to the global budget
+  static std::vector<ResourceManager*> msManagers;
+
+  /** Adds a resource which has just been loaded to the managed list,
+      accounts for its memory and pages out others if over budget.
+  */
+  void addLoaded( Resource *res, int priority );
 
   /** Checks memory usage and pages out if required.
   */
   void checkUsage(void);
 
+  /** Pages out resources until at least the given amount of memory is freed.
+      @param manager The manager to page from, or 0 for all managers
+      @param required Number of bytes to free
+  */
+  static void pageOut( ResourceManager* manager, size_t required );
+
   /// Collection of searchable ArchiveEx classes (virtual file system) for all resource types.
   static std::vector<ArchiveEx*> mCommonVFS;
 
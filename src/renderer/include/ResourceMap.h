@@ -29,13 +29,15 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Prerequisites.h"
 
 #include "MyString.h"
+#include "IdHashMap.h"
 
 #if defined( _MSC_VER )
 #   pragma warning( push )
 #   pragma warning( disable : 4172 )
 #endif
 namespace renderer {
-typedef HashMap< String, Resource*, _StringHash > ResourceMap;
+/// Resources by name; see IdHashMap
+typedef IdHashMap<Resource*> ResourceMap;
 }
 #endif
 #if defined( _MSC_VER )
@@ -76,6 +76,8 @@ private:
 
   // Singletons
   Math* mMath;
+  WorkQueue* mWorkQueue;
+  ResourceBackgroundQueue* mResourceBackgroundQueue;
   LogManager* mLogManager;
   ControllerManager* mControllerManager;
   SceneManagerEnumerator* mSceneManagerEnum;
@@ -85,10 +87,13 @@ private:
   MeshManager* mMeshManager;
   ParticleSystemManager* mParticleManager;
   SkeletonManager* mSkeletonManager;
+  BakedAnimationManager* mBakedAnimationManager;
   ArchiveFactory *mZipArchiveFactory;
+  ArchiveFactory *mPackFileFactory;
   ArchiveFactory* os_file_system_;
   Codec* mPNGCodec, *mJPGCodec, *mJPEGCodec, *mTGACodec;
   base::TimeTicks* init_time_ticks_;
+  unsigned long mCurrentFrame;
 
   std::vector<DynLib*> mPluginLibs;
   /** Method reads a plugins configuration file and instantiates all
@@ -410,6 +415,13 @@ public:
   uint32 GetTickCount() const;
 
   void RunFrame(Real delta_time);
+
+  /** Gets the number of frames run so far.
+  @remarks
+      Counted by RunFrame. Used to spread work which doesn't need doing every
+      frame, such as the animation of distant entities, over several frames.
+  */
+  unsigned long getCurrentFrameNumber(void) const;
 };
 } // Namespace Ogre
 #endif
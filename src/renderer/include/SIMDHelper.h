@@ -0,0 +1,100 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __SIMDHelper_H__
+#define __SIMDHelper_H__
+
+#include "Prerequisites.h"
+
+/* Declares a variable aligned to a 16 byte boundary, suitable for the
+   aligned SSE load / store instructions.
+*/
+#if OGRE_COMPILER == COMPILER_MSVC
+#   define OGRE_ALIGN16_DECL(type, var) __declspec(align(16)) type var
+#else
+#   define OGRE_ALIGN16_DECL(type, var) type var __attribute__((aligned(16)))
+#endif
+
+#if OGRE_HAVE_SSE
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+namespace renderer {
+/*=============================================================================
+ Small SSE building blocks shared by the vectorised kernels. All of them work
+ on four single precision lanes at once.
+=============================================================================*/
+
+/// Returns a * b + c
+FORCEINLINE __m128 sse_madd(__m128 a, __m128 b, __m128 c) {
+  return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+/// Picks a where mask is set, b elsewhere
+FORCEINLINE __m128 sse_select(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/// Clears the sign bit of each lane
+FORCEINLINE __m128 sse_abs(__m128 a) {
+  return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)));
+}
+
+/// Returns the sign bit of each lane, all other bits cleared
+FORCEINLINE __m128 sse_signbit(__m128 a) {
+  return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x80000000)));
+}
+
+/** Rounds each lane down to an integer, as floor.
+    @remarks
+        Built on the truncating conversion, so unlike _mm_cvtps_epi32 the
+        result doesn't depend on the rounding mode in MXCSR, and matches
+        the scalar code using floor. Lanes must fit in an int.
+*/
+FORCEINLINE __m128i sse_floor_epi32(__m128 a) {
+  __m128i t = _mm_cvttps_epi32(a);
+  // Truncating rounds negative values up; the compare mask is -1 for those
+  __m128 roundedUp = _mm_cmpgt_ps(_mm_cvtepi32_ps(t), a);
+  return _mm_add_epi32(t, _mm_castps_si128(roundedUp));
+}
+
+/** Reciprocal square root, refined with one Newton-Raphson step.
+    @remarks
+        The raw rsqrtps estimate only has 12 bits of precision; the
+        refinement brings it close to full single precision, still a lot
+        cheaper than a sqrt followed by a divide.
+*/
+FORCEINLINE __m128 sse_rsqrt_nr(__m128 a) {
+  __m128 r = _mm_rsqrt_ps(a);
+  // r' = 0.5 * r * (3 - a * r * r)
+  __m128 arr = _mm_mul_ps(_mm_mul_ps(a, r), r);
+  return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), r),
+                    _mm_sub_ps(_mm_set1_ps(3.0f), arr));
+}
+}
+
+#endif // OGRE_HAVE_SSE
+
+#endif
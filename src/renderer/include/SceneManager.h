@@ -30,6 +30,8 @@ http://www.gnu.org/copyleft/lesser.txt
 
 #include "MyString.h"
 #include "SceneNode.h"
+#include "TransformStore.h"
+#include "IdHashMap.h"
 #include "Plane.h"
 #include "Quaternion.h"
 #include "ColourValue.h"
@@ -93,32 +95,37 @@ protected:
   /// The rendering system to send the scene to
   RenderSystem *mDestRenderSystem;
 
-  typedef std::map<std::string, Camera*, std::less<std::string> > CameraList;
+  typedef IdHashMap<Camera*> CameraList;
 
   /** Central list of cameras - for easy memory management and lookup.
   */
   CameraList mCameras;
 
-  typedef std::map<std::string, Light*, std::less<std::string> > LightList;
+  typedef IdHashMap<Light*> LightList;
 
   /** Central list of lights - for easy memory management and lookup.
   */
   LightList mLights;
 
 
-  typedef std::map<std::string, Entity*, std::less<std::string> > EntityList;
+  typedef IdHashMap<Entity*> EntityList;
 
   /** Central list of entities - for easy memory management and lookup.
   */
   EntityList mEntities;
 
-  typedef std::map<std::string, BillboardSet*, std::less<std::string> > BillboardSetList;
+  /// Entities being animated by _updateAnimations, kept to save reallocating
+  std::vector<Entity*> mAnimatedEntities;
+  /// Skeletons of mAnimatedEntities
+  std::vector<Skeleton*> mAnimatedSkeletons;
+
+  typedef IdHashMap<BillboardSet*> BillboardSetList;
 
   /** Central list of billboard sets - for easy memory management and lookup.
   */
   BillboardSetList mBillboardSets;
 
-  typedef std::map<String, SceneNode*> SceneNodeList;
+  typedef IdHashMap<SceneNode*> SceneNodeList;
 
   /** Central list of SceneNodes - for easy memory management.
       @note
@@ -134,6 +141,11 @@ protected:
   /// Root scene node
   SceneNode* mSceneRoot;
 
+  /** Transforms and bounds of every SceneNode created by this manager,
+      including the root; see TransformStore.
+  */
+  TransformStore mTransformStore;
+
   // Sky params
   // Sky plane
   Entity* mSkyPlaneEntity;
@@ -210,7 +222,7 @@ protected:
   bool mDisplayNodes;
 
   /// Storage of animations, lookup by name
-  typedef std::map<String, Animation*> AnimationList;
+  typedef IdHashMap<Animation*> AnimationList;
   AnimationList mAnimationsList;
   AnimationStateSet mAnimationStates;
 
@@ -256,6 +268,8 @@ public:
   /** Retrieves a pointer to the named camera.
   */
   virtual Camera* getCamera(const String& name);
+  /** Retrieves a pointer to the camera with the given interned name. */
+  virtual Camera* getCamera(const StringId& name);
 
   /** Removes a camera from the scene.
       @remarks
@@ -293,6 +307,8 @@ public:
   /** Returns a pointer to the named Light which has previously been added to the scene.
   */
   virtual Light* getLight(const String& name);
+  /** Returns a pointer to the Light with the given interned name. */
+  virtual Light* getLight(const StringId& name);
 
   /** Removes the named light from the scene and destroys it.
       @remarks
@@ -422,6 +438,12 @@ public:
   */
   virtual SceneNode* getRootSceneNode(void) const;
 
+  /** Gets the store holding the transforms of this manager's SceneNodes.
+  @remarks
+      Internal; the nodes register themselves and report their changes.
+  */
+  TransformStore& _getTransformStore(void);
+
   /** Retrieves a named SceneNode from the scene graph.
   @remarks
       If you chose to name a SceneNode as you created it, or if you
@@ -429,6 +451,11 @@ public:
       up wherever it is in the scene graph using this method.
   */
   virtual SceneNode* getSceneNode(const String& name) const;
+  /** Retrieves the SceneNode with the given interned name.
+  @remarks
+      Saves hashing the name on every lookup; see StringId.
+  */
+  virtual SceneNode* getSceneNode(const StringId& name) const;
 
   /** Create an Entity (instance of a discrete mesh).
       @param
@@ -458,6 +485,8 @@ public:
   virtual Entity* createEntity(const String& entityName, PrefabType ptype);
   /** Retrieves a pointer to the named Entity. */
   virtual Entity* getEntity(const String& name);
+  /** Retrieves a pointer to the Entity with the given interned name. */
+  virtual Entity* getEntity(const StringId& name);
 
   /** Removes & destroys an Entity from the SceneManager.
       @warning
@@ -622,10 +651,10 @@ public:
   /** Internal method for updating the scene graph ie the tree of SceneNode instances managed by this class.
       @remarks
           This must be done before issuing objects to the rendering pipeline, since derived transformations from
-          parent nodes are not updated until required. This SceneManager is a basic implementation which simply
-          updates all nodes from the root. This ensures the scene is up to date but requires all the nodes
-          to be updated even if they are not visible. Subclasses could trim this such that only potentially visible
-          nodes are updated.
+          parent nodes are not updated until required. This SceneManager is a basic implementation which
+          updates the TransformStore, so only nodes which have changed since the last frame, and their
+          descendants and ancestors, are processed, in one linear sweep. Subclasses could trim this such
+          that only potentially visible nodes are updated.
   */
   virtual void _updateSceneGraph(Camera* cam);
 
@@ -648,6 +677,16 @@ public:
   */
   virtual void _applySceneAnimations(void);
 
+  /** Internal method for updating all animation before the scene is culled.
+  @remarks
+      Applies the scene animations (see _applySceneAnimations) and evaluates
+      the skeletal animation of every entity which is likely to be rendered,
+      spread over the threads of the WorkQueue. The entities keep the
+      resulting bone matrices, so queueing them for rendering only has to
+      apply their world transforms.
+  */
+  virtual void _updateAnimations(void);
+
   /** Sends visible objects found in _findVisibleObjects to the rendering engine.
   */
   virtual void _renderVisibleObjects(void);
@@ -920,6 +959,9 @@ public:
   /** Retrieves a pointer to the named BillboardSet.
   */
   virtual BillboardSet* getBillboardSet(const String& name);
+  /** Retrieves a pointer to the BillboardSet with the given interned name.
+  */
+  virtual BillboardSet* getBillboardSet(const StringId& name);
 
   /** Removes & destroys an BillboardSet from the SceneManager.
       @warning
@@ -970,6 +1012,8 @@ public:
 
   /** Looks up an Animation object previously created with createAnimation. */
   virtual Animation* getAnimation(const String& name) const;
+  /** Looks up an Animation by its interned name. */
+  virtual Animation* getAnimation(const StringId& name) const;
 
   /** Destroys an Animation.
   @remarks
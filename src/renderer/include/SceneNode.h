@@ -28,6 +28,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Prerequisites.h"
 
 #include "Node.h"
+#include "TransformStore.h"
 #include "IteratorWrappers.h"
 
 namespace renderer {
@@ -57,9 +58,18 @@ protected:
   /// SceneManager which created this node
   SceneManager* mCreator;
 
-  /// World-Axis aligned bounding box, updated only through _update
+  /// World-Axis aligned bounding box, updated through _update or the TransformStore
   AxisAlignedBox mWorldAABB;
 
+  /// Handle of this node in the creator's TransformStore
+  TransformStore::Handle mTransformHandle;
+
+  /** Overridden from Node to tell the creator's TransformStore that the
+      hierarchy has changed. */
+  void setParent(Node* parent);
+
+  friend class TransformStore;
+
   /** Tells the SceneNode to update the world bound info it stores.
   */
   virtual void _updateBounds(void);
@@ -82,6 +92,18 @@ public:
   SceneNode(SceneManager* creator, const String& name);
   ~SceneNode();
 
+  /** Allocates SceneNodes from their pool; see setAllocatorPolicy. */
+  static void* operator new(size_t size);
+  /** Returns the memory of a SceneNode to its pool. */
+  static void operator delete(void* p, size_t size);
+  /** Sets the AllocatorPolicy SceneNodes are allocated from.
+      @remarks
+          By default they come from a PoolAllocator of their own. Only
+          change this while no SceneNodes exist; pass null to go back to the
+          default pool.
+  */
+  static void setAllocatorPolicy(AllocatorPolicy* policy);
+
   /** Adds an instance of a scene object to this node.
   @remarks
       Scene objects can include Entity objects, Camera objects, Light objects,
@@ -241,6 +263,17 @@ public:
   */
   virtual bool getShowBoundingBox();
 
+  /** To be called in the event of transform changes to this node that require it's recalculation.
+  @remarks
+      Overridden from Node; rather than notifying the parent, the node is
+      put on the dirty list of the creator's TransformStore, which the
+      SceneManager updates in _updateSceneGraph.
+  */
+  virtual void needUpdate();
+
+  /** Gets the handle of this node in the creator's TransformStore. */
+  TransformStore::Handle _getTransformHandle(void) const;
+
 };
 
 
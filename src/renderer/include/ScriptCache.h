@@ -0,0 +1,177 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __ScriptCache_H__
+#define __ScriptCache_H__
+
+#include "Prerequisites.h"
+#include "Serializer.h"
+#include "StringVector.h"
+
+namespace renderer {
+
+/** One line of a compiled script, and the block it opens if any.
+    @remarks
+        Script files are compiled into a tree of these before anything is
+        created from them. The tokens are split and lower cased the way the
+        manager owning the script wants them, so applying a compiled script
+        does no text processing beyond looking up the attribute parsers.
+*/
+class _RendererExport ScriptNode {
+public:
+  ScriptNode() : isBlock(false) {}
+
+  /// The line, split into tokens
+  StringVector tokens;
+  /// True if the line is followed by a { } block
+  bool isBlock;
+  /// The lines inside the block
+  std::vector<ScriptNode> children;
+};
+typedef std::vector<ScriptNode> ScriptNodeList;
+
+/** A versioned binary cache of compiled script files.
+    @remarks
+        Reading a script means splitting and lower casing every line of it,
+        which for a large material library is a large part of the start up
+        time. The cache keeps the compiled form of each script file, so on
+        the next run it only has to be read back. An entry is used if the
+        size and modification time of the file are unchanged, or failing
+        that (some archives don't know modification times) if a hash of its
+        contents is; otherwise the file is compiled again.
+    @par
+        Scripts which do need compiling are compiled in parallel when a
+        WorkQueue exists, but the results are handed back in the order the
+        files were asked for, so applying them gives the same result as
+        parsing them one after the other.
+    @par
+        The cache is disabled until a file name is given. The file is read
+        the first time a script is asked for, and only rewritten if anything
+        changed.
+*/
+class _RendererExport ScriptCache : public Serializer {
+public:
+  /** Turns the text of a script into compiled form; implemented by the
+      managers which parse scripts. */
+  class _RendererExport Compiler {
+  public:
+    virtual ~Compiler() {}
+    /** Compiles the script in chunk, appending to nodes.
+        @remarks
+            May be called from several threads at once, so must not create
+            anything or change the state of the compiler.
+    */
+    virtual void compileScript(DataChunk& chunk, ScriptNodeList& nodes) = 0;
+  };
+
+  /// A script file within an archive
+  struct Source {
+    Source() : archive(0) {}
+    Source(ArchiveEx* a, const String& f) : archive(a), filename(f) {}
+    ArchiveEx* archive;
+    String filename;
+  };
+  typedef std::vector<Source> SourceList;
+
+  ScriptCache();
+  virtual ~ScriptCache();
+
+  /** Sets the file the cache is kept in.
+      @remarks
+          An empty name disables the cache. A file of a different version
+          is ignored and will be overwritten.
+  */
+  void setFileName(const String& filename);
+
+  /** Gets the file the cache is kept in. */
+  const String& getFileName(void) const;
+
+  /** Gets the compiled form of a number of script files, compiling those
+      which aren't cached or have changed since.
+      @remarks
+          Files are read on the calling thread, since archives can't be
+          used from several threads at once, and compiled on the WorkQueue.
+          If compiling any file throws, the exception of the first such
+          file in the list is rethrown here once all are done.
+      @param sources The files, in the order their scripts should be applied
+      @param compiler Used for the files which have to be compiled
+      @param scripts Receives one compiled script per source, in the same
+          order. They stay valid until save is called.
+  */
+  void getScripts(const SourceList& sources, Compiler* compiler,
+                  std::vector<const ScriptNodeList*>& scripts);
+
+  /** Writes the cache file if anything changed, and frees the compiled
+      scripts; call once they have been applied.
+      @remarks
+          Only the files asked for by getScripts since the cache was read
+          are written; entries for scripts which have been removed or
+          renamed are dropped.
+  */
+  void save(void);
+
+  /** Hashes a block of data (32 bit FNV-1a). */
+  static unsigned long hashData(const void* data, size_t size);
+
+protected:
+  struct Entry {
+    Entry() : size(0), lastModified(0), hash(0), used(false) {}
+    unsigned long size;
+    /// 0 if the archive doesn't know
+    unsigned long lastModified;
+    unsigned long hash;
+    ScriptNodeList nodes;
+    /// True if asked for since the file was read; not saved
+    bool used;
+  };
+  typedef std::map<String, Entry> EntryMap;
+  EntryMap mEntries;
+
+  String mFileName;
+  /// True once mFileName has been read into mEntries
+  bool mLoaded;
+  /// True if an entry was added, updated or dropped since the file was read
+  bool mDirty;
+
+  /// Reads mFileName into mEntries
+  void read(void);
+
+  /** Finds the entry for a file, bringing its details up to date.
+      @returns
+          The contents of the file if the entry's nodes need compiling from
+          it, to be deleted by the caller; otherwise 0.
+  */
+  DataChunk* lookup(const Source& source, Entry** ppEntry);
+
+  void writeNodes(const ScriptNodeList& nodes);
+  void readNodes(DataChunk& chunk, ScriptNodeList& nodes);
+  /// Size of the nodes once written, in bytes
+  unsigned long calcNodesSize(const ScriptNodeList& nodes);
+  /// True if every token can be written (readString is limited to 254 chars)
+  bool canWrite(const ScriptNodeList& nodes);
+};
+
+}
+
+#endif
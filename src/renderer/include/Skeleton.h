@@ -29,8 +29,11 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Prerequisites.h"
 #include "Resource.h"
 #include "AnimationState.h"
+#include "DataChunk.h"
 #include "Quaternion.h"
 #include "Vector3.h"
+#include "Matrix4.h"
+#include "IdHashMap.h"
 
 namespace renderer {
 
@@ -71,6 +74,32 @@ enum SkeletonAnimationBlendMode {
 */
 class _RendererExport Skeleton : public Resource {
 public:
+  /** Working storage for evaluating a pose of the skeleton.
+  @remarks
+      Holds one entry per bone, in the order the skeleton updates them (parents
+      first). Whoever evaluates a pose keeps its own PoseBuffer, which is what
+      lets entities sharing a skeleton be evaluated at the same time.
+  */
+  struct PoseBuffer {
+    /// Resizes every array to hold numBones bones
+    void resize(size_t numBones);
+
+    /// Transform relative to the parent bone
+    std::vector<Quaternion> orientations;
+    std::vector<Vector3> positions;
+    std::vector<Vector3> scales;
+    /// Blend of the animations so far, as Node keeps for _weightedTransform
+    std::vector<Real> accumWeights;
+    std::vector<Quaternion> rotFromInitial;
+    std::vector<Vector3> transFromInitial;
+    std::vector<Vector3> scaleFromInitial;
+    /// Derived transforms, in the space of the skeleton
+    std::vector<Quaternion> derivedOrientations;
+    std::vector<Vector3> derivedPositions;
+    std::vector<Vector3> derivedScales;
+    std::vector<Matrix4> transforms;
+  };
+
   /** Constructor, don't call directly, use SkeletonManager.
   @remarks
       On creation, a Skeleton has a no bones, you should create them and link
@@ -80,6 +109,10 @@ public:
   Skeleton(String name);
   ~Skeleton();
 
+  /** Reads the skeleton file, ready for load; safe on a worker thread.
+  */
+  virtual void prepare(void);
+
   /** Generic load - called by SkeletonManager.
   */
   virtual void load(void);
@@ -192,6 +225,9 @@ public:
   /** Returns the named Animation object. */
   Animation* getAnimation(const String& name) const;
 
+  /** Returns the Animation with the given interned name. */
+  Animation* getAnimation(const StringId& name) const;
+
   /** Removes an Animation from this skeleton. */
   void removeAnimation(const String& name);
 
@@ -204,12 +240,60 @@ public:
       animations do not have to sum to 1.0, because some animations may affect only subsets
       of the skeleton. If the weights exceed 1.0 for the same area of the skeleton, the
       movement will just be exaggerated.
-      @param
+  @par
+      Manually controlled bones (see Bone::setManuallyControlled) are
+      neither reset nor animated; tracks referencing them are ignored, so
+      they keep whatever transform the application gave them. _evaluatePose
+      follows the same rule.
+      @param animSet The animations to apply
+      @param skipMinorBones If true, bones flagged as minor (see Bone::setMinor) are
+          left in their binding pose
+  */
+  void setAnimationState(const AnimationStateSet& animSet, bool skipMinorBones = false);
+
+  /** Computes a hash identifying the pose the given animation state produces.
+  @remarks
+      Covers the time position and weight of every enabled animation, the
+      blend mode, and the current transform of every manually controlled
+      bone. Two calls returning the same value produce the same bone
+      matrices, so the result can be used to share skinned vertices.
+  */
+  uint64 _getPoseHash(const AnimationStateSet& animSet, bool skipMinorBones = false) const;
+
+  /** Tells the skeleton a bone has been flagged or unflagged as minor or
+      manually controlled. Internal use only. */
+  void _notifyBoneFlagsChanged(void);
+
+  /** Builds everything _evaluatePose needs which is otherwise built on demand.
+  @remarks
+      Internal use only. Must be called from a single thread, after any change
+      to the bones or animations and before _evaluatePose is called on other
+      threads. Cheap when there is nothing to build.
+  */
+  void _prepareForEvaluation(void);
+
+  /** Evaluates the pose an animation state gives, without moving the bones.
+  @remarks
+      Internal use only. Gives the same bone matrices as setAnimationState followed by
+      _getBoneMatrices, but the working data lives in the caller's buffer and the Bone
+      objects are only read, so this may be called for different animation states
+      from several threads at once, once _prepareForEvaluation has been called.
+      Manually controlled bones keep their current transform and are not animated,
+      as in setAnimationState. Tag points are not updated.
+  @param animSet The animations to apply; only their track cursors are written
+  @param skipMinorBones If true, bones flagged as minor are left in their binding pose
+  @param buffer Working storage, owned by the caller
+  @param pMatrices Filled as by _getBoneMatrices
+  @param pDualQuats If not null, filled as by _getBoneDualQuaternions
   */
-  void setAnimationState(const AnimationStateSet& animSet);
+  void _evaluatePose(const AnimationStateSet& animSet, bool skipMinorBones,
+                     PoseBuffer& buffer, Matrix4* pMatrices, Real* pDualQuats = 0) const;
 
-  /** Gets the last animation state of this skeleton. */
-  const AnimationStateSet& getAnimationState(void) const;
+  /** Tells the skeleton a bone has moved. Internal use only. */
+  void _notifyBonesChanged(void);
+
+  /** Tells the skeleton a bone has been given a new child. Internal use only. */
+  void _notifyBoneHierarchyChanged(void);
 
 
   /** Initialise an animation set suitable for use with this mesh.
@@ -223,8 +307,26 @@ public:
       Internal use only. The array pointed to by the passed in pointer must
       be at least as large as the number of bones.
       Assumes animation has already been updated.
+  @param pMatrices Array to fill
+  @param pTagPointOwner The tag points attached to this entity's objects are
+      moved to follow the bones; those of other entities sharing the skeleton
+      are left alone.
+  */
+  void _getBoneMatrices(Matrix4* pMatrices, Entity* pTagPointOwner = 0);
+
+  /** Populates the passed in array with the bone transforms as unit dual quaternions.
+  @remarks
+      Internal use only. The dual quaternion sibling of _getBoneMatrices, for
+      dual quaternion skinning; each bone takes 8 Reals, the rotation
+      quaternion then the dual part, each ordered x, y, z, w. The array
+      must hold at least 8 * getNumBones() Reals. Any scaling in the bone
+      transforms is dropped.
   */
-  void _getBoneMatrices(Matrix4* pMatrices);
+  void _getBoneDualQuaternions(Real* pDualQuats);
+
+  /** Converts a bone matrix to a unit dual quaternion, laid out as for
+      _getBoneDualQuaternions. Any scaling is dropped. */
+  static void _toDualQuaternion(const Matrix4& m, Real* pDest);
 
   /** Gets the number of animations on this skeleton. */
   unsigned short getNumAnimations(void) const;
@@ -232,16 +334,24 @@ public:
   /** Gets a single animation by index. */
   Animation* getAnimation(unsigned short index) const;
 
+  /** Compresses the keys of all the animations of this skeleton.
+  @remarks
+      See AnimationTrack::compress. Each bone gets its own rotation tolerance:
+      a rotation error at a bone moves everything below it in the hierarchy,
+      further the longer the chain of bones hanging off it. The rotation
+      tolerance of a bone is the angle which moves the end of that chain by
+      positionTolerance, so bones near the root are kept more accurately than
+      fingers and toes.
+  @param positionTolerance Largest error allowed in bone positions, in world units
+  @param scaleTolerance Largest error allowed in each component of the bone scales
+  */
+  void compressAnimations(Real positionTolerance, Real scaleTolerance = 0.001);
+
 
   /** Creates a TagPoint ready to be attached to a bone */
   TagPoint* createTagPoint(const Quaternion &offsetOrientation = Quaternion::IDENTITY,
                            const Vector3	  &offsetPosition    = Vector3::UNIT_SCALE);
 
-  /** Sets the entity that is currently updating this skeleton */
-  void setCurrentEntity(Entity *pCurrentEntity);
-  /** Gets the entity that is currently updating this skeleton */
-  Entity *getCurrentEntity(void);
-
   /** Gets the animation blending mode which this skeleton will use. */
   SkeletonAnimationBlendMode getBlendMode();
   /** Sets the animation blending mode this skeleton will use. */
@@ -249,6 +359,47 @@ public:
 
 
 protected:
+  /// File contents read by prepare
+  DataChunk mPreparedData;
+
+  /** Gets the distance from a bone to the furthest end of the bones below it,
+      in the binding pose. */
+  Real getBoneReach(const Node* bone) const;
+
+  /** Brings the derived transforms of all bones up to date, if any have moved.
+  @remarks
+      Works on arrays of the bones sorted parents first, so one pass in order
+      updates the whole hierarchy, without recursing through the node tree. The
+      results are written back to the Bone objects so that they read as up to
+      date, then the tag points of pTagPointOwner are updated from them.
+  */
+  void updateTransforms(Entity* pTagPointOwner);
+  /// Builds the flattened bone arrays, sorted parents first
+  void buildFlatBones(void);
+  /// Fills the derived transforms of a pose from its local transforms
+  void deriveTransforms(PoseBuffer& pose) const;
+  /// Fills a matrix palette, and optionally a dual quaternion one, from derived transforms
+  void makePalette(const PoseBuffer& pose, Matrix4* pMatrices, Real* pDualQuats) const;
+
+  /// Parent index of a root bone in mFlatParents
+  static const unsigned short NO_PARENT = 0xFFFF;
+  /// Bones, parents before children
+  std::vector<Bone*> mFlatBones;
+  /// Index in mFlatBones of the parent of each bone, or NO_PARENT
+  std::vector<unsigned short> mFlatParents;
+  /// Slot of each bone in the matrix palette, which is in handle order
+  std::vector<unsigned short> mFlatPaletteIndex;
+  /// Index in mFlatBones of each bone handle, or NO_PARENT for unused handles
+  std::vector<unsigned short> mFlatIndexByHandle;
+  /// Inverse binding pose transforms
+  std::vector<Matrix4> mFlatBindInverses;
+  /// Pose of the Bone objects themselves, as last updated
+  PoseBuffer mBonePose;
+  /// Whether the flat arrays need rebuilding after a change in the hierarchy
+  bool mFlatBonesDirty;
+  /// Whether a bone has moved since the transforms were last updated
+  bool mTransformsDirty;
+
   SkeletonAnimationBlendMode mBlendState;
   /// Storage of bones, lookup by bone handle
   typedef std::map<unsigned short, Bone*> BoneList;
@@ -261,9 +412,6 @@ protected:
   typedef std::map<unsigned short, TagPoint*> TagPointList;
   TagPointList mTagPointList;
 
-  /// Entity that is currently updating this skeleton
-  Entity *mCurrentEntity;
-
   /// Pointer to root bone (all others follow)
   mutable Bone *mRootBone;
   /// Bone automatic handles
@@ -273,12 +421,15 @@ protected:
   unsigned short mNextTagPointAutoHandle;
 
   /// Storage of animations, lookup by name
-  typedef std::map<String, Animation*> AnimationList;
+  typedef IdHashMap<Animation*> AnimationList;
   AnimationList mAnimationsList;
 
-
-  /// Saved version of last animation
-  AnimationStateSet mLastAnimationState;
+  /// Flags for manually controlled bones, by handle, for skipping their
+  /// tracks; built on demand
+  std::vector<bool> mManualBones;
+  /// As mManualBones, but also flagging minor bones
+  std::vector<bool> mMinorBones;
+  bool mBoneFlagsDirty;
 
   /** Internal method which parses the bones to derive the root bone.
   @remarks
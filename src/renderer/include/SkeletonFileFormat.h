@@ -82,6 +82,23 @@ enum SkeletonChunkID {
   // Real time                    : The time position (seconds)
   // Quaternion rotate            : Rotation to apply at this keyframe
   // Vector3 translate            : Translation to apply at this keyframe
+
+  SKELETON_ANIMATION_TRACK_COMPRESSED = 0x4120,
+  // The compressed keys of a track, in place of its keyframe chunks
+  // See CompressedKeyFrames for the encoding
+
+  // Real length                       : Length of the animation the keys were made for
+  // unsigned short numKeys
+  // unsigned short constantChannels   : CompressedKeyFrames::ConstantChannel flags
+  // Vector3 translateMin              : Quantisation range of the translations
+  // Vector3 translateExtent
+  // Vector3 scaleMin                  : Quantisation range of the scales
+  // Vector3 scaleExtent
+  // unsigned short times[numKeys]     : Key times, in 1/65535ths of the length
+  // unsigned short rotations[3 * n]   : 48 bit smallest three rotations
+  // unsigned short translates[3 * n]  : Quantised translations
+  // unsigned short scales[3 * n]      : Quantised scales
+  //   (n is 1 for a channel flagged as constant, otherwise numKeys)
 };
 
 } // namespace
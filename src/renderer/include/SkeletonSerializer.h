@@ -81,6 +81,8 @@ private:
   void writeAnimation(const Animation* anim);
   void writeAnimationTrack(const AnimationTrack* track);
   void writeKeyFrame(const KeyFrame* key);
+  void writeCompressedKeyFrames(const CompressedKeyFrames* keys);
+  void writeShortList(const std::vector<uint16>& shorts);
 
   // Internal import methods
   void readBone(DataChunk &chunk);
@@ -88,12 +90,15 @@ private:
   void readAnimation(DataChunk &chunk);
   void readAnimationTrack(DataChunk &chunk, Animation* anim);
   void readKeyFrame(DataChunk &chunk, AnimationTrack* track);
+  void readCompressedKeyFrames(DataChunk &chunk, AnimationTrack* track);
+  void readShortList(DataChunk &chunk, std::vector<uint16>& shorts, size_t count);
 
   unsigned long calcBoneSize(const Bone* pBone);
   unsigned long calcBoneParentSize(void);
   unsigned long calcAnimationSize(const Animation* pAnim);
   unsigned long calcAnimationTrackSize(const AnimationTrack* pTrack);
   unsigned long calcKeyFrameSize(const KeyFrame* pKey);
+  unsigned long calcCompressedKeyFramesSize(const CompressedKeyFrames* pKeys);
 
 
 
@@ -0,0 +1,91 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __StringId_H__
+#define __StringId_H__
+
+#include "Prerequisites.h"
+
+#include "MyString.h"
+
+namespace renderer {
+
+/** A string interned in an engine-wide table, represented by a 32 bit id.
+    @remarks
+        Comparing two StringIds, or using one as a key, only looks at the
+        id, never at the characters. The id is a hash of the string; the
+        first time a string is seen it is checked against the table, and
+        should its hash already belong to a different string the next free
+        value is used instead. So within one run of the program, equal
+        strings always have equal ids and different strings never do. Ids
+        are not stable between runs and must not be saved.
+    @par
+        Making a StringId from a String hashes it and looks it up in the
+        table, so code which looks the same name up often should keep the
+        StringId rather than the String. The table is shared by all threads
+        and protected by a lock; strings are never removed from it.
+    @par
+        The empty string always has the id 0, which is also what a default
+        constructed StringId holds.
+*/
+class _RendererExport StringId {
+public:
+  /** Makes the id of the empty string. */
+  StringId() : mId(0) {}
+
+  /** Interns a string, adding it to the table if it is not there yet.
+      @remarks
+          Not explicit, so registries keyed by StringId still accept
+          Strings.
+  */
+  StringId(const String& str);
+
+  /** Gets the id. */
+  uint32 getId(void) const {
+    return mId;
+  }
+
+  /** Gets the string this id was made from. */
+  const String& getString(void) const;
+
+  bool operator==(const StringId& rhs) const {
+    return mId == rhs.mId;
+  }
+  bool operator!=(const StringId& rhs) const {
+    return mId != rhs.mId;
+  }
+  /** Orders by id, which is not the order of the strings. */
+  bool operator<(const StringId& rhs) const {
+    return mId < rhs.mId;
+  }
+
+  /** Hashes a string the way the table does. */
+  static uint32 hash(const String& str);
+
+protected:
+  uint32 mId;
+};
+}
+
+#endif
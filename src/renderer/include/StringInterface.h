@@ -28,6 +28,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 
 #include "Prerequisites.h"
 #include "MyString.h"
+#include "IdHashMap.h"
 
 namespace renderer {
 
@@ -67,7 +68,7 @@ public:
   virtual String doGet(void* target) = 0;
   virtual void doSet(void* target, const String& val) = 0;
 };
-typedef std::map<String, ParamCommand* > ParamCommandMap;
+typedef IdHashMap<ParamCommand*> ParamCommandMap;
 
 /** Class to hold a dictionary of parameters for a single class. */
 class _RendererExport ParamDictionary {
@@ -112,7 +113,7 @@ public:
 
 
 };
-typedef std::map<String, ParamDictionary> ParamDictionaryMap;
+typedef IdHashMap<ParamDictionary> ParamDictionaryMap;
 
 /** Class defining the common interface which classes can use to
     present a reflection-style, self-defining parameter set to callers.
@@ -131,6 +132,8 @@ protected:
 
   /// Class name for this instance to be used as a lookup (must be initialised by subclasses)
   String mParamDictName;
+  /// Interned mParamDictName, so looking the dictionary up needs no hashing
+  StringId mParamDictId;
 
   /** Internal method for creating a parameter dictionary for the class, if it does not already exist.
   @remarks
@@ -144,8 +147,9 @@ protected:
   */
   bool createParamDictionary(const String& className) {
     mParamDictName = className;
-    if (msDictionary.find(className) == msDictionary.end()) {
-      msDictionary[className] = ParamDictionary();
+    mParamDictId = StringId(className);
+    if (msDictionary.find(mParamDictId) == msDictionary.end()) {
+      msDictionary[mParamDictId] = ParamDictionary();
       return true;
     }
     return false;
@@ -159,13 +163,14 @@ public:
 
   /** Retrieves the parameter dictionary for this class.
   @remarks
-      Only valid to call this after createParamDictionary.
+      Only valid to call this after createParamDictionary. Don't keep the
+      pointer; creating another class's dictionary may move this one.
   @returns
       Pointer to ParamDictionary shared by all instances of this class
       which you can add parameters to, retrieve parameters etc.
   */
   ParamDictionary* getParamDictionary(void) {
-    ParamDictionaryMap::iterator i = msDictionary.find(mParamDictName);
+    ParamDictionaryMap::iterator i = msDictionary.find(mParamDictId);
     if (i != msDictionary.end()) {
       return &(i->second);
     } else {
@@ -29,6 +29,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 
 #include "MyString.h"
 #include "Renderable.h"
+#include "Mesh.h"
 
 namespace renderer {
 
@@ -75,7 +76,24 @@ private:
 
   SceneDetailLevel mRenderDetail;
 
+  /** Gets the parent entity's skinned copy of this SubEntity's vertices,
+      or null if it is not being skinned in software.
+  */
+  const Mesh::SkinnedGeometry* getSkinnedGeometry(void) const;
+
 public:
+  /** Allocates SubEntities from their pool; see setAllocatorPolicy. */
+  static void* operator new(size_t size);
+  /** Returns the memory of a SubEntity to its pool. */
+  static void operator delete(void* p, size_t size);
+  /** Sets the AllocatorPolicy SubEntities are allocated from.
+      @remarks
+          By default they come from a PoolAllocator of their own. Only
+          change this while no SubEntities exist; pass null to go back to the
+          default pool.
+  */
+  static void setAllocatorPolicy(AllocatorPolicy* policy);
+
   /** Gets the name of the Material in use by this instance.
   */
   const String& getMaterialName() const;
@@ -64,8 +64,6 @@ public:
   //Matrix4 getCombinedTransform();
   Matrix4 getParentEntityTransform();
 
-  void _update(bool updateChildren, bool parentHasChanged);
-
   Matrix4 _getFullTransform(void);
 
   Matrix4 _getNodeFullTransform(void);
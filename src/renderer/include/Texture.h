@@ -165,6 +165,13 @@ public:
     return mHasAlpha;
   }
 
+  /** Reads and decodes the image(s) for the texture, ready for load.
+      @remarks
+          Does not touch the render system, so may be called on a worker
+          thread.
+  */
+  virtual void prepare(void);
+
 protected:
   unsigned long mHeight;
   unsigned long mWidth;
@@ -180,6 +187,9 @@ protected:
   unsigned long mSrcWidth, mSrcHeight;
   unsigned short mFinalBpp;
   bool mHasAlpha;
+
+  /// Images decoded by prepare, for load to upload
+  std::vector<Image> mPreparedImages;
 };
 }
 
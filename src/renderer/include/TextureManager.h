@@ -87,6 +87,11 @@ public:
     const String& name, TextureType texType = TEX_TYPE_2D,
     int numMipMaps = -1, Real gamma = 1.0f, int priority = 1 );
 
+  /** Loads a texture from an image in memory.
+      @remarks
+          The texture can't be loaded again from its name, so it is never
+          paged out; priority is ignored.
+  */
   virtual Texture * loadImage(
     const String &name, const Image &img,
     TextureType texType = TEX_TYPE_2D,
@@ -97,8 +102,12 @@ public:
     ResourceManager::load( res, priority );
   }
 
+  /** Creates a 2D texture with the default number of mipmaps, as load would.
+  */
   virtual Resource * create( const String& name ) {
-    return create(name, TEX_TYPE_2D);
+    Texture* tex = create(name, TEX_TYPE_2D);
+    tex->setNumMipMaps(mDefaultNumMipMaps);
+    return tex;
   }
 
   virtual Texture * create( const String& name, TextureType texType) = 0;
@@ -0,0 +1,148 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __TransformStore_H__
+#define __TransformStore_H__
+
+#include "Prerequisites.h"
+
+#include "AxisAlignedBox.h"
+#include "Quaternion.h"
+#include "Vector3.h"
+
+namespace renderer {
+
+/** Flat storage for the transforms and bounds of all the SceneNodes of a
+    SceneManager.
+    @remarks
+        The scene graph itself is still made of SceneNode objects, but
+        rather than walking that tree every frame the SceneManager keeps a
+        copy of each node's local and derived position, orientation and
+        scale, plus its world bounds, in parallel arrays. The arrays are
+        kept sorted by depth in the tree, so every parent comes before all
+        of its children.
+    @par
+        Nodes report changes through SceneNode::needUpdate, which puts them
+        on a dirty list. update() then makes one forward sweep over the
+        arrays to derive the transforms of the changed nodes and all their
+        descendants, and one backward sweep to rebuild the bounds of those
+        nodes and their ancestors. Nodes which have not changed are only
+        touched as far as reading a flag.
+    @par
+        Changing the hierarchy (adding, removing, creating or destroying
+        nodes) invalidates the sort order; the arrays are rebuilt on the
+        next update(), which then derives every node.
+*/
+class _RendererExport TransformStore {
+public:
+  /// Stable identifier of a node within the store
+  typedef unsigned int Handle;
+
+  enum {
+    /// Returned for nodes which aren't in a store
+    INVALID_HANDLE = 0xFFFFFFFF
+  };
+
+  TransformStore();
+  ~TransformStore();
+
+  /** Adds a node to the store.
+      @remarks
+          Called by SceneNode on construction. The handle stays valid until
+          the node is removed, however the store is reordered.
+  */
+  Handle add(SceneNode* node);
+
+  /** Removes a node from the store; called by SceneNode on destruction. */
+  void remove(Handle handle);
+
+  /** Puts a node on the dirty list so its transform and bounds are
+      recalculated, along with those of its descendants, by the next
+      update().
+  */
+  void _notifyTransformChanged(Handle handle);
+
+  /** Tells the store that a node has been attached to or detached from
+      its parent, so the depth order must be rebuilt.
+  */
+  void _notifyHierarchyChanged(void);
+
+  /** Brings the derived transforms and world bounds of every node up to
+      date, and writes them back to the SceneNodes.
+  */
+  void update(void);
+
+  /** Gets the number of nodes in the store. */
+  size_t getNumNodes(void) const;
+
+  /** Gets the world bounds of a node as of the last update(). */
+  const AxisAlignedBox& getWorldBounds(Handle handle) const;
+
+protected:
+  enum {
+    /// The node's transform must be derived again
+    DIRTY_TRANSFORM = 1,
+    /// The node's world bounds must be merged again
+    DIRTY_BOUNDS = 2,
+    /// Parent slot of nodes at the top of a hierarchy
+    NO_PARENT = 0xFFFFFFFF
+  };
+
+  /** Re-sorts the slots into depth order after the hierarchy has changed,
+      and marks every slot dirty.
+  */
+  void rebuild(void);
+
+  /// Node owning each handle, null for free handles
+  std::vector<SceneNode*> mNodeByHandle;
+  /// Slot of each handle in the arrays below
+  std::vector<size_t> mSlotByHandle;
+  /// Whether each handle is already on mDirtyList
+  std::vector<unsigned char> mQueued;
+  /// Handles free for reuse
+  std::vector<Handle> mFreeHandles;
+  /// Handles changed since the last update
+  std::vector<Handle> mDirtyList;
+
+  /** Per slot data, in depth order. */
+  std::vector<SceneNode*> mNodes;
+  std::vector<size_t> mParents;
+  std::vector<unsigned char> mFlags;
+  std::vector<unsigned char> mInheritScales;
+  std::vector<Quaternion> mLocalOrientations;
+  std::vector<Vector3> mLocalPositions;
+  std::vector<Vector3> mLocalScales;
+  std::vector<Quaternion> mDerivedOrientations;
+  std::vector<Vector3> mDerivedPositions;
+  std::vector<Vector3> mDerivedScales;
+  std::vector<AxisAlignedBox> mWorldBounds;
+  /// Merged bounds of the children of each slot, built in the backward sweep
+  std::vector<AxisAlignedBox> mChildBounds;
+
+  /// Set when the slots must be re-sorted
+  bool mHierarchyChanged;
+};
+}
+
+#endif
@@ -0,0 +1,141 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __VertexInfluenceStream_H__
+#define __VertexInfluenceStream_H__
+
+#include "Prerequisites.h"
+#include "RenderOperation.h"
+
+namespace renderer {
+
+/** Compact, skinning friendly form of a mesh's bone assignments.
+    @remarks
+        RenderOperation::VertexBlendData stores a fixed number of
+        (index, weight) pairs for every vertex, padded with zero weights up
+        to the largest count in the mesh. That is wasteful to store and slow
+        to blend from. This class rebuilds the same data once, when the
+        bone assignments are compiled, into a stream which is laid out for
+        the software skinning loop:
+        <ul>
+        <li>Each vertex keeps at most MAX_INFLUENCES bones, heaviest first,
+            and its weights are renormalised to sum to 1.</li>
+        <li>Weights are quantised to 16 bits (summing to exactly 65535 per
+            vertex) and bone indexes to 8 bits.</li>
+        <li>Vertices are grouped in blocks of 4, stored structure of arrays,
+            and each block only holds as many influence slots as its
+            heaviest vertex needs.</li>
+        </ul>
+    @par
+        skin() and skinDualQuaternion() blend positions and normals from
+        these streams using SSE where it is available, splitting large
+        meshes across the WorkQueue.
+*/
+class _RendererExport VertexInfluenceStream {
+public:
+  enum {
+    /// Most bones which may influence one vertex
+    MAX_INFLUENCES = 4,
+    /// Vertices per block
+    BLOCK_SIZE = 4
+  };
+
+  /** Builds the stream from padded blend data.
+      @param pBlend Blend data, numWeightsPerVertex entries per vertex
+      @param numWeightsPerVertex Number of entries per vertex in pBlend
+      @param numVertices Number of vertices
+  */
+  VertexInfluenceStream(const RenderOperation::VertexBlendData* pBlend,
+                        unsigned short numWeightsPerVertex, size_t numVertices);
+
+  /** Gets the number of vertices in the stream. */
+  size_t getNumVertices(void) const;
+
+  /** Gets the number of blocks of BLOCK_SIZE vertices. */
+  size_t getNumBlocks(void) const;
+
+  /** Skins a set of vertices.
+      @param pMatrices The blend matrices, indexed by bone
+      @param pSrcPos Source positions, x/y/z per vertex
+      @param srcPosStride Extra bytes between source positions, 0 if packed
+      @param pSrcNorm Source normals; may be null if there are none
+      @param srcNormStride Extra bytes between source normals, 0 if packed
+      @param pDestPos Packed destination positions
+      @param pDestNorm Packed destination normals; ignored if pSrcNorm is null
+      @remarks
+          Meshes large enough to benefit are split into block ranges and
+          skinned in parallel on the WorkQueue; this returns once they are
+          all done. Normals are renormalised after blending.
+  */
+  void skin(const Matrix4* pMatrices,
+            const Real* pSrcPos, unsigned short srcPosStride,
+            const Real* pSrcNorm, unsigned short srcNormStride,
+            Real* pDestPos, Real* pDestNorm) const;
+
+  /** Skins a set of vertices by blending dual quaternions.
+      @param pDualQuats The bone palette, 8 Reals per bone as produced by
+          Skeleton::_getBoneDualQuaternions
+      @remarks
+          Otherwise as skin(). Normals come out unit length without being
+          renormalised, since the blended transform is a pure rotation and
+          translation.
+  */
+  void skinDualQuaternion(const Real* pDualQuats,
+                          const Real* pSrcPos, unsigned short srcPosStride,
+                          const Real* pSrcNorm, unsigned short srcNormStride,
+                          Real* pDestPos, Real* pDestNorm) const;
+
+  /** Skins a range of blocks on the calling thread; see skin(). */
+  void skinBlocks(size_t firstBlock, size_t endBlock, const Matrix4* pMatrices,
+                  const Real* pSrcPos, unsigned short srcPosStride,
+                  const Real* pSrcNorm, unsigned short srcNormStride,
+                  Real* pDestPos, Real* pDestNorm) const;
+
+  /** Skins a range of blocks on the calling thread; see skinDualQuaternion(). */
+  void skinBlocksDualQuaternion(size_t firstBlock, size_t endBlock,
+                                const Real* pDualQuats,
+                                const Real* pSrcPos, unsigned short srcPosStride,
+                                const Real* pSrcNorm, unsigned short srcNormStride,
+                                Real* pDestPos, Real* pDestNorm) const;
+
+protected:
+  /** Splits the work over the WorkQueue if worthwhile; exactly one of
+      pMatrices and pDualQuats is set. */
+  void dispatch(const Matrix4* pMatrices, const Real* pDualQuats,
+                const Real* pSrcPos, unsigned short srcPosStride,
+                const Real* pSrcNorm, unsigned short srcNormStride,
+                Real* pDestPos, Real* pDestNorm) const;
+
+  size_t mNumVertices;
+  /** First slot of each block, with a terminating entry; block b uses
+      slots mBlockStart[b] to mBlockStart[b+1]-1. */
+  std::vector<unsigned int> mBlockStart;
+  /// Bone indexes, BLOCK_SIZE lanes per slot
+  std::vector<unsigned char> mIndices;
+  /// Weights scaled to 0..65535, BLOCK_SIZE lanes per slot
+  std::vector<unsigned short> mWeights;
+};
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#ifndef __WorkQueue_H__
+#define __WorkQueue_H__
+
+#include "Prerequisites.h"
+#include "Singleton.h"
+
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+
+namespace renderer {
+
+/** A pool of worker threads which run small, independent tasks.
+    @remarks
+        The engine uses this to spread CPU heavy per-frame work (software
+        skinning, animation, particles) and background work over the
+        available cores. Tasks must not touch the render system or any
+        other state which is not safe to access from another thread.
+    @par
+        Two styles of use are supported. runAndWait() runs a batch of tasks
+        and returns once all of them have completed; the calling thread
+        works on the batch too, so it never just sits idle. addTask()
+        queues a task and returns immediately; the task is responsible for
+        reporting its own completion.
+    @par
+        Long running work which isn't needed this frame, like loading
+        resources, should be queued with addBackgroundTask instead, so
+        it never holds up a runAndWait batch.
+    @par
+        If the pool is created with no worker threads, every task is run
+        inline on the calling thread.
+*/
+class _RendererExport WorkQueue : public Singleton<WorkQueue> {
+public:
+  /** A unit of work. */
+  class _RendererExport Task {
+  public:
+    virtual ~Task() {}
+    /** Does the work; called on a worker thread, or the thread calling
+        runAndWait. */
+    virtual void run(void) = 0;
+  };
+
+  /** Constructor.
+      @param numWorkers Number of worker threads to create. The default of
+          -1 creates one fewer than the number of processors, since the
+          main thread does work too.
+  */
+  WorkQueue(int numWorkers = -1);
+  ~WorkQueue();
+
+  /** Queues a task to be run on a worker thread, and returns immediately.
+      @remarks
+          The task is not deleted by the queue; it must stay alive until it
+          has run.
+  */
+  void addTask(Task* task);
+
+  /** Queues a long running task of low priority, and returns immediately.
+      @remarks
+          Workers only pick these up when there is nothing else queued, and
+          runAndWait never runs them on the calling thread, so they don't
+          delay per-frame work. As with addTask, the task is not deleted.
+  */
+  void addBackgroundTask(Task* task);
+
+  /** Runs all the given tasks and waits until every one of them is done.
+      @remarks
+          The calling thread picks up tasks as well, so this is safe to call
+          even when all the workers are busy.
+  */
+  void runAndWait(Task** tasks, size_t count);
+
+  /** Gets the number of worker threads, not including the caller. */
+  size_t getNumWorkers(void) const;
+
+  /** Override standard Singleton retrieval.
+      @remarks
+          Why do we do this? Well, it's because the Singleton
+          implementation is in a .h file, which means it gets compiled
+          into anybody who includes it. This is needed for the
+          Singleton template to work, but we actually only want it
+          compiled into the implementation of the class based on the
+          Singleton, not all of them. If we don't change this, we get
+          link errors when trying to use the Singleton-based class from
+          an outside dll.
+      @par
+          This method just delegates to the template version anyway,
+          but the implementation stays in this single compilation unit,
+          preventing link errors.
+  */
+  static WorkQueue& getSingleton(void);
+
+protected:
+  /// Tracks completion of one runAndWait call
+  struct Batch {
+    Batch() : pending(0), done(true, false) {}
+    size_t pending;
+    base::WaitableEvent done;
+  };
+
+  struct Entry {
+    Task* task;
+    Batch* batch;
+  };
+
+  /// Worker thread body
+  class Worker : public base::PlatformThread::Delegate {
+  public:
+    Worker(WorkQueue* queue) : mQueue(queue) {}
+    void ThreadMain();
+
+    base::PlatformThreadHandle mHandle;
+  private:
+    WorkQueue* mQueue;
+  };
+
+  /** Pops and runs a single queued task, if there is one.
+      @param background Whether background tasks may be run too
+      @returns false if the queue was empty
+  */
+  bool runOne(bool background);
+  /// Pushes an entry and wakes the workers
+  void push(const Entry& e);
+
+  std::deque<Entry> mEntries;
+  /// Only run once mEntries is empty
+  std::deque<Task*> mBackgroundEntries;
+  std::vector<Worker*> mWorkers;
+
+  /// Protects both queues, batch counters and mShuttingDown
+  base::Lock mLock;
+  /// Manual reset; signalled while there are queued entries
+  base::WaitableEvent mWorkAvailable;
+  bool mShuttingDown;
+};
+}
+
+#endif
@@ -28,10 +28,23 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Prerequisites.h"
 
 #include "ArchiveEx.h"
-#include "unzip.h"
+#include "IdHashMap.h"
+#include "MappedFile.h"
 
 namespace renderer {
 
+/** Archive codec for .zip files.
+    @remarks
+        The central directory is read once when the archive is loaded, into
+        a hash index from file name to where its data is, so finding a file
+        doesn't scan the directory. Names are not case sensitive.
+    @par
+        The archive file is memory mapped, and nothing is changed after
+        loading, so any number of threads can read from it at once. Stored
+        entries are returned without copying, so every read of one shares
+        the same memory and must not modify it; deflated ones are inflated
+        straight from the mapping into a buffer of their own.
+*/
 class Zip : public ArchiveEx {
 public:
   Zip();
@@ -73,8 +86,29 @@ public:
   }
 
 private:
-  unzFile mArchive;
-
+  /// Where a file's data is, from the central directory
+  struct Entry {
+    Entry() : offset(0), compressedSize(0), uncompressedSize(0),
+      method(0), lastModified(0) {}
+    /// Of the local file header
+    size_t offset;
+    size_t compressedSize;
+    size_t uncompressedSize;
+    ushort method;
+    time_t lastModified;
+  };
+  typedef IdHashMap<Entry> EntryMap;
+
+  /// Finds a file's entry, or returns 0
+  const Entry* findEntry( const String& strFile ) const;
+  /// Returns the start of a file's data, after its local header
+  const uchar* getEntryData( const Entry& entry ) const;
+
+  scoped_refptr<MappedFile> mFile;
+  /// Keyed by lower case name
+  EntryMap mEntries;
+  /// Lower case names of all the non-empty files, in directory order
+  std::vector<String> mNames;
 };
 
 }
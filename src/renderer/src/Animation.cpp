@@ -25,6 +25,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Animation.h"
 #include "KeyFrame.h"
 #include "AnimationTrack.h"
+#include "AnimationState.h"
 #include "Exception.h"
 
 namespace renderer {
@@ -100,10 +101,30 @@ String Animation::getName(void) const {
 void Animation::apply(Real timePos, Real weight, bool accumulate) {
   TrackList::iterator i;
   for (i = mTrackList.begin(); i != mTrackList.end(); ++i) {
-    i->second->apply(timePos, weight, accumulate);
+    unsigned short cursor = 0;
+    i->second->_apply(timePos, weight, accumulate, cursor);
   }
 
 
+}
+//---------------------------------------------------------------------
+void Animation::apply(const AnimationState& state, bool accumulate,
+                      const std::vector<bool>* pSkipTracks) {
+  std::vector<unsigned short>& cursors = state._getTrackCursors();
+  if (cursors.size() != mTrackList.size()) {
+    cursors.assign(mTrackList.size(), 0);
+  }
+
+  Real timePos = state.getTimePosition();
+  Real weight = state.getWeight();
+  std::vector<unsigned short>::iterator ci = cursors.begin();
+  TrackList::iterator i;
+  for (i = mTrackList.begin(); i != mTrackList.end(); ++i, ++ci) {
+    if (pSkipTracks && i->first < pSkipTracks->size() && (*pSkipTracks)[i->first]) {
+      continue;
+    }
+    i->second->_apply(timePos, weight, accumulate, *ci);
+  }
 }
 //---------------------------------------------------------------------
 void Animation::setInterpolationMode(InterpolationMode im) {
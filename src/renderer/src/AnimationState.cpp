@@ -25,6 +25,8 @@ http://www.gnu.org/copyleft/lesser.txt.
 
 #include "AnimationState.h"
 
+#include <cmath>
+
 namespace renderer {
 
 //---------------------------------------------------------------------
@@ -40,7 +42,8 @@ AnimationState::~AnimationState() {
 }
 //---------------------------------------------------------------------
 AnimationState::AnimationState(const String& animName, Real timePos, Real length, Real weight, bool enabled)
-  : mAnimationName(animName), mTimePos(timePos), mWeight(weight), mEnabled(enabled) {
+  : mAnimationName(animName), mAnimationNameId(animName), mTimePos(timePos),
+    mWeight(weight), mEnabled(enabled) {
   setLength(length);
 }
 //---------------------------------------------------------------------
@@ -50,6 +53,11 @@ String AnimationState::getAnimationName() const {
 //---------------------------------------------------------------------
 void AnimationState::setAnimationName(const String& name) {
   mAnimationName = name;
+  mAnimationNameId = StringId(name);
+}
+//---------------------------------------------------------------------
+const StringId& AnimationState::getAnimationNameId(void) const {
+  return mAnimationNameId;
 }
 //---------------------------------------------------------------------
 Real AnimationState::getTimePosition(void) const {
@@ -84,14 +92,17 @@ void AnimationState::setWeight(Real weight) {
 void AnimationState::addTime(Real offset) {
   mTimePos = mTimePos + offset;
 
-  // Wrap over upper bound
-  while (mTimePos >= mLength) {
-    mTimePos -= mLength;
+  if (mLength <= 0) {
+    mTimePos = 0;
+    return;
   }
 
-  // Wrap over lower bound
-  while (mTimePos < 0) {
-    mTimePos += mLength;
+  // Wrap into [0, length)
+  if (mTimePos >= mLength || mTimePos < 0) {
+    mTimePos = std::fmod(mTimePos, mLength);
+    if (mTimePos < 0) {
+      mTimePos += mLength;
+    }
   }
 }
 //---------------------------------------------------------------------
@@ -104,7 +115,7 @@ void AnimationState::setEnabled(bool enabled) {
 }
 //---------------------------------------------------------------------
 bool AnimationState::operator==(const AnimationState& rhs) const {
-  if (mAnimationName == rhs.mAnimationName &&
+  if (mAnimationNameId == rhs.mAnimationNameId &&
       mEnabled == rhs.mEnabled &&
       mTimePos == rhs.mTimePos &&
       mWeight == rhs.mWeight &&
@@ -119,6 +130,10 @@ bool AnimationState::operator!=(const AnimationState& rhs) const {
   return !(*this == rhs);
 }
 //---------------------------------------------------------------------
+std::vector<unsigned short>& AnimationState::_getTrackCursors(void) const {
+  return mTrackCursors;
+}
+//---------------------------------------------------------------------
 Real AnimationState::getValue(void) const {
   return mTimePos * mInvLength;
 }
@@ -25,9 +25,13 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "AnimationTrack.h"
 #include "Animation.h"
 #include "KeyFrame.h"
+#include "CompressedKeyFrames.h"
 #include "Node.h"
 #include "LogManager.h"
 
+#include <algorithm>
+#include <cmath>
+
 // Debug
 #include "RenderWindow.h"
 #include "Root.h"
@@ -41,12 +45,16 @@ AnimationTrack::AnimationTrack(Animation* parent) : mParent(parent) {
   mTargetNode = 0;
   mMaxKeyFrameTime = -1;
   mSplineBuildNeeded = false;
+  mKeyCacheBuildNeeded = false;
+  mCompressedKeys = 0;
 }
 //---------------------------------------------------------------------
 AnimationTrack::AnimationTrack(Animation* parent, Node* targetNode)
-  : mTargetNode(targetNode) {
+  : mParent(parent), mTargetNode(targetNode) {
   mMaxKeyFrameTime = -1;
   mSplineBuildNeeded = false;
+  mKeyCacheBuildNeeded = false;
+  mCompressedKeys = 0;
 }
 //---------------------------------------------------------------------
 AnimationTrack::~AnimationTrack() {
@@ -66,48 +74,43 @@ KeyFrame* AnimationTrack::getKeyFrame(unsigned short index) const {
 //---------------------------------------------------------------------
 Real AnimationTrack::getKeyFramesAtTime(Real timePos, KeyFrame** keyFrame1, KeyFrame** keyFrame2,
                                         unsigned short* firstKeyIndex) const {
-  short firstIndex = -1;
-  Real totalAnimationLength = mParent->getLength();
-
-  // Wrap time
-  while (timePos > totalAnimationLength) {
-    timePos -= totalAnimationLength;
+  if (mKeyCacheBuildNeeded) {
+    buildKeyCache();
   }
 
-  KeyFrameList::const_iterator i = mKeyFrames.begin();
-  // Find last keyframe before or on current time
-  while (i != mKeyFrames.end() && (*i)->getTime() <= timePos) {
-    *keyFrame1 = *i++;
-    ++firstIndex;
-  }
+  timePos = wrapTime(timePos);
 
-  // Trap case where there is no key before this time (problem with animation config)
-  // In this case use the first key anyway and pretend it's time index 0
-  if (firstIndex == -1) {
-    *keyFrame1 = *i;
-    ++firstIndex;
-  }
+  // Find last keyframe before or on current time
+  unsigned short firstIndex = findKeyIndex(timePos, 0);
+  *keyFrame1 = mKeyFrames[firstIndex];
 
   // Fill index of the first key
   if (firstKeyIndex != NULL) {
     *firstKeyIndex = firstIndex;
   }
 
+  // Trap case where there is no key before this time (problem with animation config)
+  // In this case use the first key anyway and pretend it's time index 0
+  if (timePos < mKeyTimes[firstIndex]) {
+    *keyFrame2 = *keyFrame1;
+    return 0.0;
+  }
+
   // Parametric time
   // t1 = time of previous keyframe
   // t2 = time of next keyframe
   Real t1, t2;
   // Find first keyframe after the time
   // If no next keyframe, wrap back to first
-  if (i == mKeyFrames.end()) {
+  if (firstIndex + 1 == mKeyFrames.size()) {
     *keyFrame2 = mKeyFrames[0];
-    t2 = totalAnimationLength;
+    t2 = mParent->getLength();
   } else {
-    *keyFrame2 = *i;
-    t2 = (*keyFrame2)->getTime();
+    *keyFrame2 = mKeyFrames[firstIndex + 1];
+    t2 = mKeyTimes[firstIndex + 1];
   }
 
-  t1 = (*keyFrame1)->getTime();
+  t1 = mKeyTimes[firstIndex];
 
   if (t1 == t2) {
     // Same KeyFrame (only one)
@@ -118,6 +121,10 @@ Real AnimationTrack::getKeyFramesAtTime(Real timePos, KeyFrame** keyFrame1, KeyF
 }
 //---------------------------------------------------------------------
 KeyFrame* AnimationTrack::createKeyFrame(Real timePos) {
+  if (mCompressedKeys) {
+    decompress();
+  }
+
   KeyFrame* kf = new KeyFrame(timePos);
 
   // Insert at correct location
@@ -128,19 +135,24 @@ KeyFrame* AnimationTrack::createKeyFrame(Real timePos) {
   } else {
     // Search
     KeyFrameList::iterator i = mKeyFrames.begin();
-    while ((*i)->getTime() > timePos && i != mKeyFrames.end()) {
+    while (i != mKeyFrames.end() && (*i)->getTime() <= timePos) {
       ++i;
     }
     mKeyFrames.insert(i, kf);
   }
 
   mSplineBuildNeeded = true;
+  mKeyCacheBuildNeeded = true;
 
   return kf;
 
 }
 //---------------------------------------------------------------------
 void AnimationTrack::removeKeyFrame(unsigned short index) {
+  if (mCompressedKeys) {
+    decompress();
+  }
+
   // If you hit this assert, then the keyframe index is out of bounds
   assert( index < (ushort)mKeyFrames.size() );
 
@@ -153,6 +165,7 @@ void AnimationTrack::removeKeyFrame(unsigned short index) {
   mKeyFrames.erase(i);
 
   mSplineBuildNeeded = true;
+  mKeyCacheBuildNeeded = true;
 
 
 }
@@ -165,8 +178,13 @@ void AnimationTrack::removeAllKeyFrames(void) {
   }
 
   mSplineBuildNeeded = true;
+  mKeyCacheBuildNeeded = true;
 
   mKeyFrames.clear();
+  mMaxKeyFrameTime = -1;
+
+  delete mCompressedKeys;
+  mCompressedKeys = 0;
 
 }
 //---------------------------------------------------------------------
@@ -174,6 +192,17 @@ KeyFrame AnimationTrack::getInterpolatedKeyFrame(Real timeIndex) const {
   // Return value
   KeyFrame kret(timeIndex);
 
+  if (mCompressedKeys) {
+    Vector3 translate, scale;
+    Quaternion rotation;
+    unsigned short cursor = 0;
+    mCompressedKeys->evaluate(wrapTime(timeIndex), cursor, translate, rotation, scale);
+    kret.setRotation(rotation);
+    kret.setTranslate(translate);
+    kret.setScale(scale);
+    return kret;
+  }
+
   // Keyframe pointers
   KeyFrame *k1, *k2;
   unsigned short firstKeyIndex;
@@ -245,24 +274,7 @@ void AnimationTrack::setAssociatedNode(Node* node) {
 //---------------------------------------------------------------------
 void AnimationTrack::applyToNode(Node* node, Real timePos, Real weight, bool accumulate) {
   KeyFrame kf = this->getInterpolatedKeyFrame(timePos);
-  if (accumulate) {
-    // add to existing. Weights are not relative, but treated as absolute multipliers for the animation
-    Vector3 translate = kf.getTranslate() * weight;
-    node->translate(translate);
-
-    // interpolate between no-rotation and full rotation, to point 'weight', so 0 = no rotate, 1 = full
-    Quaternion rotate = Quaternion::Slerp(weight, Quaternion::IDENTITY, kf.getRotation());
-    node->rotate(rotate);
-
-    Vector3 scale = kf.getScale();
-    // Not sure how to modify scale for cumulative anims... leave it alone
-    //scale = ((Vector3::UNIT_SCALE - kf.getScale()) * weight) + Vector3::UNIT_SCALE;
-    node->scale(scale);
-  } else {
-    // apply using weighted transform method
-    node->_weightedTransform(weight, kf.getTranslate(), kf.getRotation(),
-                             kf.getScale());
-  }
+  applyTransform(node, weight, accumulate, kf.getTranslate(), kf.getRotation(), kf.getScale());
 
   /*
   // DEBUG
@@ -281,6 +293,199 @@ void AnimationTrack::applyToNode(Node* node, Real timePos, Real weight, bool acc
 
 
 
+}
+//---------------------------------------------------------------------
+void AnimationTrack::_apply(Real timePos, Real weight, bool accumulate, unsigned short& cursor) {
+  if (!mTargetNode) {
+    return;
+  }
+
+  Vector3 translate, scale;
+  Quaternion rotation;
+  if (_evaluate(timePos, cursor, translate, rotation, scale)) {
+    applyTransform(mTargetNode, weight, accumulate, translate, rotation, scale);
+  }
+}
+//---------------------------------------------------------------------
+bool AnimationTrack::_evaluate(Real timePos, unsigned short& cursor, Vector3& translate,
+                               Quaternion& rotation, Vector3& scale) const {
+  if (mCompressedKeys) {
+    mCompressedKeys->evaluate(wrapTime(timePos), cursor, translate, rotation, scale);
+    return true;
+  }
+  if (mKeyFrames.empty()) {
+    return false;
+  }
+  _prepare();
+
+  timePos = wrapTime(timePos);
+  unsigned short i1 = findKeyIndex(timePos, cursor);
+  cursor = i1;
+
+  const KeySample& k1 = mKeySamples[i1];
+  Real t1 = mKeyTimes[i1];
+  Real t2;
+  unsigned short i2 = i1 + 1;
+  if (i2 == mKeyTimes.size()) {
+    i2 = 0;
+    t2 = mParent->getLength();
+  } else {
+    t2 = mKeyTimes[i2];
+  }
+
+  // Before the first key, or only one key: no interpolation
+  if (timePos <= t1 || t1 == t2) {
+    translate = k1.translate;
+    rotation = k1.rotation;
+    scale = k1.scale;
+    return true;
+  }
+
+  Real t = (timePos - t1) / (t2 - t1);
+  if (mParent->getInterpolationMode() == Animation::IM_SPLINE) {
+    translate = mPositionSpline.interpolate(i1, t);
+    rotation = mRotationSpline.interpolate(i1, t);
+    scale = mScaleSpline.interpolate(i1, t);
+  } else {
+    const KeySample& k2 = mKeySamples[i2];
+    translate = k1.translate + ((k2.translate - k1.translate) * t);
+    rotation = Quaternion::Slerp(t, k1.rotation, k2.rotation);
+    scale = k1.scale + ((k2.scale - k1.scale) * t);
+  }
+  return true;
+}
+//---------------------------------------------------------------------
+void AnimationTrack::_prepare(void) const {
+  if (mCompressedKeys) {
+    return;
+  }
+  if (mKeyCacheBuildNeeded) {
+    buildKeyCache();
+  }
+  if (mSplineBuildNeeded && mParent->getInterpolationMode() == Animation::IM_SPLINE) {
+    buildInterpolationSplines();
+  }
+}
+//---------------------------------------------------------------------
+void AnimationTrack::_keyFrameDataChanged(void) const {
+  mSplineBuildNeeded = true;
+  mKeyCacheBuildNeeded = true;
+}
+//---------------------------------------------------------------------
+void AnimationTrack::compress(Real translateTolerance, Real rotateTolerance, Real scaleTolerance) {
+  if (mCompressedKeys || mKeyFrames.empty()) {
+    return;
+  }
+
+  CompressedKeyFrames* keys = new CompressedKeyFrames();
+  keys->build(this, mParent->getLength(), translateTolerance, rotateTolerance, scaleTolerance);
+  _setCompressedKeyFrames(keys);
+}
+//---------------------------------------------------------------------
+void AnimationTrack::decompress(void) {
+  if (!mCompressedKeys) {
+    return;
+  }
+
+  CompressedKeyFrames* keys = mCompressedKeys;
+  // Clear first, so createKeyFrame doesn't try to decompress again
+  mCompressedKeys = 0;
+  removeAllKeyFrames();
+
+  Vector3 translate, scale;
+  Quaternion rotation;
+  for (unsigned short i = 0; i < keys->getNumKeys(); ++i) {
+    keys->getKey(i, translate, rotation, scale);
+    KeyFrame* kf = createKeyFrame(keys->getKeyTime(i));
+    kf->setTranslate(translate);
+    kf->setRotation(rotation);
+    kf->setScale(scale);
+  }
+
+  delete keys;
+}
+//---------------------------------------------------------------------
+bool AnimationTrack::isCompressed(void) const {
+  return mCompressedKeys != 0;
+}
+//---------------------------------------------------------------------
+const CompressedKeyFrames* AnimationTrack::_getCompressedKeyFrames(void) const {
+  return mCompressedKeys;
+}
+//---------------------------------------------------------------------
+void AnimationTrack::_setCompressedKeyFrames(CompressedKeyFrames* keys) {
+  removeAllKeyFrames();
+  // Release the packed copies too, saving the memory is the whole point
+  std::vector<Real>().swap(mKeyTimes);
+  std::vector<KeySample>().swap(mKeySamples);
+
+  mCompressedKeys = keys;
+}
+//---------------------------------------------------------------------
+Real AnimationTrack::wrapTime(Real timePos) const {
+  Real totalAnimationLength = mParent->getLength();
+  if (timePos > totalAnimationLength && totalAnimationLength > 0) {
+    timePos = std::fmod(timePos, totalAnimationLength);
+  }
+  return timePos;
+}
+//---------------------------------------------------------------------
+unsigned short AnimationTrack::findKeyIndex(Real timePos, unsigned short cursor) const {
+  size_t numKeys = mKeyTimes.size();
+
+  if (cursor < numKeys && mKeyTimes[cursor] <= timePos) {
+    // Still in the same segment as last time?
+    if (cursor + 1 == numKeys || timePos < mKeyTimes[cursor + 1]) {
+      return cursor;
+    }
+    // Moved on into the next one?
+    if (cursor + 2 == numKeys || timePos < mKeyTimes[cursor + 2]) {
+      return cursor + 1;
+    }
+  }
+
+  // Jumped, or wrapped around; search for the first key after the time
+  std::vector<Real>::const_iterator i =
+    std::upper_bound(mKeyTimes.begin(), mKeyTimes.end(), timePos);
+  if (i == mKeyTimes.begin()) {
+    return 0;
+  }
+  return (unsigned short)(i - mKeyTimes.begin() - 1);
+}
+//---------------------------------------------------------------------
+void AnimationTrack::applyTransform(Node* node, Real weight, bool accumulate,
+                                    const Vector3& translate, const Quaternion& rotation,
+                                    const Vector3& scale) const {
+  if (accumulate) {
+    // add to existing. Weights are not relative, but treated as absolute multipliers for the animation
+    node->translate(translate * weight);
+
+    // interpolate between no-rotation and full rotation, to point 'weight', so 0 = no rotate, 1 = full
+    Quaternion rotate = Quaternion::Slerp(weight, Quaternion::IDENTITY, rotation);
+    node->rotate(rotate);
+
+    // Not sure how to modify scale for cumulative anims... leave it alone
+    //scale = ((Vector3::UNIT_SCALE - kf.getScale()) * weight) + Vector3::UNIT_SCALE;
+    node->scale(scale);
+  } else {
+    // apply using weighted transform method
+    node->_weightedTransform(weight, translate, rotation, scale);
+  }
+}
+//---------------------------------------------------------------------
+void AnimationTrack::buildKeyCache(void) const {
+  mKeyTimes.resize(mKeyFrames.size());
+  mKeySamples.resize(mKeyFrames.size());
+
+  for (size_t i = 0; i < mKeyFrames.size(); ++i) {
+    const KeyFrame* kf = mKeyFrames[i];
+    mKeyTimes[i] = kf->getTime();
+    mKeySamples[i].rotation = kf->getRotation();
+    mKeySamples[i].translate = kf->getTranslate();
+    mKeySamples[i].scale = kf->getScale();
+  }
+
+  mKeyCacheBuildNeeded = false;
 }
 //---------------------------------------------------------------------
 void AnimationTrack::buildInterpolationSplines(void) const {
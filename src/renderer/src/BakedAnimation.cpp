@@ -0,0 +1,235 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#include "BakedAnimation.h"
+
+#include "Animation.h"
+#include "AnimationState.h"
+#include "LogManager.h"
+#include "Matrix4.h"
+#include "Skeleton.h"
+#include "StringConverter.h"
+
+#include <cmath>
+
+namespace renderer {
+
+namespace {
+/// Reals stored per bone per sample; the bottom row is always 0 0 0 1
+const size_t REALS_PER_BONE = 12;
+}
+//-----------------------------------------------------------------------
+BakedAnimation::BakedAnimation(const String& name, Skeleton* skeleton,
+                               const String& animName, Real sampleRate)
+  : mSkeleton(skeleton),
+    mAnimationName(animName),
+    mSampleRate(sampleRate),
+    mLength(0),
+    mNumSamples(0),
+    mNumBones(0) {
+  assert(sampleRate > 0 && "Sample rate must be above 0");
+  mName = name;
+}
+//-----------------------------------------------------------------------
+BakedAnimation::~BakedAnimation() {
+  unload();
+}
+//-----------------------------------------------------------------------
+void BakedAnimation::load(void) {
+  if (mIsLoaded) {
+    unload();
+  }
+
+  Animation* anim = mSkeleton->getAnimation(mAnimationName);
+  mLength = anim->getLength();
+  mNumBones = mSkeleton->getNumBones();
+  mNumSamples = (size_t)std::ceil(mLength * mSampleRate);
+  if (mNumSamples == 0) {
+    mNumSamples = 1;
+  }
+  mSamples.resize(mNumSamples * mNumBones * REALS_PER_BONE);
+
+  // Play the animation on its own, at full weight
+  AnimationStateSet animSet;
+  animSet[mAnimationName] = AnimationState(mAnimationName, 0, mLength, 1.0, true);
+  AnimationState& state = animSet[mAnimationName];
+
+  Skeleton::PoseBuffer buffer;
+  std::vector<Matrix4> palette(mNumBones);
+  mSkeleton->_prepareForEvaluation();
+
+  Real* pDest = mSamples.empty() ? 0 : &mSamples[0];
+  for (size_t s = 0; s < mNumSamples; ++s) {
+    state.setTimePosition(s / mSampleRate);
+    mSkeleton->_evaluatePose(animSet, false, buffer, &palette[0]);
+    for (unsigned short b = 0; b < mNumBones; ++b) {
+      const Matrix4& m = palette[b];
+      for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 4; ++col) {
+          *pDest++ = m[row][col];
+        }
+      }
+    }
+  }
+
+  mSize = mSamples.size() * sizeof(Real);
+  mIsLoaded = true;
+
+  LogManager::getSingleton().logMessage("BakedAnimation: baked " + mAnimationName +
+                                        " into " + StringConverter::toString((unsigned long)mNumSamples) +
+                                        " samples, " + StringConverter::toString((unsigned long)mSize) + " bytes.");
+}
+//-----------------------------------------------------------------------
+void BakedAnimation::unload(void) {
+  if (!mIsLoaded) {
+    return;
+  }
+  std::vector<Real>().swap(mSamples);
+  mNumSamples = 0;
+  mSize = 0;
+  mIsLoaded = false;
+}
+//-----------------------------------------------------------------------
+Skeleton* BakedAnimation::getSkeleton(void) const {
+  return mSkeleton;
+}
+//-----------------------------------------------------------------------
+const String& BakedAnimation::getAnimationName(void) const {
+  return mAnimationName;
+}
+//-----------------------------------------------------------------------
+Real BakedAnimation::getSampleRate(void) const {
+  return mSampleRate;
+}
+//-----------------------------------------------------------------------
+size_t BakedAnimation::getNumSamples(void) const {
+  return mNumSamples;
+}
+//-----------------------------------------------------------------------
+void BakedAnimation::findSample(Real timePos, size_t& sample, Real& t) const {
+  // Wrap, as AnimationState does
+  if (mLength > 0) {
+    timePos = std::fmod(timePos, mLength);
+    if (timePos < 0) {
+      timePos += mLength;
+    }
+  } else {
+    timePos = 0;
+  }
+
+  Real pos = timePos * mSampleRate;
+  sample = (size_t)pos;
+  if (sample + 1 >= mNumSamples) {
+    // The last sample leads back round to the first, which may be less than
+    // a whole sample interval away
+    sample = mNumSamples - 1;
+    Real sampleTime = sample / mSampleRate;
+    Real gap = mLength - sampleTime;
+    t = gap > 0 ? (timePos - sampleTime) / gap : 0;
+    if (t < 0) {
+      t = 0;
+    }
+  } else {
+    t = pos - sample;
+  }
+}
+//-----------------------------------------------------------------------
+void BakedAnimation::_getBoneMatrices(Real timePos, bool interpolate, Matrix4* pMatrices) const {
+  assert(mIsLoaded && "Baked animation not loaded");
+
+  size_t sample;
+  Real t;
+  findSample(timePos, sample, t);
+
+  size_t sampleSize = mNumBones * REALS_PER_BONE;
+  const Real* pA = &mSamples[sample * sampleSize];
+
+  if (!interpolate || t == 0) {
+    for (unsigned short b = 0; b < mNumBones; ++b, pA += REALS_PER_BONE) {
+      Matrix4& m = pMatrices[b];
+      m[0][0] = pA[0];
+      m[0][1] = pA[1];
+      m[0][2] = pA[2];
+      m[0][3] = pA[3];
+      m[1][0] = pA[4];
+      m[1][1] = pA[5];
+      m[1][2] = pA[6];
+      m[1][3] = pA[7];
+      m[2][0] = pA[8];
+      m[2][1] = pA[9];
+      m[2][2] = pA[10];
+      m[2][3] = pA[11];
+      m[3][0] = 0;
+      m[3][1] = 0;
+      m[3][2] = 0;
+      m[3][3] = 1;
+    }
+    return;
+  }
+
+  // Blend straight between the matrices; at typical sample rates the
+  // rotation between neighbouring samples is small enough that the
+  // shrinkage this gives isn't visible
+  const Real* pB = &mSamples[((sample + 1) % mNumSamples) * sampleSize];
+  for (unsigned short b = 0; b < mNumBones; ++b) {
+    Matrix4& m = pMatrices[b];
+    for (int row = 0; row < 3; ++row) {
+      for (int col = 0; col < 4; ++col, ++pA, ++pB) {
+        m[row][col] = *pA + (*pB - *pA) * t;
+      }
+    }
+    m[3][0] = 0;
+    m[3][1] = 0;
+    m[3][2] = 0;
+    m[3][3] = 1;
+  }
+}
+//-----------------------------------------------------------------------
+uint64 BakedAnimation::_getPoseHash(Real timePos, bool interpolate) const {
+  size_t sample;
+  Real t;
+  findSample(timePos, sample, t);
+  if (!interpolate) {
+    t = 0;
+  }
+
+  // FNV-1a over which animation, sample and blend
+  uint64 hash = GG_UINT64_C(14695981039346656037);
+  const BakedAnimation* self = this;
+  const unsigned char* parts[3] = {
+    reinterpret_cast<const unsigned char*>(&self),
+    reinterpret_cast<const unsigned char*>(&sample),
+    reinterpret_cast<const unsigned char*>(&t)
+  };
+  const size_t sizes[3] = {sizeof(self), sizeof(sample), sizeof(t)};
+  for (int i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < sizes[i]; ++j) {
+      hash ^= parts[i][j];
+      hash *= GG_UINT64_C(1099511628211);
+    }
+  }
+  return hash;
+}
+
+}
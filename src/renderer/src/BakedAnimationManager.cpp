@@ -0,0 +1,64 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#include "BakedAnimationManager.h"
+
+#include "BakedAnimation.h"
+#include "Exception.h"
+#include "Skeleton.h"
+#include "StringConverter.h"
+
+namespace renderer {
+//-----------------------------------------------------------------------
+template<> BakedAnimationManager* Singleton<BakedAnimationManager>::ms_Singleton = 0;
+//-----------------------------------------------------------------------
+BakedAnimationManager::BakedAnimationManager() {
+}
+//-----------------------------------------------------------------------
+Resource* BakedAnimationManager::create(const String& name) {
+  Except(Exception::ERR_INVALIDPARAMS,
+         "Baked animations must be created with load, not by name.",
+         "BakedAnimationManager::create");
+  return 0;
+}
+//-----------------------------------------------------------------------
+BakedAnimation* BakedAnimationManager::load(Skeleton* skeleton, const String& animName,
+    Real sampleRate, int priority) {
+  String name = skeleton->getName() + "/" + animName + "@" +
+                StringConverter::toString(sampleRate);
+
+  // Baked again by getByName if it was paged out
+  BakedAnimation* pBaked = (BakedAnimation*)(getByName(name));
+  if (!pBaked) {
+    pBaked = new BakedAnimation(name, skeleton, animName, sampleRate);
+    ResourceManager::load(pBaked, priority);
+  }
+  return pBaked;
+}
+//-----------------------------------------------------------------------
+BakedAnimationManager& BakedAnimationManager::getSingleton(void) {
+  return Singleton<BakedAnimationManager>::getSingleton();
+}
+
+}
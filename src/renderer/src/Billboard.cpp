@@ -27,12 +27,41 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Billboard.h"
 
 #include "BillboardSet.h"
+#include "Particle.h"
+#include "ClassAllocator.h"
 
 namespace renderer {
+namespace {
+/// Size of every block handed out; see Billboard::operator new
+const size_t BILLBOARD_BLOCK_SIZE = sizeof(Particle);
+
+/// The allocator of all Billboards and Particles; never deleted, as the
+/// objects may outlive the static destructors
+ClassAllocator& getBillboardAllocator(void) {
+  static ClassAllocator* allocator = new ClassAllocator(BILLBOARD_BLOCK_SIZE);
+  return *allocator;
+}
+}
+//-----------------------------------------------------------------------
+void* Billboard::operator new(size_t size) {
+  assert(size <= BILLBOARD_BLOCK_SIZE &&
+         "Billboard subclasses must fit in the Billboard pool");
+  return getBillboardAllocator().allocate(BILLBOARD_BLOCK_SIZE);
+}
+//-----------------------------------------------------------------------
+void Billboard::operator delete(void* p) {
+  getBillboardAllocator().deallocate(p, BILLBOARD_BLOCK_SIZE);
+}
+//-----------------------------------------------------------------------
+void Billboard::setAllocatorPolicy(AllocatorPolicy* policy) {
+  getBillboardAllocator().setPolicy(policy);
+}
 
 //-----------------------------------------------------------------------
 Billboard::Billboard():
   mOwnDimensions(false),
+  mWidth(0),
+  mHeight(0),
   mPosition(Vector3::ZERO),
   mDirection(Vector3::ZERO),
   mParentSet(0),
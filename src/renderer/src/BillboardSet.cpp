@@ -30,21 +30,31 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "MyMath.h"
 #include "Sphere.h"
 #include "Root.h"
+#include "SIMDHelper.h"
 #include <algorithm>
 
 namespace renderer {
 
+namespace {
+/// Orders visible billboards furthest from the camera first
+struct FurtherFirst {
+  template <typename T>
+  bool operator()(const T& a, const T& b) const {
+    return a.depth > b.depth;
+  }
+};
+}
+
 String BillboardSet::msMovableType = "BillboardSet";
 //-----------------------------------------------------------------------
 BillboardSet::BillboardSet() :
   mOriginType( BBO_CENTER ),
   mAllDefaultSize( true ),
   mAutoExtendPool( true ),
-  mpPositions( 0 ),
-  mpColours( 0 ),
-  mpTexCoords( 0 ),
+  mpVertexData( 0 ),
   mpIndexes(0),
   mCullIndividual( false ),
+  mSortingEnabled( false ),
   mBillboardType(BBT_POINT) {
   setDefaultDimensions( 100, 100 );
   setMaterialName( "BaseWhite" );
@@ -58,11 +68,10 @@ BillboardSet::BillboardSet(
   mOriginType( BBO_CENTER ),
   mAllDefaultSize( true ),
   mAutoExtendPool( true ),
-  mpPositions( 0 ),
-  mpColours( 0 ),
-  mpTexCoords( 0 ),
+  mpVertexData( 0 ),
   mpIndexes(0),
   mCullIndividual( false ),
+  mSortingEnabled( false ),
   mBillboardType(BBT_POINT) {
   setDefaultDimensions( 100, 100 );
   setMaterialName( "BaseWhite" );
@@ -77,14 +86,10 @@ BillboardSet::~BillboardSet() {
   }
 
   // Delete shared buffers
-  if (mpPositions)
-    delete [] mpPositions;
+  if (mpVertexData)
+    delete [] mpVertexData;
   if (mpIndexes)
     delete [] mpIndexes;
-  if (mpTexCoords)
-    delete [] mpTexCoords;
-  if (mpColours)
-    delete [] mpColours;
 
 }
 //-----------------------------------------------------------------------
@@ -255,115 +260,197 @@ void BillboardSet::_notifyCurrentCamera( Camera* cam ) {
      use hardware TnL if it is available.
   */
 
-  // Min and max bounds for AABB
-  Vector3 min( Math::POS_INFINITY, Math::POS_INFINITY, Math::POS_INFINITY );
-  Vector3 max( Math::NEG_INFINITY, Math::NEG_INFINITY, Math::NEG_INFINITY );
+  // Gather the active list into contiguous arrays for genQuads
+  size_t count = mActiveBillboards.size();
+  mGatherPositions.resize(count);
+  mGatherDirections.resize(count);
+  mGatherColours.resize(count);
+  if (!mAllDefaultSize) {
+    mGatherWidths.resize(count);
+    mGatherHeights.resize(count);
+    mGatherOwnDimensions.resize(count);
+  }
 
   ActiveBillboardList::iterator it;
-  // Parametric offsets of origin
-  Real leftOff, rightOff, topOff, bottomOff;
+  size_t i = 0;
+  for (it = mActiveBillboards.begin(); it != mActiveBillboards.end(); ++it, ++i) {
+    const Billboard* bill = *it;
+    mGatherPositions[i] = bill->mPosition;
+    mGatherDirections[i] = bill->mDirection;
+    mGatherColours[i] = bill->mColour;
+    if (!mAllDefaultSize) {
+      mGatherWidths[i] = bill->mWidth;
+      mGatherHeights[i] = bill->mHeight;
+      mGatherOwnDimensions[i] = bill->mOwnDimensions ? 1 : 0;
+    }
+  }
+
+  BillboardArrays arrays;
+  arrays.count = count;
+  arrays.positions = count ? &mGatherPositions[0] : 0;
+  arrays.directions = count ? &mGatherDirections[0] : 0;
+  arrays.colours = count ? &mGatherColours[0] : 0;
+  if (!mAllDefaultSize && count) {
+    arrays.widths = &mGatherWidths[0];
+    arrays.heights = &mGatherHeights[0];
+    arrays.ownDimensions = &mGatherOwnDimensions[0];
+  } else {
+    arrays.widths = 0;
+    arrays.heights = 0;
+    arrays.ownDimensions = 0;
+  }
+  arrays.rotations = 0;
+  arrays.sizeScale = 1;
 
-  // Boundary offsets based on origin and camera orientation
-  // Vector3 vLeftOff, vRightOff, vTopOff, vBottomOff;
-  // Final vertex offsets, used where sizes all default to save calcs
-  Vector3 vOffset[4];
+  genQuads(cam, arrays);
+}
+//-----------------------------------------------------------------------
+void BillboardSet::genQuads(Camera* cam, const BillboardArrays& arrays) {
+  QuadSetup setup;
 
   // Get offsets for origin type
-  getParametricOffsets(leftOff, rightOff, topOff, bottomOff);
-  // Get camera axes in billboard space
-  Vector3 camX, camY;
+  getParametricOffsets(setup.leftOff, setup.rightOff, setup.topOff, setup.bottomOff);
 
   // Generate axes etc up-front if not oriented per-billboard
-  if (mBillboardType != BBT_ORIENTED_SELF) {
-    genBillboardAxes(*cam, &camX, &camY);
+  setup.selfOriented = (mBillboardType == BBT_ORIENTED_SELF);
+  if (!setup.selfOriented) {
+    genBillboardAxes(*cam, &setup.camX, &setup.camY);
 
     /* If all billboards are the same size we can precalculate the
        offsets and just use '+' instead of '*' for each billboard,
        and it should be faster.
     */
-    genVertOffsets(leftOff, rightOff, topOff, bottomOff,
-                   mDefaultWidth, mDefaultHeight, camX, camY, vOffset);
-
+    Vector3 vOffset[4];
+    genVertOffsets(setup.leftOff, setup.rightOff, setup.topOff, setup.bottomOff,
+                   mDefaultWidth * arrays.sizeScale, mDefaultHeight * arrays.sizeScale,
+                   setup.camX, setup.camY, vOffset);
+    for (int v = 0; v < 4; ++v) {
+      setup.defaultOffsets[v][0] = vOffset[v].x;
+      setup.defaultOffsets[v][1] = vOffset[v].y;
+      setup.defaultOffsets[v][2] = vOffset[v].z;
+      setup.defaultOffsets[v][3] = 0;
+    }
   }
 
-  // Init num visible
-  mNumVisibleBillboards = 0;
+  // Particle systems are already in world space; skip the transforms then
+  Matrix4 xworld;
+  getWorldTransforms(&xworld);
+  bool worldIdentity = (xworld == Matrix4::IDENTITY);
 
-  RGBA* pC = mpColours;
-  Real* pV = mpPositions;
+  Real* pDest = mpVertexData;
+  mNumVisibleBillboards = 0;
 
-  if( mAllDefaultSize ) { // If they're all the same size
-    /* No per-billboard checking, just blast through.
-       Saves us an if clause every billboard which may
-       make a difference.
-    */
-    for( it = mActiveBillboards.begin();
-         it != mActiveBillboards.end();
-         ++it ) {
-      // Skip if not visible (NB always true if not bounds checking individual billboards)
-      if (!billboardVisible(cam, it)) continue;
-
-      if (mBillboardType == BBT_ORIENTED_SELF) {
-        // Have to generate axes & offsets per billboard
-        genBillboardAxes(*cam, &camX, &camY, *it);
-        genVertOffsets(leftOff, rightOff, topOff, bottomOff,
-                       mDefaultWidth, mDefaultHeight, camX, camY, vOffset);
+  if (!mSortingEnabled) {
+    // Cull and build in one pass
+    for (size_t i = 0; i < arrays.count; ++i) {
+      if (mCullIndividual) {
+        const Vector3& pos = arrays.positions[i];
+        if (!billboardVisible(cam, worldIdentity ? pos : xworld * pos, arrays, i))
+          continue;
       }
 
-
-      genVertices(&pV, &pC, vOffset, *it);
-
-      // Increment visibles
+      genQuad(*cam, setup, arrays, i, &pDest);
       mNumVisibleBillboards++;
     }
-  } else { // not all default size
-    Vector3 vOwnOffset[4];
-    for( it = mActiveBillboards.begin(); it != mActiveBillboards.end(); ++it ) {
-      // Skip if not visible (NB always true if not bounds checking individual billboards)
-      if (!billboardVisible(cam, it)) continue;
+  } else {
+    // Cull and work out the depths, sort furthest first, then build
+    const Vector3& camPos = cam->getDerivedPosition();
+    mVisible.clear();
+    for (size_t i = 0; i < arrays.count; ++i) {
+      const Vector3& pos = arrays.positions[i];
+      Vector3 worldPos = worldIdentity ? pos : xworld * pos;
+      if (mCullIndividual && !billboardVisible(cam, worldPos, arrays, i))
+        continue;
+
+      VisibleBillboard vis;
+      vis.depth = (worldPos - camPos).squaredLength();
+      vis.index = static_cast<unsigned int>(i);
+      mVisible.push_back(vis);
+    }
 
-      if (mBillboardType == BBT_ORIENTED_SELF) {
-        // Have to generate axes & offsets per billboard
-        genBillboardAxes(*cam, &camX, &camY, *it);
-      }
+    std::sort(mVisible.begin(), mVisible.end(), FurtherFirst());
 
-      // If it has own dimensions, or self-oriented, gen offsets
-      if( (*it)->mOwnDimensions || mBillboardType == BBT_ORIENTED_SELF ) {
-        // Generate using own dimensions
-        genVertOffsets(leftOff, rightOff, topOff, bottomOff,
-                       (*it)->mWidth, (*it)->mHeight, camX, camY, vOwnOffset);
-        // Create vertex data
-        genVertices(&pV, &pC, vOwnOffset, *it);
-      } else { // Use default dimension, already computed before the loop, for faster creation
-        genVertices(&pV, &pC, vOffset, *it);
-      }
+    std::vector<VisibleBillboard>::const_iterator v, vend = mVisible.end();
+    for (v = mVisible.begin(); v != vend; ++v) {
+      genQuad(*cam, setup, arrays, v->index, &pDest);
+    }
+    mNumVisibleBillboards = static_cast<unsigned short>(mVisible.size());
+  }
+}
+//-----------------------------------------------------------------------
+void BillboardSet::genQuad(Camera& cam, const QuadSetup& setup,
+                           const BillboardArrays& arrays, size_t index, Real** ppDest) {
+  const Vector3& pos = arrays.positions[index];
+  bool own = arrays.ownDimensions && arrays.ownDimensions[index];
+  Real rotation = arrays.rotations ? arrays.rotations[index] : 0;
 
-      // Increment visibles
-      mNumVisibleBillboards++;
+  // Offsets of the 4 corners, x y z 0
+  const Real (*offsets)[4] = setup.defaultOffsets;
+  OGRE_ALIGN16_DECL(Real, ownOffsets[4][4]);
 
+  if (setup.selfOriented || own || rotation != 0) {
+    Vector3 x = setup.camX, y = setup.camY;
+    if (setup.selfOriented) {
+      // Have to generate axes per billboard
+      genBillboardAxes(cam, &x, &y, &arrays.directions[index]);
+    }
+    if (rotation != 0) {
+      Real c = Math::Cos(rotation);
+      Real s = Math::Sin(rotation);
+      Vector3 rotX = x * c + y * s;
+      y = y * c - x * s;
+      x = rotX;
+    }
+
+    Vector3 vOwnOffset[4];
+    genVertOffsets(setup.leftOff, setup.rightOff, setup.topOff, setup.bottomOff,
+                   (own ? arrays.widths[index] : mDefaultWidth) * arrays.sizeScale,
+                   (own ? arrays.heights[index] : mDefaultHeight) * arrays.sizeScale,
+                   x, y, vOwnOffset);
+    for (int v = 0; v < 4; ++v) {
+      ownOffsets[v][0] = vOwnOffset[v].x;
+      ownOffsets[v][1] = vOwnOffset[v].y;
+      ownOffsets[v][2] = vOwnOffset[v].z;
+      ownOffsets[v][3] = 0;
     }
+    offsets = ownOffsets;
   }
 
-  /*
-  // Update bounding box limits
-  unsigned int vertBufferSize = mNumVisibleBillboards * 4 * 3;
-
-  for( j = 0; j < vertBufferSize; j += 3 )
-  {
-          min.makeFloor( Vector3(
-                             mpPositions[j],
-                             mpPositions[j+1],
-                             mpPositions[j+2] ) );
-
-          max.makeCeil( Vector3(
-                             mpPositions[j],
-                             mpPositions[j+1],
-                             mpPositions[j+2] ) );
+  RGBA rgba;
+  Root::getSingleton().convertColourValue(arrays.colours[index], &rgba);
+  uint32 colour = static_cast<uint32>(rgba);
+
+  Real* pDest = *ppDest;
+
+  // Left-top, right-top, left-bottom, right-bottom; texture coordinates
+  // were written when the buffer was allocated and are left alone
+#if OGRE_HAVE_SSE
+  // Only defined for single precision (see Platform.h): the four floats
+  // of a vertex are a single __m128.
+  // Centre plus offset gives x y z 0; or-ing in the colour bits fills
+  // the 4th lane, so each vertex is a single store
+  __m128 centre = _mm_setr_ps(pos.x, pos.y, pos.z, 0.0f);
+  __m128 colourBits = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, colour));
+  for (int v = 0; v < 4; ++v) {
+    __m128 vertex = _mm_add_ps(centre, _mm_loadu_ps(offsets[v]));
+    _mm_storeu_ps(pDest, _mm_or_ps(vertex, colourBits));
+    pDest += VERTEX_SIZE;
   }
+#else
+  // Also the path for double precision, where the colour takes the start
+  // of a whole Real slot; the rest of the slot is cleared so the buffer
+  // doesn't hold garbage
+  for (int v = 0; v < 4; ++v) {
+    pDest[0] = offsets[v][0] + pos.x;
+    pDest[1] = offsets[v][1] + pos.y;
+    pDest[2] = offsets[v][2] + pos.z;
+    pDest[3] = 0;
+    memcpy(pDest + 3, &colour, sizeof(uint32));
+    pDest += VERTEX_SIZE;
+  }
+#endif
 
-  // Set AABB
-  mAABB.setExtents(min, max);
-  */
+  *ppDest = pDest;
 }
 //-----------------------------------------------------------------------
 void BillboardSet::_updateBounds(void) {
@@ -426,20 +513,20 @@ void BillboardSet::getRenderOperation(RenderOperation& rend) {
   // Texture-related flags
   rend.numTextureCoordSets     = 1;
   rend.numTextureDimensions[0] = 2;
-  rend.pTexCoords[0]           = mpTexCoords;
+  rend.pTexCoords[0]           = mpVertexData + 4;
 
   rend.numVertices = mNumVisibleBillboards * 4;
   rend.numIndexes  = mNumVisibleBillboards * 6;
 
-  rend.pDiffuseColour = mpColours;
+  rend.pDiffuseColour = reinterpret_cast<RGBA*>(mpVertexData + 3);
 
-  rend.pVertices = mpPositions;
+  rend.pVertices = mpVertexData;
   rend.pIndexes  = mpIndexes;
 
-  // Dedicated buffers for both components (simpler since types are different)
-  rend.diffuseStride     = 0;
-  rend.vertexStride      = 0;
-  rend.texCoordStride[0] = 0;
+  // One interleaved buffer; strides are the bytes skipped after each element
+  rend.vertexStride      = sizeof(Real) * (VERTEX_SIZE - 3);
+  rend.diffuseStride     = sizeof(Real) * VERTEX_SIZE - sizeof(uint32);
+  rend.texCoordStride[0] = sizeof(Real) * (VERTEX_SIZE - 2);
 }
 
 //-----------------------------------------------------------------------
@@ -460,38 +547,25 @@ bool BillboardSet::getAutoextend(void) const {
 //-----------------------------------------------------------------------
 void BillboardSet::setPoolSize( unsigned int size ) {
   // Never shrink below size()
-  size_t currSize = mBillboardPool.size();
+  size_t currSize = getPoolSize();
 
   if( currSize < size ) {
     this->increasePool(size);
 
-    for( size_t i = currSize; i < size; ++i ) {
-      // Add new items to the queue
-      mFreeBillboards.push_back( mBillboardPool[i] );
-    }
-
     /* Allocate / reallocate vertex data
        Note that we allocate enough space for ALL the billboards in the pool, but only issue
        rendering operations for the sections relating to the active billboards
     */
-    if (mpPositions)
-      delete [] mpPositions;
+    if (mpVertexData)
+      delete [] mpVertexData;
     if (mpIndexes)
       delete [] mpIndexes;
-    if (mpTexCoords)
-      delete [] mpTexCoords;
-    if (mpColours)
-      delete [] mpColours;
-
-    /* Alloc positions   ( 4 verts per billboard, 3 components )
-             colours     ( 1 x RGBA per vertex )
-             indices     ( 6 per billboard ( 2 tris ) )
-             tex. coords ( 2D coords, 4 per billboard )
+
+    /* Alloc vertices ( 4 per billboard, position + colour + 2D tex. coord )
+             indices  ( 6 per billboard ( 2 tris ) )
     */
-    mpPositions = new Real[size * 3 * 4];
-    mpColours   = new RGBA[size * 4];
-    mpIndexes   = new unsigned short[size * 6];
-    mpTexCoords = new Real[size * 2 * 4];
+    mpVertexData = new Real[size * 4 * VERTEX_SIZE];
+    mpIndexes    = new unsigned short[size * 6];
 
     /* Create indexes and tex coords (will be the same every frame)
        Using indexes because it means 1/3 less vertex transforms (4 instead of 6)
@@ -529,7 +603,12 @@ void BillboardSet::setPoolSize( unsigned int size ) {
       mpIndexes[idx+5] = idxOff + 2;
 
       // Do tex coords
-      memcpy( mpTexCoords + (bboard * 4 * 2), texData, sizeof(Real) * 2 * 4 );
+      Real* pVert = mpVertexData + (bboard * 4 * VERTEX_SIZE);
+      for (int v = 0; v < 4; ++v) {
+        pVert[4] = texData[v * 2];
+        pVert[5] = texData[v * 2 + 1];
+        pVert += VERTEX_SIZE;
+      }
     }
   }
 }
@@ -621,22 +700,24 @@ void BillboardSet::setCullIndividually(bool cullIndividual) {
   mCullIndividual = cullIndividual;
 }
 //-----------------------------------------------------------------------
-bool BillboardSet::billboardVisible(Camera* cam, ActiveBillboardList::iterator bill) {
-  // Return always visible if not culling individually
-  if (!mCullIndividual) return true;
-
+bool BillboardSet::getSortingEnabled(void) const {
+  return mSortingEnabled;
+}
+//-----------------------------------------------------------------------
+void BillboardSet::setSortingEnabled(bool sortingEnabled) {
+  mSortingEnabled = sortingEnabled;
+}
+//-----------------------------------------------------------------------
+bool BillboardSet::billboardVisible(Camera* cam, const Vector3& worldPos,
+                                    const BillboardArrays& arrays, size_t index) {
   // Cull based on sphere (have to transform less)
   Sphere sph;
-  Matrix4 xworld;
+  sph.setCenter(worldPos);
 
-  getWorldTransforms(&xworld);
-
-  sph.setCenter(xworld * (*bill)->mPosition);
-
-  if ((*bill)->mOwnDimensions) {
-    sph.setRadius(std::max((*bill)->mWidth, (*bill)->mHeight));
+  if (arrays.ownDimensions && arrays.ownDimensions[index]) {
+    sph.setRadius(std::max(arrays.widths[index], arrays.heights[index]) * arrays.sizeScale);
   } else {
-    sph.setRadius(std::max(mDefaultWidth, mDefaultHeight));
+    sph.setRadius(std::max(mDefaultWidth, mDefaultHeight) * arrays.sizeScale);
   }
 
   return cam->isVisible(sph);
@@ -650,13 +731,15 @@ void BillboardSet::increasePool(unsigned int size) {
   mBillboardPool.reserve(size);
   mBillboardPool.resize(size);
 
-  // Create new billboards
-  for( size_t i = oldSize; i < size; ++i )
+  // Create new billboards, and add them to the queue
+  for( size_t i = oldSize; i < size; ++i ) {
     mBillboardPool[i] = new Billboard();
+    mFreeBillboards.push_back( mBillboardPool[i] );
+  }
 
 }
 //-----------------------------------------------------------------------
-void BillboardSet:: genBillboardAxes(Camera& cam, Vector3* pX, Vector3 *pY, const Billboard* pBill) {
+void BillboardSet:: genBillboardAxes(Camera& cam, Vector3* pX, Vector3 *pY, const Vector3* pDirection) {
   // Default behaviour is that billboards are in local node space
   // so orientation of camera (in world space) must be reverse-transformed
   // into node space to generate the axes
@@ -684,7 +767,7 @@ void BillboardSet:: genBillboardAxes(Camera& cam, Vector3* pX, Vector3 *pY, cons
   case BBT_ORIENTED_SELF:
     // Y-axis is direction
     // X-axis is cross with camera direction
-    *pY = pBill->mDirection;
+    *pY = *pDirection;
     // Convert into billboard local space
     *pX = invTransform * cam.getDerivedDirection().crossProduct(*pY);
 
@@ -709,36 +792,6 @@ Vector3 BillboardSet::getCommonDirection(void) {
   return mCommonDirection;
 }
 //-----------------------------------------------------------------------
-void BillboardSet::genVertices(Real **pPos, RGBA **pCol, const Vector3* offsets, const Billboard* pBillboard) {
-  // Positions
-
-  // Left-top
-  *(*pPos)++ = offsets[0].x + pBillboard->mPosition.x;
-  *(*pPos)++ = offsets[0].y + pBillboard->mPosition.y;
-  *(*pPos)++ = offsets[0].z + pBillboard->mPosition.z;
-  // Right-top
-  *(*pPos)++ = offsets[1].x + pBillboard->mPosition.x;
-  *(*pPos)++ = offsets[1].y + pBillboard->mPosition.y;
-  *(*pPos)++ = offsets[1].z + pBillboard->mPosition.z;
-  // Left-bottom
-  *(*pPos)++ = offsets[2].x + pBillboard->mPosition.x;
-  *(*pPos)++ = offsets[2].y + pBillboard->mPosition.y;
-  *(*pPos)++ = offsets[2].z + pBillboard->mPosition.z;
-  // Right-bottom
-  *(*pPos)++ = offsets[3].x + pBillboard->mPosition.x;
-  *(*pPos)++ = offsets[3].y + pBillboard->mPosition.y;
-  *(*pPos)++ = offsets[3].z + pBillboard->mPosition.z;
-
-  // Update colours
-  RGBA colour;
-  Root::getSingleton().convertColourValue(pBillboard->mColour, &colour);
-  *(*pCol)++ = colour;
-  *(*pCol)++ = colour;
-  *(*pCol)++ = colour;
-  *(*pCol)++ = colour;
-
-}
-//-----------------------------------------------------------------------
 void BillboardSet::genVertOffsets(Real inleft, Real inright, Real intop, Real inbottom,
                                   Real width, Real height, const Vector3& x, const Vector3& y, Vector3* pDestVec) {
   Vector3 vLeftOff, vRightOff, vTopOff, vBottomOff;
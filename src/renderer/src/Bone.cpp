@@ -31,11 +31,11 @@ namespace renderer {
 
 //---------------------------------------------------------------------
 Bone::Bone(unsigned short handle, Skeleton* creator)
-  : Node(), mManuallyControlled(false), mHandle(handle), mCreator(creator) {
+  : Node(), mManuallyControlled(false), mMinor(false), mHandle(handle), mCreator(creator) {
 }
 //---------------------------------------------------------------------
 Bone::Bone(const String& name, unsigned short handle, Skeleton* creator)
-  : Node(name), mManuallyControlled(false), mHandle(handle), mCreator(creator) {
+  : Node(name), mManuallyControlled(false), mMinor(false), mHandle(handle), mCreator(creator) {
 }
 //---------------------------------------------------------------------
 Bone::~Bone() {
@@ -72,16 +72,38 @@ void Bone::reset(void) {
 //---------------------------------------------------------------------
 void Bone::setManuallyControlled(bool manuallyControlled) {
   this->mManuallyControlled = manuallyControlled;
+  mCreator->_notifyBoneFlagsChanged();
 }
 //---------------------------------------------------------------------
-bool Bone::isManuallyControlled() {
+bool Bone::isManuallyControlled() const {
   return mManuallyControlled;
 }
 //---------------------------------------------------------------------
+void Bone::setMinor(bool minor) {
+  mMinor = minor;
+  mCreator->_notifyBoneFlagsChanged();
+}
+//---------------------------------------------------------------------
+bool Bone::isMinor(void) const {
+  return mMinor;
+}
+//---------------------------------------------------------------------
 Matrix4 Bone::_getBindingPoseInverseTransform(void) {
   return mBindDerivedInverseTransform;
 }
 //---------------------------------------------------------------------
+void Bone::addChild(Node* child) {
+  Node::addChild(child);
+  mCreator->_notifyBoneHierarchyChanged();
+}
+//---------------------------------------------------------------------
+void Bone::needUpdate() {
+  mNeedParentUpdate = true;
+  mNeedChildUpdate = true;
+  mCachedTransformOutOfDate = true;
+  mCreator->_notifyBonesChanged();
+}
+//---------------------------------------------------------------------
 unsigned short Bone::getHandle(void) const {
   return mHandle;
 }
@@ -0,0 +1,378 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#include "CompressedKeyFrames.h"
+#include "AnimationTrack.h"
+#include "KeyFrame.h"
+#include "MyMath.h"
+
+#include <algorithm>
+
+namespace renderer {
+
+namespace {
+
+/// Quantised time of the end of the animation
+const Real TIME_RANGE = 65535.0f;
+/// Smallest three components never exceed 1/sqrt(2) in magnitude
+const Real ROTATION_RANGE = 0.70710678f;
+const Real ROTATION_STEPS = 32767.0f;
+const Real RANGE_STEPS = 65535.0f;
+
+uint16 quantise(Real value, Real min, Real extent, Real steps) {
+  if (extent <= 0) {
+    return 0;
+  }
+  Real n = (value - min) / extent * steps + 0.5f;
+  if (n < 0) {
+    return 0;
+  }
+  if (n > steps) {
+    return (uint16)steps;
+  }
+  return (uint16)n;
+}
+//---------------------------------------------------------------------
+void packRotation(const Quaternion& q, uint16* pOut) {
+  Real c[4] = { q.w, q.x, q.y, q.z };
+
+  int largest = 0;
+  for (int i = 1; i < 4; ++i) {
+    if (Math::Abs(c[i]) > Math::Abs(c[largest])) {
+      largest = i;
+    }
+  }
+  // Keep the dropped component positive so it can be rebuilt with a sqrt;
+  // record the flip so the key decodes with its original sign, which matters
+  // since interpolation doesn't correct for the shortest path
+  uint64 negate = c[largest] < 0 ? 1 : 0;
+  Real sign = negate ? -1.0f : 1.0f;
+
+  uint64 packed = ((uint64)largest << 46) | (negate << 45);
+  int shift = 30;
+  for (int i = 0; i < 4; ++i) {
+    if (i != largest) {
+      packed |= (uint64)quantise(c[i] * sign, -ROTATION_RANGE, 2 * ROTATION_RANGE,
+                                 ROTATION_STEPS) << shift;
+      shift -= 15;
+    }
+  }
+
+  pOut[0] = (uint16)(packed >> 32);
+  pOut[1] = (uint16)(packed >> 16);
+  pOut[2] = (uint16)packed;
+}
+//---------------------------------------------------------------------
+void unpackRotation(const uint16* pIn, Quaternion& q) {
+  uint64 packed = ((uint64)pIn[0] << 32) | ((uint64)pIn[1] << 16) | pIn[2];
+  int largest = (int)(packed >> 46) & 0x3;
+  bool negate = ((packed >> 45) & 0x1) != 0;
+
+  const Real scale = 2 * ROTATION_RANGE / ROTATION_STEPS;
+  Real c[4];
+  Real sum = 0;
+  int shift = 30;
+  for (int i = 0; i < 4; ++i) {
+    if (i != largest) {
+      c[i] = (Real)((packed >> shift) & 0x7FFF) * scale - ROTATION_RANGE;
+      sum += c[i] * c[i];
+      shift -= 15;
+    }
+  }
+  c[largest] = sum < 1 ? Math::Sqrt(1 - sum) : 0;
+
+  if (negate) {
+    q = Quaternion(-c[0], -c[1], -c[2], -c[3]);
+  } else {
+    q = Quaternion(c[0], c[1], c[2], c[3]);
+  }
+}
+//---------------------------------------------------------------------
+void decodeRange(const uint16* pIn, const Vector3& min, const Vector3& extent,
+                 Vector3& v) {
+  const Real scale = 1.0f / RANGE_STEPS;
+  v.x = min.x + pIn[0] * extent.x * scale;
+  v.y = min.y + pIn[1] * extent.y * scale;
+  v.z = min.z + pIn[2] * extent.z * scale;
+}
+//---------------------------------------------------------------------
+bool rotationsMatch(const Quaternion& a, const Quaternion& b, Real cosHalfTolerance) {
+  return Math::Abs(a.Dot(b)) >= cosHalfTolerance;
+}
+//---------------------------------------------------------------------
+bool vectorsMatch(const Vector3& a, const Vector3& b, Real tolerance) {
+  return Math::Abs(a.x - b.x) <= tolerance &&
+         Math::Abs(a.y - b.y) <= tolerance &&
+         Math::Abs(a.z - b.z) <= tolerance;
+}
+//---------------------------------------------------------------------
+void findRange(const std::vector<Vector3>& values, Vector3& min, Vector3& extent) {
+  Vector3 max = values[0];
+  min = values[0];
+  for (size_t i = 1; i < values.size(); ++i) {
+    min.makeFloor(values[i]);
+    max.makeCeil(values[i]);
+  }
+  extent = max - min;
+}
+}
+
+//---------------------------------------------------------------------
+CompressedKeyFrames::CompressedKeyFrames()
+  : mLength(0), mTimeScale(0), mConstantChannels(0),
+    mTranslateMin(Vector3::ZERO), mTranslateExtent(Vector3::ZERO),
+    mScaleMin(Vector3::UNIT_SCALE), mScaleExtent(Vector3::ZERO) {
+}
+//---------------------------------------------------------------------
+CompressedKeyFrames::~CompressedKeyFrames() {
+}
+//---------------------------------------------------------------------
+void CompressedKeyFrames::setLength(Real length) {
+  mLength = length;
+  mTimeScale = length > 0 ? TIME_RANGE / length : 0;
+}
+//---------------------------------------------------------------------
+void CompressedKeyFrames::build(const AnimationTrack* track, Real length,
+                                Real translateTolerance, Real rotateTolerance,
+                                Real scaleTolerance) {
+  unsigned short numKeys = track->getNumKeyFrames();
+  assert(numKeys > 0 && "Can't compress a track with no keys");
+
+  setLength(length);
+
+  std::vector<Real> times(numKeys);
+  std::vector<Quaternion> rotations(numKeys);
+  std::vector<Vector3> translates(numKeys);
+  std::vector<Vector3> scales(numKeys);
+  unsigned short i;
+  for (i = 0; i < numKeys; ++i) {
+    const KeyFrame* kf = track->getKeyFrame(i);
+    times[i] = kf->getTime();
+    rotations[i] = kf->getRotation();
+    translates[i] = kf->getTranslate();
+    scales[i] = kf->getScale();
+  }
+
+  Real cosHalfRotate = Math::Cos(rotateTolerance * 0.5f);
+
+  // Find the channels which don't change
+  mConstantChannels = CC_ROTATION | CC_TRANSLATE | CC_SCALE;
+  for (i = 1; i < numKeys; ++i) {
+    if (!rotationsMatch(rotations[i], rotations[0], cosHalfRotate)) {
+      mConstantChannels &= ~CC_ROTATION;
+    }
+    if (!vectorsMatch(translates[i], translates[0], translateTolerance)) {
+      mConstantChannels &= ~CC_TRANSLATE;
+    }
+    if (!vectorsMatch(scales[i], scales[0], scaleTolerance)) {
+      mConstantChannels &= ~CC_SCALE;
+    }
+  }
+
+  // Drop the keys which interpolating their neighbours reproduces well enough.
+  // Grow each segment from the last kept key until one of the keys it skips
+  // would be off by more than the tolerance. The first and last keys always
+  // stay, since the track also interpolates from the last key back to the first.
+  std::vector<bool> keep(numKeys, false);
+  keep[0] = true;
+  if (mConstantChannels != (CC_ROTATION | CC_TRANSLATE | CC_SCALE)) {
+    keep[numKeys - 1] = true;
+    unsigned short start = 0;
+    for (unsigned short end = 2; end < numKeys; ++end) {
+      Real span = times[end] - times[start];
+      bool fits = true;
+      for (unsigned short k = start + 1; k < end && fits; ++k) {
+        Real t = span > 0 ? (times[k] - times[start]) / span : 0;
+        if (!(mConstantChannels & CC_ROTATION)) {
+          fits = rotationsMatch(Quaternion::Slerp(t, rotations[start], rotations[end]),
+                                rotations[k], cosHalfRotate);
+        }
+        if (fits && !(mConstantChannels & CC_TRANSLATE)) {
+          fits = vectorsMatch(translates[start] + (translates[end] - translates[start]) * t,
+                              translates[k], translateTolerance);
+        }
+        if (fits && !(mConstantChannels & CC_SCALE)) {
+          fits = vectorsMatch(scales[start] + (scales[end] - scales[start]) * t,
+                              scales[k], scaleTolerance);
+        }
+      }
+      if (!fits) {
+        keep[end - 1] = true;
+        start = end - 1;
+      }
+    }
+  }
+
+  // Quantisation ranges
+  findRange(translates, mTranslateMin, mTranslateExtent);
+  findRange(scales, mScaleMin, mScaleExtent);
+
+  // Pack the keys which are left
+  mTimes.clear();
+  mRotations.clear();
+  mTranslates.clear();
+  mScales.clear();
+  for (i = 0; i < numKeys; ++i) {
+    if (!keep[i]) {
+      continue;
+    }
+    mTimes.push_back(quantise(times[i], 0, length, TIME_RANGE));
+
+    uint16 packed[3];
+    if (i == 0 || !(mConstantChannels & CC_ROTATION)) {
+      packRotation(rotations[i], packed);
+      mRotations.insert(mRotations.end(), packed, packed + 3);
+    }
+    if (i == 0 || !(mConstantChannels & CC_TRANSLATE)) {
+      packed[0] = quantise(translates[i].x, mTranslateMin.x, mTranslateExtent.x, RANGE_STEPS);
+      packed[1] = quantise(translates[i].y, mTranslateMin.y, mTranslateExtent.y, RANGE_STEPS);
+      packed[2] = quantise(translates[i].z, mTranslateMin.z, mTranslateExtent.z, RANGE_STEPS);
+      mTranslates.insert(mTranslates.end(), packed, packed + 3);
+    }
+    if (i == 0 || !(mConstantChannels & CC_SCALE)) {
+      packed[0] = quantise(scales[i].x, mScaleMin.x, mScaleExtent.x, RANGE_STEPS);
+      packed[1] = quantise(scales[i].y, mScaleMin.y, mScaleExtent.y, RANGE_STEPS);
+      packed[2] = quantise(scales[i].z, mScaleMin.z, mScaleExtent.z, RANGE_STEPS);
+      mScales.insert(mScales.end(), packed, packed + 3);
+    }
+  }
+}
+//---------------------------------------------------------------------
+unsigned short CompressedKeyFrames::getNumKeys(void) const {
+  return (unsigned short)mTimes.size();
+}
+//---------------------------------------------------------------------
+Real CompressedKeyFrames::getKeyTime(unsigned short index) const {
+  assert(index < mTimes.size());
+  return mTimes[index] * mLength / TIME_RANGE;
+}
+//---------------------------------------------------------------------
+void CompressedKeyFrames::decodeRotation(unsigned short index, Quaternion& rotation) const {
+  if (mConstantChannels & CC_ROTATION) {
+    index = 0;
+  }
+  unpackRotation(&mRotations[index * 3], rotation);
+}
+//---------------------------------------------------------------------
+void CompressedKeyFrames::decodeTranslate(unsigned short index, Vector3& translate) const {
+  if (mConstantChannels & CC_TRANSLATE) {
+    index = 0;
+  }
+  decodeRange(&mTranslates[index * 3], mTranslateMin, mTranslateExtent, translate);
+}
+//---------------------------------------------------------------------
+void CompressedKeyFrames::decodeScale(unsigned short index, Vector3& scale) const {
+  if (mConstantChannels & CC_SCALE) {
+    index = 0;
+  }
+  decodeRange(&mScales[index * 3], mScaleMin, mScaleExtent, scale);
+}
+//---------------------------------------------------------------------
+void CompressedKeyFrames::getKey(unsigned short index, Vector3& translate,
+                                 Quaternion& rotation, Vector3& scale) const {
+  assert(index < mTimes.size());
+  decodeTranslate(index, translate);
+  decodeRotation(index, rotation);
+  decodeScale(index, scale);
+}
+//---------------------------------------------------------------------
+unsigned short CompressedKeyFrames::findKeyIndex(Real time, unsigned short cursor) const {
+  size_t numKeys = mTimes.size();
+
+  if (cursor < numKeys && mTimes[cursor] <= time) {
+    if (cursor + 1 == numKeys || time < mTimes[cursor + 1]) {
+      return cursor;
+    }
+    if (cursor + 2 == numKeys || time < mTimes[cursor + 2]) {
+      return cursor + 1;
+    }
+  }
+
+  std::vector<uint16>::const_iterator i =
+    std::upper_bound(mTimes.begin(), mTimes.end(), time);
+  if (i == mTimes.begin()) {
+    return 0;
+  }
+  return (unsigned short)(i - mTimes.begin() - 1);
+}
+//---------------------------------------------------------------------
+void CompressedKeyFrames::evaluate(Real timePos, unsigned short& cursor, Vector3& translate,
+                                   Quaternion& rotation, Vector3& scale) const {
+  assert(!mTimes.empty());
+
+  Real time = timePos * mTimeScale;
+  unsigned short i1 = findKeyIndex(time, cursor);
+  cursor = i1;
+
+  Real t1 = mTimes[i1];
+  Real t2;
+  unsigned short i2 = i1 + 1;
+  if (i2 == mTimes.size()) {
+    // Wrap back to the first key at the end of the animation
+    i2 = 0;
+    t2 = TIME_RANGE;
+  } else {
+    t2 = mTimes[i2];
+  }
+
+  if (time <= t1 || t1 == t2) {
+    getKey(i1, translate, rotation, scale);
+    return;
+  }
+
+  Real t = (time - t1) / (t2 - t1);
+  Vector3 v1, v2;
+  Quaternion q1, q2;
+
+  if (mConstantChannels & CC_ROTATION) {
+    decodeRotation(0, rotation);
+  } else {
+    decodeRotation(i1, q1);
+    decodeRotation(i2, q2);
+    rotation = Quaternion::Slerp(t, q1, q2);
+  }
+
+  decodeTranslate(i1, v1);
+  if (mConstantChannels & CC_TRANSLATE) {
+    translate = v1;
+  } else {
+    decodeTranslate(i2, v2);
+    translate = v1 + ((v2 - v1) * t);
+  }
+
+  decodeScale(i1, v1);
+  if (mConstantChannels & CC_SCALE) {
+    scale = v1;
+  } else {
+    decodeScale(i2, v2);
+    scale = v1 + ((v2 - v1) * t);
+  }
+}
+//---------------------------------------------------------------------
+size_t CompressedKeyFrames::getMemoryUsage(void) const {
+  return sizeof(*this) + sizeof(uint16) *
+         (mTimes.size() + mRotations.size() + mTranslates.size() + mScales.size());
+}
+
+}
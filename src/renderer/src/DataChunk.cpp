@@ -30,7 +30,7 @@ namespace renderer {
 
 //-----------------------------------------------------------------------
 DataChunk::DataChunk()
-  : mData( NULL ), mSize( 0 ) {
+  : mData( NULL ), mPos( NULL ), mEnd( NULL ), mSize( 0 ) {
 }
 
 DataChunk::DataChunk( void *pData, size_t size ) {
@@ -40,12 +40,15 @@ DataChunk::DataChunk( void *pData, size_t size ) {
   mSize = size;
 }
 
+//-----------------------------------------------------------------------
+DataChunk::~DataChunk() {
+}
+
 //-----------------------------------------------------------------------
 uchar* DataChunk::allocate( size_t size, const uchar * ptr ) {
   assert (size > 0);
 
-  if( mData )
-    delete [] mData;
+  release();
 
   mData = new uchar[size];
   mSize = size;
@@ -58,10 +61,43 @@ uchar* DataChunk::allocate( size_t size, const uchar * ptr ) {
   return mData;
 }
 
+//-----------------------------------------------------------------------
+void DataChunk::map( MappedFile* file ) {
+  map(file, 0, file->getSize());
+}
+
+//-----------------------------------------------------------------------
+void DataChunk::map( MappedFile* file, size_t offset, size_t size ) {
+  assert(offset + size <= file->getSize());
+
+  // Only free allocated memory; reassigning mMapping releases a mapping
+  if (!mMapping)
+    release();
+  mMapping = file;
+
+  mData = file->getPtr() + offset;
+  mSize = size;
+  mPos = mData;
+  mEnd = mData + mSize;
+}
+
+//-----------------------------------------------------------------------
+bool DataChunk::isMapped() const {
+  return mMapping != NULL;
+}
+
+//-----------------------------------------------------------------------
+void DataChunk::release(void) {
+  if (mMapping)
+    mMapping = NULL;
+  else if (mData)
+    delete [] mData;
+}
+
 //-----------------------------------------------------------------------
 DataChunk & DataChunk::clear(void) {
   if (mData) {
-    delete [] mData;
+    release();
     mData = 0;
     mSize = 0;
   }
@@ -114,14 +150,20 @@ DataChunk & DataChunk::skip( long offset ) {
   return *this;
 }
 //-----------------------------------------------------------------------
+size_t DataChunk::scanUpTo( const char *delim ) const {
+  // Like strcspn, but never reads past the end; the data need not be null
+  // terminated, and reading beyond a mapped file can fault
+  const uchar* p = mPos;
+  while (p < mEnd && !strchr(delim, *p))
+    ++p;
+  return p - mPos;
+}
+//-----------------------------------------------------------------------
 ulong DataChunk::readUpTo( void* buffer, size_t size, const char *delim ) {
-  size_t pos = strcspn((const char*)mPos, delim);
+  size_t pos = scanUpTo(delim);
   if (pos > size)
     pos = size;
 
-  // Make sure pos can never go past the end of the data
-  if(mPos + pos > mEnd) pos = mEnd - mPos;
-
   if (pos > 0) {
     memcpy(buffer, (const void*)mPos, pos);
   }
@@ -131,11 +173,7 @@ ulong DataChunk::readUpTo( void* buffer, size_t size, const char *delim ) {
 }
 //-----------------------------------------------------------------------
 ulong DataChunk::skipUpTo( const char *delim ) {
-
-  size_t pos = strcspn( (const char*)mPos, delim );
-
-  // Make sure pos can never go past the end of the data
-  if(mPos + pos > mEnd) pos = mEnd - mPos;
+  size_t pos = scanUpTo(delim);
 
   mPos += pos + 1;
 
@@ -151,7 +189,7 @@ bool DataChunk::isEOF(void) {
 }
 //-----------------------------------------------------------------------
 String DataChunk::getLine(bool trimAfter) {
-  static char buf[512]; // prevent continuous allocation / deallocation - not thread safe!
+  char buf[512]; // on the stack, so scripts can be parsed on several threads
   int count;
 
   count = readUpTo(buf, 511);
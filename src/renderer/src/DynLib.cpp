@@ -29,7 +29,9 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "LogManager.h"
 
 #if OGRE_PLATFORM == PLATFORM_WIN32
-#   define WIN32_LEAN_AND_MEAN
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
 #   include <windows.h>
 #endif
 
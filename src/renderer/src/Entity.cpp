@@ -35,12 +35,52 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Camera.h"
 #include "TagPoint.h"
 #include "AxisAlignedBox.h"
+#include "Root.h"
+#include "RenderSystem.h"
+#include "BakedAnimation.h"
+#include "BakedAnimationManager.h"
+#include "ClassAllocator.h"
 
 namespace renderer {
+namespace {
+/// The allocator of all Entities; never deleted, as the objects may outlive
+/// the static destructors
+ClassAllocator& getEntityAllocator(void) {
+  static ClassAllocator* allocator = new ClassAllocator(sizeof(Entity));
+  return *allocator;
+}
+}
+//-----------------------------------------------------------------------
+void* Entity::operator new(size_t size) {
+  return getEntityAllocator().allocate(size);
+}
+//-----------------------------------------------------------------------
+void Entity::operator delete(void* p, size_t size) {
+  getEntityAllocator().deallocate(p, size);
+}
+//-----------------------------------------------------------------------
+void Entity::setAllocatorPolicy(AllocatorPolicy* policy) {
+  getEntityAllocator().setPolicy(policy);
+}
 String Entity::msMovableType = "Entity";
+unsigned short Entity::msNextAnimationPhase = 0;
 //-----------------------------------------------------------------------
 Entity::Entity () {
   mFullBoundingBox = new AxisAlignedBox;
+  mSkinnedPose = 0;
+  mSkinnedPoseMesh = 0;
+  mBoneDualQuats = 0;
+  mSkinningMethodOverridden = false;
+  mBoneModelMatrices = 0;
+  mBoneModelMesh = 0;
+  mBonesSkippedMinor = false;
+  mBonePoseHash = 0;
+  mBoneDualQuatsValid = false;
+  mBonesPrepared = false;
+  mBonesPreparedFrame = 0;
+  mLastVisibleFrame = 0;
+  mAnimationLodIndex = -1;
+  mAnimationPhase = msNextAnimationPhase++;
 }
 //-----------------------------------------------------------------------
 Entity::Entity( const String& name, Mesh* mesh, SceneManager* creator) :
@@ -49,6 +89,9 @@ Entity::Entity( const String& name, Mesh* mesh, SceneManager* creator) :
   mCreatorSceneManager(creator) {
   mFullBoundingBox = new AxisAlignedBox;
 
+  // Sub entities point into the mesh, so it mustn't be paged out
+  mesh->addReference();
+
   // Build main subentity list
   buildSubEntityList(mesh, &mSubEntityList);
 
@@ -60,6 +103,7 @@ Entity::Entity( const String& name, Mesh* mesh, SceneManager* creator) :
     for (i = 1; i < numLod; ++i) {
       SubEntityList* sublist = new SubEntityList();
       const Mesh::MeshLodUsage& usage = mesh->getLodLevel(i);
+      usage.manualMesh->addReference();
       buildSubEntityList(usage.manualMesh, sublist);
       mLodSubEntityList.push_back(sublist);
     }
@@ -72,10 +116,27 @@ Entity::Entity( const String& name, Mesh* mesh, SceneManager* creator) :
     mesh->_initAnimationState(&mAnimationState);
     mNumBoneMatrices = mesh->_getNumBoneMatrices();
     mBoneMatrices = new Matrix4[mNumBoneMatrices];
+    mBoneModelMatrices = new Matrix4[mNumBoneMatrices];
+    mBoneDualQuats = new Real[mNumBoneMatrices * 8];
   } else {
     mBoneMatrices = 0;
+    mBoneModelMatrices = 0;
+    mBoneDualQuats = 0;
     mNumBoneMatrices = 0;
   }
+  mBoneModelMesh = 0;
+  mBonesSkippedMinor = false;
+  mBonePoseHash = 0;
+  mBoneDualQuatsValid = false;
+  mBonesPrepared = false;
+  mBonesPreparedFrame = 0;
+  mLastVisibleFrame = 0;
+  mAnimationLodIndex = -1;
+  mAnimationPhase = msNextAnimationPhase++;
+  mSkinnedPose = 0;
+  mSkinnedPoseMesh = 0;
+  mSkinningMethod = SKIN_LINEAR;
+  mSkinningMethodOverridden = false;
 
   mDisplaySkeleton = false;
 
@@ -109,8 +170,24 @@ Entity::~Entity() {
     delete (*li);
 
   }
+  // Release the meshes & baked animations
+  if (mMesh->isLodManual()) {
+    for (ushort l = 1; l < mMesh->getNumLodLevels(); ++l) {
+      mMesh->getLodLevel(l).manualMesh->removeReference();
+    }
+  }
+  mMesh->removeReference();
+  BakedAnimationList::iterator bi;
+  for (bi = mBakedAnimations.begin(); bi != mBakedAnimations.end(); ++bi) {
+    bi->second.baked->removeReference();
+  }
   if (mBoneMatrices)
     delete [] mBoneMatrices;
+  if (mBoneModelMatrices)
+    delete [] mBoneModelMatrices;
+  if (mBoneDualQuats)
+    delete [] mBoneDualQuats;
+  releaseSkinnedPose();
 
   delete mFullBoundingBox;
 }
@@ -150,6 +227,15 @@ Entity* Entity::clone( const String& newName) {
     newEnt->getSubEntity(n)->setMaterialName((*i)->getMaterialName());
   }
   newEnt->mAnimationState = mAnimationState;
+  newEnt->mSkinningMethod = mSkinningMethod;
+  newEnt->mSkinningMethodOverridden = mSkinningMethodOverridden;
+  newEnt->mAnimationLodLevels = mAnimationLodLevels;
+  // The clone holds its own reference to each baked animation, released
+  // in its destructor
+  newEnt->mBakedAnimations = mBakedAnimations;
+  BakedAnimationList::iterator bi;
+  for (bi = newEnt->mBakedAnimations.begin(); bi != newEnt->mBakedAnimations.end(); ++bi)
+    bi->second.baked->addReference();
   return newEnt;
 }
 //-----------------------------------------------------------------------
@@ -178,6 +264,13 @@ void Entity::_notifyCurrentCamera(Camera* cam) {
     // Apply minimum detail restriction (remember higher = lower detail)
     mMeshLodIndex = std::min(mMinMeshLodIndex, mMeshLodIndex);
 
+    // Animation LOD, from the same biased depth
+    mAnimationLodIndex = -1;
+    for (size_t i = 0; i < mAnimationLodLevels.size(); ++i) {
+      if (squaredDepth < mAnimationLodLevels[i].fromDepthSquared)
+        break;
+      mAnimationLodIndex = (int)i;
+    }
 
   }
   // Notify any child objects
@@ -244,6 +337,7 @@ void Entity::_updateRenderQueue(RenderQueue* queue) {
   // Since we know we're going to be rendered, take this opportunity to
   // cache bone matrices & apply world matrix to them
   if (mMesh->hasSkeleton()) {
+    mLastVisibleFrame = Root::getSingleton().getCurrentFrameNumber();
     cacheBoneMatrices();
 
     //--- pass this point,  we are sure that the transformation matrix of each bone and tagPoint have been updated
@@ -291,45 +385,188 @@ const String Entity::getMovableType(void) const {
   return msMovableType;
 }
 //-----------------------------------------------------------------------
-void Entity::cacheBoneMatrices(void) {
+Mesh* Entity::getSkeletonMesh(void) const {
   // Get the appropriate meshes skeleton here
   // Can use lower LOD mesh skeleton if mesh LOD is manual
   // We make the assumption that lower LOD meshes will have
   //   fewer bones than the full LOD, therefore marix stack will be
   //   big enough.
-  Mesh* theMesh;
   if (mMesh->isLodManual() && mMeshLodIndex > 1) {
     // Use lower detail skeleton
-    theMesh = mMesh->getLodLevel(mMeshLodIndex).manualMesh;
+    Mesh* lodMesh = mMesh->getLodLevel(mMeshLodIndex).manualMesh;
     // Lower detail may not have skeleton
-    if (!theMesh->hasSkeleton()) {
-      mNumBoneMatrices = 0;
+    return lodMesh->hasSkeleton() ? lodMesh : 0;
+  }
+  // Use normal mesh
+  return mMesh->hasSkeleton() ? mMesh : 0;
+}
+//-----------------------------------------------------------------------
+void Entity::evaluateBones(Mesh* theMesh) {
+  // Animation LOD; distant entities reuse their last bones on most frames
+  unsigned short updateInterval = 1;
+  bool skipMinorBones = false;
+  if (mAnimationLodIndex >= 0 && mChildObjectList.empty()) {
+    const AnimationLodLevel& level = mAnimationLodLevels[mAnimationLodIndex];
+    updateInterval = level.updateInterval;
+    skipMinorBones = level.skipMinorBones;
+  }
+  bool evaluate = updateInterval <= 1 ||
+                  mBoneModelMesh != theMesh ||
+                  mBonesSkippedMinor != skipMinorBones ||
+                  (Root::getSingleton().getCurrentFrameNumber() + mAnimationPhase) % updateInterval == 0;
+  if (!evaluate) {
+    return;
+  }
+
+  Skeleton* skel = theMesh->getSkeleton();
+  RenderSystem* rsys = Root::getSingleton().getRenderSystem();
+  bool dualQuats = rsys && !rsys->_isVertexBlendSupported() &&
+                   getSkinningMethod() == SKIN_DUAL_QUATERNION;
+
+  Real bakedTime = 0;
+  const BakedAnimationUsage* pBaked = findBakedAnimation(theMesh, bakedTime);
+  uint64 poseHash = pBaked ?
+                    pBaked->baked->_getPoseHash(bakedTime, pBaked->interpolate) :
+                    skel->_getPoseHash(mAnimationState, skipMinorBones);
+
+  if (mChildObjectList.empty()) {
+    // Still holding this pose?
+    if (mBoneModelMesh == theMesh && mBonePoseHash == poseHash &&
+        (mBoneDualQuatsValid || !dualQuats)) {
       return;
     }
+    if (pBaked) {
+      pBaked->baked->_getBoneMatrices(bakedTime, pBaked->interpolate, mBoneModelMatrices);
+      if (dualQuats) {
+        unsigned short numBones = theMesh->_getNumBoneMatrices();
+        for (unsigned short b = 0; b < numBones; ++b) {
+          Skeleton::_toDualQuaternion(mBoneModelMatrices[b], mBoneDualQuats + 8 * b);
+        }
+      }
+    } else {
+      skel->_evaluatePose(mAnimationState, skipMinorBones, mPoseBuffer,
+                          mBoneModelMatrices, dualQuats ? mBoneDualQuats : 0);
+    }
   } else {
-    // Use normal mesh
-    theMesh = mMesh;
+    // The tag points of attached objects follow the Bone objects, so pose
+    // those; this also moves the tag points along with the entity
+    skel->setAnimationState(mAnimationState, skipMinorBones);
+    skel->_getBoneMatrices(mBoneModelMatrices, this);
+    if (dualQuats) {
+      skel->_getBoneDualQuaternions(mBoneDualQuats);
+    }
   }
 
-  // Tell the skeleton who's making a call to update him
-  theMesh->getSkeleton()->setCurrentEntity(this);
+  mNumBoneMatrices = theMesh->_getNumBoneMatrices();
+  mBoneModelMesh = theMesh;
+  mBonesSkippedMinor = skipMinorBones;
+  mBonePoseHash = poseHash;
+  mBoneDualQuatsValid = dualQuats;
+}
+//-----------------------------------------------------------------------
+Skeleton* Entity::_getSkeletonToAnimate(void) const {
+  if (!mChildObjectList.empty()) {
+    return 0;
+  }
+  if (mLastVisibleFrame + 1 < Root::getSingleton().getCurrentFrameNumber()) {
+    // Not seen lately, so probably won't be rendered
+    return 0;
+  }
+  Mesh* theMesh = getSkeletonMesh();
+  return theMesh ? theMesh->getSkeleton() : 0;
+}
+//-----------------------------------------------------------------------
+void Entity::_updateAnimation(void) {
+  Mesh* theMesh = getSkeletonMesh();
+  if (!theMesh) {
+    return;
+  }
+  evaluateBones(theMesh);
+  mBonesPrepared = true;
+  mBonesPreparedFrame = Root::getSingleton().getCurrentFrameNumber();
+}
+//-----------------------------------------------------------------------
+void Entity::cacheBoneMatrices(void) {
+  Mesh* theMesh = getSkeletonMesh();
+  if (!theMesh) {
+    mNumBoneMatrices = 0;
+    mBoneModelMesh = 0;
+    mBonesPrepared = false;
+    releaseSkinnedPose();
+    return;
+  }
 
-  theMesh->_getBoneMatrices(mAnimationState, mBoneMatrices);
-  // Reset the skeleton to 'no caller'
-  theMesh->getSkeleton()->setCurrentEntity(0);
+  // Use the bones from _updateAnimation if it ran this frame; the mesh LOD may
+  // have changed since, when the entity was culled
+  if (!mBonesPrepared ||
+      mBonesPreparedFrame != Root::getSingleton().getCurrentFrameNumber() ||
+      mBoneModelMesh != theMesh) {
+    // Not evaluated on another thread, so prepare here
+    if (mChildObjectList.empty()) {
+      theMesh->getSkeleton()->_prepareForEvaluation();
+    }
+    evaluateBones(theMesh);
+  }
+  mBonesPrepared = false;
+
+  RenderSystem* rsys = Root::getSingleton().getRenderSystem();
+  if (rsys && !rsys->_isVertexBlendSupported()) {
+    // Software skinning; share the blended vertices with any other entity
+    // in the same pose, and only blend again when the pose changes
+    if (mSkinnedPoseMesh != theMesh) {
+      releaseSkinnedPose();
+      mSkinnedPoseMesh = theMesh;
+    }
+    SkinningMethod method = getSkinningMethod();
+    if (method == SKIN_DUAL_QUATERNION && !mBoneDualQuatsValid) {
+      // Method changed since the bones were evaluated; do them again
+      mBoneModelMesh = 0;
+      if (mChildObjectList.empty()) {
+        theMesh->getSkeleton()->_prepareForEvaluation();
+      }
+      evaluateBones(theMesh);
+    }
+    mSkinnedPose = theMesh->_updateSkinnedPose(mSkinnedPose, mBonePoseHash, method);
+    if (!mSkinnedPose->skinned) {
+      if (method == SKIN_DUAL_QUATERNION) {
+        theMesh->_skinPose(mSkinnedPose, mBoneModelMatrices, mBoneDualQuats);
+      } else {
+        theMesh->_skinPose(mSkinnedPose, mBoneModelMatrices);
+      }
+    }
+  } else {
+    releaseSkinnedPose();
+  }
 
   // Apply our current world transform to these too, since these are used as
-  // replacement world matrices
+  // replacement world matrices; done every frame since the entity may move
+  // while its bones are not being updated
   int i;
   Matrix4 worldXform = _getParentNodeFullTransform();
-  mNumBoneMatrices = theMesh->_getNumBoneMatrices();
 
   for (i = 0; i < mNumBoneMatrices; ++i) {
-    mBoneMatrices[i] = worldXform * mBoneMatrices[i];
+    mBoneMatrices[i] = worldXform * mBoneModelMatrices[i];
   }
 
 }
 //-----------------------------------------------------------------------
+void Entity::releaseSkinnedPose(void) {
+  if (mSkinnedPose) {
+    mSkinnedPoseMesh->_releaseSkinnedPose(mSkinnedPose);
+    mSkinnedPose = 0;
+  }
+  mSkinnedPoseMesh = 0;
+}
+//-----------------------------------------------------------------------
+void Entity::setSkinningMethod(SkinningMethod method) {
+  mSkinningMethod = method;
+  mSkinningMethodOverridden = true;
+}
+//-----------------------------------------------------------------------
+SkinningMethod Entity::getSkinningMethod(void) const {
+  return mSkinningMethodOverridden ? mSkinningMethod : mMesh->getSkinningMethod();
+}
+//-----------------------------------------------------------------------
 void Entity::setDisplaySkeleton(bool display) {
   mDisplaySkeleton = display;
 }
@@ -342,6 +579,95 @@ void Entity::setLodBias(Real factor, ushort maxDetailIndex, ushort minDetailInde
 
 }
 //-----------------------------------------------------------------------
+void Entity::addAnimationLodLevel(Real fromDepth, unsigned short updateInterval,
+                                  bool skipMinorBones) {
+  assert(updateInterval > 0 && "Update interval must be at least 1 frame");
+
+  AnimationLodLevel level;
+  level.fromDepthSquared = fromDepth * fromDepth;
+  level.updateInterval = updateInterval;
+  level.skipMinorBones = skipMinorBones;
+
+  // Keep nearest first
+  AnimationLodLevelList::iterator i = mAnimationLodLevels.begin();
+  while (i != mAnimationLodLevels.end() && i->fromDepthSquared <= level.fromDepthSquared)
+    ++i;
+  mAnimationLodLevels.insert(i, level);
+}
+//-----------------------------------------------------------------------
+void Entity::removeAllAnimationLodLevels(void) {
+  mAnimationLodLevels.clear();
+  mAnimationLodIndex = -1;
+}
+//-----------------------------------------------------------------------
+void Entity::bakeAnimation(const String& animName, Real sampleRate, bool interpolate) {
+  if (!mMesh->hasSkeleton()) {
+    Except(Exception::ERR_INVALIDPARAMS, "Entity " + mName + " has no skeleton to animate.",
+           "Entity::bakeAnimation");
+  }
+
+  BakedAnimationUsage usage;
+  usage.baked = BakedAnimationManager::getSingleton().load(mMesh->getSkeleton(),
+                animName, sampleRate);
+  usage.interpolate = interpolate;
+  // Held for as long as the entity uses it
+  usage.baked->addReference();
+  BakedAnimationList::iterator i = mBakedAnimations.find(animName);
+  if (i != mBakedAnimations.end())
+    i->second.baked->removeReference();
+  mBakedAnimations[animName] = usage;
+  // Make sure the palette is redone from the table
+  mBoneModelMesh = 0;
+}
+//-----------------------------------------------------------------------
+void Entity::removeBakedAnimation(const String& animName) {
+  BakedAnimationList::iterator i = mBakedAnimations.find(animName);
+  if (i != mBakedAnimations.end()) {
+    i->second.baked->removeReference();
+    mBakedAnimations.erase(i);
+  }
+  mBoneModelMesh = 0;
+}
+//-----------------------------------------------------------------------
+const Entity::BakedAnimationUsage* Entity::findBakedAnimation(Mesh* theMesh,
+    Real& timePos) const {
+  if (mBakedAnimations.empty() || !mChildObjectList.empty()) {
+    return 0;
+  }
+
+  // Only stands in for a single animation
+  const AnimationState* pState = 0;
+  AnimationStateSet::const_iterator i;
+  for (i = mAnimationState.begin(); i != mAnimationState.end(); ++i) {
+    if (i->second.getEnabled()) {
+      if (pState) {
+        return 0;
+      }
+      pState = &i->second;
+    }
+  }
+  if (!pState) {
+    return 0;
+  }
+
+  BakedAnimationList::const_iterator bi = mBakedAnimations.find(pState->getAnimationName());
+  if (bi == mBakedAnimations.end()) {
+    return 0;
+  }
+  const BakedAnimation* baked = bi->second.baked;
+  // A manual LOD may have its own skeleton, and the table may have been paged out
+  if (baked->getSkeleton() != theMesh->getSkeleton() || !baked->isLoaded()) {
+    return 0;
+  }
+  if (baked->getSkeleton()->getBlendMode() == ANIMBLEND_CUMULATIVE &&
+      pState->getWeight() != 1.0f) {
+    return 0;
+  }
+
+  timePos = pState->getTimePosition();
+  return &bi->second;
+}
+//-----------------------------------------------------------------------
 void Entity::buildSubEntityList(Mesh* mesh, SubEntityList* sublist) {
   // Create SubEntities
   int i, numSubMeshes;
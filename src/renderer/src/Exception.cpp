@@ -37,6 +37,8 @@ Exception* Exception::last = NULL;
 
 OgreChar Exception::msFunctionStack[ OGRE_CALL_STACK_DEPTH ][ 256 ];
 ushort   Exception::msStackDepth = 0;
+// Statics are initialised on the main thread
+base::PlatformThreadId Exception::msStackThread = base::PlatformThread::CurrentId();
 
 Exception::Exception(int num, const String& desc, const String& src) :
   line( 0 ),
@@ -135,6 +137,8 @@ Exception* Exception::getLastException(void) throw() {
 
 //-----------------------------------------------------------------------
 void Exception::_pushFunction( const String& strFuncName ) throw() {
+  if( base::PlatformThread::CurrentId() != msStackThread )
+    return;
   if( msStackDepth < OGRE_CALL_STACK_DEPTH )
     strncpy( msFunctionStack[ msStackDepth ], strFuncName.c_str(), 255 );
   msStackDepth++;
@@ -142,6 +146,8 @@ void Exception::_pushFunction( const String& strFuncName ) throw() {
 
 //-----------------------------------------------------------------------
 void Exception::_popFunction() throw() {
+  if( base::PlatformThread::CurrentId() != msStackThread )
+    return;
   msStackDepth--;
 }
 }
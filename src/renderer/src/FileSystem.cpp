@@ -8,6 +8,7 @@
 #include "Exception.h"
 #include "StringVector.h"
 #include "Root.h"
+#include "MappedFile.h"
 
 
 
@@ -34,44 +35,87 @@ namespace renderer {
 FileSystemFactory* pFSFactory = NULL;
 
 //-----------------------------------------------------------------------
-bool FileSystem::fileOpen( const String& strFile, FILE **ppFile ) const {
-  setPath();
+/* Every path is made absolute from the archive's base path, rather than
+   changing the working directory around each call. That was not safe when
+   files are read from more than one thread, and changed the directory under
+   the rest of the application's feet too.
+*/
+static bool isDirectory( String strPath ) {
+  // stat fails on directories with a trailing separator on some platforms
+  while( strPath.size() > 1 &&
+         ( strPath[strPath.size()-1] == '/' || strPath[strPath.size()-1] == '\\' ) )
+    strPath.erase( strPath.size()-1 );
 
-  FILE *pFile;
-  pFile = fopen( strFile.c_str(), "r+b" );
-  ppFile = &pFile;
+  struct stat tagStat;
+  if( stat( strPath.c_str(), &tagStat ) )
+    return false;
+  return ( tagStat.st_mode & S_IFDIR ) != 0;
+}
 
-  retunset(true);
+//-----------------------------------------------------------------------
+static String makePattern( const String& strDir, const String& strPattern ) {
+  String str = strDir;
+  if( str[str.size()-1] != '/' && str[str.size()-1] != '\\' )
+    str += '/';
+  return str + strPattern;
 }
 
 //-----------------------------------------------------------------------
-bool FileSystem::fileRead( const String& strFile, DataChunk **ppChunk ) const {
-  setPath();
+String FileSystem::getFullPath( const String& strFile ) const {
+  if( strFile.empty() )
+    return mstrBasePath;
+  return mstrBasePath + '/' + strFile;
+}
 
-  struct stat tagStat;
+//-----------------------------------------------------------------------
+bool FileSystem::fileOpen( const String& strFile, FILE **ppFile ) const {
+  *ppFile = fopen( getFullPath( strFile ).c_str(), "r+b" );
+  return *ppFile != NULL;
+}
+
+//-----------------------------------------------------------------------
+bool FileSystem::fileRead( const String& strFile, DataChunk **ppChunk ) const {
+  String strPath = getFullPath( strFile );
   DataChunk *pChunk = *ppChunk;
 
-  stat( strFile.c_str(), &tagStat );
-  pChunk->allocate( tagStat.st_size );
+  // Map the file so it is parsed straight out of the page cache, rather
+  // than copied into a buffer first
+  MappedFile* pMapped = MappedFile::open( strPath );
+  if( pMapped ) {
+    pChunk->map( pMapped );
+    return true;
+  }
+
+  // Not mappable; it may be empty, or not exist at all
+  struct stat tagStat;
+  if( stat( strPath.c_str(), &tagStat ) )
+    return false;
+  if( tagStat.st_size == 0 ) {
+    pChunk->clear();
+    return true;
+  }
 
-  FILE* pFile = fopen( strFile.c_str(), "rb" );
+  FILE* pFile = fopen( strPath.c_str(), "rb" );
+  if( !pFile )
+    return false;
 
+  pChunk->allocate( tagStat.st_size );
   fread( (void*)pChunk->getPtr(), tagStat.st_size, 1, pFile );
   fclose( pFile );
 
-  retunset(true);
+  return true;
 }
 
 //-----------------------------------------------------------------------
 bool FileSystem::fileSave( FILE *pFile, const String& strPath, bool bOverwrite /* = false */ ) {
-  setPath();
+  String strFullPath = getFullPath( strPath );
 
-  FILE *pArchFile = fopen( strPath.c_str(), "r" );
+  FILE *pArchFile = fopen( strFullPath.c_str(), "r" );
   if( !pArchFile || ( pFile && bOverwrite ) ) {
     if( pArchFile )
-      freopen( strPath.c_str(), "wb", pArchFile );
+      freopen( strFullPath.c_str(), "wb", pArchFile );
     else
-      pArchFile = fopen( strPath.c_str(), "wb" );
+      pArchFile = fopen( strFullPath.c_str(), "wb" );
 
     long lPos = ftell( pFile );
     fseek( pFile, 0, SEEK_END );
@@ -86,70 +130,66 @@ bool FileSystem::fileSave( FILE *pFile, const String& strPath, bool bOverwrite /
     fseek( pFile, lPos, SEEK_SET );
     fclose( pArchFile );
 
-    retunset(true);
+    return true;
   }
-  retunset(false);
+  return false;
 }
 
 //-----------------------------------------------------------------------
 bool FileSystem::fileWrite( const DataChunk& refChunk, const String& strPath, bool bOverwrite /* = false */ ) {
-  setPath();
+  String strFullPath = getFullPath( strPath );
 
-  FILE* pFile = fopen( strPath.c_str(), "r" );
+  FILE* pFile = fopen( strFullPath.c_str(), "r" );
   if( !pFile || ( pFile && bOverwrite ) ) {
     if( pFile )
-      freopen( strPath.c_str(), "wb", pFile );
+      freopen( strFullPath.c_str(), "wb", pFile );
     else
-      pFile = fopen( strPath.c_str(), "wb" );
+      pFile = fopen( strFullPath.c_str(), "wb" );
 
     fwrite( (const void*)refChunk.getPtr(), refChunk.getSize(), 1, pFile );
     fclose(pFile);
 
-    retunset(true);
+    return true;
   }
 
-  retunset(false);
+  return false;
 }
 
 //-----------------------------------------------------------------------
 bool FileSystem::fileTest( const String& strFile ) const {
-  setPath();
-
-  char szPath[MAX_PATH+1];
-  _getcwd( szPath, MAX_PATH);
-
   struct stat tagStat;
-  if(!stat( strFile.c_str(), &tagStat ))
-    retunset(true);
-  retunset(false);
+  if(!stat( getFullPath( strFile ).c_str(), &tagStat ))
+    return true;
+  return false;
 }
 
 //-----------------------------------------------------------------------
 bool FileSystem::fileCopy( const String& strSrc, const String& strDest, bool bOverwrite ) {
-  setPath();
-
   FILE* pSrcFile, *pDestFile;
   struct stat tagStat;
   int iCh;
 
   if( strSrc != strDest ) {
-    pDestFile = fopen(strDest.c_str(), "r" );
+    String strSrcPath = getFullPath( strSrc );
+    String strDestPath = getFullPath( strDest );
+
+    pDestFile = fopen(strDestPath.c_str(), "r" );
 
     if( pDestFile == NULL )
-      pDestFile = fopen( strDest.c_str(), "wb" );
+      pDestFile = fopen( strDestPath.c_str(), "wb" );
     else if( pDestFile != NULL && bOverwrite == true ) {
       fclose( pDestFile );
-      pDestFile = fopen( strDest.c_str(), "wb" );
+      pDestFile = fopen( strDestPath.c_str(), "wb" );
     }
 
     if( pDestFile == 0 )
-      retunset(false);
+      return false;
 
-    pSrcFile = fopen( strSrc.c_str(), "rb" );
+    pSrcFile = fopen( strSrcPath.c_str(), "rb" );
     if( !pSrcFile )
-      retunset(false);
+      return false;
 
-    stat( strSrc.c_str(), &tagStat );
+    stat( strSrcPath.c_str(), &tagStat );
 
     for( long lI=0; lI<tagStat.st_size; lI++ ) {
       iCh = fgetc( pSrcFile );
@@ -159,50 +199,44 @@ bool FileSystem::fileCopy( const String& strSrc, const String& strDest, bool bOv
     fclose( pDestFile );
     fclose( pSrcFile );
 
-    retunset(true);
+    return true;
   }
 
-  retunset(false);
+  return false;
 }
 
 //-----------------------------------------------------------------------
 bool FileSystem::fileMove( const String& strSrc, const String& strDest, bool bOverwrite ) {
-  setPath();
-
   if( fileCopy( strSrc, strDest, bOverwrite ) ) {
-    if( _unlink( strSrc.c_str() ) ) {
-      retunset(true);
-    } else {
-      retunset(false);
-    }
-  } else
-    retunset(false);
+    if( !_unlink( getFullPath( strSrc ).c_str() ) )
+      return true;
+  }
+  return false;
 }
 
 //-----------------------------------------------------------------------
 bool FileSystem::fileDele( const String& strFile ) {
-  setPath();
+  String strPath = getFullPath( strFile );
 
-  FILE* pFile = fopen( strFile.c_str(), "r" );
+  FILE* pFile = fopen( strPath.c_str(), "r" );
 
   if( !pFile )
-    retunset(false);
+    return false;
   fclose( pFile );
 
-  _unlink( strFile.c_str() );
+  _unlink( strPath.c_str() );
 
-  retunset(true);
+  return true;
 }
 
 //-----------------------------------------------------------------------
 bool FileSystem::fileInfo( const String& strFile, FileInfo** ppInfo ) const {
-  setPath();
   FileInfo* pInfo = *ppInfo;;
 
   struct stat tagStat;
-  if( !stat( strFile.c_str(), &tagStat ) ) {
+  if( stat( getFullPath( strFile ).c_str(), &tagStat ) ) {
     pInfo = NULL;
-    retunset(false);
+    return false;
   }
 
   pInfo->iCompSize = pInfo->iUncompSize = tagStat.st_size;
@@ -210,32 +244,21 @@ bool FileSystem::fileInfo( const String& strFile, FileInfo** ppInfo ) const {
 
   strcpy( pInfo->szFilename, strFile.c_str() );
 
-  retunset(true);
-}
-
-//-----------------------------------------------------------------------
-void FileSystem::setPath() const {
-  _getcwd( mszTempPath, MAX_PATH );
-  _chdir( mstrBasePath.c_str() );
-}
-
-//-----------------------------------------------------------------------
-void FileSystem::unsetPath() const {
-  _chdir( mszTempPath );
+  return true;
 }
 
 //-----------------------------------------------------------------------
 std::vector<String> FileSystem::dirGetFiles( const String& strDir ) const {
   std::vector<String> vec;
 
-  setPath();
-  if( _chdir( strDir.c_str() ) == -1 )
+  String strPath = getFullPath( strDir );
+  if( !isDirectory( strPath ) )
     Except(Exception::ERR_FILE_NOT_FOUND, "Cannot open requested directory", "FileSystem::dirGetFiles");
 
   long lHandle;
   struct _finddata_t tagData;
 
-  if( ( lHandle = _findfirst( "*.*", &tagData ) ) != -1 ) {
+  if( ( lHandle = _findfirst( makePattern( strPath, "*.*" ).c_str(), &tagData ) ) != -1 ) {
     _findnext( lHandle, &tagData );
 
     // okay, we skipped . and .., get to the good stuff
@@ -248,21 +271,21 @@ std::vector<String> FileSystem::dirGetFiles( const String& strDir ) const {
     _findclose(lHandle);
   }
 
-  retunset(vec);
+  return vec;
 };
 
 //-----------------------------------------------------------------------
 std::vector<String> FileSystem::dirGetSubs( const String& strDir ) const {
   std::vector<String> vec;
 
-  setPath();
-  if( _chdir( strDir.c_str() ) == -1 )
+  String strPath = getFullPath( strDir );
+  if( !isDirectory( strPath ) )
     Except(Exception::ERR_FILE_NOT_FOUND, "Cannot open requested directory", "FileSystem::dirGetFiles");
 
   long lHandle;
   struct _finddata_t tagData;
 
-  if( ( lHandle = _findfirst( "*.*", &tagData ) ) != -1 ) {
+  if( ( lHandle = _findfirst( makePattern( strPath, "*.*" ).c_str(), &tagData ) ) != -1 ) {
     _findnext( lHandle, &tagData );
 
     // okay, we skipped . and .., get to the good stuff
@@ -275,20 +298,20 @@ std::vector<String> FileSystem::dirGetSubs( const String& strDir ) const {
     _findclose(lHandle);
   }
 
-  retunset(vec);
+  return vec;
 };
 
 //-----------------------------------------------------------------------
 bool FileSystem::dirDele( const String& strDir, bool bRecursive ) {
-  setPath();
-  if( _chdir( strDir.c_str() ) == -1 )
-    retunset(true);
+  String strPath = getFullPath( strDir );
+  if( !isDirectory( strPath ) )
+    return true;
 
-  recursDeleDir( bRecursive );
-  if( _rmdir( strDir.c_str() ) == -1 )
-    retunset(false);
+  recursDeleDir( strPath, bRecursive );
+  if( _rmdir( strPath.c_str() ) == -1 )
+    return false;
 
-  retunset(true);
+  return true;
 };
 
 //-----------------------------------------------------------------------
@@ -318,10 +341,9 @@ std::vector<String> FileSystem::getAllNamesLike( const String& strStartPath, con
   long lHandle, res;
   struct _finddata_t tagData;
 
-  setPath();
-  _chdir(strStartPath.c_str());
+  String strSearch = makePattern( getFullPath( strStartPath ), "*" + strPattern );
 
-  lHandle = _findfirst(("*" + strPattern).c_str(), &tagData);
+  lHandle = _findfirst(strSearch.c_str(), &tagData);
   res = 0;
   while (lHandle != -1 && res != -1) {
     retList.push_back(tagData.name);
@@ -330,59 +352,43 @@ std::vector<String> FileSystem::getAllNamesLike( const String& strStartPath, con
   if(lHandle != -1)
     _findclose(lHandle);
 
-  retunset(retList);
+  return retList;
 };
 
 //-----------------------------------------------------------------------
-void FileSystem::recursDeleDir( bool bRecursive ) {
+void FileSystem::recursDeleDir( const String& strDir, bool bRecursive ) {
   long lHandle;
   struct _finddata_t tagData;
 
-  if( ( lHandle = _findfirst( "*.*", &tagData ) ) != -1 ) {
+  if( ( lHandle = _findfirst( makePattern( strDir, "*.*" ).c_str(), &tagData ) ) != -1 ) {
     _findnext( lHandle, &tagData );
 
-    while( _findnext( lHandle, &tagData ) == 0 )
+    while( _findnext( lHandle, &tagData ) == 0 ) {
+      String strPath = makePattern( strDir, tagData.name );
       if( !( tagData.attrib & _A_SUBDIR ) )
-        _unlink( tagData.name );
+        _unlink( strPath.c_str() );
       else if( bRecursive ) {
-        _chdir( tagData.name );
-        recursDeleDir( true );
-        _rmdir( tagData.name );
+        recursDeleDir( strPath, true );
+        _rmdir( strPath.c_str() );
       }
+    }
     _findclose(lHandle);
   }
-
-  _chdir( ".." );
 }
 
 //-----------------------------------------------------------------------
 void FileSystem::load() {
-
-  /* SJS: Dropped the 'stat' check
-  For starters must check the result from stat - if non-zero the struct is unreliable (garbage)
-  After running a number of tests stat never seemed to work for folders anyway, the result was always
-  -1 and the S_IFDIR check was purely random. Should work but doesn't?
-
-  struct stat tagStat;
-  int statResult;
-
-  stat( mName.c_str(), &tagStat );
-
-  if( !( tagStat.st_mode & S_IFDIR ) )
-      throw Exception(Exception::ERR_ITEM_NOT_FOUND, "Cannot find folder " + mName, "FileSystem::load");
-  else
-      mstrBasePath = mName;
-  */
-
-  /* cearny: Simplest solution is always the best. If I can't chdir to the given path, then it musn't
-  be a directory */
-  char szCurrPath[260];
-  _getcwd( szCurrPath, 259 );
-  if( _chdir( mName.c_str() ) )
+  // Resolve the base path now, so that later calls don't depend on the
+  // working directory
+  char szFullPath[MAX_PATH+1];
+#if OGRE_PLATFORM == PLATFORM_WIN32
+  if( !_fullpath( szFullPath, mName.c_str(), MAX_PATH ) || !isDirectory( szFullPath ) )
+#else
+  if( !realpath( mName.c_str(), szFullPath ) || !isDirectory( szFullPath ) )
+#endif
     Except( Exception::ERR_ITEM_NOT_FOUND, "Cannot find folder " + mName, "FileSystem::load" );
-  _chdir( szCurrPath );
 
-  mstrBasePath = mName;
+  mstrBasePath = szFullPath;
 
   LogManager::getSingleton().logMessage( "FileSystem Archive Codec for " + mName + " created.");
 };
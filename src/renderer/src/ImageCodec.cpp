@@ -30,10 +30,18 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include <IL/il.h>
 #include <IL/ilu.h>
 
+#include "base/synchronization/lock.h"
+
 namespace renderer {
 
 bool ImageCodec::_is_initialized = false;
 
+namespace {
+/// DevIL works on a global bound image, so only one thread may use it at a
+/// time; textures are decoded on worker threads (see Texture::prepare)
+base::Lock gDevILLock;
+}
+
 #if 0
 //---------------------------------------------------------------------
 void ImageCodec::codeToFile( const DataChunk& input,
@@ -78,6 +86,8 @@ ImageCodec::ImageData * ImageCodec::decode( const DataChunk& input, DataChunk* o
   ILint Imagformat, BytesPerPixel;
   ImageData * ret_data = new ImageData;
 
+  base::AutoLock lock(gDevILLock);
+
   // Ensure DevIL is started
   if( !_is_initialized ) {
     ilInit();
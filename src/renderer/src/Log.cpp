@@ -25,6 +25,8 @@ http://www.gnu.org/copyleft/lesser.txt.
 
 #include "Log.h"
 
+#include "base/synchronization/lock.h"
+
 namespace renderer {
 
 //-----------------------------------------------------------------------
@@ -32,14 +34,17 @@ Log::Log( const String& name, bool debuggerOuput ) {
   mfpLog.open(name.c_str());
   mDebugOut = debuggerOuput;
   mLogLevel = LL_NORMAL;
+  mLock = new base::Lock();
 }
 //-----------------------------------------------------------------------
 Log::~Log() {
   mfpLog.close();
+  delete mLock;
 }
 //-----------------------------------------------------------------------
 void Log::logMessage( const String& message, LogMessageLevel lml ) {
   if ((mLogLevel + lml) >= LOG_THRESHOLD) {
+    base::AutoLock l(*mLock);
     if (mDebugOut)
       fprintf( stderr, "%s\n", message.c_str());
 
@@ -0,0 +1,95 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#include "MappedFile.h"
+
+#if OGRE_PLATFORM == PLATFORM_WIN32
+#   include <windows.h>
+#else
+#   include <sys/types.h>
+#   include <sys/stat.h>
+#   include <sys/mman.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+namespace renderer {
+
+//-----------------------------------------------------------------------
+MappedFile* MappedFile::open(const String& path) {
+#if OGRE_PLATFORM == PLATFORM_WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return 0;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return 0;
+  }
+
+  // The view keeps the file open, so neither handle is needed after this
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!mapping)
+    return 0;
+  void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+  CloseHandle(mapping);
+  if (!data)
+    return 0;
+
+  return new MappedFile(static_cast<uchar*>(data),
+                        static_cast<size_t>(size.QuadPart));
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    return 0;
+
+  struct stat tagStat;
+  if (fstat(fd, &tagStat) || tagStat.st_size == 0) {
+    close(fd);
+    return 0;
+  }
+
+  size_t size = static_cast<size_t>(tagStat.st_size);
+  void* data = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return 0;
+
+  return new MappedFile(static_cast<uchar*>(data), size);
+#endif
+}
+
+//-----------------------------------------------------------------------
+MappedFile::~MappedFile() {
+#if OGRE_PLATFORM == PLATFORM_WIN32
+  UnmapViewOfFile(mData);
+#else
+  munmap(mData, mSize);
+#endif
+}
+
+}
@@ -861,8 +861,14 @@ MaterialManager::~MaterialManager() {
 }
 //-----------------------------------------------------------------------
 void MaterialManager::parseScript(DataChunk& chunk) {
+  ScriptNodeList nodes;
+  compileScript(chunk, nodes);
+  applyScript(nodes);
+}
+//-----------------------------------------------------------------------
+void MaterialManager::compileScript(DataChunk& chunk, ScriptNodeList& nodes) {
   String line;
-  Material* pMat;
+  ScriptNode* pMat;
   char tempBuf[512];
 
   pMat = 0;
@@ -874,8 +880,10 @@ void MaterialManager::parseScript(DataChunk& chunk) {
       if (pMat == 0) {
         // No current material
         // So first valid data should be a material name
-        // NB defer loading until later
-        pMat = (Material*)createDeferred(line);
+        nodes.push_back(ScriptNode());
+        pMat = &nodes.back();
+        pMat->tokens.push_back(line);
+        pMat->isBlock = true;
         // Skip to and over next {
         chunk.readUpTo(tempBuf, 511, "{");
       } else {
@@ -885,11 +893,13 @@ void MaterialManager::parseScript(DataChunk& chunk) {
           pMat = 0;
         } else if (line == "{") {
           // new pass
-          parseNewTextureLayer(chunk, pMat);
+          pMat->children.push_back(ScriptNode());
+          compileTextureLayer(chunk, pMat->children.back());
 
         } else {
           // Attribute
-          parseAttrib(StringToLowerASCII(line), pMat);
+          pMat->children.push_back(ScriptNode());
+          base::SplitString(StringToLowerASCII(line), &pMat->children.back().tokens, " \t");
         }
 
       }
@@ -899,11 +909,37 @@ void MaterialManager::parseScript(DataChunk& chunk) {
 
   }
 
+}
+//-----------------------------------------------------------------------
+void MaterialManager::applyScript(const ScriptNodeList& nodes) {
+  ScriptNodeList::const_iterator i, iend = nodes.end();
+  for (i = nodes.begin(); i != iend; ++i) {
+    // NB defer loading until later
+    Material* pMat = (Material*)createDeferred(i->tokens[0]);
+
+    ScriptNodeList::const_iterator c, cend = i->children.end();
+    for (c = i->children.begin(); c != cend; ++c) {
+      if (c->isBlock) {
+        // Texture layer
+        Material::TextureLayer* pLayer = pMat->addTextureLayer("");
+        ScriptNodeList::const_iterator l, lend = c->children.end();
+        for (l = c->children.begin(); l != lend; ++l) {
+          parseLayerAttrib(l->tokens, pMat, pLayer);
+        }
+      } else {
+        parseAttrib(c->tokens, pMat);
+      }
+    }
+  }
+
 }
 //-----------------------------------------------------------------------
 void MaterialManager::parseAllSources(const String& extension) {
   StringVector materialFiles;
-  DataChunk* pChunk;
+  // Files in the order they are to be applied, which decides what happens
+  // when two define the same material
+  ScriptCache::SourceList sources;
+  std::vector<const ScriptNodeList*> scripts;
 
   std::vector<ArchiveEx*>::iterator i = mVFS.begin();
 
@@ -911,11 +947,8 @@ void MaterialManager::parseAllSources(const String& extension) {
   for (; i != mVFS.end(); ++i) {
     materialFiles = (*i)->getAllNamesLike( "./", extension);
     for (StringVector::iterator si = materialFiles.begin(); si != materialFiles.end(); ++si) {
-      SDDataChunk dat;
-      pChunk = &dat;
-      (*i)->fileRead(si[0], &pChunk );
       LogManager::getSingleton().logMessage("Parsing material script: " + si[0]);
-      parseScript(dat);
+      sources.push_back(ScriptCache::Source(*i, si[0]));
     }
 
   }
@@ -923,17 +956,28 @@ void MaterialManager::parseAllSources(const String& extension) {
   for (i = mCommonVFS.begin(); i != mCommonVFS.end(); ++i) {
     materialFiles = (*i)->getAllNamesLike( "./", extension);
     for (StringVector::iterator si = materialFiles.begin(); si != materialFiles.end(); ++si) {
-      SDDataChunk dat;
-      pChunk = &dat;
-      (*i)->fileRead(si[0], &pChunk );
       LogManager::getSingleton().logMessage("Parsing material script: " + si[0]);
-      parseScript(dat);
+      sources.push_back(ScriptCache::Source(*i, si[0]));
     }
   }
 
+  // Compiled in parallel, but applied one by one on this thread
+  mScriptCache.getScripts(sources, this, scripts);
+  for (size_t s = 0; s < scripts.size(); ++s) {
+    applyScript(*scripts[s]);
+  }
+  mScriptCache.save();
 
 }
 //-----------------------------------------------------------------------
+void MaterialManager::setScriptCacheFile(const String& filename) {
+  mScriptCache.setFileName(filename);
+}
+//-----------------------------------------------------------------------
+const String& MaterialManager::getScriptCacheFile(void) const {
+  return mScriptCache.getFileName();
+}
+//-----------------------------------------------------------------------
 Resource* MaterialManager::create( const String& name) {
   // Check name not already used
   if (getByName(name) != 0)
@@ -952,11 +996,10 @@ Resource* MaterialManager::create( const String& name) {
   return m;
 }
 //-----------------------------------------------------------------------
-void MaterialManager::parseNewTextureLayer(DataChunk& chunk, Material* pMat) {
+void MaterialManager::compileTextureLayer(DataChunk& chunk, ScriptNode& layer) {
   String line;
-  Material::TextureLayer* pLayer;
 
-  pLayer = pMat->addTextureLayer("");
+  layer.isBlock = true;
 
 
   while (!chunk.isEOF()) {
@@ -967,7 +1010,19 @@ void MaterialManager::parseNewTextureLayer(DataChunk& chunk, Material* pMat) {
         // end of layer
         return;
       } else {
-        parseLayerAttrib(line, pMat, pLayer);
+        layer.children.push_back(ScriptNode());
+        StringVector& vecparams = layer.children.back().tokens;
+
+        // Split params on space
+        base::SplitString(line, &vecparams, " \t");
+
+        // Lower case the command, and all params if not texture
+        vecparams[0] = StringToLowerASCII(vecparams[0]);
+        if (vecparams[0] != "texture" && vecparams[0] != "cubic_texture" && vecparams[0] != "anim_texture") {
+          for( size_t p = 1; p < vecparams.size(); ++p )
+            vecparams[p] = StringToLowerASCII(vecparams[p]);
+
+        }
       }
     }
 
@@ -975,11 +1030,9 @@ void MaterialManager::parseNewTextureLayer(DataChunk& chunk, Material* pMat) {
   }
 }
 //-----------------------------------------------------------------------
-void MaterialManager::parseAttrib( const String& line, Material* pMat) {
-  StringVector vecparams;
-
-  // Split params on space
-  base::SplitString(line, &vecparams, " \t");
+void MaterialManager::parseAttrib( const StringVector& tokens, Material* pMat) {
+  // Parsers take a mutable iterator
+  StringVector vecparams = tokens;
   StringVector::iterator params = vecparams.begin();
 
   // Look up first param (command setting)
@@ -988,7 +1041,7 @@ void MaterialManager::parseAttrib( const String& line, Material* pMat) {
     // BAD command. BAD!
     LogManager::getSingleton().logMessage(
       "Bad material attribute line: '"
-      + line + "' in " + pMat->getName() +
+      + base::JoinString(tokens, ' ') + "' in " + pMat->getName() +
       ", unknown command '" + params[0] + "'");
   } else {
     // Use parser
@@ -999,28 +1052,19 @@ void MaterialManager::parseAttrib( const String& line, Material* pMat) {
 
 }
 //-----------------------------------------------------------------------
-void MaterialManager::parseLayerAttrib( const String& line, Material* pMat, Material::TextureLayer* pLayer) {
-  StringVector vecparams;
-
-  // Split params on space
-  base::SplitString(line, &vecparams, " \t");
+void MaterialManager::parseLayerAttrib( const StringVector& tokens, Material* pMat, Material::TextureLayer* pLayer) {
+  // Parsers take a mutable iterator
+  StringVector vecparams = tokens;
   StringVector::iterator params = vecparams.begin();
 
   // Look up first param (command setting)
-  params[0] = StringToLowerASCII(params[0]);
   LayerAttribParserList::iterator iparsers = mLayerAttribParsers.find(params[0]);
   if (iparsers == mLayerAttribParsers.end()) {
     // BAD command. BAD!
     LogManager::getSingleton().logMessage("Bad texture layer attribute line: '"
-                                          + line + "' in " + pMat->getName() + ", unknown command '" + params[0] + "'");
+                                          + base::JoinString(tokens, ' ') + "' in " + pMat->getName() + ", unknown command '" + params[0] + "'");
   } else {
     // Use parser
-    if (params[0] != "texture" && params[0] != "cubic_texture" && params[0] != "anim_texture") {
-      // Lower case all params if not texture
-      for( size_t p = 1; p < vecparams.size(); ++p )
-        params[p] = StringToLowerASCII(params[p]);
-
-    }
     iparsers->second(params, (unsigned int)vecparams.size(), pMat, pLayer);
   }
 
@@ -33,11 +33,27 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "MeshSerializer.h"
 #include "SkeletonManager.h"
 #include "Skeleton.h"
+#include "VertexInfluenceStream.h"
 #include <algorithm>
 
 
 namespace renderer {
 
+//-----------------------------------------------------------------------
+/** Memory taken by a set of geometry, in bytes. */
+static size_t geometrySize(const GeometryData& geom) {
+  size_t perVertex = sizeof(Real) * 3;
+  if (geom.hasNormals)
+    perVertex += sizeof(Real) * 3;
+  if (geom.hasColours)
+    perVertex += sizeof(unsigned long);
+  for (unsigned short t = 0; t < geom.numTexCoords; ++t) {
+    perVertex += sizeof(Real) * geom.numTexCoordDimensions[t];
+  }
+  perVertex += sizeof(RenderOperation::VertexBlendData) * geom.numBlendWeightsPerVertex;
+  return perVertex * geom.numVertices;
+}
+
 //-----------------------------------------------------------------------
 Mesh::Mesh(String name) {
   mName = name;
@@ -52,6 +68,7 @@ Mesh::Mesh(String name) {
   sharedGeometry.pColours = 0;
   sharedGeometry.pNormals = 0;
   sharedGeometry.pBlendingWeights = 0;
+  sharedGeometry.pInfluences = 0;
   sharedGeometry.numBlendWeightsPerVertex = 0;
 
   for (int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; ++i) {
@@ -70,6 +87,7 @@ Mesh::Mesh(String name) {
   lod.fromDepthSquared = 0.0f;
   mMeshLodUsageList.push_back(lod);
   mIsLodManual = false;
+  mSkinningMethod = SKIN_LINEAR;
 
 
 }
@@ -79,6 +97,12 @@ Mesh::~Mesh() {
   if (mIsLoaded) {
     unload();
   }
+  mPreparedData.clear();
+  SkinnedPoseMap::iterator i;
+  for (i = mSkinnedPoses.begin(); i != mSkinnedPoses.end(); ++i) {
+    delete i->second;
+  }
+  mSkinnedPoses.clear();
 }
 
 //-----------------------------------------------------------------------
@@ -117,6 +141,12 @@ SubMesh* Mesh::getSubMesh(unsigned short index) const {
   return const_cast<SubMesh*>(i[index]);
 }
 //-----------------------------------------------------------------------
+void Mesh::prepare() {
+  mPreparedData.clear();
+  if (!mManuallyDefined)
+    MeshManager::getSingleton()._findResourceData(mName, mPreparedData);
+}
+//-----------------------------------------------------------------------
 void Mesh::load() {
   // Load from specified 'name'
   if (mIsLoaded) {
@@ -130,8 +160,10 @@ void Mesh::load() {
     sprintf(msg, "Mesh: Loading %s .", mName.c_str());
     LogManager::getSingleton().logMessage(msg);
 
-    DataChunk chunk;
-    MeshManager::getSingleton()._findResourceData(mName, chunk);
+    // Use the data read in the background, if there is any
+    DataChunk& chunk = mPreparedData;
+    if (!chunk.getPtr())
+      MeshManager::getSingleton()._findResourceData(mName, chunk);
 
     // Determine file type
     std::vector<String> extVec;
@@ -156,6 +188,15 @@ void Mesh::load() {
 
   _updateBounds();
 
+  // Work out the memory used, for paging
+  mSize = geometrySize(sharedGeometry);
+  for (SubMeshList::iterator i = mSubMeshList.begin(); i != mSubMeshList.end(); ++i) {
+    if (!(*i)->useSharedVertices)
+      mSize += geometrySize((*i)->geometry);
+    mSize += sizeof(unsigned short) * 3 * (*i)->numFaces;
+  }
+  mIsLoaded = true;
+
 }
 
 //-----------------------------------------------------------------------
@@ -189,8 +230,33 @@ void Mesh::unload() {
       }
     }
   }
+  if (sharedGeometry.pBlendingWeights) {
+    delete [] sharedGeometry.pBlendingWeights;
+    sharedGeometry.pBlendingWeights = 0;
+  }
+  if (sharedGeometry.pInfluences) {
+    delete sharedGeometry.pInfluences;
+    sharedGeometry.pInfluences = 0;
+  }
+  // Skinned poses refer to the geometry just destroyed; entities may still
+  // hold them, so keep the poses but have them skinned again
+  SkinnedPoseMap::iterator ipose;
+  for (ipose = mSkinnedPoses.begin(); ipose != mSkinnedPoses.end(); ++ipose) {
+    ipose->second->skinned = false;
+    ipose->second->geometry.clear();
+  }
   // Clear SubMesh names
   mSubMeshNameMap.clear();
+
+  mSubMeshList.clear();
+  sharedGeometry.numVertices = 0;
+  if (!mManuallyDefined) {
+    // Read again on load
+    mMeshLodUsageList.resize(1);
+    mNumLods = 1;
+    mIsLodManual = false;
+  }
+  mIsLoaded = false;
 }
 
 //-----------------------------------------------------------------------
@@ -530,13 +596,26 @@ void Mesh::_initAnimationState(AnimationStateSet* animSet) {
   mSkeleton->_initAnimationState(animSet);
 
   // Take the opportunity to update the compiled bone assignments
-  if (mBoneAssignmentsOutOfDate)
+  bool recompiled = false;
+  if (mBoneAssignmentsOutOfDate) {
     compileBoneAssignments();
+    recompiled = true;
+  }
 
   SubMeshList::iterator i;
   for (i = mSubMeshList.begin(); i != mSubMeshList.end(); ++i) {
     if ((*i)->mBoneAssignmentsOutOfDate) {
       (*i)->compileBoneAssignments();
+      recompiled = true;
+    }
+  }
+
+  if (recompiled) {
+    // Any skinned poses were built from the old weights
+    SkinnedPoseMap::iterator ipose;
+    for (ipose = mSkinnedPoses.begin(); ipose != mSkinnedPoses.end(); ++ipose) {
+      ipose->second->skinned = false;
+      ipose->second->geometry.clear();
     }
   }
 }
@@ -548,21 +627,125 @@ unsigned short Mesh::_getNumBoneMatrices(void) {
   return mSkeleton->getNumBones();
 }
 //-----------------------------------------------------------------------
-void Mesh::_getBoneMatrices(const AnimationStateSet& animSet, Matrix4* pMatrices) {
+void Mesh::_getBoneMatrices(const AnimationStateSet& animSet, Matrix4* pMatrices,
+                            bool skipMinorBones) {
   // Delegate to Skeleton
   assert(mSkeleton && "Skeleton not present");
 
-  mSkeleton->setAnimationState(animSet);
+  mSkeleton->setAnimationState(animSet, skipMinorBones);
   mSkeleton->_getBoneMatrices(pMatrices);
 
 }
 //-----------------------------------------------------------------------
+Mesh::SkinnedPose* Mesh::_updateSkinnedPose(SkinnedPose* pCurrent, uint64 poseHash,
+    SkinningMethod method) {
+  // The same pose skinned another way gives different vertices
+  if (method != SKIN_LINEAR)
+    poseHash = ~poseHash;
+
+  if (pCurrent && pCurrent->hash == poseHash)
+    return pCurrent;
+
+  // Someone else already has this pose?
+  SkinnedPoseMap::iterator i = mSkinnedPoses.find(poseHash);
+  if (i != mSkinnedPoses.end()) {
+    if (pCurrent)
+      _releaseSkinnedPose(pCurrent);
+    ++i->second->refCount;
+    return i->second;
+  }
+
+  SkinnedPose* pose;
+  if (pCurrent && pCurrent->refCount == 1) {
+    // Sole user of the old pose, so re-key it and keep its buffers
+    mSkinnedPoses.erase(pCurrent->hash);
+    pose = pCurrent;
+  } else {
+    if (pCurrent)
+      _releaseSkinnedPose(pCurrent);
+    pose = new SkinnedPose();
+    pose->refCount = 1;
+  }
+  pose->hash = poseHash;
+  pose->skinned = false;
+  mSkinnedPoses[poseHash] = pose;
+
+  return pose;
+}
+//-----------------------------------------------------------------------
+void Mesh::_releaseSkinnedPose(SkinnedPose* pPose) {
+  assert(pPose->refCount > 0 && "Skinned pose released too often");
+  if (--pPose->refCount == 0) {
+    mSkinnedPoses.erase(pPose->hash);
+    delete pPose;
+  }
+}
+//-----------------------------------------------------------------------
+void Mesh::_skinPose(SkinnedPose* pPose, const Matrix4* pMatrices,
+                     const Real* pDualQuats) {
+  if (pPose->geometry.empty()) {
+    // Work out which geometry buffers need skinning
+    SkinnedGeometry skinned;
+    if (sharedGeometry.pInfluences) {
+      skinned.geometry = &sharedGeometry;
+      pPose->geometry.push_back(skinned);
+    }
+    SubMeshList::iterator i;
+    for (i = mSubMeshList.begin(); i != mSubMeshList.end(); ++i) {
+      if (!(*i)->useSharedVertices && (*i)->geometry.pInfluences) {
+        skinned.geometry = &(*i)->geometry;
+        pPose->geometry.push_back(skinned);
+      }
+    }
+  }
+
+  std::vector<SkinnedGeometry>::iterator i;
+  for (i = pPose->geometry.begin(); i != pPose->geometry.end(); ++i) {
+    const GeometryData* geom = i->geometry;
+    if (geom->numVertices == 0)
+      continue;
+    i->positions.resize(geom->numVertices * 3);
+    if (geom->hasNormals)
+      i->normals.resize(geom->numVertices * 3);
+
+    const Real* pSrcNorm = geom->hasNormals ? geom->pNormals : 0;
+    Real* pDestNorm = geom->hasNormals ? &i->normals.front() : 0;
+    if (pDualQuats) {
+      geom->pInfluences->skinDualQuaternion(pDualQuats,
+                                            geom->pVertices, geom->vertexStride,
+                                            pSrcNorm, geom->normalStride,
+                                            &i->positions.front(), pDestNorm);
+    } else {
+      geom->pInfluences->skin(pMatrices,
+                              geom->pVertices, geom->vertexStride,
+                              pSrcNorm, geom->normalStride,
+                              &i->positions.front(), pDestNorm);
+    }
+  }
+
+  pPose->skinned = true;
+}
+//-----------------------------------------------------------------------
+const Mesh::SkinnedGeometry* Mesh::_getSkinnedGeometry(const SkinnedPose* pPose,
+    const GeometryData* geometry) const {
+  std::vector<SkinnedGeometry>::const_iterator i;
+  for (i = pPose->geometry.begin(); i != pPose->geometry.end(); ++i) {
+    if (i->geometry == geometry)
+      return &(*i);
+  }
+  return 0;
+}
+//-----------------------------------------------------------------------
 void Mesh::compileBoneAssignments(void) {
   // Deallocate
   if (sharedGeometry.pBlendingWeights) {
     delete [] sharedGeometry.pBlendingWeights;
     sharedGeometry.pBlendingWeights = 0;
   }
+  if (sharedGeometry.pInfluences) {
+    delete sharedGeometry.pInfluences;
+    sharedGeometry.pInfluences = 0;
+  }
 
   // Iterate through, finding the largest # bones per vertex
   unsigned short maxBones = 0;
@@ -570,6 +753,7 @@ void Mesh::compileBoneAssignments(void) {
   VertexBoneAssignmentList::iterator i, iend;
   i = mBoneAssignments.begin();
   iend = mBoneAssignments.end();
+  currBones = 0;
   for (; i != iend; ++i) {
     if (lastVertIdx != i->second.vertexIndex) {
       // change in vertex
@@ -583,6 +767,9 @@ void Mesh::compileBoneAssignments(void) {
     lastVertIdx = i->second.vertexIndex;
 
   }
+  // Last vertex
+  if (maxBones < currBones)
+    maxBones = currBones;
 
   if (maxBones == 0) {
     // No bone assignments
@@ -602,7 +789,7 @@ void Mesh::compileBoneAssignments(void) {
   for (v = 0; v < sharedGeometry.numVertices; ++v) {
     for (unsigned short bone = 0; bone < maxBones; ++bone) {
       // Do we still have data for this vertex?
-      if (i->second.vertexIndex == v) {
+      if (i != iend && i->second.vertexIndex == v) {
         // If so, assign
         pBlend->matrixIndex = i->second.boneIndex;
         pBlend->blendWeight = i->second.weight;
@@ -616,10 +803,22 @@ void Mesh::compileBoneAssignments(void) {
     }
   }
 
+  // Build the compacted stream used for software skinning
+  sharedGeometry.pInfluences = new VertexInfluenceStream(
+    sharedGeometry.pBlendingWeights, maxBones, sharedGeometry.numVertices);
+
   mBoneAssignmentsOutOfDate = false;
 
 }
 //---------------------------------------------------------------------
+void Mesh::setSkinningMethod(SkinningMethod method) {
+  mSkinningMethod = method;
+}
+//---------------------------------------------------------------------
+SkinningMethod Mesh::getSkinningMethod(void) const {
+  return mSkinningMethod;
+}
+//---------------------------------------------------------------------
 void Mesh::_notifySkeleton(Skeleton* pSkel) {
   mSkeleton = pSkel;
   mSkeletonName = pSkel->getName();
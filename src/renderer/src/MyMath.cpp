@@ -29,6 +29,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Sphere.h"
 #include "AxisAlignedBox.h"
 #include "Plane.h"
+#include "SIMDHelper.h"
 
 
 namespace renderer {
@@ -40,48 +41,217 @@ const Real Math::PI = Real( 4.0 * atan( 1.0 ) );
 const Real Math::TWO_PI = Real( 2.0 * PI );
 const Real Math::HALF_PI = Real( 0.5 * PI );
 
-int Math::mTrigTableSize;
 Math::AngleUnit Math::msAngleUnit;
 
-Real  Math::mTrigTableFactor;
-Real *Math::mSinTable = NULL;
-Real *Math::mTanTable = NULL;
-
 //-----------------------------------------------------------------------
-Math::Math( unsigned int trigTableSize ) {
+// Polynomial kernels
+//-----------------------------------------------------------------------
+// The 'fast' scalar functions and the batch functions share these, so the
+// SSE and fallback paths give the same answers. Trig arguments are reduced
+// by quadrant to [-PI/4, PI/4] with a three part Cody-Waite split of PI/2,
+// which holds full single precision up to |x| of about 8192. The
+// coefficients are the minimax fits from the Cephes single precision
+// library.
+static const Real POLY_TWO_OVER_PI = 0.636619772367581343f;
+static const Real POLY_PIO2_1 = 1.5703125f;
+static const Real POLY_PIO2_2 = 4.837512969970703125e-4f;
+static const Real POLY_PIO2_3 = 7.54978995489188216e-8f;
+
+static const Real POLY_SIN_1 = -1.6666654611e-1f;
+static const Real POLY_SIN_2 = 8.3321608736e-3f;
+static const Real POLY_SIN_3 = -1.9515295891e-4f;
+
+static const Real POLY_COS_1 = 4.166664568298827e-2f;
+static const Real POLY_COS_2 = -1.388731625493765e-3f;
+static const Real POLY_COS_3 = 2.443315711809948e-5f;
+
+static const Real POLY_TAN_PI_8 = 0.414213562373095f;
+static const Real POLY_ATAN_1 = -3.33329491539e-1f;
+static const Real POLY_ATAN_2 = 1.99777106478e-1f;
+static const Real POLY_ATAN_3 = -1.38776856032e-1f;
+static const Real POLY_ATAN_4 = 8.05374449538e-2f;
+
+static const Real POLY_EXP_HI = 88.3762626647949f;
+static const Real POLY_EXP_LO = -87.3365447504019f;
+static const Real POLY_LOG2E = 1.44269504088896341f;
+/// Largest power of 2 Exp may scale by; 2^128 isn't a finite float
+static const Real POLY_EXP_MAX_N = 127.0f;
+static const Real POLY_LN2_1 = 0.693359375f;
+static const Real POLY_LN2_2 = -2.12194440e-4f;
+static const Real POLY_EXP_1 = 5.0000001201e-1f;
+static const Real POLY_EXP_2 = 1.6666665459e-1f;
+static const Real POLY_EXP_3 = 4.1665795894e-2f;
+static const Real POLY_EXP_4 = 8.3334519073e-3f;
+static const Real POLY_EXP_5 = 1.3981999507e-3f;
+static const Real POLY_EXP_6 = 1.9875691500e-4f;
+
+//-----------------------------------------------------------------------
+static void polySinCos(Real x, Real& s, Real& c) {
+  // Quadrant and remainder in [-PI/4, PI/4]
+  int q = int(floor(x * POLY_TWO_OVER_PI + 0.5f));
+  Real fq = Real(q);
+  Real r = ((x - fq * POLY_PIO2_1) - fq * POLY_PIO2_2) - fq * POLY_PIO2_3;
+  Real z = r * r;
+
+  Real ps = ((POLY_SIN_3 * z + POLY_SIN_2) * z + POLY_SIN_1) * z * r + r;
+  Real pc = ((POLY_COS_3 * z + POLY_COS_2) * z + POLY_COS_1) * z * z
+            - 0.5f * z + 1.0f;
+
+  // Odd quadrants swap sine and cosine, then fix up the signs
+  if (q & 1) {
+    s = pc;
+    c = ps;
+  } else {
+    s = ps;
+    c = pc;
+  }
+  if (q & 2)
+    s = -s;
+  if ((q + 1) & 2)
+    c = -c;
+}
+//-----------------------------------------------------------------------
+static Real polyATan2(Real y, Real x) {
+  Real ax = fabs(x), ay = fabs(y);
+  Real mx = ax > ay ? ax : ay;
+  Real mn = ax > ay ? ay : ax;
+  Real t = mx > 0 ? mn / mx : 0;
+
+  // Fold [tan(PI/8), 1] onto [-tan(PI/8), 0] around PI/4
+  Real base = 0;
+  if (t > POLY_TAN_PI_8) {
+    t = (t - 1.0f) / (t + 1.0f);
+    base = 0.25f * Math::PI;
+  }
+  Real z = t * t;
+  Real r = base + ((((POLY_ATAN_4 * z + POLY_ATAN_3) * z + POLY_ATAN_2) * z
+                    + POLY_ATAN_1) * z * t + t);
+
+  if (ay > ax)
+    r = Math::HALF_PI - r;
+  if (x < 0)
+    r = Math::PI - r;
+  return y < 0 ? -r : r;
+}
+//-----------------------------------------------------------------------
+static Real polyExp(Real x) {
+  if (x > POLY_EXP_HI)
+    x = POLY_EXP_HI;
+  else if (x < POLY_EXP_LO)
+    x = POLY_EXP_LO;
+
+  // e^x = 2^n * e^r, r in [-ln2/2, ln2/2]. At the upper clamp n rounds to
+  // 128, so it's capped; r is then a little over ln2/2, and the result
+  // stays finite.
+  int n = int(floor(std::min(x * POLY_LOG2E + 0.5f, POLY_EXP_MAX_N)));
+  Real fn = Real(n);
+  Real r = (x - fn * POLY_LN2_1) - fn * POLY_LN2_2;
+
+  Real p = POLY_EXP_6;
+  p = p * r + POLY_EXP_5;
+  p = p * r + POLY_EXP_4;
+  p = p * r + POLY_EXP_3;
+  p = p * r + POLY_EXP_2;
+  p = p * r + POLY_EXP_1;
+  p = p * r * r + r + 1.0f;
+
+  return Real(ldexp(p, n));
+}
+
+#if OGRE_HAVE_SSE
+//-----------------------------------------------------------------------
+static void ssePolySinCos(__m128 x, __m128& s, __m128& c) {
+  // Rounded as polySinCos does, whatever the MXCSR rounding mode
+  __m128i q = sse_floor_epi32(sse_madd(x, _mm_set1_ps(POLY_TWO_OVER_PI), _mm_set1_ps(0.5f)));
+  __m128 fq = _mm_cvtepi32_ps(q);
+  __m128 r = _mm_sub_ps(x, _mm_mul_ps(fq, _mm_set1_ps(POLY_PIO2_1)));
+  r = _mm_sub_ps(r, _mm_mul_ps(fq, _mm_set1_ps(POLY_PIO2_2)));
+  r = _mm_sub_ps(r, _mm_mul_ps(fq, _mm_set1_ps(POLY_PIO2_3)));
+  __m128 z = _mm_mul_ps(r, r);
+
+  __m128 ps = sse_madd(_mm_set1_ps(POLY_SIN_3), z, _mm_set1_ps(POLY_SIN_2));
+  ps = sse_madd(ps, z, _mm_set1_ps(POLY_SIN_1));
+  ps = sse_madd(_mm_mul_ps(ps, z), r, r);
+
+  __m128 pc = sse_madd(_mm_set1_ps(POLY_COS_3), z, _mm_set1_ps(POLY_COS_2));
+  pc = sse_madd(pc, z, _mm_set1_ps(POLY_COS_1));
+  pc = _mm_mul_ps(_mm_mul_ps(pc, z), z);
+  pc = _mm_add_ps(_mm_sub_ps(pc, _mm_mul_ps(_mm_set1_ps(0.5f), z)),
+                  _mm_set1_ps(1.0f));
+
+  __m128i one = _mm_set1_epi32(1);
+  __m128i two = _mm_set1_epi32(2);
+  __m128 swap = _mm_castsi128_ps(
+                  _mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+  // Bit 1 of the quadrant shifted up into the sign bit
+  __m128 signS = _mm_castsi128_ps(
+                   _mm_slli_epi32(_mm_and_si128(q, two), 30));
+  __m128 signC = _mm_castsi128_ps(
+                   _mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30));
+
+  s = _mm_xor_ps(sse_select(swap, pc, ps), signS);
+  c = _mm_xor_ps(sse_select(swap, ps, pc), signC);
+}
+//-----------------------------------------------------------------------
+static __m128 ssePolyATan2(__m128 y, __m128 x) {
+  __m128 ax = sse_abs(x), ay = sse_abs(y);
+  __m128 mx = _mm_max_ps(ax, ay);
+  __m128 mn = _mm_min_ps(ax, ay);
+  __m128 zero = _mm_setzero_ps();
+  __m128 t = _mm_and_ps(_mm_cmpgt_ps(mx, zero), _mm_div_ps(mn, mx));
+
+  __m128 one = _mm_set1_ps(1.0f);
+  __m128 fold = _mm_cmpgt_ps(t, _mm_set1_ps(POLY_TAN_PI_8));
+  t = sse_select(fold, _mm_div_ps(_mm_sub_ps(t, one), _mm_add_ps(t, one)), t);
+  __m128 base = _mm_and_ps(fold, _mm_set1_ps(0.25f * Math::PI));
+
+  __m128 z = _mm_mul_ps(t, t);
+  __m128 p = sse_madd(_mm_set1_ps(POLY_ATAN_4), z, _mm_set1_ps(POLY_ATAN_3));
+  p = sse_madd(p, z, _mm_set1_ps(POLY_ATAN_2));
+  p = sse_madd(p, z, _mm_set1_ps(POLY_ATAN_1));
+  __m128 r = _mm_add_ps(base, sse_madd(_mm_mul_ps(p, z), t, t));
+
+  r = sse_select(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(Math::HALF_PI), r), r);
+  r = sse_select(_mm_cmplt_ps(x, zero), _mm_sub_ps(_mm_set1_ps(Math::PI), r), r);
+  return _mm_xor_ps(r, sse_signbit(y));
+}
+//-----------------------------------------------------------------------
+static __m128 ssePolyExp(__m128 x) {
+  x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(POLY_EXP_LO)), _mm_set1_ps(POLY_EXP_HI));
+
+  // As polyExp; n <= 127 keeps 2^n, built below, finite
+  __m128i n = sse_floor_epi32(_mm_min_ps(sse_madd(x, _mm_set1_ps(POLY_LOG2E), _mm_set1_ps(0.5f)),
+                                         _mm_set1_ps(POLY_EXP_MAX_N)));
+  __m128 fn = _mm_cvtepi32_ps(n);
+  __m128 r = _mm_sub_ps(x, _mm_mul_ps(fn, _mm_set1_ps(POLY_LN2_1)));
+  r = _mm_sub_ps(r, _mm_mul_ps(fn, _mm_set1_ps(POLY_LN2_2)));
+
+  __m128 p = sse_madd(_mm_set1_ps(POLY_EXP_6), r, _mm_set1_ps(POLY_EXP_5));
+  p = sse_madd(p, r, _mm_set1_ps(POLY_EXP_4));
+  p = sse_madd(p, r, _mm_set1_ps(POLY_EXP_3));
+  p = sse_madd(p, r, _mm_set1_ps(POLY_EXP_2));
+  p = sse_madd(p, r, _mm_set1_ps(POLY_EXP_1));
+  p = _mm_add_ps(sse_madd(_mm_mul_ps(p, r), r, r), _mm_set1_ps(1.0f));
+
+  // Build 2^n straight into the exponent bits
+  __m128 pow2n = _mm_castsi128_ps(
+                   _mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+  return _mm_mul_ps(p, pow2n);
+}
+#endif
+
+//-----------------------------------------------------------------------
+Math::Math() {
   msAngleUnit = AU_DEGREE;
 
-  mTrigTableSize = trigTableSize;
-  mTrigTableFactor = mTrigTableSize / Math::TWO_PI;
-
-  mSinTable = new Real[mTrigTableSize];
-  mTanTable = new Real[mTrigTableSize];
-
-  buildTrigTables();
-
   // Init random number generator
   srand( (unsigned)time(0) );
 }
 
 //-----------------------------------------------------------------------
 Math::~Math() {
-  delete [] mSinTable;
-  delete [] mTanTable;
 }
 
-//-----------------------------------------------------------------------
-void Math::buildTrigTables(void) {
-  // Build trig lookup tables
-  // Could get away with building only PI sized Sin table but simpler this
-  // way. Who cares, it'll ony use an extra 8k of memory anyway and I like
-  // simplicity.
-  Real angle;
-  for (int i = 0; i < mTrigTableSize; ++i) {
-    angle = Math::TWO_PI * i / mTrigTableSize;
-    mSinTable[i] = sin(angle);
-    mTanTable[i] = tan(angle);
-  }
-}
 //-----------------------------------------------------------------------
 int Math::IAbs (int iValue) {
   return ( iValue >= 0 ? iValue : -iValue );
@@ -129,7 +299,9 @@ Real Math::ATan (Real fValue) {
   return Real(asm_arctan(fValue));
 }
 //-----------------------------------------------------------------------
-Real Math::ATan2 (Real fY, Real fX) {
+Real Math::ATan2 (Real fY, Real fX, bool fast) {
+  if (fast)
+    return polyATan2(fY, fX);
   return Real(atan2(fY,fX));
 }
 //-----------------------------------------------------------------------
@@ -137,19 +309,19 @@ Real Math::Ceil (Real fValue) {
   return Real(ceil(fValue));
 }
 //-----------------------------------------------------------------------
-Real Math::Cos (Real fValue, bool useTables) {
-  if (useTables) {
-    // Convert to sin equivalent
-    fValue += Math::HALF_PI;
-
-    return Sin(fValue, useTables);
-
+Real Math::Cos (Real fValue, bool fast) {
+  if (fast) {
+    Real fSin, fCos;
+    polySinCos(fValue, fSin, fCos);
+    return fCos;
   } else {
     return Real(asm_cos(fValue));
   }
 }
 //-----------------------------------------------------------------------
-Real Math::Exp (Real fValue) {
+Real Math::Exp (Real fValue, bool fast) {
+  if (fast)
+    return polyExp(fValue);
   return Real(exp(fValue));
 }
 //-----------------------------------------------------------------------
@@ -175,22 +347,20 @@ Real Math::Sign (Real fValue) {
   return 0.0;
 }
 //-----------------------------------------------------------------------
-Real Math::Sin (Real fValue, bool useTables) {
-  if (useTables) {
-    // Convert range to index values, wrap if required
-    int idx;
-    if (fValue >= 0) {
-      idx = int(fValue * mTrigTableFactor) % mTrigTableSize;
-    } else {
-      idx = mTrigTableSize - (int(-fValue * mTrigTableFactor) % mTrigTableSize) - 1;
-    }
-
-    return mSinTable[idx];
+Real Math::Sin (Real fValue, bool fast) {
+  if (fast) {
+    Real fSin, fCos;
+    polySinCos(fValue, fSin, fCos);
+    return fSin;
   } else {
     return Real(asm_sin(fValue));
   }
 }
 //-----------------------------------------------------------------------
+void Math::SinCos (Real fValue, Real& fSin, Real& fCos) {
+  polySinCos(fValue, fSin, fCos);
+}
+//-----------------------------------------------------------------------
 Real Math::Sqr (Real fValue) {
   return fValue*fValue;
 }
@@ -199,7 +369,11 @@ Real Math::Sqrt (Real fValue) {
   return Real(asm_sqrt(fValue));
 }
 //-----------------------------------------------------------------------
-Real Math::InvSqrt (Real fValue) {
+Real Math::InvSqrt (Real fValue, bool fast) {
+#if OGRE_HAVE_SSE
+  if (fast)
+    return _mm_cvtss_f32(sse_rsqrt_nr(_mm_set_ss(fValue)));
+#endif
   return Real(asm_rsq(fValue));
 }
 //-----------------------------------------------------------------------
@@ -300,16 +474,96 @@ bool Math::pointInTri2D( Real px, Real py, Real ax, Real ay, Real bx, Real by, R
 }
 
 //-----------------------------------------------------------------------
-Real Math::Tan(Real radians, bool useTables) {
-  if (useTables) {
-    // Convert range to index values, wrap if required
-    int idx = int(radians *= mTrigTableFactor) % mTrigTableSize;
-    return mTanTable[idx];
+Real Math::Tan(Real radians, bool fast) {
+  if (fast) {
+    Real fSin, fCos;
+    polySinCos(radians, fSin, fCos);
+    return fSin / fCos;
   } else {
     return Real(asm_tan(radians));
   }
 }
 
+//-----------------------------------------------------------------------
+void Math::Sin4 (const Real* fValues, Real* fResults) {
+#if OGRE_HAVE_SSE
+  __m128 s, c;
+  ssePolySinCos(_mm_loadu_ps(fValues), s, c);
+  _mm_storeu_ps(fResults, s);
+#else
+  Real fCos;
+  for (int i = 0; i < 4; ++i)
+    polySinCos(fValues[i], fResults[i], fCos);
+#endif
+}
+//-----------------------------------------------------------------------
+void Math::Cos4 (const Real* fValues, Real* fResults) {
+#if OGRE_HAVE_SSE
+  __m128 s, c;
+  ssePolySinCos(_mm_loadu_ps(fValues), s, c);
+  _mm_storeu_ps(fResults, c);
+#else
+  Real fSin;
+  for (int i = 0; i < 4; ++i)
+    polySinCos(fValues[i], fSin, fResults[i]);
+#endif
+}
+//-----------------------------------------------------------------------
+void Math::SinCos4 (const Real* fValues, Real* fSin, Real* fCos) {
+#if OGRE_HAVE_SSE
+  __m128 s, c;
+  ssePolySinCos(_mm_loadu_ps(fValues), s, c);
+  _mm_storeu_ps(fSin, s);
+  _mm_storeu_ps(fCos, c);
+#else
+  for (int i = 0; i < 4; ++i) {
+    Real fValue = fValues[i];
+    polySinCos(fValue, fSin[i], fCos[i]);
+  }
+#endif
+}
+//-----------------------------------------------------------------------
+void Math::Tan4 (const Real* fValues, Real* fResults) {
+#if OGRE_HAVE_SSE
+  __m128 s, c;
+  ssePolySinCos(_mm_loadu_ps(fValues), s, c);
+  _mm_storeu_ps(fResults, _mm_div_ps(s, c));
+#else
+  Real fSin, fCos;
+  for (int i = 0; i < 4; ++i) {
+    polySinCos(fValues[i], fSin, fCos);
+    fResults[i] = fSin / fCos;
+  }
+#endif
+}
+//-----------------------------------------------------------------------
+void Math::ATan2_4 (const Real* fY, const Real* fX, Real* fResults) {
+#if OGRE_HAVE_SSE
+  _mm_storeu_ps(fResults, ssePolyATan2(_mm_loadu_ps(fY), _mm_loadu_ps(fX)));
+#else
+  for (int i = 0; i < 4; ++i)
+    fResults[i] = polyATan2(fY[i], fX[i]);
+#endif
+}
+//-----------------------------------------------------------------------
+void Math::Exp4 (const Real* fValues, Real* fResults) {
+#if OGRE_HAVE_SSE
+  _mm_storeu_ps(fResults, ssePolyExp(_mm_loadu_ps(fValues)));
+#else
+  for (int i = 0; i < 4; ++i)
+    fResults[i] = polyExp(fValues[i]);
+#endif
+}
+//-----------------------------------------------------------------------
+void Math::InvSqrt4 (const Real* fValues, Real* fResults) {
+#if OGRE_HAVE_SSE
+  _mm_storeu_ps(fResults, sse_rsqrt_nr(_mm_loadu_ps(fValues)));
+#else
+  for (int i = 0; i < 4; ++i)
+    fResults[i] = Real(asm_rsq(fValues[i]));
+#endif
+}
+
 //-----------------------------------------------------------------------
 bool Math::RealEqual( Real a, Real b, Real tolerance ) {
   if ((b < (a + tolerance)) && (b > (a - tolerance)))
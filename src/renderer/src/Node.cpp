@@ -360,7 +360,12 @@ const Vector3 & Node::_getDerivedScale(void) const {
 }
 //-----------------------------------------------------------------------
 void Node::removeAllChildren(void) {
+  ChildNodeMap::iterator i, iend = mChildren.end();
+  for (i = mChildren.begin(); i != iend; ++i) {
+    i->second->setParent(NULL);
+  }
   mChildren.clear();
+  mChildrenToUpdate.clear();
 }
 //-----------------------------------------------------------------------
 void Node::setScale(const Vector3& scale) {
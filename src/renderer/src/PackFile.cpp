@@ -0,0 +1,342 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#include "PackFile.h"
+
+#include "base/string_util.h"
+#include "LogManager.h"
+#include "Exception.h"
+#include "SDDataChunk.h"
+#include "StringVector.h"
+#include "WorkQueue.h"
+
+#include "zlib.h"
+
+namespace renderer {
+
+namespace {
+/// Orders the table of contents by hash, for binary search
+struct EntryHashLess {
+  bool operator()(const PackEntry& entry, uint32 hash) const {
+    return entry.hash < hash;
+  }
+};
+
+/// Decompresses one chunk of an entry
+class InflateTask : public WorkQueue::Task {
+public:
+  InflateTask() : src(0), srcSize(0), dest(0), destSize(0), ok(false) {}
+
+  void run(void) {
+    uLongf size = static_cast<uLongf>(destSize);
+    ok = uncompress(dest, &size, src, static_cast<uLong>(srcSize)) == Z_OK &&
+         size == destSize;
+  }
+
+  const uchar* src;
+  size_t srcSize;
+  uchar* dest;
+  size_t destSize;
+  bool ok;
+};
+}
+
+//-----------------------------------------------------------------------
+bool PackFile::hasValidName( const PackEntry& entry ) const {
+  return static_cast<uint64>( entry.nameOffset ) + entry.nameLength <= mHeader->namesSize;
+}
+
+//-----------------------------------------------------------------------
+const PackEntry* PackFile::findEntry( const String& strFile ) const {
+  String name = StringToLowerASCII( strFile );
+  uint32 hash = packNameHash( name.c_str(), name.size() );
+
+  const PackEntry* pEnd = mEntries + mHeader->numEntries;
+  for( const PackEntry* p = std::lower_bound( mEntries, pEnd, hash, EntryHashLess() );
+       p != pEnd && p->hash == hash; ++p ) {
+    if( p->nameLength == name.size() && hasValidName( *p ) &&
+        !memcmp( mNames + p->nameOffset, name.c_str(), name.size() ) )
+      return p;
+  }
+  return 0;
+}
+
+//-----------------------------------------------------------------------
+bool PackFile::inflateEntry( const PackEntry& entry, uchar* pDest ) const {
+  const uchar* pData = mFile->getPtr() + entry.offset;
+  size_t chunkSize = mHeader->chunkSize;
+  // Worked out so that nothing can overflow, whatever the entry says
+  uint64 numChunks64 = entry.uncompressedSize / chunkSize +
+                       ( entry.uncompressedSize % chunkSize != 0 ? 1 : 0 );
+  if( numChunks64 >= entry.size / sizeof( uint64 ) )
+    return false;
+  size_t numChunks = static_cast<size_t>( numChunks64 );
+  uint64 tableSize = ( numChunks64 + 1 ) * sizeof( uint64 );
+
+  // The chunks follow the offset table, they mustn't overlap it
+  const uint64* pOffsets = reinterpret_cast<const uint64*>( pData );
+  if( pOffsets[0] < tableSize )
+    return false;
+
+  std::vector<InflateTask> tasks( numChunks );
+  for( size_t i = 0; i < numChunks; ++i ) {
+    if( pOffsets[i] > pOffsets[i + 1] || pOffsets[i + 1] > entry.size )
+      return false;
+    InflateTask& task = tasks[i];
+    task.src = pData + pOffsets[i];
+    task.srcSize = static_cast<size_t>( pOffsets[i + 1] - pOffsets[i] );
+    task.dest = pDest + i * chunkSize;
+    task.destSize = std::min( chunkSize,
+                              static_cast<size_t>( entry.uncompressedSize ) - i * chunkSize );
+  }
+
+  WorkQueue* pQueue = WorkQueue::getSingletonPtr();
+  if( pQueue && numChunks > 1 ) {
+    std::vector<WorkQueue::Task*> pointers( numChunks );
+    for( size_t i = 0; i < numChunks; ++i )
+      pointers[i] = &tasks[i];
+    pQueue->runAndWait( &pointers[0], numChunks );
+  } else {
+    for( size_t i = 0; i < numChunks; ++i )
+      tasks[i].run();
+  }
+
+  for( size_t i = 0; i < numChunks; ++i ) {
+    if( !tasks[i].ok )
+      return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------
+bool PackFile::fileOpen( const String& strFile, FILE** ppFile ) const {
+  SDDataChunk chunk;
+  DataChunk* pChunk = &chunk;
+  if( !fileRead( strFile, &pChunk ) )
+    return false;
+
+  FILE *pFile = *ppFile;
+  fwrite( (const void*)chunk.getPtr(), 1, chunk.getSize(), pFile );
+  fseek( pFile, 0, SEEK_SET );
+  return true;
+}
+
+//-----------------------------------------------------------------------
+bool PackFile::fileRead( const String& strFile, DataChunk** ppChunk ) const {
+  const PackEntry* pEntry = findEntry( strFile );
+  if( !pEntry )
+    return false;
+
+  DataChunk* pChunk = *ppChunk;
+  // Offset first, so that offset + size can't overflow
+  uint64 fileSize = mFile->getSize();
+  if( pEntry->offset > fileSize || pEntry->size > fileSize - pEntry->offset ||
+      pEntry->uncompressedSize > std::numeric_limits<size_t>::max() )
+    Except( Exception::ERR_INTERNAL_ERROR, "Corrupt entry " + strFile + " in pack " + mName,
+            "PackFile::fileRead" );
+
+  if( pEntry->uncompressedSize == 0 ) {
+    pChunk->clear();
+    return true;
+  }
+
+  if( pEntry->method == PACK_STORED ) {
+    // Refer to the data in place
+    pChunk->map( mFile.get(), static_cast<size_t>( pEntry->offset ),
+                 static_cast<size_t>( pEntry->size ) );
+    return true;
+  }
+
+  if( pEntry->method != PACK_DEFLATED )
+    Except( Exception::ERR_INVALIDPARAMS, "Unsupported compression method for " + strFile +
+            " in pack " + mName, "PackFile::fileRead" );
+
+  pChunk->allocate( static_cast<size_t>( pEntry->uncompressedSize ) );
+  if( !inflateEntry( *pEntry, pChunk->getPtr() ) ) {
+    pChunk->clear();
+    Except( Exception::ERR_INTERNAL_ERROR, "Corrupt entry " + strFile + " in pack " + mName,
+            "PackFile::fileRead" );
+  }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------
+bool PackFile::fileSave( ::FILE* pFile, const String& strPath, bool bOverwrite /* = false */ ) {
+  return false;
+}
+
+//-----------------------------------------------------------------------
+bool PackFile::fileWrite( const DataChunk& refChunk, const String& strPath, bool bOverwrite /* = false */ ) {
+  return false;
+}
+
+//-----------------------------------------------------------------------
+bool PackFile::fileTest( const String& strFile ) const {
+  return findEntry( strFile ) != 0;
+}
+
+//-----------------------------------------------------------------------
+bool PackFile::fileCopy( const String& strSrc, const String& strDest, bool bOverwrite ) {
+  return false;
+}
+
+//-----------------------------------------------------------------------
+bool PackFile::fileMove( const String& strSrc, const String& strDest, bool bOverwrite ) {
+  return false;
+}
+
+//-----------------------------------------------------------------------
+bool PackFile::fileDele( const String& strFile ) {
+  return false;
+}
+
+//-----------------------------------------------------------------------
+bool PackFile::fileInfo( const String& strFile, FileInfo** ppInfo ) const {
+  const PackEntry* pEntry = findEntry( strFile );
+  if( !pEntry )
+    return false;
+
+  // FileInfo only has room for sizes up to 2GB
+  const uint64 maxSize = static_cast<uint64>( std::numeric_limits<int>::max() );
+  if( pEntry->size > maxSize || pEntry->uncompressedSize > maxSize )
+    return false;
+
+  FileInfo* pInfo = *ppInfo;
+  pInfo->iCompSize = static_cast<int>( pEntry->size );
+  pInfo->iUncompSize = static_cast<int>( pEntry->uncompressedSize );
+  pInfo->iLastMod = static_cast<time_t>( pEntry->lastModified );
+  strncpy( pInfo->szFilename, strFile.c_str(), sizeof( pInfo->szFilename ) - 1 );
+  pInfo->szFilename[sizeof( pInfo->szFilename ) - 1] = '\0';
+
+  return true;
+}
+
+//-----------------------------------------------------------------------
+std::vector<String> PackFile::dirGetFiles( const String& strDir ) const {
+  return const_cast<PackFile *>(this)->getAllNamesLike( strDir, "", false );
+}
+
+//-----------------------------------------------------------------------
+std::vector<String> PackFile::dirGetSubs( const String& strDir ) const {
+  return std::vector<String>();
+}
+
+//-----------------------------------------------------------------------
+bool PackFile::dirDele( const String& strDir, bool bRecursive ) {
+  return false;
+};
+
+//-----------------------------------------------------------------------
+bool PackFile::dirMove( const String& strSrc, const String& strDest, bool bOverwrite ) {
+  return false;
+};
+
+//-----------------------------------------------------------------------
+bool PackFile::dirInfo( const String& strDir, FileInfo** ppInfo ) const {
+  return false;
+};
+
+//-----------------------------------------------------------------------
+bool PackFile::dirCopy( const String& strSrc, const String& strDest, bool bOverwrite ) {
+  return false;
+};
+
+//-----------------------------------------------------------------------
+bool PackFile::dirTest( const String& strDir ) const {
+  return false;
+};
+
+//-----------------------------------------------------------------------
+StringVector PackFile::getAllNamesLike( const String& strStartPath, const String& strPattern, bool bRecursive /* = true */ ) {
+  StringVector retVec;
+  String szPattern = StringToLowerASCII(strPattern);
+
+  for( uint32 i = 0; i < mHeader->numEntries; ++i ) {
+    const PackEntry& entry = mEntries[i];
+    if( entry.uncompressedSize == 0 || !hasValidName( entry ) )
+      continue;
+
+    String filename( mNames + entry.nameOffset, entry.nameLength );
+    if( filename.find( szPattern ) != String::npos )
+      retVec.push_back( filename );
+  }
+
+  return retVec;
+};
+
+//-----------------------------------------------------------------------
+void PackFile::load() {
+  mFile = MappedFile::open( mName );
+  if( !mFile )
+    Except( Exception::ERR_FILE_NOT_FOUND, "Pack " + mName + " not found.",
+            "PackFile::load" );
+
+  // Only the header and the bounds of the tables are checked here, so
+  // mounting doesn't touch the whole table; entries are checked as they are
+  // used
+  size_t size = mFile->getSize();
+  mHeader = reinterpret_cast<const PackHeader*>( mFile->getPtr() );
+  if( size < sizeof( PackHeader ) || mHeader->magic != PACK_MAGIC )
+    Except( Exception::ERR_INTERNAL_ERROR, mName + " is not a pack file.", "PackFile::load" );
+  if( mHeader->version != PACK_VERSION )
+    Except( Exception::ERR_INTERNAL_ERROR, "Pack " + mName + " has an unsupported version.",
+            "PackFile::load" );
+
+  uint64 tocEnd = sizeof( PackHeader ) +
+                  static_cast<uint64>( mHeader->numEntries ) * sizeof( PackEntry );
+  if( mHeader->chunkSize == 0 || tocEnd > size ||
+      mHeader->namesOffset < tocEnd || mHeader->namesOffset > size ||
+      mHeader->namesSize > size - mHeader->namesOffset )
+    Except( Exception::ERR_INTERNAL_ERROR, "Corrupt table of contents in pack " + mName,
+            "PackFile::load" );
+
+  mEntries = reinterpret_cast<const PackEntry*>( mFile->getPtr() + sizeof( PackHeader ) );
+  mNames = reinterpret_cast<const char*>( mFile->getPtr() + mHeader->namesOffset );
+
+  LogManager::getSingleton().logMessage( "Pack Archive codec for " + mName + " created.");
+};
+
+//-----------------------------------------------------------------------
+void PackFile::unload() {
+  // Chunks still referring to stored entries keep the file mapped
+  mFile = NULL;
+
+  LogManager::getSingleton().logMessage( "Pack Archive codec for " + mName + " unloaded." );
+
+  delete this;
+};
+
+//-----------------------------------------------------------------------
+PackFile::PackFile() : mHeader(0), mEntries(0), mNames(0) {}
+
+//-----------------------------------------------------------------------
+PackFile::PackFile( const String& name ) : mHeader(0), mEntries(0), mNames(0) {
+  mName = name;
+}
+
+//-----------------------------------------------------------------------
+PackFile::~PackFile() {}
+
+}
@@ -0,0 +1,121 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#include "ParticleData.h"
+#include "Particle.h"
+
+namespace renderer {
+
+//-----------------------------------------------------------------------
+ParticleData::ParticleData()
+  : mSize(0), mCapacity(0) {
+}
+//-----------------------------------------------------------------------
+void ParticleData::reserve(size_t capacity) {
+  if (capacity <= mCapacity)
+    return;
+
+  mPositions.resize(capacity);
+  mDirections.resize(capacity);
+  mColours.resize(capacity);
+  mTimeToLive.resize(capacity);
+  mWidths.resize(capacity);
+  mHeights.resize(capacity);
+  mOwnDimensions.resize(capacity);
+  mRotations.resize(capacity);
+  mCapacity = capacity;
+}
+//-----------------------------------------------------------------------
+size_t ParticleData::append(const Particle& p) {
+  assert(mSize < mCapacity && "Particle quota exceeded");
+  size_t index = mSize++;
+  _writeParticle(index, p);
+  return index;
+}
+//-----------------------------------------------------------------------
+void ParticleData::swapRemove(size_t index) {
+  assert(index < mSize && "Particle index out of bounds");
+  size_t last = --mSize;
+  if (index == last)
+    return;
+
+  mPositions[index] = mPositions[last];
+  mDirections[index] = mDirections[last];
+  mColours[index] = mColours[last];
+  mTimeToLive[index] = mTimeToLive[last];
+  mWidths[index] = mWidths[last];
+  mHeights[index] = mHeights[last];
+  mOwnDimensions[index] = mOwnDimensions[last];
+  mRotations[index] = mRotations[last];
+}
+//-----------------------------------------------------------------------
+void ParticleData::clear(void) {
+  mSize = 0;
+}
+//-----------------------------------------------------------------------
+ParticleData::Batch ParticleData::getBatch(size_t start, size_t count) {
+  assert(start + count <= mSize && "Particle range out of bounds");
+  Batch b;
+  b.count = count;
+  if (count) {
+    b.positions = &mPositions[start];
+    b.directions = &mDirections[start];
+    b.colours = &mColours[start];
+    b.timeToLive = &mTimeToLive[start];
+    b.widths = &mWidths[start];
+    b.heights = &mHeights[start];
+    b.ownDimensions = &mOwnDimensions[start];
+    b.rotations = &mRotations[start];
+  } else {
+    b.positions = b.directions = 0;
+    b.colours = 0;
+    b.timeToLive = b.widths = b.heights = b.rotations = 0;
+    b.ownDimensions = 0;
+  }
+  return b;
+}
+//-----------------------------------------------------------------------
+void ParticleData::_readParticle(size_t index, Particle* p) const {
+  p->mPosition = mPositions[index];
+  p->mDirection = mDirections[index];
+  p->mColour = mColours[index];
+  p->mTimeToLive = mTimeToLive[index];
+  p->mOwnDimensions = mOwnDimensions[index] != 0;
+  p->mWidth = mWidths[index];
+  p->mHeight = mHeights[index];
+  p->mRotation = mRotations[index];
+}
+//-----------------------------------------------------------------------
+void ParticleData::_writeParticle(size_t index, const Particle& p) {
+  mPositions[index] = p.mPosition;
+  mDirections[index] = p.mDirection;
+  mColours[index] = p.mColour;
+  mTimeToLive[index] = p.mTimeToLive;
+  mOwnDimensions[index] = p.mOwnDimensions ? 1 : 0;
+  mWidths[index] = p.mWidth;
+  mHeights[index] = p.mHeight;
+  mRotations[index] = p.mRotation;
+}
+
+}
@@ -62,6 +62,7 @@ ParticleEmitter::ParticleEmitter() {
   mColourRangeStart = mColourRangeEnd = ColourValue::White;
   mEnabled = true;
   mDurationMax = 0;
+  mEmissionRemainder = 0;
 
 }
 //-----------------------------------------------------------------------
@@ -169,14 +170,13 @@ Real ParticleEmitter::genEmissionTTL(void) {
 }
 //-----------------------------------------------------------------------
 unsigned short ParticleEmitter::genConstantEmissionCount(Real timeElapsed) {
-  static Real remainder = 0;
   unsigned short intRequest;
 
   if (mEnabled) {
     // Keep fractions, otherwise a high frame rate will result in zero emissions!
-    remainder += mEmissionRate * timeElapsed;
-    intRequest = (unsigned short)remainder;
-    remainder -= intRequest;
+    mEmissionRemainder += mEmissionRate * timeElapsed;
+    intRequest = (unsigned short)mEmissionRemainder;
+    mEmissionRemainder -= intRequest;
 
     // Check duration
     if (mDurationMax) {
@@ -23,22 +23,40 @@ http://www.gnu.org/copyleft/lesser.txt.
 -----------------------------------------------------------------------------
 */
 #include "ParticleIterator.h"
-#include "Particle.h"
+#include "ParticleData.h"
 
 namespace renderer {
 
 //-----------------------------------------------------------------------
-ParticleIterator::ParticleIterator(std::list<Billboard*>::iterator start, std::list<Billboard*>::iterator end) {
-  mStart = mPos = start;
-  mEnd = end;
+ParticleIterator::ParticleIterator(ParticleData* data, BillboardSet* owner)
+  : mData(data), mPos(0), mLoaded(0) {
+  mCurrent._notifyOwner(owner);
+}
+//-----------------------------------------------------------------------
+ParticleIterator::~ParticleIterator() {
+  flush();
+}
+//-----------------------------------------------------------------------
+void ParticleIterator::flush(void) {
+  if (mLoaded != mPos) {
+    mData->_writeParticle(mLoaded, mCurrent);
+    mLoaded = mPos;
+  }
 }
 //-----------------------------------------------------------------------
 bool ParticleIterator::end(void) {
-  return (mPos == mEnd);
+  if (mPos == mData->size()) {
+    flush();
+    return true;
+  }
+  return false;
 }
 //-----------------------------------------------------------------------
 Particle* ParticleIterator::getNext(void) {
-  return static_cast<Particle*>(*mPos++);
+  flush();
+  mData->_readParticle(mPos, &mCurrent);
+  mLoaded = mPos++;
+  return &mCurrent;
 }
 
 
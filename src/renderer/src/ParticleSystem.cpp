@@ -34,39 +34,70 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Camera.h"
 #include "StringConverter.h"
 #include "LogManager.h"
+#include "Sphere.h"
+#include "Root.h"
+#include "WorkQueue.h"
+#include <algorithm>
 
 
 
 
 namespace renderer {
+namespace {
+/// Most tasks the affectors of one system are split into
+const size_t MAX_AFFECTOR_TASKS = 16;
+/// Fewest particles worth giving a task of their own
+const size_t MIN_PARTICLES_PER_TASK = 4096;
+
+/// Applies a run of batch affectors to a range of particles
+class AffectorTask : public WorkQueue::Task {
+public:
+  void run(void) {
+    system->_affectParticleRange(start, end, firstAffector, endAffector,
+                                 applyMotion, timeElapsed);
+  }
+
+  ParticleSystem* system;
+  size_t start, end;
+  size_t firstAffector, endAffector;
+  bool applyMotion;
+  Real timeElapsed;
+};
+}
+
 // Init statics
 ParticleSystem::CmdCull ParticleSystem::msCullCmd;
+ParticleSystem::CmdSorted ParticleSystem::msSortedCmd;
 ParticleSystem::CmdHeight ParticleSystem::msHeightCmd;
 ParticleSystem::CmdMaterial ParticleSystem::msMaterialCmd;
 ParticleSystem::CmdQuota ParticleSystem::msQuotaCmd;
 ParticleSystem::CmdWidth ParticleSystem::msWidthCmd;
 ParticleSystem::CmdBillboardType ParticleSystem::msBillboardTypeCmd;
 ParticleSystem::CmdCommonDirection ParticleSystem::msCommonDirectionCmd;
+ParticleSystem::CmdLodTransitionTime ParticleSystem::msLodTransitionTimeCmd;
 
 //-----------------------------------------------------------------------
-ParticleSystem::ParticleSystem() {
+ParticleSystem::ParticleSystem()
+  : mLastVisibleFrame(0), mAsleep(false), mSleepTime(0),
+    mLodIndex(-1), mLodTransitionTime(1), mLodEmissionScale(1), mLodSizeScale(1) {
   initParameters();
 }
 //-----------------------------------------------------------------------
-ParticleSystem::ParticleSystem(const String& name) {
+ParticleSystem::ParticleSystem(const String& name)
+  : mLastVisibleFrame(0), mAsleep(false), mSleepTime(0),
+    mLodIndex(-1), mLodTransitionTime(1), mLodEmissionScale(1), mLodSizeScale(1) {
   // DO NOT use superclass constructor
   // This will call setPoolSize in the BillboardSet context and create Billboard objects
   //  instead of Particle objects
   // Unavoidable due to C++ funky virtualisation rules & constructors
-  mpPositions = 0;
-  mpColours = 0;
+  mpVertexData = 0;
   mpIndexes = 0;
-  mpTexCoords = 0;
   mAutoExtendPool = true;
   mAllDefaultSize = true;
   mOriginType = BBO_CENTER;
   mName = name;
   mCullIndividual = true;
+  mSortingEnabled = false;
   setDefaultDimensions( 100, 100 );
   setMaterialName( "BaseWhite" );
   // Default to 10 particles, expect app to specify (will only be increased, not decreased)
@@ -74,6 +105,10 @@ ParticleSystem::ParticleSystem(const String& name) {
 
   initParameters();
 
+  // Counts as seen when created, so it doesn't sleep before it's had a
+  // chance to be
+  if (Root::getSingletonPtr())
+    mLastVisibleFrame = Root::getSingleton().getCurrentFrameNumber();
 }
 //-----------------------------------------------------------------------
 ParticleSystem::~ParticleSystem() {
@@ -172,8 +207,14 @@ ParticleSystem& ParticleSystem::operator=(const ParticleSystem& rhs) {
   mDefaultHeight = rhs.mDefaultHeight;
   mDefaultWidth = rhs.mDefaultWidth;
   mCullIndividual = rhs.mCullIndividual;
+  mSortingEnabled = rhs.mSortingEnabled;
   mBillboardType = rhs.mBillboardType;
   mCommonDirection = rhs.mCommonDirection;
+  mLodLevels = rhs.mLodLevels;
+  mLodTransitionTime = rhs.mLodTransitionTime;
+  mLodIndex = -1;
+  mLodEmissionScale = 1;
+  mLodSizeScale = 1;
 
 
   return *this;
@@ -181,7 +222,15 @@ ParticleSystem& ParticleSystem::operator=(const ParticleSystem& rhs) {
 }
 //-----------------------------------------------------------------------
 unsigned int ParticleSystem::getNumParticles(void) const {
-  return (unsigned int)mActiveBillboards.size();
+  return (unsigned int)mParticles.size();
+}
+//-----------------------------------------------------------------------
+int ParticleSystem::getNumBillboards(void) const {
+  return static_cast< int >( mParticles.size() );
+}
+//-----------------------------------------------------------------------
+unsigned int ParticleSystem::getPoolSize(void) const {
+  return static_cast< unsigned int >( mParticles.getCapacity() );
 }
 //-----------------------------------------------------------------------
 unsigned int ParticleSystem::getParticleQuota(void) const {
@@ -195,51 +244,114 @@ void ParticleSystem::setParticleQuota(unsigned int quota) {
 }
 //-----------------------------------------------------------------------
 void ParticleSystem::_update(Real timeElapsed) {
+  if (mParentNode)
+    _updateParticles(timeElapsed, mParentNode->_getDerivedOrientation(),
+                     mParentNode->_getDerivedPosition());
+  else
+    _updateParticles(timeElapsed, Quaternion::IDENTITY, Vector3::ZERO);
+
+  if (mParentNode)
+    mParentNode->needUpdate();
+
+}
+//-----------------------------------------------------------------------
+void ParticleSystem::_updateParticles(Real timeElapsed, const Quaternion& parentOrientation,
+                                      const Vector3& parentPosition) {
+  _updateLod(timeElapsed);
   _expire(timeElapsed);
-  _triggerEmitters(timeElapsed);
+  _triggerEmitters(timeElapsed, parentOrientation, parentPosition);
   _triggerAffectors(timeElapsed);
-  _applyMotion(timeElapsed);
-  _updateBounds();
+  _calculateBounds(parentOrientation, parentPosition);
 
 }
 //-----------------------------------------------------------------------
-void ParticleSystem::_expire(Real timeElapsed) {
-  ActiveBillboardList::iterator i, itEnd;
-  Particle* pParticle;
+void ParticleSystem::_notifyAttached(Node* parent) {
+  BillboardSet::_notifyAttached(parent);
+  // Likewise when attached, which may be long after it was created
+  if (parent && Root::getSingletonPtr())
+    mLastVisibleFrame = Root::getSingleton().getCurrentFrameNumber();
+}
+//-----------------------------------------------------------------------
+unsigned long ParticleSystem::_getLastVisibleFrame(void) const {
+  return mLastVisibleFrame;
+}
+//-----------------------------------------------------------------------
+bool ParticleSystem::isAsleep(void) const {
+  return mAsleep;
+}
+//-----------------------------------------------------------------------
+void ParticleSystem::_sleep(Real timeElapsed) {
+  mAsleep = true;
+  mSleepTime += timeElapsed;
+}
+//-----------------------------------------------------------------------
+void ParticleSystem::_wake(void) {
+  ParticleSystemManager& mgr = ParticleSystemManager::getSingleton();
+  Real catchUp = mSleepTime;
 
-  itEnd = mActiveBillboards.end();
+  mAsleep = false;
+  mSleepTime = 0;
 
-  for (i = mActiveBillboards.begin(); i != itEnd; ++i) {
-    pParticle = static_cast<Particle*>(*i);
-    if (pParticle->mTimeToLive < timeElapsed) {
-      // Destroy this one
-      mFreeBillboards.push_back( *i );
-      i = mActiveBillboards.erase( i );
+  if (catchUp > mgr.getMaxCatchUpTime()) {
+    // Too long to replay; start again from a warmed up system
+    mParticles.clear();
+    catchUp = mgr.getMaxCatchUpTime();
+  }
+  if (catchUp > 0)
+    fastForward(catchUp, mgr.getCatchUpInterval());
+  else
+    _updateBounds();
+
+}
+//-----------------------------------------------------------------------
+void ParticleSystem::_expire(Real timeElapsed) {
+  Real* ttl = mParticles.getTimeToLive();
+  size_t i = 0;
+
+  while (i < mParticles.size()) {
+    if (ttl[i] < timeElapsed) {
+      // Destroy this one; the last particle moves into its slot, so
+      // look at the same index again
+      mParticles.swapRemove(i);
     } else {
       // Decrement TTL
-      pParticle->mTimeToLive -= timeElapsed;
+      ttl[i] -= timeElapsed;
+      ++i;
     }
-
   }
 }
 //-----------------------------------------------------------------------
-void ParticleSystem::_triggerEmitters(Real timeElapsed) {
+void ParticleSystem::_triggerEmitters(Real timeElapsed, const Quaternion& parentOrientation,
+                                      const Vector3& parentPosition) {
   // Add up requests for emission
-  static std::vector<unsigned> requested;
-  if( requested.size() != mEmitters.size() )
+  std::vector<unsigned>& requested = mRequested;
+  if( requested.size() != mEmitters.size() ) {
     requested.resize( mEmitters.size() );
+    mLodEmissionRemainders.resize( mEmitters.size(), 0 );
+  }
 
-  size_t totalRequested, emitterCount, i, emissionAllowed;
+  size_t totalRequested, emitterCount, i, emissionAllowed, quota;
   ParticleEmitterList::iterator it, iEmitEnd;
 
+  // A LOD level may lower the quota; particles over it just aren't replaced
+  quota = getParticleQuota();
+  if (mLodIndex >= 0 && mLodLevels[mLodIndex].quota)
+    quota = std::min(quota, (size_t)mLodLevels[mLodIndex].quota);
+
   iEmitEnd = mEmitters.end();
   emitterCount = mEmitters.size();
-  emissionAllowed = getParticleQuota() - mActiveBillboards.size();
+  emissionAllowed = quota > mParticles.size() ? quota - mParticles.size() : 0;
   totalRequested = 0;
 
   // Count up total requested emissions
   for (it = mEmitters.begin(), i = 0; it != iEmitEnd; ++it, ++i) {
     requested[i] = (*it)->_getEmissionCount(timeElapsed);
+    if (mLodEmissionScale < 1) {
+      // Thin out for LOD, keeping fractions as the emitters do
+      Real scaled = requested[i] * mLodEmissionScale + mLodEmissionRemainders[i];
+      requested[i] = (unsigned int)scaled;
+      mLodEmissionRemainders[i] = scaled - requested[i];
+    }
     totalRequested += requested[i];
   }
 
@@ -249,80 +361,158 @@ void ParticleSystem::_triggerEmitters(Real timeElapsed) {
     // Apportion down requested values to allotted values
     Real ratio =  (Real)emissionAllowed / (Real)totalRequested;
     for (i = 0; i < emitterCount; ++i) {
-      requested[i] *= (unsigned int)ratio;
+      requested[i] = (unsigned int)(requested[i] * ratio);
     }
   }
 
   // Emit
   for (it = mEmitters.begin(), i = 0; it != iEmitEnd; ++it, ++i) {
     for (unsigned int j = 0; j < requested[i]; ++j) {
-      // Create a new particle & init using emitter
-      Particle* p = addParticle();
-      (*it)->_initParticle(p);
+      // Init a new particle using emitter, then copy it into the arrays
+      Particle p;
+      p._notifyOwner(this);
+      (*it)->_initParticle(&p);
       // Translate position & direction into world space
       // Maybe make emitter do this?
-      p->mPosition =  (mParentNode->_getDerivedOrientation() * p->mPosition) + mParentNode->_getDerivedPosition();
-      p->mDirection = mParentNode->_getDerivedOrientation() * p->mDirection;
-
+      p.mPosition = (parentOrientation * p.mPosition) + parentPosition;
+      p.mDirection = parentOrientation * p.mDirection;
+      mParticles.append(p);
     }
   }
 
 
 }
 //-----------------------------------------------------------------------
-void ParticleSystem::_applyMotion(Real timeElapsed) {
-  ActiveBillboardList::iterator i, itEnd;
-  Particle* pParticle;
+void ParticleSystem::_applyMotion(const ParticleData::Batch& batch, Real timeElapsed) {
+  Vector3* pos = batch.positions;
+  const Vector3* dir = batch.directions;
 
-  itEnd = mActiveBillboards.end();
-  for (i = mActiveBillboards.begin(); i != itEnd; ++i) {
-    pParticle = static_cast<Particle*>(*i);
-    pParticle->mPosition += (pParticle->mDirection * timeElapsed);
+  for (size_t i = 0; i < batch.count; ++i) {
+    pos[i] += (dir[i] * timeElapsed);
   }
 
 }
 //-----------------------------------------------------------------------
 void ParticleSystem::_triggerAffectors(Real timeElapsed) {
-  ParticleAffectorList::iterator i, itEnd;
+  const size_t numAffectors = mAffectors.size();
+  const size_t count = mParticles.size();
+  size_t i = 0, runEnd;
+
+  // Only large systems are worth splitting
+  size_t numTasks = 1;
+  WorkQueue* queue = WorkQueue::getSingletonPtr();
+  if (queue) {
+    numTasks = std::min(queue->getNumWorkers() + 1, MAX_AFFECTOR_TASKS);
+    numTasks = std::min(numTasks, count / MIN_PARTICLES_PER_TASK);
+  }
+
+  while (true) {
+    // Affectors which walk the whole system, one after another
+    for (; i < numAffectors && !mAffectors[i]->isBatched(); ++i) {
+      if (isAffectorActive(i))
+        mAffectors[i]->_affectParticles(this, timeElapsed);
+    }
+
+    // Then a run of batch affectors, all applied to one block before
+    // moving on to the next. The last run also moves the particles (even
+    // if it's empty, because the list ended with a non batch affector).
+    for (runEnd = i; runEnd < numAffectors && mAffectors[runEnd]->isBatched(); ++runEnd);
+    bool last = (runEnd == numAffectors);
+
+    if (numTasks <= 1) {
+      _affectParticleRange(0, count, i, runEnd, last, timeElapsed);
+    } else {
+      // Blocks don't depend on each other, so share them out in whole blocks
+      AffectorTask tasks[MAX_AFFECTOR_TASKS];
+      WorkQueue::Task* taskList[MAX_AFFECTOR_TASKS];
+      size_t particlesPerTask = (count + numTasks - 1) / numTasks;
+      particlesPerTask = (particlesPerTask + AFFECTOR_BLOCK_SIZE - 1) /
+                         AFFECTOR_BLOCK_SIZE * AFFECTOR_BLOCK_SIZE;
+      for (size_t t = 0; t < numTasks; ++t) {
+        AffectorTask& task = tasks[t];
+        task.system = this;
+        task.start = std::min(count, t * particlesPerTask);
+        task.end = std::min(count, task.start + particlesPerTask);
+        task.firstAffector = i;
+        task.endAffector = runEnd;
+        task.applyMotion = last;
+        task.timeElapsed = timeElapsed;
+        taskList[t] = &task;
+      }
+      queue->runAndWait(taskList, numTasks);
+    }
 
-  itEnd = mAffectors.end();
-  for (i = mAffectors.begin(); i != itEnd; ++i) {
-    (*i)->_affectParticles(this, timeElapsed);
+    if (last)
+      break;
+    i = runEnd;
   }
 
 }
 //-----------------------------------------------------------------------
-void ParticleSystem::increasePool(unsigned int size) {
-  size_t oldSize = mBillboardPool.size();
-
-  // Increase size
-  mBillboardPool.reserve(size);
-  mBillboardPool.resize(size);
+void ParticleSystem::_affectParticleRange(size_t start, size_t end,
+    size_t firstAffector, size_t endAffector,
+    bool applyMotion, Real timeElapsed) {
+  for (size_t block = start; block < end; block += AFFECTOR_BLOCK_SIZE) {
+    ParticleData::Batch batch = mParticles.getBatch(
+                                  block, std::min((size_t)AFFECTOR_BLOCK_SIZE, end - block));
+    for (size_t a = firstAffector; a < endAffector; ++a) {
+      if (isAffectorActive(a))
+        mAffectors[a]->_affectParticleBatch(this, batch, timeElapsed);
+    }
+    if (applyMotion)
+      _applyMotion(batch, timeElapsed);
+  }
 
-  // Create new particles
-  for( size_t i = oldSize; i < size; i++ )
-    mBillboardPool[i] = new Particle();
+}
+//-----------------------------------------------------------------------
+void ParticleSystem::increasePool(unsigned int size) {
+  // Particles live in the arrays, no Particle instances are created
+  mParticles.reserve(size);
 
 }
 //-----------------------------------------------------------------------
 ParticleIterator ParticleSystem::_getIterator(void) {
-  return ParticleIterator(mActiveBillboards.begin(), mActiveBillboards.end());
+  return ParticleIterator(&mParticles, this);
 }
 //-----------------------------------------------------------------------
-Particle* ParticleSystem::addParticle(void) {
-  // Fast creation (don't use superclass since emitter will init)
-  Billboard* newBill = mFreeBillboards.front();
-  mFreeBillboards.pop_front();
-  mActiveBillboards.push_back(newBill);
+ParticleData& ParticleSystem::_getParticleData(void) {
+  return mParticles;
+}
+//-----------------------------------------------------------------------
+void ParticleSystem::_notifyCurrentCamera(Camera* cam) {
+  // Being looked at; catch up first if this system was asleep
+  mLastVisibleFrame = Root::getSingleton().getCurrentFrameNumber();
+  if (mAsleep)
+    _wake();
 
-  newBill->_notifyOwner(this);
+  // Pick the LOD level for the next update
+  if (mParentNode && !mLodLevels.empty()) {
+    Real squaredDepth = mParentNode->getSquaredViewDepth(cam) * cam->_getLodBiasInverse();
+    mLodIndex = -1;
+    for (size_t i = 0; i < mLodLevels.size(); ++i) {
+      if (squaredDepth < mLodLevels[i].fromDepthSquared)
+        break;
+      mLodIndex = (int)i;
+    }
+  }
 
-  // Because we're creating objects here we know this is a Particle
-  return static_cast<Particle*>(newBill);
+  // Build the quads straight from the particle arrays; no gathering
+  // needed, unlike BillboardSet
+  BillboardArrays arrays;
+  arrays.count = mParticles.size();
+  arrays.positions = mParticles.getPositions();
+  arrays.directions = mParticles.getDirections();
+  arrays.colours = mParticles.getColours();
+  arrays.widths = mParticles.getWidths();
+  arrays.heights = mParticles.getHeights();
+  arrays.ownDimensions = mParticles.getOwnDimensions();
+  arrays.rotations = mParticles.getRotations();
+  arrays.sizeScale = mLodSizeScale;
 
+  genQuads(cam, arrays);
 }
 //-----------------------------------------------------------------------
-void ParticleSystem::genBillboardAxes(Camera& cam, Vector3* pX, Vector3 *pY, const Billboard* pBill) {
+void ParticleSystem::genBillboardAxes(Camera& cam, Vector3* pX, Vector3 *pY, const Vector3* pDirection) {
   // Orientation different from BillboardSet
   // Billboards are in world space (to decouple them from emitters in node space)
   Quaternion camQ;
@@ -348,7 +538,7 @@ void ParticleSystem::genBillboardAxes(Camera& cam, Vector3* pX, Vector3 *pY, con
     // X-axis is cross with camera direction
 
     // Scale direction first
-    *pY = (pBill->mDirection * 0.01);
+    *pY = (*pDirection * 0.01);
     *pX = cam.getDerivedDirection().crossProduct(*pY);
 
     break;
@@ -391,6 +581,11 @@ void ParticleSystem::initParameters(void) {
                                     PT_BOOL),
                        &msCullCmd);
 
+    dict->addParameter(ParameterDef("sorted",
+                                    "If true, particles are drawn furthest from the camera first. Needed for alpha blended particles to look right.",
+                                    PT_BOOL),
+                       &msSortedCmd);
+
     dict->addParameter(ParameterDef("billboard_type",
                                     "The type of billboard to use. 'point' means a simulated spherical particle, "
                                     "'oriented_common' means all particles in the set are oriented around common_direction, "
@@ -398,6 +593,12 @@ void ParticleSystem::initParameters(void) {
                                     PT_UNSIGNED_INT),
                        &msBillboardTypeCmd);
 
+    dict->addParameter(ParameterDef("lod_transition_time",
+                                    "The time in seconds over which changes of emission rate and particle size are "
+                                    "blended in when the LOD level changes.",
+                                    PT_REAL),
+                       &msLodTransitionTimeCmd);
+
     dict->addParameter(ParameterDef("common_direction",
                                     "Only useful when billboard_type is oriented_common. This parameter sets the common "
                                     "orientation for all particles in the set (e.g. raindrops may all be oriented downwards).",
@@ -408,8 +609,45 @@ void ParticleSystem::initParameters(void) {
 }
 //-----------------------------------------------------------------------
 void ParticleSystem::_updateBounds() {
-  // Call superclass
-  BillboardSet::_updateBounds();
+  if (mParentNode)
+    _calculateBounds(mParentNode->_getDerivedOrientation(), mParentNode->_getDerivedPosition());
+  else
+    _calculateBounds(Quaternion::IDENTITY, Vector3::ZERO);
+
+  if (mParentNode)
+    mParentNode->needUpdate();
+}
+//-----------------------------------------------------------------------
+void ParticleSystem::_calculateBounds(const Quaternion& parentOrientation,
+                                      const Vector3& parentPosition) {
+  const size_t count = mParticles.size();
+
+  if (count == 0) {
+    // No particles, null bbox
+    mAABB.setNull();
+    mBoundingRadius = 0.0f;
+  } else {
+    Real maxSqLen = -1.0f;
+
+    Vector3 min(Math::POS_INFINITY, Math::POS_INFINITY, Math::POS_INFINITY);
+    Vector3 max(Math::NEG_INFINITY, Math::NEG_INFINITY, Math::NEG_INFINITY);
+    const Vector3* pos = mParticles.getPositions();
+
+    for (size_t i = 0; i < count; ++i) {
+      min.makeFloor(pos[i]);
+      max.makeCeil(pos[i]);
+
+      maxSqLen = std::max(maxSqLen, pos[i].squaredLength());
+    }
+    // Adjust for billboard size
+    Real adjust = std::max(mDefaultWidth, mDefaultHeight) * mLodSizeScale;
+    Vector3 vecAdjust(adjust, adjust, adjust);
+    min -= vecAdjust;
+    max += vecAdjust;
+
+    mAABB.setExtents(min, max);
+    mBoundingRadius = Math::Sqrt(maxSqLen);
+  }
 
   if (mParentNode && !mAABB.isNull()) {
     // Have to override because bounds are supposed to be in local node space
@@ -420,8 +658,8 @@ void ParticleSystem::_updateBounds() {
     Vector3 max( Math::NEG_INFINITY, Math::NEG_INFINITY, Math::NEG_INFINITY );
     Vector3 temp;
     const Vector3 *corner = mAABB.getAllCorners();
-    Quaternion invQ = mParentNode->_getDerivedOrientation().Inverse();
-    Vector3 t = mParentNode->_getDerivedPosition();
+    Quaternion invQ = parentOrientation.Inverse();
+    const Vector3& t = parentPosition;
 
     for (int i = 0; i < 8; ++i) {
       // Reverse transform corner
@@ -441,6 +679,80 @@ void ParticleSystem::fastForward(Real time, Real interval) {
     _update(interval);
   }
 }
+//-----------------------------------------------------------------------
+void ParticleSystem::addLodLevel(Real fromDepth, Real emissionScale, unsigned int quota,
+                                 unsigned int affectorMask, bool sizeCompensation) {
+  assert(emissionScale >= 0 && emissionScale <= 1 && "Emission scale must be from 0 to 1");
+
+  LodLevel level;
+  level.fromDepthSquared = fromDepth * fromDepth;
+  level.emissionScale = emissionScale;
+  level.quota = quota;
+  level.affectorMask = affectorMask;
+  level.sizeCompensation = sizeCompensation;
+
+  // Keep nearest first
+  LodLevelList::iterator i = mLodLevels.begin();
+  while (i != mLodLevels.end() && i->fromDepthSquared <= level.fromDepthSquared)
+    ++i;
+  mLodLevels.insert(i, level);
+  // The current index may now point at a different level; picked again
+  // when next seen
+  mLodIndex = -1;
+}
+//-----------------------------------------------------------------------
+unsigned short ParticleSystem::getNumLodLevels(void) const {
+  return static_cast< unsigned short >( mLodLevels.size() );
+}
+//-----------------------------------------------------------------------
+void ParticleSystem::removeAllLodLevels(void) {
+  mLodLevels.clear();
+  mLodIndex = -1;
+}
+//-----------------------------------------------------------------------
+void ParticleSystem::setLodTransitionTime(Real seconds) {
+  mLodTransitionTime = seconds;
+}
+//-----------------------------------------------------------------------
+Real ParticleSystem::getLodTransitionTime(void) const {
+  return mLodTransitionTime;
+}
+//-----------------------------------------------------------------------
+int ParticleSystem::_getLodIndex(void) const {
+  return mLodIndex;
+}
+//-----------------------------------------------------------------------
+void ParticleSystem::_updateLod(Real timeElapsed) {
+  Real targetEmission = 1;
+  Real targetSize = 1;
+  if (mLodIndex >= 0) {
+    const LodLevel& level = mLodLevels[mLodIndex];
+    targetEmission = level.emissionScale;
+    if (level.sizeCompensation) {
+      // Covered area goes with count * size^2; don't blow up tiny scales
+      targetSize = 1 / Math::Sqrt(std::max(targetEmission, (Real)0.1));
+    }
+  }
+
+  // Ease towards the targets rather than jumping
+  Real blend = 1;
+  if (mLodTransitionTime > 0)
+    blend = std::min((Real)1, timeElapsed / mLodTransitionTime);
+  mLodEmissionScale += (targetEmission - mLodEmissionScale) * blend;
+  mLodSizeScale += (targetSize - mLodSizeScale) * blend;
+  // Settle once close enough, so full detail really is full detail
+  if (Math::Abs(targetEmission - mLodEmissionScale) < 0.001)
+    mLodEmissionScale = targetEmission;
+  if (Math::Abs(targetSize - mLodSizeScale) < 0.001)
+    mLodSizeScale = targetSize;
+
+}
+//-----------------------------------------------------------------------
+bool ParticleSystem::isAffectorActive(size_t index) const {
+  if (mLodIndex < 0 || index >= 32)
+    return true;
+  return (mLodLevels[mLodIndex].affectorMask & (1u << index)) != 0;
+}
 
 //-----------------------------------------------------------------------
 String ParticleSystem::CmdCull::doGet(void* target) {
@@ -452,6 +764,15 @@ void ParticleSystem::CmdCull::doSet(void* target, const String& val) {
     StringConverter::parseBool(val));
 }
 //-----------------------------------------------------------------------
+String ParticleSystem::CmdSorted::doGet(void* target) {
+  return StringConverter::toString(
+           static_cast<ParticleSystem*>(target)->getSortingEnabled() );
+}
+void ParticleSystem::CmdSorted::doSet(void* target, const String& val) {
+  static_cast<ParticleSystem*>(target)->setSortingEnabled(
+    StringConverter::parseBool(val));
+}
+//-----------------------------------------------------------------------
 String ParticleSystem::CmdHeight::doGet(void* target) {
   return StringConverter::toString(
            static_cast<ParticleSystem*>(target)->getDefaultHeight() );
@@ -522,5 +843,14 @@ void ParticleSystem::CmdCommonDirection::doSet(void* target, const String& val)
   static_cast<ParticleSystem*>(target)->setCommonDirection(
     StringConverter::parseVector3(val));
 }
+//-----------------------------------------------------------------------
+String ParticleSystem::CmdLodTransitionTime::doGet(void* target) {
+  return StringConverter::toString(
+           static_cast<ParticleSystem*>(target)->getLodTransitionTime() );
+}
+void ParticleSystem::CmdLodTransitionTime::doSet(void* target, const String& val) {
+  static_cast<ParticleSystem*>(target)->setLodTransitionTime(
+    StringConverter::parseReal(val));
+}
 
 }
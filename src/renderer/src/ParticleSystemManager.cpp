@@ -34,13 +34,35 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "LogManager.h"
 #include "MyString.h"
 #include "SDDataChunk.h"
+#include "StringConverter.h"
+#include "Node.h"
+#include "WorkQueue.h"
 
 
 namespace renderer {
+namespace {
+/// Updates one particle system
+class SystemUpdateTask : public WorkQueue::Task {
+public:
+  void run(void) {
+    system->_updateParticles(timeElapsed, parentOrientation, parentPosition);
+  }
+
+  ParticleSystem* system;
+  Real timeElapsed;
+  /// Derived on the main thread, see ParticleSystem::_updateParticles
+  Quaternion parentOrientation;
+  Vector3 parentPosition;
+};
+}
+
 ParticleSystemManager* Singleton<ParticleSystemManager>::ms_Singleton = 0;
 //-----------------------------------------------------------------------
 ParticleSystemManager::ParticleSystemManager() {
   mTimeFactor = 1;
+  mSleepFrames = 30;
+  mMaxCatchUpTime = 2;
+  mCatchUpInterval = 0.1;
 }
 //-----------------------------------------------------------------------
 ParticleSystemManager::~ParticleSystemManager() {
@@ -55,8 +77,14 @@ ParticleSystemManager::~ParticleSystemManager() {
 }
 //-----------------------------------------------------------------------
 void ParticleSystemManager::parseScript(DataChunk& chunk) {
+  ScriptNodeList nodes;
+  compileScript(chunk, nodes);
+  applyScript(nodes);
+}
+//-----------------------------------------------------------------------
+void ParticleSystemManager::compileScript(DataChunk& chunk, ScriptNodeList& nodes) {
   String line;
-  ParticleSystem* pSys;
+  ScriptNode* pSys;
   std::vector<String> vecparams;
 
   pSys = 0;
@@ -68,46 +96,46 @@ void ParticleSystemManager::parseScript(DataChunk& chunk) {
       if (pSys == 0) {
         // No current system
         // So first valid data should be a system name
-        pSys = createTemplate(line);
+        nodes.push_back(ScriptNode());
+        pSys = &nodes.back();
+        pSys->tokens.push_back(line);
+        pSys->isBlock = true;
         // Skip to and over next {
         skipToNextOpenBrace(chunk);
       } else {
         // Already in a system
+        vecparams.clear();
+        base::SplitString(line, &vecparams, "\t ");
+
         if (line == "}") {
           // Finished system
           pSys = 0;
-        } else if (line.substr(0,7) == "emitter") {
-          // new emitter
-          // Get typename
-          vecparams.clear();
-          base::SplitString(line, &vecparams, "\t ");
+        } else if (vecparams[0] == "emitter" || vecparams[0] == "affector" ||
+                   vecparams[0] == "lod") {
+          // new emitter, affector or LOD level
+          // Get typename / distance
           if (vecparams.size() < 2) {
-            // Oops, bad emitter
-            LogManager::getSingleton().logMessage("Bad particle system emitter line: '"
-                                                  + line + "' in " + pSys->getName());
+            // Oops, bad line
+            LogManager::getSingleton().logMessage("Bad particle system " + vecparams[0] + " line: '"
+                                                  + line + "' in " + pSys->tokens[0]);
             skipToNextCloseBrace(chunk);
-
+            continue;
           }
+          pSys->children.push_back(ScriptNode());
+          ScriptNode& node = pSys->children.back();
+          node.tokens.push_back(vecparams[0]);
+          node.tokens.push_back(vecparams[1]);
           skipToNextOpenBrace(chunk);
-          parseNewEmitter(vecparams[1], chunk, pSys);
-
-        } else if (line.substr(0,8) == "affector") {
-          // new affector
-          // Get typename
-          vecparams.clear();
-          base::SplitString(line, &vecparams, "\t ");
-          if (vecparams.size() < 2) {
-            // Oops, bad emitter
-            LogManager::getSingleton().logMessage("Bad particle system affector line: '"
-                                                  + line + "' in " + pSys->getName());
-            skipToNextCloseBrace(chunk);
+          // Emitter & affector attributes are a name and a value, LOD ones
+          // are split on every space
+          compileBlock(chunk, node, vecparams[0] == "lod" ? 0 : 1);
 
-          }
-          skipToNextOpenBrace(chunk);
-          parseNewAffector(vecparams[1],chunk, pSys);
         } else {
           // Attribute
-          parseAttrib(line, pSys);
+          pSys->children.push_back(ScriptNode());
+          StringVector& tokens = pSys->children.back().tokens;
+          base::SplitString(line, &tokens, "\t ", 1);
+          tokens.resize(2);
         }
 
       }
@@ -118,21 +146,63 @@ void ParticleSystemManager::parseScript(DataChunk& chunk) {
   }
 
 
+}
+//-----------------------------------------------------------------------
+void ParticleSystemManager::applyScript(const ScriptNodeList& nodes) {
+  ScriptNodeList::const_iterator i, iend = nodes.end();
+  for (i = nodes.begin(); i != iend; ++i) {
+    ParticleSystem* pSys = createTemplate(i->tokens[0]);
+
+    ScriptNodeList::const_iterator c, cend = i->children.end();
+    for (c = i->children.begin(); c != cend; ++c) {
+      if (!c->isBlock) {
+        parseAttrib(c->tokens, pSys);
+      } else if (c->tokens[0] == "emitter") {
+        parseNewEmitter(*c, pSys);
+      } else if (c->tokens[0] == "affector") {
+        parseNewAffector(*c, pSys);
+      } else {
+        parseNewLodLevel(*c, pSys);
+      }
+    }
+  }
+
 }
 //-----------------------------------------------------------------------
 void ParticleSystemManager::parseAllSources(const String& extension) {
   std::set<String> particleFiles;
+  // Files in the order they are to be applied, which decides what happens
+  // when two define the same template
+  ScriptCache::SourceList sources;
+  std::vector<const ScriptNodeList*> scripts;
 
   particleFiles = ResourceManager::_getAllCommonNamesLike("./", extension);
 
   // Iterate through returned files
   std::set<String>::iterator i;
   for (i = particleFiles.begin(); i != particleFiles.end(); ++i) {
-    SDDataChunk chunk;
     LogManager::getSingleton().logMessage("Parsing particle script " + *i);
-    ResourceManager::_findCommonResourceData(*i, chunk);
-    parseScript(chunk);
+    ArchiveEx* archive = ResourceManager::_findCommonArchive(*i);
+    if (!archive)
+      Except(Exception::ERR_ITEM_NOT_FOUND, "Resource " + *i + " not found.",
+             "ParticleSystemManager::parseAllSources");
+    sources.push_back(ScriptCache::Source(archive, *i));
   }
+
+  // Compiled in parallel, but applied one by one on this thread
+  mScriptCache.getScripts(sources, this, scripts);
+  for (size_t s = 0; s < scripts.size(); ++s) {
+    applyScript(*scripts[s]);
+  }
+  mScriptCache.save();
+}
+//-----------------------------------------------------------------------
+void ParticleSystemManager::setScriptCacheFile(const String& filename) {
+  mScriptCache.setFileName(filename);
+}
+//-----------------------------------------------------------------------
+const String& ParticleSystemManager::getScriptCacheFile(void) const {
+  return mScriptCache.getFileName();
 }
 //-----------------------------------------------------------------------
 void ParticleSystemManager::addEmitterFactory(ParticleEmitterFactory* factory) {
@@ -271,11 +341,53 @@ bool ParticleSystemManager::RunFrame(Real t) {
   // Apply time factor
   Real timeSinceLastFrame = mTimeFactor * t;// evt.timeSinceLastFrame;
 
-  // update systems
-  // TODO: only do this for visible systems
+  // Only update systems which have been seen recently, the others sleep
+  // until they are seen again
+  unsigned long frame = Root::getSingleton().getCurrentFrameNumber();
+  mAwakeSystems.clear();
   ParticleSystemMap::iterator i;
   for (i = mSystems.begin(); i != mSystems.end(); ++i) {
-    i->second->_update(timeSinceLastFrame);
+    ParticleSystem* sys = i->second;
+    // Never while the bounds are null; the system can't be seen until it
+    // has some, so would never be woken
+    if (mSleepFrames && frame - sys->_getLastVisibleFrame() > mSleepFrames &&
+        !sys->getBoundingBox().isNull()) {
+      sys->_sleep(timeSinceLastFrame);
+    } else {
+      mAwakeSystems.push_back(sys);
+    }
+  }
+
+  size_t numSystems = mAwakeSystems.size();
+  if (numSystems == 0)
+    return true;
+
+  // Systems don't share anything but their parent nodes, which are derived
+  // here on this thread and notified afterwards
+  std::vector<SystemUpdateTask> tasks(numSystems);
+  std::vector<WorkQueue::Task*> taskList(numSystems);
+  for (size_t s = 0; s < numSystems; ++s) {
+    ParticleSystem* sys = mAwakeSystems[s];
+    Node* node = sys->getParentNode();
+    tasks[s].system = sys;
+    tasks[s].timeElapsed = timeSinceLastFrame;
+    tasks[s].parentOrientation = node ? node->_getDerivedOrientation() : Quaternion::IDENTITY;
+    tasks[s].parentPosition = node ? node->_getDerivedPosition() : Vector3::ZERO;
+    taskList[s] = &tasks[s];
+  }
+
+  WorkQueue* queue = WorkQueue::getSingletonPtr();
+  if (numSystems > 1 && queue && queue->getNumWorkers() > 0) {
+    queue->runAndWait(&taskList[0], numSystems);
+  } else {
+    for (size_t s = 0; s < numSystems; ++s)
+      tasks[s].run();
+  }
+
+  for (size_t s = 0; s < numSystems; ++s) {
+    Node* node = mAwakeSystems[s]->getParentNode();
+    if (node)
+      node->needUpdate();
   }
 
   return true;
@@ -297,90 +409,114 @@ ParticleSystemManager& ParticleSystemManager::getSingleton(void) {
   return Singleton<ParticleSystemManager>::getSingleton();
 }
 //-----------------------------------------------------------------------
-void ParticleSystemManager::parseNewEmitter(const String& type, DataChunk& chunk, ParticleSystem* sys) {
-  // Create new emitter
-  ParticleEmitter* pEmit = sys->addEmitter(type);
-  // Parse emitter details
+void ParticleSystemManager::compileBlock(DataChunk& chunk, ScriptNode& node, unsigned int maxSplit) {
   String line;
 
+  node.isBlock = true;
+
   while(!chunk.isEOF()) {
     line = chunk.getLine();
     // Ignore comments & blanks
     if (!(line.length() == 0 || line.substr(0,2) == "//")) {
       if (line == "}") {
-        // Finished emitter
+        // Finished block
         break;
       } else {
         // Attribute
-        parseEmitterAttrib(StringToLowerASCII(line), pEmit);
+        node.children.push_back(ScriptNode());
+        StringVector& tokens = node.children.back().tokens;
+        base::SplitString(StringToLowerASCII(line), &tokens, "\t ", maxSplit);
+        if (maxSplit)
+          tokens.resize(maxSplit + 1);
       }
     }
   }
 
-
+}
+//-----------------------------------------------------------------------
+void ParticleSystemManager::parseNewEmitter(const ScriptNode& node, ParticleSystem* sys) {
+  // Create new emitter
+  ParticleEmitter* pEmit = sys->addEmitter(node.tokens[1]);
+  // Parse emitter details
+  ScriptNodeList::const_iterator i, iend = node.children.end();
+  for (i = node.children.begin(); i != iend; ++i) {
+    parseEmitterAttrib(i->tokens, pEmit);
+  }
 
 }
 //-----------------------------------------------------------------------
-void ParticleSystemManager::parseNewAffector(const String& type, DataChunk& chunk, ParticleSystem* sys) {
+void ParticleSystemManager::parseNewAffector(const ScriptNode& node, ParticleSystem* sys) {
   // Create new affector
-  ParticleAffector* pAff = sys->addAffector(type);
+  ParticleAffector* pAff = sys->addAffector(node.tokens[1]);
   // Parse affector details
-  String line;
-
-  while(!chunk.isEOF()) {
-    line = chunk.getLine();
-    // Ignore comments & blanks
-    if (!(line.length() == 0 || line.substr(0,2) == "//")) {
-      if (line == "}") {
-        // Finished affector
-        break;
-      } else {
-        // Attribute
-        parseAffectorAttrib(StringToLowerASCII(line), pAff);
+  ScriptNodeList::const_iterator i, iend = node.children.end();
+  for (i = node.children.begin(); i != iend; ++i) {
+    parseAffectorAttrib(i->tokens, pAff);
+  }
+}
+//-----------------------------------------------------------------------
+void ParticleSystemManager::parseNewLodLevel(const ScriptNode& node, ParticleSystem* sys) {
+  // Defaults are full detail
+  Real emissionScale = 1;
+  unsigned int quota = 0;
+  unsigned int affectorMask = ParticleSystem::ALL_AFFECTORS;
+  bool sizeCompensation = false;
+
+  // Parse LOD level details
+  ScriptNodeList::const_iterator i, iend = node.children.end();
+  for (i = node.children.begin(); i != iend; ++i) {
+    const StringVector& vecparams = i->tokens;
+
+    if (vecparams[0] == "emission_scale" && vecparams.size() > 1) {
+      emissionScale = StringConverter::parseReal(vecparams[1]);
+      emissionScale = std::max((Real)0, std::min((Real)1, emissionScale));
+    } else if (vecparams[0] == "quota" && vecparams.size() > 1) {
+      quota = StringConverter::parseUnsignedInt(vecparams[1]);
+    } else if (vecparams[0] == "affectors") {
+      // Indexes of the affectors to keep
+      affectorMask = 0;
+      for (size_t a = 1; a < vecparams.size(); ++a) {
+        unsigned int index = StringConverter::parseUnsignedInt(vecparams[a]);
+        if (index < 32)
+          affectorMask |= (1u << index);
       }
+    } else if (vecparams[0] == "size_compensation" && vecparams.size() > 1) {
+      sizeCompensation = StringConverter::parseBool(vecparams[1]);
+    } else {
+      // BAD command. BAD!
+      LogManager::getSingleton().logMessage("Bad particle system lod attribute line: '"
+                                            + base::JoinString(vecparams, ' ') + "' in " + sys->getName());
     }
   }
+
+  sys->addLodLevel(StringConverter::parseReal(node.tokens[1]), emissionScale, quota,
+                   affectorMask, sizeCompensation);
 }
 //-----------------------------------------------------------------------
-void ParticleSystemManager::parseAttrib(const String& line, ParticleSystem* sys) {
-  std::vector<String> vecparams;
-
-  // Split params on space
-  base::SplitString(line, &vecparams, "\t ", 1);
-
+void ParticleSystemManager::parseAttrib(const StringVector& tokens, ParticleSystem* sys) {
   // Look up first param (command setting)
-  if (!sys->setParameter(vecparams[0], vecparams[1])) {
+  if (!sys->setParameter(tokens[0], tokens[1])) {
     // BAD command. BAD!
     LogManager::getSingleton().logMessage("Bad particle system attribute line: '"
-                                          + line + "' in " + sys->getName());
+                                          + base::JoinString(tokens, ' ') + "' in " + sys->getName());
   }
 }
 //-----------------------------------------------------------------------
-void ParticleSystemManager::parseEmitterAttrib(const String& line, ParticleEmitter* emit) {
-  std::vector<String> vecparams;
-
-  // Split params on first space
-  base::SplitString(line, &vecparams, "\t ", 1);
-
+void ParticleSystemManager::parseEmitterAttrib(const StringVector& tokens, ParticleEmitter* emit) {
   // Look up first param (command setting)
-  if (!emit->setParameter(vecparams[0], vecparams[1])) {
+  if (!emit->setParameter(tokens[0], tokens[1])) {
     // BAD command. BAD!
     LogManager::getSingleton().logMessage("Bad particle emitter attribute line: '"
-                                          + line + "' for emitter " + emit->getType());
+                                          + base::JoinString(tokens, ' ') + "' for emitter " + emit->getType());
   }
 }
 //-----------------------------------------------------------------------
-void ParticleSystemManager::parseAffectorAttrib(const String& line, ParticleAffector* aff) {
-  std::vector<String> vecparams;
-
-  // Split params on space
-  base::SplitString(line, &vecparams, "\t ", 1);
-
+void ParticleSystemManager::parseAffectorAttrib(const StringVector& tokens, ParticleAffector* aff) {
   // Look up first param (command setting)
-  if (!aff->setParameter(vecparams[0], vecparams[1])) {
+  if (!aff->setParameter(tokens[0], tokens[1])) {
     // BAD command. BAD!
     LogManager::getSingleton().logMessage("Bad particle affector attribute line: '"
-                                          + line + "' for affector " + aff->getType());
+                                          + base::JoinString(tokens, ' ') + "' for affector " + aff->getType());
   }
 }
 //-----------------------------------------------------------------------
@@ -407,4 +543,28 @@ Real ParticleSystemManager::getTimeFactor(void) {
 void ParticleSystemManager::setTimeFactor(Real tf) {
   if(tf >= 0) mTimeFactor = tf;
 }
+//-----------------------------------------------------------------------
+void ParticleSystemManager::setSleepFrames(unsigned int frames) {
+  mSleepFrames = frames;
+}
+//-----------------------------------------------------------------------
+unsigned int ParticleSystemManager::getSleepFrames(void) const {
+  return mSleepFrames;
+}
+//-----------------------------------------------------------------------
+void ParticleSystemManager::setMaxCatchUpTime(Real time) {
+  if (time >= 0) mMaxCatchUpTime = time;
+}
+//-----------------------------------------------------------------------
+Real ParticleSystemManager::getMaxCatchUpTime(void) const {
+  return mMaxCatchUpTime;
+}
+//-----------------------------------------------------------------------
+void ParticleSystemManager::setCatchUpInterval(Real interval) {
+  if (interval > 0) mCatchUpInterval = interval;
+}
+//-----------------------------------------------------------------------
+Real ParticleSystemManager::getCatchUpInterval(void) const {
+  return mCatchUpInterval;
+}
 }
@@ -0,0 +1,122 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#include "PoolAllocator.h"
+
+namespace renderer {
+namespace {
+/// Locks only if the pool is thread safe
+class OptionalAutoLock {
+public:
+  OptionalAutoLock(base::Lock& lock, bool enabled)
+    : mLock(lock), mEnabled(enabled) {
+    if (mEnabled) {
+      mLock.Acquire();
+    }
+  }
+  ~OptionalAutoLock() {
+    if (mEnabled) {
+      mLock.Release();
+    }
+  }
+private:
+  base::Lock& mLock;
+  bool mEnabled;
+};
+}
+
+//-----------------------------------------------------------------------
+PoolAllocator::PoolAllocator(size_t blockSize, size_t blocksPerSlab, bool threadSafe)
+  : mBlockSize((std::max(blockSize, sizeof(FreeBlock)) + 15) & ~size_t(15)),
+    mBlocksPerSlab(std::max(blocksPerSlab, size_t(1))),
+    mThreadSafe(threadSafe),
+    mFreeList(0),
+    mNumAllocated(0) {
+}
+//-----------------------------------------------------------------------
+PoolAllocator::~PoolAllocator() {
+  std::vector<char*>::iterator i;
+  for (i = mSlabs.begin(); i != mSlabs.end(); ++i) {
+    ::operator delete(*i);
+  }
+}
+//-----------------------------------------------------------------------
+void* PoolAllocator::allocate(size_t size) {
+  if (size > mBlockSize) {
+    return ::operator new(size);
+  }
+
+  OptionalAutoLock lock(mLock, mThreadSafe);
+  if (!mFreeList) {
+    addSlab();
+  }
+  FreeBlock* block = mFreeList;
+  mFreeList = block->next;
+  ++mNumAllocated;
+  return block;
+}
+//-----------------------------------------------------------------------
+void PoolAllocator::deallocate(void* p, size_t size) {
+  if (!p) {
+    return;
+  }
+  if (size > mBlockSize) {
+    ::operator delete(p);
+    return;
+  }
+
+  OptionalAutoLock lock(mLock, mThreadSafe);
+  FreeBlock* block = static_cast<FreeBlock*>(p);
+  block->next = mFreeList;
+  mFreeList = block;
+  --mNumAllocated;
+}
+//-----------------------------------------------------------------------
+size_t PoolAllocator::getBlockSize(void) const {
+  return mBlockSize;
+}
+//-----------------------------------------------------------------------
+size_t PoolAllocator::getNumAllocated(void) const {
+  OptionalAutoLock lock(mLock, mThreadSafe);
+  return mNumAllocated;
+}
+//-----------------------------------------------------------------------
+size_t PoolAllocator::getReservedSize(void) const {
+  OptionalAutoLock lock(mLock, mThreadSafe);
+  return mSlabs.size() * mBlocksPerSlab * mBlockSize;
+}
+//-----------------------------------------------------------------------
+void PoolAllocator::addSlab(void) {
+  char* slab = static_cast<char*>(::operator new(mBlocksPerSlab * mBlockSize));
+  mSlabs.push_back(slab);
+
+  // Link the blocks in address order, so they are handed out that way
+  for (size_t i = mBlocksPerSlab; i-- > 0; ) {
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * mBlockSize);
+    block->next = mFreeList;
+    mFreeList = block;
+  }
+}
+
+}
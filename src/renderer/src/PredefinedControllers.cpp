@@ -209,7 +209,7 @@ Real WaveformControllerFunction::calculate(Real source) {
   // Calculate output in -1..1 range
   switch (mWaveType) {
   case WFT_SINE:
-    output = Math::Sin(input * Math::TWO_PI);
+    output = Math::Sin(input * Math::TWO_PI, true);
     break;
   case WFT_TRIANGLE:
     if (input < 0.25)
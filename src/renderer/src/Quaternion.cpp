@@ -132,8 +132,8 @@ void Quaternion::FromAngleAxis (const Real& rfAngle,
   //   q = cos(A/2)+sin(A/2)*(x*i+y*j+z*k)
 
   Real fHalfAngle = 0.5*rfAngle;
-  Real fSin = Math::Sin(fHalfAngle);
-  w = Math::Cos(fHalfAngle);
+  Real fSin;
+  Math::SinCos(fHalfAngle, fSin, w);
   x = fSin*rkAxis.x;
   y = fSin*rkAxis.y;
   z = fSin*rkAxis.z;
@@ -293,10 +293,10 @@ Quaternion Quaternion::Exp () const {
   // use exp(q) = cos(A)+A*(x*i+y*j+z*k) since A/sin(A) has limit 1.
 
   Real fAngle = Math::Sqrt(x*x+y*y+z*z);
-  Real fSin = Math::Sin(fAngle);
+  Real fSin;
 
   Quaternion kResult;
-  kResult.w = Math::Cos(fAngle);
+  Math::SinCos(fAngle, fSin, kResult.w);
 
   if ( Math::Abs(fSin) >= ms_fEpsilon ) {
     Real fCoeff = fSin/fAngle;
@@ -360,10 +360,14 @@ Quaternion Quaternion::Slerp (Real fT, const Quaternion& rkP,
   if ( Math::Abs(fAngle) < ms_fEpsilon )
     return rkP;
 
-  Real fSin = Math::Sin(fAngle);
-  Real fInvSin = 1.0/fSin;
-  Real fCoeff0 = Math::Sin((1.0-fT)*fAngle)*fInvSin;
-  Real fCoeff1 = Math::Sin(fT*fAngle)*fInvSin;
+  // All three sines in one batch
+  Real fAngles[4] = { fAngle, (1.0f-fT)*fAngle, fT*fAngle, 0 };
+  Real fSins[4];
+  Math::Sin4(fAngles, fSins);
+
+  Real fInvSin = 1.0/fSins[0];
+  Real fCoeff0 = fSins[1]*fInvSin;
+  Real fCoeff1 = fSins[2]*fInvSin;
   return fCoeff0*rkP + fCoeff1*rkQ;
 }
 //-----------------------------------------------------------------------
@@ -375,11 +379,14 @@ Quaternion Quaternion::SlerpExtraSpins (Real fT,
   if ( Math::Abs(fAngle) < ms_fEpsilon )
     return rkP;
 
-  Real fSin = Math::Sin(fAngle);
   Real fPhase = Math::PI*iExtraSpins*fT;
-  Real fInvSin = 1.0/fSin;
-  Real fCoeff0 = Math::Sin((1.0-fT)*fAngle - fPhase)*fInvSin;
-  Real fCoeff1 = Math::Sin(fT*fAngle + fPhase)*fInvSin;
+  Real fAngles[4] = { fAngle, (1.0f-fT)*fAngle - fPhase, fT*fAngle + fPhase, 0 };
+  Real fSins[4];
+  Math::Sin4(fAngles, fSins);
+
+  Real fInvSin = 1.0/fSins[0];
+  Real fCoeff0 = fSins[1]*fInvSin;
+  Real fCoeff1 = fSins[2]*fInvSin;
   return fCoeff0*rkP + fCoeff1*rkQ;
 }
 //-----------------------------------------------------------------------
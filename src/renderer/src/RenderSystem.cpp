@@ -37,6 +37,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "RenderWindow.h"
 #include "MeshManager.h"
 #include "Material.h"
+#include "VertexInfluenceStream.h"
 #include "base/time.h"
 
 namespace renderer {
@@ -408,8 +409,8 @@ unsigned short RenderSystem::_getNumVertexBlendMatrices(void) {
 }
 //-----------------------------------------------------------------------
 void RenderSystem::softwareVertexBlend(RenderOperation& op, Matrix4* pMatrices) {
-  // Source vector
-  Vector3 sourceVec;
+  // Source vectors
+  Vector3 sourceVec, sourceNorm;
   // Accumulation vectors
   Vector3 accumVecPos, accumVecNorm;
 
@@ -428,6 +429,24 @@ void RenderSystem::softwareVertexBlend(RenderOperation& op, Matrix4* pMatrices)
     mTempNormalBlendBuffer.resize(numVertReals);
   }
 
+  if (op.pInfluences) {
+    // Fast path using the compacted influences
+    const bool hasNormals = (op.vertexOptions & RenderOperation::VO_NORMALS) != 0;
+    op.pInfluences->skin(pMatrices, op.pVertices, op.vertexStride,
+                         hasNormals ? op.pNormals : 0, op.normalStride,
+                         &mTempVertexBlendBuffer.front(),
+                         hasNormals ? &mTempNormalBlendBuffer.front() : 0);
+
+    // Re-point the render operation vertex buffer, which is now packed
+    op.pVertices = &mTempVertexBlendBuffer.front();
+    op.vertexStride = 0;
+    if (hasNormals) {
+      op.pNormals = &mTempNormalBlendBuffer.front();
+      op.normalStride = 0;
+    }
+    return;
+  }
+
 
   // Loop per vertex
   pVertElem = op.pVertices;
@@ -441,12 +460,13 @@ void RenderSystem::softwareVertexBlend(RenderOperation& op, Matrix4* pMatrices)
     sourceVec.z = *pVertElem++;
 
     if (op.vertexOptions & RenderOperation::VO_NORMALS) {
-      accumVecNorm.x = *pNormElem++;
-      accumVecNorm.y = *pNormElem++;
-      accumVecNorm.z = *pNormElem++;
+      sourceNorm.x = *pNormElem++;
+      sourceNorm.y = *pNormElem++;
+      sourceNorm.z = *pNormElem++;
     }
-    // Load accumulator
+    // Load accumulators
     accumVecPos = Vector3::ZERO;
+    accumVecNorm = Vector3::ZERO;
 
     // Loop per blend weight
     for (unsigned short blendIdx = 0; blendIdx < op.numBlendWeightsPerVertex; ++blendIdx) {
@@ -462,9 +482,10 @@ void RenderSystem::softwareVertexBlend(RenderOperation& op, Matrix4* pMatrices)
           // We should blend by inverse transform here, but because we're assuming the 3x3
           // aspect of the matrix is orthogonal (no non-uniform scaling), the inverse transpose
           // is equal to the main 3x3 matrix
-          // Note because it's a normal we just extract the rotational part, saves us renormalising
+          // Note because it's a normal we just extract the rotational part; the
+          // weighted sum is renormalised below
           pMatrices[pBlend->matrixIndex].extract3x3Matrix(rot3x3);
-          accumVecNorm = (rot3x3 * pBlend->blendWeight) * accumVecNorm;
+          accumVecNorm += (rot3x3 * sourceNorm) * pBlend->blendWeight;
         }
 
       }
@@ -476,10 +497,13 @@ void RenderSystem::softwareVertexBlend(RenderOperation& op, Matrix4* pMatrices)
     mTempVertexBlendBuffer[vertIdx+1] = accumVecPos.y;
     mTempVertexBlendBuffer[vertIdx+2] = accumVecPos.z;
 
-    // Stored blended vertex in temp buffer
-    mTempNormalBlendBuffer[vertIdx] = accumVecNorm.x;
-    mTempNormalBlendBuffer[vertIdx+1] = accumVecNorm.y;
-    mTempNormalBlendBuffer[vertIdx+2] = accumVecNorm.z;
+    // Stored blended normal in temp buffer
+    if (op.vertexOptions & RenderOperation::VO_NORMALS) {
+      accumVecNorm.normalise();
+      mTempNormalBlendBuffer[vertIdx] = accumVecNorm.x;
+      mTempNormalBlendBuffer[vertIdx+1] = accumVecNorm.y;
+      mTempNormalBlendBuffer[vertIdx+2] = accumVecNorm.z;
+    }
   }
 
   // Re-point the render operation vertex buffer
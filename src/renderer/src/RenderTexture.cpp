@@ -40,7 +40,8 @@ RenderTexture::RenderTexture( const String & name, uint width, uint height, Text
   mPriority = OGRE_REND_TO_TEX_RT_GROUP;
 
   mTexture = TextureManager::getSingleton().createManual( mName, texType, mWidth, mHeight, 0, PF_R8G8B8, TU_RENDERTARGET );
-  TextureManager::getSingleton().load( static_cast< Resource * >( mTexture ) );
+  // Contents can't be reloaded, so never page it out
+  TextureManager::getSingleton().load( static_cast< Resource * >( mTexture ), 0 );
 }
 
 void RenderTexture::firePostUpdate() {
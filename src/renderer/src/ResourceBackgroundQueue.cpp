@@ -0,0 +1,236 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#include "ResourceBackgroundQueue.h"
+
+#include "Exception.h"
+#include "LogManager.h"
+#include "Resource.h"
+#include "ResourceManager.h"
+
+namespace renderer {
+//-----------------------------------------------------------------------
+template<> ResourceBackgroundQueue* Singleton<ResourceBackgroundQueue>::ms_Singleton = 0;
+//-----------------------------------------------------------------------
+ResourceBackgroundQueue::ResourceBackgroundQueue()
+  : mInFlight(0), mNextTicket(1), mIdle(true, true) {
+}
+//-----------------------------------------------------------------------
+ResourceBackgroundQueue::~ResourceBackgroundQueue() {
+  // Drop whatever hasn't started, and let the rest finish
+  std::list<Request*> pending;
+  {
+    base::AutoLock l(mLock);
+    pending.swap(mPending);
+  }
+  mIdle.Wait();
+  // Idle is signalled under the lock; taking it makes sure the signalling
+  // thread is done with the queue
+  base::AutoLock l(mLock);
+
+  std::list<Request*>::iterator i;
+  for (i = pending.begin(); i != pending.end(); ++i) {
+    if (!(*i)->loaded)
+      (*i)->resource->destroy();
+    delete *i;
+  }
+  std::deque<Request*>::iterator c;
+  for (c = mCompleted.begin(); c != mCompleted.end(); ++c) {
+    if (!(*c)->loaded)
+      (*c)->resource->destroy();
+    delete *c;
+  }
+  mCompleted.clear();
+}
+//-----------------------------------------------------------------------
+ResourceBackgroundQueue::Ticket ResourceBackgroundQueue::load(ResourceManager* manager,
+    const String& name, int priority, Listener* listener) {
+  Request* req = new Request();
+  req->resource = manager->getByName(name);
+  req->loaded = req->resource != 0;
+  if (!req->loaded)
+    req->resource = manager->create(name);
+  req->manager = manager;
+  req->priority = priority;
+  req->listener = listener;
+  return add(req);
+}
+//-----------------------------------------------------------------------
+ResourceBackgroundQueue::Ticket ResourceBackgroundQueue::load(ResourceManager* manager,
+    Resource* res, int priority, Listener* listener) {
+  Request* req = new Request();
+  req->resource = res;
+  req->loaded = false;
+  req->manager = manager;
+  req->priority = priority;
+  req->listener = listener;
+  return add(req);
+}
+//-----------------------------------------------------------------------
+ResourceBackgroundQueue::Ticket ResourceBackgroundQueue::add(Request* req) {
+  req->queue = this;
+  Ticket ticket;
+  std::vector<Request*> start;
+  {
+    base::AutoLock l(mLock);
+    req->ticket = mNextTicket++;
+    mOpenTickets.insert(req->ticket);
+
+    if (req->loaded) {
+      // Nothing to do but report it
+      mCompleted.push_back(req);
+    } else {
+      // After any others of the same priority
+      std::list<Request*>::iterator i = mPending.begin();
+      while (i != mPending.end() && (*i)->priority >= req->priority)
+        ++i;
+      mPending.insert(i, req);
+    }
+    ticket = req->ticket;
+    takePending(start);
+  }
+
+  startRequests(start);
+  return ticket;
+}
+//-----------------------------------------------------------------------
+void ResourceBackgroundQueue::takePending(std::vector<Request*>& start) {
+  // Lock must be held
+  WorkQueue* queue = WorkQueue::getSingletonPtr();
+  // Leave some of the workers free for per-frame work
+  size_t maxInFlight = queue ? std::max((size_t)1, queue->getNumWorkers() / 2) : 1;
+
+  while (!mPending.empty() && mInFlight < maxInFlight) {
+    start.push_back(mPending.front());
+    mPending.pop_front();
+    ++mInFlight;
+  }
+  if (mInFlight > 0)
+    mIdle.Reset();
+  else
+    mIdle.Signal();
+}
+//-----------------------------------------------------------------------
+void ResourceBackgroundQueue::startRequests(const std::vector<Request*>& start) {
+  // Called without the lock; with no workers the requests run right here
+  WorkQueue* queue = WorkQueue::getSingletonPtr();
+  for (size_t i = 0; i < start.size(); ++i) {
+    if (queue)
+      queue->addBackgroundTask(start[i]);
+    else
+      start[i]->run();
+  }
+}
+//-----------------------------------------------------------------------
+void ResourceBackgroundQueue::Request::run(void) {
+  try {
+    resource->prepare();
+  } catch (Exception& e) {
+    error = e.getFullDescription();
+  } catch (std::exception& e) {
+    error = e.what();
+  } catch (...) {
+    error = "Unknown error";
+  }
+  // Must be the last use of this request; it may be deleted straight away
+  queue->prepared(this);
+}
+//-----------------------------------------------------------------------
+void ResourceBackgroundQueue::prepared(Request* req) {
+  std::vector<Request*> start;
+  {
+    base::AutoLock l(mLock);
+    mCompleted.push_back(req);
+    --mInFlight;
+    takePending(start);
+  }
+  // Nothing here may touch the queue itself, which may be going away
+  startRequests(start);
+}
+//-----------------------------------------------------------------------
+bool ResourceBackgroundQueue::isProcessComplete(Ticket ticket) const {
+  base::AutoLock l(mLock);
+  return mOpenTickets.find(ticket) == mOpenTickets.end();
+}
+//-----------------------------------------------------------------------
+size_t ResourceBackgroundQueue::getNumPending(void) const {
+  base::AutoLock l(mLock);
+  return mOpenTickets.size();
+}
+//-----------------------------------------------------------------------
+void ResourceBackgroundQueue::_processCompleted(void) {
+  std::deque<Request*> completed;
+  {
+    base::AutoLock l(mLock);
+    completed.swap(mCompleted);
+  }
+
+  std::deque<Request*>::iterator i;
+  for (i = completed.begin(); i != completed.end(); ++i) {
+    Request* req = *i;
+    Resource* res = req->resource;
+
+    if (!req->loaded) {
+      if (req->error.empty()) {
+        try {
+          Resource* existing = req->manager->getByName(res->getName());
+          if (existing) {
+            // Loaded some other way in the meantime; stick with that one
+            res->destroy();
+            res = existing;
+          } else {
+            // Finishes with the prepared data
+            req->manager->load(res, req->priority);
+          }
+        } catch (Exception& e) {
+          req->error = e.getFullDescription();
+        } catch (std::exception& e) {
+          req->error = e.what();
+        } catch (...) {
+          req->error = "Unknown error";
+        }
+      }
+      if (!req->error.empty()) {
+        LogManager::getSingleton().logMessage("Background loading of " + res->getName() +
+                                              " failed: " + req->error);
+        res->destroy();
+        res = 0;
+      }
+    }
+
+    {
+      base::AutoLock l(mLock);
+      mOpenTickets.erase(req->ticket);
+    }
+    if (req->listener)
+      req->listener->operationCompleted(req->ticket, res);
+    delete req;
+  }
+}
+//-----------------------------------------------------------------------
+ResourceBackgroundQueue& ResourceBackgroundQueue::getSingleton(void) {
+  return Singleton<ResourceBackgroundQueue>::getSingleton();
+}
+
+}
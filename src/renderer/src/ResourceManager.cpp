@@ -27,12 +27,34 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Exception.h"
 #include "ArchiveEx.h"
 #include "ArchiveManager.h"
+#include "LogManager.h"
+#include "StringConverter.h"
 #include "StringVector.h"
 
 namespace renderer {
 
 std::vector<ArchiveEx*> ResourceManager::mCommonVFS;
 ResourceManager::FileMap ResourceManager::mCommonArchiveFiles;
+size_t ResourceManager::msGlobalMemoryBudget = std::numeric_limits<size_t>::max();
+size_t ResourceManager::msGlobalMemoryUsage = 0;
+std::vector<ResourceManager*> ResourceManager::msManagers;
+
+namespace {
+/// A resource which could be paged out
+struct PageCandidate {
+  ResourceManager* manager;
+  Resource* resource;
+};
+
+/// Orders candidates by priority, then least recently used first
+struct PageCandidateLess {
+  bool operator()(const PageCandidate& a, const PageCandidate& b) const {
+    if (a.resource->getPriority() != b.resource->getPriority())
+      return a.resource->getPriority() < b.resource->getPriority();
+    return a.resource->getLastAccess() < b.resource->getLastAccess();
+  }
+};
+}
 
 /** Internal method for standardising paths - use forward slashes only, end with slash.
 */
@@ -49,22 +71,37 @@ static String convertPath( const String &init) {
 //-----------------------------------------------------------------------
 ResourceManager::ResourceManager() {
   // Init memory limit & usage
-  mMemoryBudget = std::numeric_limits<unsigned long>::max();
+  mMemoryBudget = std::numeric_limits<size_t>::max();
   mMemoryUsage = 0;
 
+  msManagers.push_back(this);
 }
 
 //-----------------------------------------------------------------------
 ResourceManager::~ResourceManager() {
   this->unloadAndDestroyAll();
+
+  msManagers.erase(std::find(msManagers.begin(), msManagers.end(), this));
 }
 
 //-----------------------------------------------------------------------
 void ResourceManager::load(Resource *res, int priority) {
   res->load();
+  addLoaded(res, priority);
+}
+
+//-----------------------------------------------------------------------
+void ResourceManager::addLoaded(Resource *res, int priority) {
   res->touch();
+  res->setPriority(priority);
+  res->mIsPagedOut = false;
 
   mResources.insert( ResourceMap::value_type( res->getName(), res ) );
+
+  // Update memory usage
+  mMemoryUsage += res->getSize();
+  msGlobalMemoryUsage += res->getSize();
+  checkUsage();
 }
 
 //-----------------------------------------------------------------------
@@ -74,19 +111,50 @@ void ResourceManager::setMemoryBudget( size_t bytes) {
   checkUsage();
 }
 
+//-----------------------------------------------------------------------
+size_t ResourceManager::getMemoryBudget(void) const {
+  return mMemoryBudget;
+}
+
+//-----------------------------------------------------------------------
+size_t ResourceManager::getMemoryUsage(void) const {
+  return mMemoryUsage;
+}
+
+//-----------------------------------------------------------------------
+void ResourceManager::setGlobalMemoryBudget( size_t bytes ) {
+  msGlobalMemoryBudget = bytes;
+  if (msGlobalMemoryUsage > msGlobalMemoryBudget)
+    pageOut(0, msGlobalMemoryUsage - msGlobalMemoryBudget);
+}
+
+//-----------------------------------------------------------------------
+size_t ResourceManager::getGlobalMemoryBudget(void) {
+  return msGlobalMemoryBudget;
+}
+
+//-----------------------------------------------------------------------
+size_t ResourceManager::getGlobalMemoryUsage(void) {
+  return msGlobalMemoryUsage;
+}
+
 //-----------------------------------------------------------------------
 void ResourceManager::unload(Resource* res) {
   if (!res)
     return;
 
+  // Update memory usage; a paged out resource is already accounted for
+  if (res->isLoaded() && !res->isPagedOut()) {
+    mMemoryUsage -= res->getSize();
+    msGlobalMemoryUsage -= res->getSize();
+  }
+  res->mIsPagedOut = false;
+
   // Unload resource
   res->unload();
 
   // Erase entry in map
   mResources.erase( res->getName() );
-
-  // Update memory usage
-  mMemoryUsage -= res->getSize();
 }
 
 //-----------------------------------------------------------------------
@@ -102,20 +170,90 @@ void ResourceManager::unloadAndDestroyAll() {
 
   // Empty the list
   mResources.clear();
+  msGlobalMemoryUsage -= mMemoryUsage;
+  mMemoryUsage = 0;
 }
 //-----------------------------------------------------------------------
 Resource* ResourceManager::getByName(const String& name) {
+  return getByName(StringId(name));
+}
+//-----------------------------------------------------------------------
+Resource* ResourceManager::getByName(const StringId& name) {
   ResourceMap::iterator it = mResources.find(name);
 
   if( it == mResources.end() )
     return 0;
-  else
-    return it->second;
+
+  Resource* res = it->second;
+  if (res->isPagedOut()) {
+    // Bring it back transparently
+    res->load();
+    res->mIsPagedOut = false;
+    res->touch();
+    mMemoryUsage += res->getSize();
+    msGlobalMemoryUsage += res->getSize();
+    checkUsage();
+  } else {
+    res->touch();
+  }
+  return res;
 }
 
 //-----------------------------------------------------------------------
 void ResourceManager::checkUsage(void) {
-  // Page out here?
+  if (mMemoryUsage > mMemoryBudget)
+    pageOut(this, mMemoryUsage - mMemoryBudget);
+  if (msGlobalMemoryUsage > msGlobalMemoryBudget)
+    pageOut(0, msGlobalMemoryUsage - msGlobalMemoryBudget);
+}
+
+//-----------------------------------------------------------------------
+void ResourceManager::pageOut( ResourceManager* manager, size_t required ) {
+  std::vector<PageCandidate> candidates;
+
+  std::vector<ResourceManager*>::iterator m, mend = msManagers.end();
+  for (m = msManagers.begin(); m != mend; ++m) {
+    if (manager && *m != manager)
+      continue;
+
+    ResourceMap::iterator i, iend = (*m)->mResources.end();
+    for (i = (*m)->mResources.begin(); i != iend; ++i) {
+      Resource* res = i->second;
+      if (res->isLoaded() && !res->isPagedOut() && res->getPriority() > 0 &&
+          res->getSize() > 0 && !res->isInUse()) {
+        PageCandidate c;
+        c.manager = *m;
+        c.resource = res;
+        candidates.push_back(c);
+      }
+    }
+  }
+
+  std::sort(candidates.begin(), candidates.end(), PageCandidateLess());
+
+  size_t freed = 0;
+  size_t count = 0;
+  std::vector<PageCandidate>::iterator c, cend = candidates.end();
+  for (c = candidates.begin(); c != cend && freed < required; ++c) {
+    // Size first, some resources forget it when unloaded
+    size_t size = c->resource->getSize();
+    c->resource->unload();
+    c->resource->mIsPagedOut = true;
+    c->manager->mMemoryUsage -= size;
+    msGlobalMemoryUsage -= size;
+    freed += size;
+    ++count;
+  }
+
+  if (freed < required) {
+    LogManager::getSingleton().logMessage("Resource memory budget exceeded by " +
+                                          StringConverter::toString((unsigned long)(required - freed)) +
+                                          " bytes; everything else is in use.");
+  } else {
+    LogManager::getSingleton().logMessage("Paged out " + StringConverter::toString((unsigned long)count) +
+                                          " resources, " + StringConverter::toString((unsigned long)freed) + " bytes.",
+                                          LML_TRIVIAL);
+  }
 }
 
 //-----------------------------------------------------------------------
@@ -189,6 +327,24 @@ bool ResourceManager::_findResourceData(
   return false;
 }
 //-----------------------------------------------------------------------
+ArchiveEx* ResourceManager::_findCommonArchive( const String& filename ) {
+  // Search file cache first
+  FileMap::const_iterator it;
+  if( ( it = mCommonArchiveFiles.find( filename ) ) != mCommonArchiveFiles.end() )
+    return it->second;
+
+  // Not found in cache
+  // Look for it the hard way
+  std::vector<ArchiveEx*>::iterator j;
+  for(j = mCommonVFS.begin(); j != mCommonVFS.end(); ++j ) {
+    if( *j && (*j)->fileTest(filename) ) {
+      return *j;
+    }
+  }
+
+  return 0;
+}
+//-----------------------------------------------------------------------
 std::set<String> ResourceManager::_getAllCommonNamesLike( const String& startPath, const String& extension ) {
   std::vector<ArchiveEx*>::iterator i;
   StringVector vecFiles;
@@ -42,12 +42,18 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "TextureManager.h"
 #include "ParticleSystemManager.h"
 #include "SkeletonManager.h"
+#include "BakedAnimationManager.h"
 #include "ZipArchiveFactory.h"
+#include "PackFileFactory.h"
 #include "FileSystemFactory.h"
+#include "WorkQueue.h"
+#include "ResourceBackgroundQueue.h"
 
 #if OGRE_PLATFORM == PLATFORM_WIN32
 
-#   define WIN32_LEAN_AND_MEAN
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
 #   include <direct.h>
 
 #endif
@@ -113,16 +119,23 @@ Root::Root(const String& pluginFileName) {
   // Skeleton manager
   mSkeletonManager = new SkeletonManager();
 
+  // Baked animation manager
+  mBakedAnimationManager = new BakedAnimationManager();
+
   // ..particle system manager
   mParticleManager = new ParticleSystemManager();
 
   // Timer
   init_time_ticks_ = new base::TimeTicks();
   *init_time_ticks_ = base::TimeTicks::Now();
+  mCurrentFrame = 0;
 
   mZipArchiveFactory = new ZipArchiveFactory();
   ArchiveManager::getSingleton().addArchiveFactory( mZipArchiveFactory );
 
+  mPackFileFactory = new PackFileFactory();
+  ArchiveManager::getSingleton().addArchiveFactory( mPackFileFactory );
+
   os_file_system_ = new FileSystemFactory();
   ArchiveManager::getSingleton().addArchiveFactory(os_file_system_);
 
@@ -136,6 +149,12 @@ Root::Root(const String& pluginFileName) {
   // Create new Math object (will be managed by singleton)
   mMath = new Math();
 
+  // Worker threads for per-frame jobs (will be managed by singleton)
+  mWorkQueue = new WorkQueue();
+
+  // Background resource loading, run on the workers (will be managed by singleton)
+  mResourceBackgroundQueue = new ResourceBackgroundQueue();
+
 
   // Can't create controller manager until initialised
   mControllerManager = 0;
@@ -173,9 +192,13 @@ Root::Root(const String& pluginFileName) {
 //-----------------------------------------------------------------------
 Root::~Root() {
   shutdown();
+  delete mResourceBackgroundQueue;
+  delete mWorkQueue;
   delete mSceneManagerEnum;
   delete mZipArchiveFactory;
+  delete mPackFileFactory;
   delete mArchiveManager;
+  delete mBakedAnimationManager;
   delete mSkeletonManager;
   delete mMeshManager;
   delete mMaterialManager;
@@ -549,8 +572,16 @@ uint32 Root::GetTickCount() const {
 }
 
 void Root::RunFrame(Real delta_time) {
+  ++mCurrentFrame;
+  // Finish the resources loaded in the background since last frame
+  mResourceBackgroundQueue->_processCompleted();
   mControllerManager->RunFrame(delta_time);
+  mParticleManager->RunFrame(delta_time);
   getRenderSystem()->UpdateRenderTargets(delta_time);
 }
 
+unsigned long Root::getCurrentFrameNumber(void) const {
+  return mCurrentFrame;
+}
+
 }
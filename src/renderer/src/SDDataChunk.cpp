@@ -35,8 +35,7 @@ SDDataChunk::SDDataChunk( void *pData, size_t size )
 }
 
 SDDataChunk::~SDDataChunk() {
-  if( mData )
-    delete[] mData;
+  clear();
 }
 
 }
@@ -41,13 +41,46 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "RenderQueueSortingGrouping.h"
 #include "StringConverter.h"
 #include "RenderQueueListener.h"
+#include "Skeleton.h"
+#include "WorkQueue.h"
 
 // This class implements the most basic scene manager
 
 #include <cstdio>
+#include <algorithm>
 
 namespace renderer {
 
+namespace {
+/// Most tasks the animation of a frame is split into
+const size_t MAX_ANIMATION_TASKS = 16;
+/// Fewest entities worth giving a task of their own
+const size_t MIN_ENTITIES_PER_TASK = 4;
+
+/// Applies the scene animations, alongside the entity tasks
+class SceneAnimationTask : public WorkQueue::Task {
+public:
+  void run(void) {
+    sceneManager->_applySceneAnimations();
+  }
+
+  SceneManager* sceneManager;
+};
+
+/// Evaluates the skeletons of a range of entities
+class EntityAnimationTask : public WorkQueue::Task {
+public:
+  void run(void) {
+    for (size_t i = first; i < end; ++i) {
+      (*entities)[i]->_updateAnimation();
+    }
+  }
+
+  const std::vector<Entity*>* entities;
+  size_t first, end;
+};
+}
+
 SceneManager::SceneManager() {
   // Root scene node
   mSceneRoot = new SceneNode(this, "root node");
@@ -95,6 +128,10 @@ Camera* SceneManager::createCamera(const String& name) {
 
 //-----------------------------------------------------------------------
 Camera* SceneManager::getCamera(const String& name) {
+  return getCamera(StringId(name));
+}
+//-----------------------------------------------------------------------
+Camera* SceneManager::getCamera(const StringId& name) {
   CameraList::iterator i = mCameras.find(name);
   if (i == mCameras.end()) {
     return 0;
@@ -149,6 +186,10 @@ Light* SceneManager::createLight(const String& name) {
 
 //-----------------------------------------------------------------------
 Light* SceneManager::getLight(const String& name) {
+  return getLight(StringId(name));
+}
+//-----------------------------------------------------------------------
+Light* SceneManager::getLight(const StringId& name) {
   LightList::iterator i = mLights.find(name);
   if (i == mLights.end()) {
     return 0;
@@ -237,6 +278,10 @@ Entity* SceneManager::createEntity(
 
 //-----------------------------------------------------------------------
 Entity* SceneManager::getEntity(const String& name) {
+  return getEntity(StringId(name));
+}
+//-----------------------------------------------------------------------
+Entity* SceneManager::getEntity(const StringId& name) {
   EntityList::iterator i = mEntities.find(name);
   if (i == mEntities.end()) {
     return 0;
@@ -378,11 +423,19 @@ SceneNode* SceneManager::getRootSceneNode(void) const {
   return mSceneRoot;
 }
 //-----------------------------------------------------------------------
+TransformStore& SceneManager::_getTransformStore(void) {
+  return mTransformStore;
+}
+//-----------------------------------------------------------------------
 SceneNode* SceneManager::getSceneNode(const String& name) const {
+  return getSceneNode(StringId(name));
+}
+//-----------------------------------------------------------------------
+SceneNode* SceneManager::getSceneNode(const StringId& name) const {
   SceneNodeList::const_iterator i = mSceneNodes.find(name);
 
   if (i == mSceneNodes.end()) {
-    Except(Exception::ERR_ITEM_NOT_FOUND, "SceneNode '" + name + "' not found.",
+    Except(Exception::ERR_ITEM_NOT_FOUND, "SceneNode '" + name.getString() + "' not found.",
            "SceneManager::getSceneNode");
   }
 
@@ -569,7 +622,7 @@ void SceneManager::_renderScene(Camera* camera, Viewport* vp) {
 
 
   // Update the scene
-  _applySceneAnimations();
+  _updateAnimations();
   _updateSceneGraph(camera);
   _updateDynamicLights();
 
@@ -1061,14 +1114,11 @@ void SceneManager::_renderSubMesh(SubMesh* sm) {
 
 //-----------------------------------------------------------------------
 void SceneManager::_updateSceneGraph(Camera* cam) {
-  // Cascade down the graph updating transforms & world bounds
-  // In this implementation, just update from the root
+  // Derive transforms & world bounds of the nodes which changed since the
+  //   last frame, their descendants and ancestors, in one linear sweep
   // Smarter SceneManager subclasses may choose to update only
   //   certain scene graph branches
-  // ÿ任
-  // ʵУֻǼ򵥵ĴӸ㿪ʼ
-  // ܵĳܻѡָֻĳ֦
-  mSceneRoot->_update(true, false);
+  mTransformStore.update();
 
 
 }
@@ -1338,6 +1388,10 @@ BillboardSet* SceneManager::createBillboardSet(const String& name, unsigned int
 }
 //-----------------------------------------------------------------------
 BillboardSet* SceneManager::getBillboardSet(const String& name) {
+  return getBillboardSet(StringId(name));
+}
+//-----------------------------------------------------------------------
+BillboardSet* SceneManager::getBillboardSet(const StringId& name) {
   BillboardSetList::iterator i = mBillboardSets.find(name);
   if (i == mBillboardSets.end()) {
     return 0;
@@ -1379,10 +1433,14 @@ Animation* SceneManager::createAnimation(const String& name, Real length) {
 }
 //-----------------------------------------------------------------------
 Animation* SceneManager::getAnimation(const String& name) const {
+  return getAnimation(StringId(name));
+}
+//-----------------------------------------------------------------------
+Animation* SceneManager::getAnimation(const StringId& name) const {
   AnimationList::const_iterator i = mAnimationsList.find(name);
   if (i == mAnimationsList.end()) {
     Except(Exception::ERR_ITEM_NOT_FOUND,
-           "Cannot find animation with name " + name,
+           "Cannot find animation with name " + name.getString(),
            "SceneManager::getAnimation");
   }
   return i->second;
@@ -1482,7 +1540,7 @@ void SceneManager::_applySceneAnimations(void) {
   iend = mAnimationStates.end();
 
   for (; i != iend; ++i) {
-    Animation* anim = getAnimation(i->second.getAnimationName());
+    Animation* anim = getAnimation(i->second.getAnimationNameId());
 
     // Reset any nodes involved
     // NB this excludes blended animations
@@ -1497,10 +1555,75 @@ void SceneManager::_applySceneAnimations(void) {
 
 
     // Apply the animation
-    anim->apply(i->second.getTimePosition(), i->second.getWeight());
+    anim->apply(i->second);
+  }
+
+
+}
+//---------------------------------------------------------------------
+void SceneManager::_updateAnimations(void) {
+  // Gather the entities likely to be rendered
+  mAnimatedEntities.clear();
+  mAnimatedSkeletons.clear();
+  EntityList::iterator ei;
+  for (ei = mEntities.begin(); ei != mEntities.end(); ++ei) {
+    Skeleton* skel = ei->second->_getSkeletonToAnimate();
+    if (skel) {
+      mAnimatedEntities.push_back(ei->second);
+      mAnimatedSkeletons.push_back(skel);
+    }
+    // Objects on tag points move with the bones, so the bounds of the
+    // node must be merged again even though the node itself hasn't moved
+    Node* node = ei->second->getParentNode();
+    if (node && ei->second->getAttachedObjectIterator().hasMoreElements()) {
+      node->needUpdate();
+    }
+  }
+
+  // Build whatever the skeletons build on demand, while still on one thread
+  std::sort(mAnimatedSkeletons.begin(), mAnimatedSkeletons.end());
+  mAnimatedSkeletons.erase(std::unique(mAnimatedSkeletons.begin(), mAnimatedSkeletons.end()),
+                           mAnimatedSkeletons.end());
+  std::vector<Skeleton*>::iterator si;
+  for (si = mAnimatedSkeletons.begin(); si != mAnimatedSkeletons.end(); ++si) {
+    (*si)->_prepareForEvaluation();
+  }
+
+  size_t numEntities = mAnimatedEntities.size();
+  size_t numTasks = 1;
+  WorkQueue* queue = WorkQueue::getSingletonPtr();
+  if (queue) {
+    numTasks = std::min(queue->getNumWorkers() + 1, MAX_ANIMATION_TASKS);
+    numTasks = std::min(numTasks, numEntities / MIN_ENTITIES_PER_TASK);
   }
 
+  if (numTasks <= 1) {
+    _applySceneAnimations();
+    for (size_t i = 0; i < numEntities; ++i) {
+      mAnimatedEntities[i]->_updateAnimation();
+    }
+    return;
+  }
+
+  // Scene animations only move scene nodes, which entity animation never
+  // reads, so they can run alongside
+  SceneAnimationTask sceneTask;
+  sceneTask.sceneManager = this;
+  EntityAnimationTask tasks[MAX_ANIMATION_TASKS];
+  WorkQueue::Task* taskList[MAX_ANIMATION_TASKS + 1];
+  taskList[0] = &sceneTask;
+
+  size_t entitiesPerTask = (numEntities + numTasks - 1) / numTasks;
+  size_t t;
+  for (t = 0; t < numTasks; ++t) {
+    EntityAnimationTask& task = tasks[t];
+    task.entities = &mAnimatedEntities;
+    task.first = std::min(numEntities, t * entitiesPerTask);
+    task.end = std::min(numEntities, task.first + entitiesPerTask);
+    taskList[t + 1] = &task;
+  }
 
+  queue->runAndWait(taskList, numTasks + 1);
 }
 //---------------------------------------------------------------------
 void SceneManager::manualRender(RenderOperation* rend,
@@ -32,25 +32,86 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "SceneManager.h"
 #include "MovableObject.h"
 #include "WireBoundingBox.h"
+#include "ClassAllocator.h"
 
 namespace renderer {
+namespace {
+/// The allocator of all SceneNodes; never deleted, as the objects may outlive
+/// the static destructors
+ClassAllocator& getSceneNodeAllocator(void) {
+  static ClassAllocator* allocator = new ClassAllocator(sizeof(SceneNode));
+  return *allocator;
+}
+}
+//-----------------------------------------------------------------------
+void* SceneNode::operator new(size_t size) {
+  return getSceneNodeAllocator().allocate(size);
+}
+//-----------------------------------------------------------------------
+void SceneNode::operator delete(void* p, size_t size) {
+  getSceneNodeAllocator().deallocate(p, size);
+}
+//-----------------------------------------------------------------------
+void SceneNode::setAllocatorPolicy(AllocatorPolicy* policy) {
+  getSceneNodeAllocator().setPolicy(policy);
+}
 //-----------------------------------------------------------------------
 SceneNode::SceneNode(SceneManager* creator)
-  : Node(), mCreator(creator), mWireBoundingBox(0), mShowBoundingBox(false) {
+  : Node(), mCreator(creator), mWireBoundingBox(0), mShowBoundingBox(false),
+    mTransformHandle(TransformStore::INVALID_HANDLE) {
+  if (mCreator) {
+    mTransformHandle = mCreator->_getTransformStore().add(this);
+  }
   needUpdate();
 }
 //-----------------------------------------------------------------------
 SceneNode::SceneNode(SceneManager* creator, const String& name)
-  : Node(name), mCreator(creator), mWireBoundingBox(0), mShowBoundingBox(false) {
+  : Node(name), mCreator(creator), mWireBoundingBox(0), mShowBoundingBox(false),
+    mTransformHandle(TransformStore::INVALID_HANDLE) {
+  if (mCreator) {
+    mTransformHandle = mCreator->_getTransformStore().add(this);
+  }
   needUpdate();
 }
 //-----------------------------------------------------------------------
 SceneNode::~SceneNode() {
+  // Don't leave the parent or children pointing at a dead node
+  if (mParent) {
+    mParent->removeChild(getName());
+  }
+  removeAllChildren();
+
+  if (mCreator) {
+    mCreator->_getTransformStore().remove(mTransformHandle);
+  }
+
   if (mWireBoundingBox) {
     delete mWireBoundingBox;
   }
 }
 //-----------------------------------------------------------------------
+void SceneNode::setParent(Node* parent) {
+  Node::setParent(parent);
+  if (mCreator) {
+    mCreator->_getTransformStore()._notifyHierarchyChanged();
+  }
+}
+//-----------------------------------------------------------------------
+void SceneNode::needUpdate() {
+  mNeedParentUpdate = true;
+  mNeedChildUpdate = true;
+  mCachedTransformOutOfDate = true;
+  mChildrenToUpdate.clear();
+
+  if (mCreator) {
+    mCreator->_getTransformStore()._notifyTransformChanged(mTransformHandle);
+  }
+}
+//-----------------------------------------------------------------------
+TransformStore::Handle SceneNode::_getTransformHandle(void) const {
+  return mTransformHandle;
+}
+//-----------------------------------------------------------------------
 void SceneNode::_update(bool updateChildren, bool parentHasChanged) {
   // ݸԼı任Ȼӽı任߽
   Node::_update(updateChildren, parentHasChanged);
@@ -273,14 +334,12 @@ void SceneNode::removeAndDestroyChild(unsigned short index) {
 }
 //-----------------------------------------------------------------------
 void SceneNode::removeAndDestroyAllChildren(void) {
-  ChildNodeMap::iterator i, iend;
-  iend = mChildren.end();
-  for (i = mChildren.begin(); i != iend; ++i) {
-    SceneNode* sn = static_cast<SceneNode*>(i->second);
+  // Destroying a child detaches it from this node, so keep taking the first
+  while (!mChildren.empty()) {
+    SceneNode* sn = static_cast<SceneNode*>(mChildren.begin()->second);
     sn->removeAndDestroyAllChildren();
     sn->getCreator()->destroySceneNode(sn->getName());
   }
-  mChildren.clear();
 }
 
 
@@ -0,0 +1,384 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#include "ScriptCache.h"
+
+#include "ArchiveEx.h"
+#include "DataChunk.h"
+#include "SDDataChunk.h"
+#include "Exception.h"
+#include "LogManager.h"
+#include "WorkQueue.h"
+
+namespace renderer {
+
+namespace {
+/// Chunk holding one cached script
+const unsigned short SCRIPT_CACHE_ENTRY = 0x1100;
+/// Chunk overhead = ID + size
+const unsigned long CHUNK_OVERHEAD_SIZE = sizeof(unsigned short) + sizeof(unsigned long);
+
+/// Compiles one script file
+class CompileTask : public WorkQueue::Task {
+public:
+  CompileTask() : compiler(0), chunk(0), nodes(0), error(0) {}
+
+  void run(void) {
+    try {
+      compiler->compileScript(*chunk, *nodes);
+    } catch (Exception& e) {
+      // Can't let it escape a worker thread; rethrown by the caller
+      error = new Exception(e);
+    } catch (std::exception& e) {
+      error = new Exception(Exception::ERR_INTERNAL_ERROR,
+                            String("Error compiling script: ") + e.what(),
+                            "ScriptCache::getScripts");
+    } catch (...) {
+      error = new Exception(Exception::ERR_INTERNAL_ERROR,
+                            "Unknown error compiling script",
+                            "ScriptCache::getScripts");
+    }
+  }
+
+  ScriptCache::Compiler* compiler;
+  DataChunk* chunk;
+  ScriptNodeList* nodes;
+  Exception* error;
+};
+}
+
+//-----------------------------------------------------------------------
+ScriptCache::ScriptCache()
+  : mLoaded(false), mDirty(false) {
+  // Version number
+  mVersion = "[ScriptCache_v1.00]";
+}
+//-----------------------------------------------------------------------
+ScriptCache::~ScriptCache() {
+}
+//-----------------------------------------------------------------------
+void ScriptCache::setFileName(const String& filename) {
+  mFileName = filename;
+  mEntries.clear();
+  mLoaded = false;
+  mDirty = false;
+}
+//-----------------------------------------------------------------------
+const String& ScriptCache::getFileName(void) const {
+  return mFileName;
+}
+//-----------------------------------------------------------------------
+void ScriptCache::getScripts(const SourceList& sources, Compiler* compiler,
+                             std::vector<const ScriptNodeList*>& scripts) {
+  if (!mLoaded) {
+    read();
+    mLoaded = true;
+  }
+
+  // Read everything which needs compiling first; archives aren't thread safe
+  std::vector<CompileTask> tasks;
+  std::vector<Entry*> compiled;
+  try {
+    SourceList::const_iterator i, iend = sources.end();
+    for (i = sources.begin(); i != iend; ++i) {
+      Entry* entry;
+      DataChunk* chunk = lookup(*i, &entry);
+      if (chunk) {
+        tasks.push_back(CompileTask());
+        tasks.back().compiler = compiler;
+        tasks.back().chunk = chunk;
+        tasks.back().nodes = &entry->nodes;
+        compiled.push_back(entry);
+      }
+      // Map entries don't move, so this stays valid while more are added
+      scripts.push_back(&entry->nodes);
+    }
+  } catch (...) {
+    for (size_t t = 0; t < tasks.size(); ++t) {
+      delete tasks[t].chunk;
+    }
+    throw;
+  }
+
+  // Scripts are independent of each other until they are applied
+  size_t numTasks = tasks.size();
+  WorkQueue* queue = WorkQueue::getSingletonPtr();
+  if (numTasks > 1 && queue && queue->getNumWorkers() > 0) {
+    std::vector<WorkQueue::Task*> taskList(numTasks);
+    for (size_t t = 0; t < numTasks; ++t) {
+      taskList[t] = &tasks[t];
+    }
+    queue->runAndWait(&taskList[0], numTasks);
+  } else {
+    for (size_t t = 0; t < numTasks; ++t) {
+      tasks[t].run();
+    }
+  }
+
+  // Report the first failure in source order, as parsing serially would
+  Exception* error = 0;
+  for (size_t t = 0; t < numTasks; ++t) {
+    delete tasks[t].chunk;
+    if (tasks[t].error) {
+      // Don't cache a half compiled script
+      *compiled[t] = Entry();
+      if (!error)
+        error = tasks[t].error;
+      else
+        delete tasks[t].error;
+    }
+  }
+  if (error) {
+    Exception e(*error);
+    delete error;
+    throw e;
+  }
+}
+//-----------------------------------------------------------------------
+DataChunk* ScriptCache::lookup(const Source& source, Entry** ppEntry) {
+  String key = source.archive->getName() + "|" + source.filename;
+  EntryMap::iterator i = mEntries.find(key);
+
+  // Size and time stamp, if the archive knows them
+  ArchiveEx::FileInfo info;
+  memset(&info, 0, sizeof(info));
+  ArchiveEx::FileInfo* pInfo = &info;
+  if (!source.archive->fileInfo(source.filename, &pInfo))
+    memset(&info, 0, sizeof(info));
+  unsigned long lastModified = static_cast<unsigned long>(info.iLastMod);
+
+  if (i != mEntries.end() && lastModified != 0 &&
+      i->second.lastModified == lastModified &&
+      i->second.size == static_cast<unsigned long>(info.iUncompSize)) {
+    // Unchanged, no need to even read it
+    i->second.used = true;
+    *ppEntry = &i->second;
+    return 0;
+  }
+
+  SDDataChunk* chunk = new SDDataChunk();
+  DataChunk* pChunk = chunk;
+  try {
+    source.archive->fileRead(source.filename, &pChunk);
+  } catch (...) {
+    delete chunk;
+    throw;
+  }
+  unsigned long size = static_cast<unsigned long>(chunk->getSize());
+  unsigned long hash = hashData(chunk->getPtr(), chunk->getSize());
+
+  if (i != mEntries.end() && i->second.size == size && i->second.hash == hash) {
+    // Touched but the same; remember the new time stamp
+    if (i->second.lastModified != lastModified) {
+      i->second.lastModified = lastModified;
+      mDirty = true;
+    }
+    i->second.used = true;
+    delete chunk;
+    *ppEntry = &i->second;
+    return 0;
+  }
+
+  // New or changed; the details are filled in now so that the same file
+  // listed twice is only compiled once
+  Entry& entry = mEntries[key];
+  entry.size = size;
+  entry.lastModified = lastModified;
+  entry.hash = hash;
+  entry.nodes.clear();
+  entry.used = true;
+  mDirty = true;
+
+  *ppEntry = &entry;
+  return chunk;
+}
+//-----------------------------------------------------------------------
+void ScriptCache::save(void) {
+  // Entries nobody asked for are of scripts which no longer exist; the file
+  // needs writing again to drop them, or they'd be kept forever
+  EntryMap::const_iterator i, iend = mEntries.end();
+  for (i = mEntries.begin(); i != iend && !mDirty; ++i) {
+    if (!i->second.used)
+      mDirty = true;
+  }
+
+  if (!mFileName.empty() && mDirty) {
+    mpfFile = fopen(mFileName.c_str(), "wb");
+    if (!mpfFile) {
+      LogManager::getSingleton().logMessage("Unable to write script cache " + mFileName);
+    } else {
+      writeFileHeader();
+
+      for (i = mEntries.begin(); i != iend; ++i) {
+        const Entry& entry = i->second;
+        if (!entry.used || !canWrite(entry.nodes) || i->first.length() >= 255)
+          continue;
+
+        unsigned long size = CHUNK_OVERHEAD_SIZE;
+        size += static_cast<unsigned long>(i->first.length() + 1);
+        size += sizeof(unsigned long) * 3;
+        size += calcNodesSize(entry.nodes);
+        writeChunkHeader(SCRIPT_CACHE_ENTRY, size);
+
+        writeString(i->first);
+        writeLongs(&entry.size, 1);
+        writeLongs(&entry.lastModified, 1);
+        writeLongs(&entry.hash, 1);
+        writeNodes(entry.nodes);
+      }
+      fclose(mpfFile);
+      mpfFile = 0;
+    }
+  }
+
+  // Scripts have been applied, no need to hold on to them
+  mEntries.clear();
+  mLoaded = false;
+  mDirty = false;
+}
+//-----------------------------------------------------------------------
+unsigned long ScriptCache::hashData(const void* data, size_t size) {
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  unsigned long hash = 2166136261UL;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= p[i];
+    hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+  }
+  return hash;
+}
+//-----------------------------------------------------------------------
+void ScriptCache::read(void) {
+  mEntries.clear();
+  mDirty = false;
+  if (mFileName.empty())
+    return;
+
+  FILE* fp = fopen(mFileName.c_str(), "rb");
+  if (!fp)
+    return;
+
+  fseek(fp, 0, SEEK_END);
+  long fileSize = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  SDDataChunk chunk;
+  size_t bytesRead = 0;
+  if (fileSize > 0) {
+    chunk.allocate(fileSize);
+    bytesRead = fread(chunk.getPtr(), 1, fileSize, fp);
+  }
+  fclose(fp);
+  if (fileSize <= 0 || bytesRead != (size_t)fileSize)
+    return;
+
+  try {
+    readFileHeader(chunk);
+
+    while (!chunk.isEOF()) {
+      unsigned short chunkID = readChunk(chunk);
+      if (chunkID != SCRIPT_CACHE_ENTRY) {
+        // Not ours, skip it
+        chunk.skip(mCurrentChunkLen - CHUNK_OVERHEAD_SIZE);
+        continue;
+      }
+      String key = readString(chunk);
+      Entry& entry = mEntries[key];
+      readLongs(chunk, &entry.size, 1);
+      readLongs(chunk, &entry.lastModified, 1);
+      readLongs(chunk, &entry.hash, 1);
+      readNodes(chunk, entry.nodes);
+    }
+  } catch (Exception&) {
+    // Old version or damaged; start again
+    LogManager::getSingleton().logMessage("Ignoring out of date script cache " + mFileName);
+    mEntries.clear();
+  }
+}
+//-----------------------------------------------------------------------
+void ScriptCache::writeNodes(const ScriptNodeList& nodes) {
+  unsigned long count = static_cast<unsigned long>(nodes.size());
+  writeLongs(&count, 1);
+
+  ScriptNodeList::const_iterator i, iend = nodes.end();
+  for (i = nodes.begin(); i != iend; ++i) {
+    unsigned short header[2];
+    header[0] = i->isBlock ? 1 : 0;
+    header[1] = static_cast<unsigned short>(i->tokens.size());
+    writeShorts(header, 2);
+    for (size_t t = 0; t < i->tokens.size(); ++t) {
+      writeString(i->tokens[t]);
+    }
+    if (i->isBlock)
+      writeNodes(i->children);
+  }
+}
+//-----------------------------------------------------------------------
+void ScriptCache::readNodes(DataChunk& chunk, ScriptNodeList& nodes) {
+  unsigned long count;
+  readLongs(chunk, &count, 1);
+  nodes.resize(count);
+
+  for (unsigned long i = 0; i < count; ++i) {
+    ScriptNode& node = nodes[i];
+    unsigned short header[2];
+    readShorts(chunk, header, 2);
+    node.isBlock = header[0] != 0;
+    node.tokens.resize(header[1]);
+    for (unsigned short t = 0; t < header[1]; ++t) {
+      node.tokens[t] = readString(chunk);
+    }
+    if (node.isBlock)
+      readNodes(chunk, node.children);
+  }
+}
+//-----------------------------------------------------------------------
+unsigned long ScriptCache::calcNodesSize(const ScriptNodeList& nodes) {
+  unsigned long size = sizeof(unsigned long);
+
+  ScriptNodeList::const_iterator i, iend = nodes.end();
+  for (i = nodes.begin(); i != iend; ++i) {
+    size += sizeof(unsigned short) * 2;
+    for (size_t t = 0; t < i->tokens.size(); ++t) {
+      // String plus terminator
+      size += static_cast<unsigned long>(i->tokens[t].length() + 1);
+    }
+    if (i->isBlock)
+      size += calcNodesSize(i->children);
+  }
+  return size;
+}
+//-----------------------------------------------------------------------
+bool ScriptCache::canWrite(const ScriptNodeList& nodes) {
+  ScriptNodeList::const_iterator i, iend = nodes.end();
+  for (i = nodes.begin(); i != iend; ++i) {
+    for (size_t t = 0; t < i->tokens.size(); ++t) {
+      if (i->tokens[t].length() >= 255 || i->tokens[t].find('\n') != String::npos)
+        return false;
+    }
+    if (i->isBlock && !canWrite(i->children))
+      return false;
+  }
+  return true;
+}
+
+}
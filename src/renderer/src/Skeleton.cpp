@@ -36,7 +36,13 @@ http://www.gnu.org/copyleft/lesser.txt.
 // Just for logging
 #include "AnimationTrack.h"
 #include "KeyFrame.h"
+#include "CompressedKeyFrames.h"
+#include "StringConverter.h"
 #include "TagPoint.h"
+#include "Matrix3.h"
+#include "MyMath.h"
+
+#include <algorithm>
 
 
 namespace renderer {
@@ -54,10 +60,20 @@ Skeleton::Skeleton(String name) {
   // set animation blending to weighted, not cumulative
   mBlendState = ANIMBLEND_AVERAGE;
 
+  mBoneFlagsDirty = true;
+  mFlatBonesDirty = true;
+  mTransformsDirty = true;
+
 }
 //---------------------------------------------------------------------
 Skeleton::~Skeleton() {
   unload();
+  mPreparedData.clear();
+}
+//---------------------------------------------------------------------
+void Skeleton::prepare(void) {
+  mPreparedData.clear();
+  SkeletonManager::getSingleton()._findResourceData(mName, mPreparedData);
 }
 //---------------------------------------------------------------------
 void Skeleton::load(void) {
@@ -72,8 +88,10 @@ void Skeleton::load(void) {
   sprintf(msg, "Skeleton: Loading %s .", mName.c_str());
   LogManager::getSingleton().logMessage(msg);
 
-  DataChunk chunk;
-  SkeletonManager::getSingleton()._findResourceData(mName, chunk);
+  // Use the data read in the background, if there is any
+  DataChunk& chunk = mPreparedData;
+  if (!chunk.getPtr())
+    SkeletonManager::getSingleton()._findResourceData(mName, chunk);
 
   // Determine file type
   std::vector<String> extVec;
@@ -106,6 +124,8 @@ void Skeleton::unload(void) {
     delete i->second;
   }
   mBoneList.clear();
+  mFlatBones.clear();
+  mFlatBonesDirty = true;
 
   // destroy TagPoints
   TagPointList::iterator itp;
@@ -135,6 +155,7 @@ Bone* Skeleton::createBone(const String& name) {
   }
   Bone* ret = new Bone(name, mNextAutoHandle++, this);
   mBoneList[ret->getHandle()] = ret;
+  mFlatBonesDirty = true;
   mBoneListByName[name] = ret;
   return ret;
 }
@@ -146,6 +167,7 @@ Bone* Skeleton::createBone(unsigned short handle) {
   }
   Bone* ret = new Bone(handle, this);
   mBoneList[handle] = ret;
+  mFlatBonesDirty = true;
   mBoneListByName[ret->getName()] = ret;
   return ret;
 
@@ -158,6 +180,7 @@ Bone* Skeleton::createBone(const String& name, unsigned short handle) {
   }
   Bone* ret = new Bone(name, handle, this);
   mBoneList[handle] = ret;
+  mFlatBonesDirty = true;
   mBoneListByName[name] = ret;
   return ret;
 }
@@ -173,15 +196,6 @@ TagPoint* Skeleton::createTagPoint(const Quaternion &offsetOrientation, const Ve
   return ret;
 }
 
-void Skeleton::setCurrentEntity(Entity *pCurrentEntity) {
-  mCurrentEntity = pCurrentEntity;
-}
-
-Entity *Skeleton::getCurrentEntity(void) {
-  return mCurrentEntity;
-}
-
-
 //---------------------------------------------------------------------
 Bone* Skeleton::getRootBone(void) const {
   if (mRootBone == 0) {
@@ -191,64 +205,412 @@ Bone* Skeleton::getRootBone(void) const {
   return mRootBone;
 }
 //---------------------------------------------------------------------
-void Skeleton::setAnimationState(const AnimationStateSet& animSet) {
+void Skeleton::setAnimationState(const AnimationStateSet& animSet, bool skipMinorBones) {
   /*
   Algorithm:
-    1. Check if animation state is any different from last, if not do nothing
-    2. Reset all bone positions
-    3. Iterate per AnimationState, if enabled get Animation and call Animation::apply
-  */
+    1. Reset all bone positions
+    2. Iterate per AnimationState, if enabled get Animation and call Animation::apply
 
-  if (mLastAnimationState.size() == animSet.size()) {
-    // Same size, may be able to skip update
-    bool different = false;
-    AnimationStateSet::iterator i;
-    AnimationStateSet::const_iterator j;
-    i = mLastAnimationState.begin();
-    j = animSet.begin();
-    for (; i != mLastAnimationState.end(); ++i, ++j) {
-      if (i->second != j->second) {
-        different = true;
-        break;
-      }
-    }
-    // Check any differences?
-    if (!different) {
-      // No, no need to update
-      return;
-    }
-  }
-
-  // Ok, we've established the animation state is different
+  The bones are shared by every entity using this skeleton, so there's no
+  telling whether they still hold the pose of this animation state; callers
+  wanting to skip unchanged poses compare _getPoseHash themselves.
+  */
 
   // Reset bones
   reset();
 
+  if (mBoneFlagsDirty) {
+    // Bone handles are the keys of the sorted map, so the last is the largest
+    size_t numHandles = mBoneList.empty() ? 0 : mBoneList.rbegin()->first + 1;
+    mManualBones.assign(numHandles, false);
+    mMinorBones.assign(numHandles, false);
+    BoneList::const_iterator ibone;
+    for (ibone = mBoneList.begin(); ibone != mBoneList.end(); ++ibone) {
+      bool manual = ibone->second->isManuallyControlled();
+      mManualBones[ibone->first] = manual;
+      mMinorBones[ibone->first] = manual || ibone->second->isMinor();
+    }
+    mBoneFlagsDirty = false;
+  }
+  // Manually controlled bones are left alone, as reset did; the same rule
+  // as _evaluatePose
+  const std::vector<bool>* pSkipTracks = skipMinorBones ? &mMinorBones : &mManualBones;
+
   // Per animation state
   AnimationStateSet::const_iterator istate;
   for (istate = animSet.begin(); istate != animSet.end(); ++istate) {
     // Apply if enabled
     const AnimationState& animState = istate->second;
     if (animState.getEnabled()) {
-      Animation* anim = getAnimation(animState.getAnimationName());
-      anim->apply(animState.getTimePosition(), animState.getWeight(), mBlendState == ANIMBLEND_CUMULATIVE);
+      Animation* anim = getAnimation(animState.getAnimationNameId());
+      anim->apply(animState, mBlendState == ANIMBLEND_CUMULATIVE, pSkipTracks);
     }
   }
+}
+//---------------------------------------------------------------------
+namespace {
+const uint64 FNV_OFFSET_BASIS = GG_UINT64_C(14695981039346656037);
+const uint64 FNV_PRIME = GG_UINT64_C(1099511628211);
+
+/// FNV-1a over a block of bytes
+uint64 hashBytes(uint64 hash, const void* pData, size_t size) {
+  const unsigned char* p = static_cast<const unsigned char*>(pData);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= p[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+}
+//---------------------------------------------------------------------
+uint64 Skeleton::_getPoseHash(const AnimationStateSet& animSet, bool skipMinorBones) const {
+  uint64 hash = FNV_OFFSET_BASIS;
+  hash = hashBytes(hash, &mBlendState, sizeof(mBlendState));
+  hash = hashBytes(hash, &skipMinorBones, sizeof(skipMinorBones));
 
-  mLastAnimationState = animSet;
+  AnimationStateSet::const_iterator istate;
+  for (istate = animSet.begin(); istate != animSet.end(); ++istate) {
+    const AnimationState& animState = istate->second;
+    // Disabled animations don't contribute to the pose
+    if (!animState.getEnabled())
+      continue;
+    Real time = animState.getTimePosition();
+    Real weight = animState.getWeight();
+    uint32 nameId = animState.getAnimationNameId().getId();
+    hash = hashBytes(hash, &nameId, sizeof(nameId));
+    hash = hashBytes(hash, &time, sizeof(time));
+    hash = hashBytes(hash, &weight, sizeof(weight));
+  }
 
+  BoneList::const_iterator ibone;
+  for (ibone = mBoneList.begin(); ibone != mBoneList.end(); ++ibone) {
+    const Bone* bone = ibone->second;
+    if (!bone->isManuallyControlled())
+      continue;
+    hash = hashBytes(hash, &ibone->first, sizeof(ibone->first));
+    hash = hashBytes(hash, &bone->getPosition(), sizeof(Vector3));
+    hash = hashBytes(hash, &bone->getOrientation(), sizeof(Quaternion));
+    hash = hashBytes(hash, &bone->getScale(), sizeof(Vector3));
+  }
 
+  return hash;
+}
+//---------------------------------------------------------------------
+void Skeleton::_notifyBoneFlagsChanged(void) {
+  mBoneFlagsDirty = true;
+}
+//---------------------------------------------------------------------
+void Skeleton::_prepareForEvaluation(void) {
+  if (mFlatBonesDirty) {
+    buildFlatBones();
+  }
+
+  AnimationList::iterator ai;
+  for (ai = mAnimationsList.begin(); ai != mAnimationsList.end(); ++ai) {
+    const Animation::TrackList& tracks = ai->second->_getTrackList();
+    Animation::TrackList::const_iterator ti;
+    for (ti = tracks.begin(); ti != tracks.end(); ++ti) {
+      ti->second->_prepare();
+    }
+  }
+}
+//---------------------------------------------------------------------
+void Skeleton::_evaluatePose(const AnimationStateSet& animSet, bool skipMinorBones,
+                             PoseBuffer& buffer, Matrix4* pMatrices, Real* pDualQuats) const {
+  assert(!mFlatBonesDirty && "Skeleton::_prepareForEvaluation not called");
+
+  size_t numBones = mFlatBones.size();
+  buffer.resize(numBones);
+
+  // Start from the binding pose, or wherever the application put manual bones
+  for (size_t k = 0; k < numBones; ++k) {
+    const Bone* bone = mFlatBones[k];
+    if (bone->isManuallyControlled()) {
+      buffer.orientations[k] = bone->mOrientation;
+      buffer.positions[k] = bone->mPosition;
+      buffer.scales[k] = bone->mScale;
+    } else {
+      buffer.orientations[k] = bone->mInitialOrientation;
+      buffer.positions[k] = bone->mInitialPosition;
+      buffer.scales[k] = bone->mInitialScale;
+    }
+    buffer.accumWeights[k] = 0;
+    buffer.rotFromInitial[k] = Quaternion::IDENTITY;
+    buffer.transFromInitial[k] = Vector3::ZERO;
+    buffer.scaleFromInitial[k] = Vector3::UNIT_SCALE;
+  }
+
+  bool accumulate = mBlendState == ANIMBLEND_CUMULATIVE;
+  Vector3 translate, scale;
+  Quaternion rotation;
+
+  AnimationStateSet::const_iterator istate;
+  for (istate = animSet.begin(); istate != animSet.end(); ++istate) {
+    const AnimationState& animState = istate->second;
+    if (!animState.getEnabled())
+      continue;
+
+    const Animation::TrackList& tracks =
+      getAnimation(animState.getAnimationNameId())->_getTrackList();
+    std::vector<unsigned short>& cursors = animState._getTrackCursors();
+    if (cursors.size() != tracks.size()) {
+      cursors.assign(tracks.size(), 0);
+    }
+    Real timePos = animState.getTimePosition();
+    Real weight = animState.getWeight();
+
+    std::vector<unsigned short>::iterator ci = cursors.begin();
+    Animation::TrackList::const_iterator ti;
+    for (ti = tracks.begin(); ti != tracks.end(); ++ti, ++ci) {
+      // Tracks are keyed by the handle of the bone they move
+      if (ti->first >= mFlatIndexByHandle.size())
+        continue;
+      unsigned short k = mFlatIndexByHandle[ti->first];
+      if (k == NO_PARENT)
+        continue;
+      const Bone* bone = mFlatBones[k];
+      // Manually controlled bones aren't animated, as in setAnimationState
+      if (bone->isManuallyControlled() || (skipMinorBones && bone->isMinor()))
+        continue;
+      if (!ti->second->_evaluate(timePos, *ci, translate, rotation, scale))
+        continue;
+
+      if (accumulate) {
+        // As AnimationTrack::applyTransform does to a node
+        buffer.positions[k] += translate * weight;
+        buffer.orientations[k] = buffer.orientations[k] *
+                                 Quaternion::Slerp(weight, Quaternion::IDENTITY, rotation);
+        buffer.scales[k] = buffer.scales[k] * scale;
+      } else {
+        // As Node::_weightedTransform
+        Real& accumWeight = buffer.accumWeights[k];
+        if (accumWeight == 0.0f) {
+          buffer.rotFromInitial[k] = rotation;
+          buffer.transFromInitial[k] = translate;
+          buffer.scaleFromInitial[k] = scale;
+          accumWeight = weight;
+        } else {
+          Real factor = weight / (accumWeight + weight);
+          buffer.transFromInitial[k] += (translate - buffer.transFromInitial[k]) * factor;
+          buffer.rotFromInitial[k] =
+            Quaternion::Slerp(factor, buffer.rotFromInitial[k], rotation);
+          Vector3 scaleDiff = (scale - Vector3::UNIT_SCALE) * factor;
+          buffer.scaleFromInitial[k] = buffer.scaleFromInitial[k] *
+                                       (scaleDiff + Vector3::UNIT_SCALE);
+          accumWeight += weight;
+        }
+        buffer.orientations[k] = bone->mInitialOrientation * buffer.rotFromInitial[k];
+        buffer.positions[k] = bone->mInitialPosition + buffer.transFromInitial[k];
+        buffer.scales[k] = bone->mInitialScale * buffer.scaleFromInitial[k];
+      }
+    }
+  }
+
+  deriveTransforms(buffer);
+  makePalette(buffer, pMatrices, pDualQuats);
+}
+//---------------------------------------------------------------------
+void Skeleton::PoseBuffer::resize(size_t numBones) {
+  if (orientations.size() == numBones) {
+    return;
+  }
+  orientations.resize(numBones);
+  positions.resize(numBones);
+  scales.resize(numBones);
+  accumWeights.resize(numBones);
+  rotFromInitial.resize(numBones);
+  transFromInitial.resize(numBones);
+  scaleFromInitial.resize(numBones);
+  derivedOrientations.resize(numBones);
+  derivedPositions.resize(numBones);
+  derivedScales.resize(numBones);
+  transforms.resize(numBones);
 }
 //---------------------------------------------------------------------
 void Skeleton::setBindingPose(void) {
   // Update the derived transforms
-  getRootBone()->_update(true, false);
+  updateTransforms(0);
 
 
   BoneList::iterator i;
   for (i = mBoneList.begin(); i != mBoneList.end(); ++i) {
     i->second->setBindingPose();
   }
+
+  for (size_t k = 0; k < mFlatBones.size(); ++k) {
+    mFlatBindInverses[k] = mFlatBones[k]->_getBindingPoseInverseTransform();
+  }
+}
+//---------------------------------------------------------------------
+void Skeleton::_notifyBonesChanged(void) {
+  mTransformsDirty = true;
+}
+//---------------------------------------------------------------------
+void Skeleton::_notifyBoneHierarchyChanged(void) {
+  mFlatBonesDirty = true;
+}
+//---------------------------------------------------------------------
+void Skeleton::buildFlatBones(void) {
+  size_t numBones = mBoneList.size();
+
+  // Sort by depth in the hierarchy, then by handle; that puts every bone
+  // after its parent and keeps siblings in palette order
+  std::vector<Bone*> bonesByRank;
+  std::vector<std::pair<unsigned short, unsigned short> > order;
+  bonesByRank.reserve(numBones);
+  order.reserve(numBones);
+
+  BoneList::iterator i;
+  for (i = mBoneList.begin(); i != mBoneList.end(); ++i) {
+    unsigned short depth = 0;
+    for (Node* p = i->second->getParent(); p; p = p->getParent()) {
+      ++depth;
+    }
+    order.push_back(std::make_pair(depth, (unsigned short)bonesByRank.size()));
+    bonesByRank.push_back(i->second);
+  }
+  std::sort(order.begin(), order.end());
+
+  std::map<const Node*, unsigned short> flatIndex;
+  mFlatBones.resize(numBones);
+  mFlatPaletteIndex.resize(numBones);
+  // Bone handles are the keys of the sorted map, so the last is the largest
+  mFlatIndexByHandle.assign(numBones ? mBoneList.rbegin()->first + 1 : 0, NO_PARENT);
+  for (size_t k = 0; k < numBones; ++k) {
+    mFlatBones[k] = bonesByRank[order[k].second];
+    mFlatPaletteIndex[k] = order[k].second;
+    mFlatIndexByHandle[mFlatBones[k]->getHandle()] = (unsigned short)k;
+    flatIndex[mFlatBones[k]] = (unsigned short)k;
+  }
+
+  mFlatParents.resize(numBones);
+  mFlatBindInverses.resize(numBones);
+  for (size_t k = 0; k < numBones; ++k) {
+    std::map<const Node*, unsigned short>::iterator pi =
+      flatIndex.find(mFlatBones[k]->getParent());
+    mFlatParents[k] = pi == flatIndex.end() ? NO_PARENT : pi->second;
+    mFlatBindInverses[k] = mFlatBones[k]->_getBindingPoseInverseTransform();
+  }
+
+  mBonePose.resize(numBones);
+
+  mFlatBonesDirty = false;
+  mTransformsDirty = true;
+}
+//---------------------------------------------------------------------
+void Skeleton::updateTransforms(Entity* pTagPointOwner) {
+  if (mFlatBonesDirty) {
+    buildFlatBones();
+  }
+
+  if (mTransformsDirty) {
+    size_t numBones = mFlatBones.size();
+    for (size_t k = 0; k < numBones; ++k) {
+      const Bone* bone = mFlatBones[k];
+      mBonePose.orientations[k] = bone->mOrientation;
+      mBonePose.positions[k] = bone->mPosition;
+      mBonePose.scales[k] = bone->mScale;
+    }
+
+    deriveTransforms(mBonePose);
+
+    for (size_t k = 0; k < numBones; ++k) {
+      // Leave the bone looking freshly updated
+      Bone* bone = mFlatBones[k];
+      bone->mDerivedOrientation = mBonePose.derivedOrientations[k];
+      bone->mDerivedPosition = mBonePose.derivedPositions[k];
+      bone->mDerivedScale = mBonePose.derivedScales[k];
+      bone->mCachedTransform = mBonePose.transforms[k];
+      bone->mCachedTransformOutOfDate = false;
+      bone->mNeedParentUpdate = false;
+      bone->mNeedChildUpdate = false;
+    }
+    mTransformsDirty = false;
+  }
+
+  // Tag points follow the bones they hang off, but only those of the entity
+  // whose pose the bones now hold
+  TagPointList::iterator itp;
+  for (itp = mTagPointList.begin(); itp != mTagPointList.end(); ++itp) {
+    TagPoint* tp = itp->second;
+    if (tp->getParent() && tp->getParentEntity() == pTagPointOwner) {
+      tp->_update(true, true);
+    }
+  }
+}
+//---------------------------------------------------------------------
+void Skeleton::deriveTransforms(PoseBuffer& pose) const {
+  size_t numBones = mFlatBones.size();
+  for (size_t k = 0; k < numBones; ++k) {
+    unsigned short parent = mFlatParents[k];
+    Quaternion& orientation = pose.derivedOrientations[k];
+    Vector3& position = pose.derivedPositions[k];
+    Vector3& scale = pose.derivedScales[k];
+
+    // As Node::_updateFromParent; the parent is always done already
+    if (parent == NO_PARENT) {
+      orientation = pose.orientations[k];
+      position = pose.positions[k];
+      scale = pose.scales[k];
+    } else {
+      const Quaternion& parentOrientation = pose.derivedOrientations[parent];
+      orientation = parentOrientation * pose.orientations[k];
+      position = parentOrientation * pose.positions[k];
+      if (mFlatBones[k]->mInheritScale) {
+        position = position * pose.derivedScales[parent];
+        scale = pose.scales[k] * pose.derivedScales[parent];
+      } else {
+        scale = pose.scales[k];
+      }
+      position += pose.derivedPositions[parent];
+    }
+    mFlatBones[k]->makeTransform(position, scale, orientation, pose.transforms[k]);
+  }
+}
+//---------------------------------------------------------------------
+void Skeleton::makePalette(const PoseBuffer& pose, Matrix4* pMatrices, Real* pDualQuats) const {
+  /*
+      Calculating the bone matrices
+      -----------------------------
+      Now that we have the derived orientations & positions of the bones, we have
+      to compute the Matrix4 to apply to the vertices of a mesh.
+      Because any modification of a vertex has to be relative to the bone, we must first
+      reverse transform by the Bone's original derived position/orientation, then transform
+      by the new derived position / orientation.
+  */
+  size_t numBones = mFlatBones.size();
+  for (size_t k = 0; k < numBones; ++k) {
+    Matrix4 m = pose.transforms[k] * mFlatBindInverses[k];
+    if (pMatrices) {
+      pMatrices[mFlatPaletteIndex[k]] = m;
+    }
+    if (pDualQuats) {
+      _toDualQuaternion(m, pDualQuats + 8 * mFlatPaletteIndex[k]);
+    }
+  }
+}
+//---------------------------------------------------------------------
+void Skeleton::_toDualQuaternion(const Matrix4& m, Real* pDest) {
+  // Split the transform into rotation and translation
+  Matrix3 rot;
+  m.extract3x3Matrix(rot);
+  // Strip any scaling, dual quaternions can't represent it
+  rot.Orthonormalize();
+  Quaternion q;
+  q.FromRotationMatrix(rot);
+  q = q * Math::InvSqrt(q.Norm());
+
+  // Dual part is half the translation (as a pure quaternion) times the rotation
+  Quaternion d = Quaternion(0, m[0][3], m[1][3], m[2][3]) * q * 0.5;
+
+  pDest[0] = q.x;
+  pDest[1] = q.y;
+  pDest[2] = q.z;
+  pDest[3] = q.w;
+  pDest[4] = d.x;
+  pDest[5] = d.y;
+  pDest[6] = d.z;
+  pDest[7] = d.w;
 }
 //---------------------------------------------------------------------
 void Skeleton::reset(void) {
@@ -265,18 +627,19 @@ Animation* Skeleton::createAnimation(const String& name, Real length) {
   // Add to list
   mAnimationsList[name] = ret;
 
-  // Also add to state
-  mLastAnimationState[name] = AnimationState(name, 0, length);
-
   return ret;
 
 }
 //---------------------------------------------------------------------
 Animation* Skeleton::getAnimation(const String& name) const {
+  return getAnimation(StringId(name));
+}
+//---------------------------------------------------------------------
+Animation* Skeleton::getAnimation(const StringId& name) const {
   AnimationList::const_iterator i = mAnimationsList.find(name);
 
   if (i == mAnimationsList.end()) {
-    Except(Exception::ERR_ITEM_NOT_FOUND, "No animation entry found named " + name,
+    Except(Exception::ERR_ITEM_NOT_FOUND, "No animation entry found named " + name.getString(),
            "Skeleton::getAnimation");
   }
 
@@ -296,10 +659,6 @@ void Skeleton::removeAnimation(const String& name) {
   mAnimationsList.erase(i);
 
 }
-//---------------------------------------------------------------------
-const AnimationStateSet& Skeleton::getAnimationState(void) const {
-  return mLastAnimationState;
-}
 //-----------------------------------------------------------------------
 void Skeleton::_initAnimationState(AnimationStateSet* animSet) {
   animSet->clear();
@@ -317,30 +676,18 @@ unsigned short Skeleton::getNumBones(void) const {
   return (unsigned short)mBoneList.size();
 }
 //-----------------------------------------------------------------------
-void Skeleton::_getBoneMatrices(Matrix4* pMatrices) {
+void Skeleton::_getBoneMatrices(Matrix4* pMatrices, Entity* pTagPointOwner) {
   // Update derived transforms
-  getRootBone()->_update(true, false);
-
-  /*
-      Calculating the bone matrices
-      -----------------------------
-      Now that we have the derived orientations & positions in the Bone nodes, we have
-      to compute the Matrix4 to apply to the vertices of a mesh.
-      Because any modification of a vertex has to be relative to the bone, we must first
-      reverse transform by the Bone's original derived position/orientation, then transform
-      by the new derived position / orientation.
-  */
-
-  BoneList::iterator i, boneend;
-  boneend = mBoneList.end();
-
+  updateTransforms(pTagPointOwner);
 
-  for(i = mBoneList.begin(); i != boneend; ++i) {
-    Bone* pBone = i->second;
-    *pMatrices = pBone->_getFullTransform() *  pBone->_getBindingPoseInverseTransform();
-    pMatrices++;
-  }
+  makePalette(mBonePose, pMatrices, 0);
+}
+//---------------------------------------------------------------------
+void Skeleton::_getBoneDualQuaternions(Real* pDualQuats) {
+  // Update derived transforms
+  updateTransforms(0);
 
+  makePalette(mBonePose, 0, pDualQuats);
 }
 //---------------------------------------------------------------------
 unsigned short Skeleton::getNumAnimations(void) const {
@@ -359,6 +706,50 @@ Animation* Skeleton::getAnimation(unsigned short index) const {
   return i->second;
 }
 //---------------------------------------------------------------------
+void Skeleton::compressAnimations(Real positionTolerance, Real scaleTolerance) {
+  size_t rawSize = 0;
+  size_t compressedSize = 0;
+
+  AnimationList::iterator ai;
+  for (ai = mAnimationsList.begin(); ai != mAnimationsList.end(); ++ai) {
+    const Animation::TrackList& tracks = ai->second->_getTrackList();
+    Animation::TrackList::const_iterator ti;
+    for (ti = tracks.begin(); ti != tracks.end(); ++ti) {
+      AnimationTrack* track = ti->second;
+      if (track->isCompressed() || track->getNumKeyFrames() == 0) {
+        continue;
+      }
+      rawSize += track->getNumKeyFrames() * (sizeof(KeyFrame) + sizeof(KeyFrame*));
+
+      // Leaf bones still carry the vertices around them; treat them as
+      // reaching as far as they are long
+      const Node* bone = track->getAssociatedNode();
+      Real reach = 0;
+      if (bone) {
+        reach = std::max(getBoneReach(bone), bone->getPosition().length());
+      }
+      Real rotateTolerance = reach > positionTolerance ?
+                             positionTolerance / reach : 1.0f;
+
+      track->compress(positionTolerance, rotateTolerance, scaleTolerance);
+      compressedSize += track->_getCompressedKeyFrames()->getMemoryUsage();
+    }
+  }
+
+  LogManager::getSingleton().logMessage("Skeleton " + mName +
+                                        ": compressed animation keys from " + StringConverter::toString((unsigned long)rawSize) +
+                                        " to " + StringConverter::toString((unsigned long)compressedSize) + " bytes.");
+}
+//---------------------------------------------------------------------
+Real Skeleton::getBoneReach(const Node* bone) const {
+  Real reach = 0;
+  for (unsigned short i = 0; i < bone->numChildren(); ++i) {
+    const Node* child = bone->getChild(i);
+    reach = std::max(reach, child->getPosition().length() + getBoneReach(child));
+  }
+  return reach;
+}
+//---------------------------------------------------------------------
 Bone* Skeleton::getBone(unsigned short handle) const {
   BoneList::const_iterator i = mBoneList.find(handle);
 
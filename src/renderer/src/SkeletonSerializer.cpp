@@ -29,11 +29,14 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Animation.h"
 #include "AnimationTrack.h"
 #include "KeyFrame.h"
+#include "CompressedKeyFrames.h"
 #include "Bone.h"
 #include "StringConverter.h"
 #include "DataChunk.h"
 #include "LogManager.h"
 
+#include <algorithm>
+
 
 
 
@@ -173,6 +176,11 @@ void SkeletonSerializer::writeAnimationTrack(const AnimationTrack* track) {
   unsigned short boneid = bone->getHandle();
   writeShorts(&boneid, 1);
 
+  if (track->isCompressed()) {
+    writeCompressedKeyFrames(track->_getCompressedKeyFrames());
+    return;
+  }
+
   // Write all keyframes
   for (unsigned short i = 0; i < track->getNumKeyFrames(); ++i) {
     writeKeyFrame(track->getKeyFrame(i));
@@ -193,6 +201,38 @@ void SkeletonSerializer::writeKeyFrame(const KeyFrame* key) {
   writeObject(key->getTranslate());
 }
 //---------------------------------------------------------------------
+void SkeletonSerializer::writeCompressedKeyFrames(const CompressedKeyFrames* keys) {
+  writeChunkHeader(SKELETON_ANIMATION_TRACK_COMPRESSED, calcCompressedKeyFramesSize(keys));
+
+  // Real length                       : Length of the animation the keys were made for
+  writeReals(&keys->mLength, 1);
+  // unsigned short numKeys
+  unsigned short numKeys = keys->getNumKeys();
+  writeShorts(&numKeys, 1);
+  // unsigned short constantChannels   : CompressedKeyFrames::ConstantChannel flags
+  writeShorts(&keys->mConstantChannels, 1);
+  // Quantisation ranges
+  writeObject(keys->mTranslateMin);
+  writeObject(keys->mTranslateExtent);
+  writeObject(keys->mScaleMin);
+  writeObject(keys->mScaleExtent);
+  // Key data
+  writeShortList(keys->mTimes);
+  writeShortList(keys->mRotations);
+  writeShortList(keys->mTranslates);
+  writeShortList(keys->mScales);
+}
+//---------------------------------------------------------------------
+void SkeletonSerializer::writeShortList(const std::vector<uint16>& shorts) {
+  // writeShorts takes at most 64k values at a time
+  size_t done = 0;
+  while (done < shorts.size()) {
+    unsigned short count = (unsigned short)std::min(shorts.size() - done, (size_t)0xFFFF);
+    writeShorts(&shorts[done], count);
+    done += count;
+  }
+}
+//---------------------------------------------------------------------
 unsigned long SkeletonSerializer::calcBoneSize(const Bone* pBone) {
   unsigned long size = CHUNK_OVERHEAD_SIZE;
 
@@ -246,6 +286,10 @@ unsigned long SkeletonSerializer::calcAnimationTrackSize(const AnimationTrack* p
   // unsigned short boneIndex     : Index of bone to apply to
   size += sizeof(unsigned short);
 
+  if (pTrack->isCompressed()) {
+    return size + calcCompressedKeyFramesSize(pTrack->_getCompressedKeyFrames());
+  }
+
   // Nested keyframes
   for (unsigned short i = 0; i < pTrack->getNumKeyFrames(); ++i) {
     size += calcKeyFrameSize(pTrack->getKeyFrame(i));
@@ -268,6 +312,23 @@ unsigned long SkeletonSerializer::calcKeyFrameSize(const KeyFrame* pKey) {
   return size;
 }
 //---------------------------------------------------------------------
+unsigned long SkeletonSerializer::calcCompressedKeyFramesSize(const CompressedKeyFrames* pKeys) {
+  unsigned long size = CHUNK_OVERHEAD_SIZE;
+
+  // length
+  size += sizeof(Real);
+  // numKeys, constantChannels
+  size += sizeof(unsigned short) * 2;
+  // quantisation ranges
+  size += sizeof(Real) * 3 * 4;
+  // key data
+  size += (unsigned long)(sizeof(unsigned short) *
+                          (pKeys->mTimes.size() + pKeys->mRotations.size() +
+                           pKeys->mTranslates.size() + pKeys->mScales.size()));
+
+  return size;
+}
+//---------------------------------------------------------------------
 void SkeletonSerializer::readBone(DataChunk &chunk) {
   // char* name
   String name = readString(chunk);
@@ -353,8 +414,13 @@ void SkeletonSerializer::readAnimationTrack(DataChunk &chunk, Animation* anim) {
   // Keep looking for nested keyframes
   if (!chunk.isEOF()) {
     unsigned short chunkID = readChunk(chunk);
-    while(chunkID == SKELETON_ANIMATION_TRACK_KEYFRAME && !chunk.isEOF()) {
-      readKeyFrame(chunk, pTrack);
+    while((chunkID == SKELETON_ANIMATION_TRACK_KEYFRAME ||
+           chunkID == SKELETON_ANIMATION_TRACK_COMPRESSED) && !chunk.isEOF()) {
+      if (chunkID == SKELETON_ANIMATION_TRACK_COMPRESSED) {
+        readCompressedKeyFrames(chunk, pTrack);
+      } else {
+        readKeyFrame(chunk, pTrack);
+      }
 
       if (!chunk.isEOF()) {
         // Get next chunk
@@ -388,6 +454,46 @@ void SkeletonSerializer::readKeyFrame(DataChunk &chunk, AnimationTrack* track) {
   kf->setTranslate(trans);
 }
 //---------------------------------------------------------------------
+void SkeletonSerializer::readCompressedKeyFrames(DataChunk &chunk, AnimationTrack* track) {
+  CompressedKeyFrames* keys = new CompressedKeyFrames();
+
+  // Real length                       : Length of the animation the keys were made for
+  Real length;
+  readReals(chunk, &length, 1);
+  keys->setLength(length);
+  // unsigned short numKeys
+  unsigned short numKeys;
+  readShorts(chunk, &numKeys, 1);
+  // unsigned short constantChannels   : CompressedKeyFrames::ConstantChannel flags
+  readShorts(chunk, &keys->mConstantChannels, 1);
+  // Quantisation ranges
+  readObject(chunk, &keys->mTranslateMin);
+  readObject(chunk, &keys->mTranslateExtent);
+  readObject(chunk, &keys->mScaleMin);
+  readObject(chunk, &keys->mScaleExtent);
+  // Key data
+  unsigned short flags = keys->mConstantChannels;
+  readShortList(chunk, keys->mTimes, numKeys);
+  readShortList(chunk, keys->mRotations,
+                3 * ((flags & CompressedKeyFrames::CC_ROTATION) ? 1 : numKeys));
+  readShortList(chunk, keys->mTranslates,
+                3 * ((flags & CompressedKeyFrames::CC_TRANSLATE) ? 1 : numKeys));
+  readShortList(chunk, keys->mScales,
+                3 * ((flags & CompressedKeyFrames::CC_SCALE) ? 1 : numKeys));
+
+  track->_setCompressedKeyFrames(keys);
+}
+//---------------------------------------------------------------------
+void SkeletonSerializer::readShortList(DataChunk &chunk, std::vector<uint16>& shorts, size_t count) {
+  shorts.resize(count);
+  size_t done = 0;
+  while (done < count) {
+    unsigned short n = (unsigned short)std::min(count - done, (size_t)0xFFFF);
+    readShorts(chunk, &shorts[done], n);
+    done += n;
+  }
+}
+//---------------------------------------------------------------------
 
 
 
@@ -0,0 +1,153 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#include "StringId.h"
+
+#include "base/synchronization/lock.h"
+
+namespace renderer {
+namespace {
+/** The table behind StringId; open addressing over the ids.
+    @remarks
+        Strings live in a deque so the references handed out by getString
+        stay valid as the table grows.
+*/
+class StringIdTable {
+public:
+  StringIdTable() : mMask(0), mCount(0) {
+    resize(1024);
+  }
+
+  uint32 intern(const String& str) {
+    if (str.empty()) {
+      return 0;
+    }
+
+    base::AutoLock lock(mLock);
+    uint32 id = StringId::hash(str);
+    for (;;) {
+      // 0 is kept for the empty string
+      if (id == 0) {
+        id = 1;
+      }
+      size_t slot = find(id);
+      if (mSlots[slot].str == 0) {
+        break;
+      }
+      if (*mSlots[slot].str == str) {
+        return id;
+      }
+      // Hash collision with another string; try the next id
+      ++id;
+    }
+
+    if ((mCount + 1) * 2 > mSlots.size()) {
+      resize(mSlots.size() * 2);
+    }
+    mStrings.push_back(str);
+    Slot& s = mSlots[find(id)];
+    s.id = id;
+    s.str = &mStrings.back();
+    ++mCount;
+    return id;
+  }
+
+  const String& lookup(uint32 id) {
+    if (id == 0) {
+      return mEmpty;
+    }
+
+    base::AutoLock lock(mLock);
+    const String* str = mSlots[find(id)].str;
+    assert(str && "StringId not in the table");
+    return str ? *str : mEmpty;
+  }
+
+private:
+  struct Slot {
+    Slot() : id(0), str(0) {}
+    uint32 id;
+    const String* str;
+  };
+
+  /// Finds the slot holding id, or the empty slot where it would go
+  size_t find(uint32 id) const {
+    size_t slot = id & mMask;
+    while (mSlots[slot].str && mSlots[slot].id != id) {
+      slot = (slot + 1) & mMask;
+    }
+    return slot;
+  }
+
+  void resize(size_t size) {
+    std::vector<Slot> old;
+    old.swap(mSlots);
+    mSlots.resize(size);
+    mMask = size - 1;
+    for (size_t i = 0; i < old.size(); ++i) {
+      if (old[i].str) {
+        mSlots[find(old[i].id)] = old[i];
+      }
+    }
+  }
+
+  std::vector<Slot> mSlots;
+  std::deque<String> mStrings;
+  size_t mMask;
+  size_t mCount;
+  String mEmpty;
+  base::Lock mLock;
+};
+
+/** Gets the table, creating it on first use.
+    @remarks
+        Static objects of other classes may intern strings while they are
+        constructed, so the table can't be a plain static.
+*/
+StringIdTable& getTable(void) {
+  static StringIdTable table;
+  return table;
+}
+}
+
+//-----------------------------------------------------------------------
+StringId::StringId(const String& str)
+  : mId(getTable().intern(str)) {
+}
+//-----------------------------------------------------------------------
+const String& StringId::getString(void) const {
+  return getTable().lookup(mId);
+}
+//-----------------------------------------------------------------------
+uint32 StringId::hash(const String& str) {
+  // 32 bit FNV-1a
+  uint32 h = 2166136261U;
+  for (String::const_iterator i = str.begin(); i != str.end(); ++i) {
+    h ^= static_cast<unsigned char>(*i);
+    h *= 16777619U;
+  }
+  return h;
+}
+
+}
@@ -28,10 +28,32 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "SceneManager.h"
 #include "MaterialManager.h"
 #include "SubMesh.h"
+#include "Mesh.h"
 #include "TagPoint.h"
 #include "LogManager.h"
+#include "ClassAllocator.h"
 
 namespace renderer {
+namespace {
+/// The allocator of all SubEntities; never deleted, as the objects may outlive
+/// the static destructors
+ClassAllocator& getSubEntityAllocator(void) {
+  static ClassAllocator* allocator = new ClassAllocator(sizeof(SubEntity));
+  return *allocator;
+}
+}
+//-----------------------------------------------------------------------
+void* SubEntity::operator new(size_t size) {
+  return getSubEntityAllocator().allocate(size);
+}
+//-----------------------------------------------------------------------
+void SubEntity::operator delete(void* p, size_t size) {
+  getSubEntityAllocator().deallocate(p, size);
+}
+//-----------------------------------------------------------------------
+void SubEntity::setAllocatorPolicy(AllocatorPolicy* policy) {
+  getSubEntityAllocator().setPolicy(policy);
+}
 //-----------------------------------------------------------------------
 SubEntity::SubEntity () {
   mpMaterial = static_cast<Material*>(MaterialManager::getSingleton().getByName("BaseWhite"));
@@ -74,10 +96,32 @@ Material* SubEntity::getMaterial(void) const {
 void SubEntity::getRenderOperation(RenderOperation& rend) {
   // Use LOD
   mSubMesh->_getRenderOperation(rend, mParentEntity->mMeshLodIndex);
+
+  const Mesh::SkinnedGeometry* skinned = getSkinnedGeometry();
+  if (skinned) {
+    // Already blended for this pose, render as a rigid mesh
+    rend.vertexOptions &= ~RenderOperation::VO_BLEND_WEIGHTS;
+    rend.pVertices = const_cast<Real*>(&skinned->positions.front());
+    rend.vertexStride = 0;
+    if (!skinned->normals.empty()) {
+      rend.pNormals = const_cast<Real*>(&skinned->normals.front());
+      rend.normalStride = 0;
+    }
+  }
+}
+//-----------------------------------------------------------------------
+const Mesh::SkinnedGeometry* SubEntity::getSkinnedGeometry(void) const {
+  const Mesh::SkinnedPose* pose = mParentEntity->mSkinnedPose;
+  if (!pose || mParentEntity->mSkinnedPoseMesh != mSubMesh->parent)
+    return 0;
+
+  const GeometryData* geom = mSubMesh->useSharedVertices ?
+                             &mSubMesh->parent->sharedGeometry : &mSubMesh->geometry;
+  return mSubMesh->parent->_getSkinnedGeometry(pose, geom);
 }
 //-----------------------------------------------------------------------
 void SubEntity::getWorldTransforms(Matrix4* xform) {
-  if (!mParentEntity->mNumBoneMatrices) {
+  if (!mParentEntity->mNumBoneMatrices || getSkinnedGeometry()) {
     *xform = mParentEntity->_getParentNodeFullTransform();
   } else {
     // Bones, use cached matrices built when Entity::_updateRenderQueue was called
@@ -90,7 +134,7 @@ void SubEntity::getWorldTransforms(Matrix4* xform) {
 }
 //-----------------------------------------------------------------------
 unsigned short SubEntity::getNumWorldTransforms(void) {
-  if (!mParentEntity->mNumBoneMatrices)
+  if (!mParentEntity->mNumBoneMatrices || getSkinnedGeometry())
     return 1;
   else
     return mParentEntity->mNumBoneMatrices;
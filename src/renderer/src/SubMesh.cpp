@@ -27,6 +27,7 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "Mesh.h"
 #include "Exception.h"
 #include "MeshManager.h"
+#include "VertexInfluenceStream.h"
 
 namespace renderer {
 //-----------------------------------------------------------------------
@@ -46,6 +47,7 @@ SubMesh::SubMesh() {
   geometry.pColours = 0;
   geometry.pNormals = 0;
   geometry.pBlendingWeights = 0;
+  geometry.pInfluences = 0;
   geometry.numBlendWeightsPerVertex = 0;
 
   for (int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; ++i) {
@@ -90,6 +92,10 @@ SubMesh::~SubMesh() {
     delete [] geometry.pBlendingWeights;
     geometry.pBlendingWeights = 0;
   }
+  if (geometry.pInfluences) {
+    delete geometry.pInfluences;
+    geometry.pInfluences = 0;
+  }
 
   removeLodLevels();
 }
@@ -178,6 +184,7 @@ void SubMesh::_getRenderOperation(RenderOperation& ro, ushort lodIndex) {
     ro.vertexOptions |= RenderOperation::VO_BLEND_WEIGHTS;
     ro.numBlendWeightsPerVertex = geom->numBlendWeightsPerVertex;
     ro.pBlendingWeights = geom->pBlendingWeights;
+    ro.pInfluences = geom->pInfluences;
   }
 }
 //-----------------------------------------------------------------------
@@ -203,6 +210,10 @@ void SubMesh::compileBoneAssignments(void) {
     delete [] geometry.pBlendingWeights;
     geometry.pBlendingWeights = 0;
   }
+  if (geometry.pInfluences) {
+    delete geometry.pInfluences;
+    geometry.pInfluences = 0;
+  }
 
   // Iterate through, finding the largest # bones per vertex
   unsigned short maxBones = 0;
@@ -224,6 +235,9 @@ void SubMesh::compileBoneAssignments(void) {
     lastVertIdx = i->second.vertexIndex;
 
   }
+  // Last vertex
+  if (maxBones < currBones)
+    maxBones = currBones;
 
   if (maxBones == 0) {
     // No bone assignments
@@ -243,7 +257,7 @@ void SubMesh::compileBoneAssignments(void) {
   for (v = 0; v < geometry.numVertices; ++v) {
     for (unsigned short bone = 0; bone < maxBones; ++bone) {
       // Do we still have data for this vertex?
-      if (i->second.vertexIndex == v) {
+      if (i != iend && i->second.vertexIndex == v) {
         // If so, assign
         pBlend->matrixIndex = i->second.boneIndex;
         pBlend->blendWeight = i->second.weight;
@@ -257,6 +271,10 @@ void SubMesh::compileBoneAssignments(void) {
     }
   }
 
+  // Build the compacted stream used for software skinning
+  geometry.pInfluences = new VertexInfluenceStream(
+    geometry.pBlendingWeights, maxBones, geometry.numVertices);
+
   mBoneAssignmentsOutOfDate = false;
 
 
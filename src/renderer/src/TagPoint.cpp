@@ -50,13 +50,6 @@ Matrix4 TagPoint::getParentEntityTransform() {
 }
 
 
-void TagPoint::_update(bool updateChildren, bool parentHasChanged) {
-  //It's the parent entity that is currently updating the skeleton and his bones
-  if(mParentEntity == mCreator->getCurrentEntity()) {
-    Node::_update(updateChildren, parentHasChanged);
-  }
-}
-
 void TagPoint::needUpdate() {
   // We need to tell parent entities node
   if (mParentEntity) {
@@ -25,6 +25,32 @@ http://www.gnu.org/copyleft/lesser.txt.
 
 #include "Texture.h"
 
+#include "Exception.h"
+
 namespace renderer {
 
+//-----------------------------------------------------------------------
+void Texture::prepare(void) {
+  mPreparedImages.clear();
+
+  if( mUsage == TU_RENDERTARGET )
+    return;
+
+  if( mTextureType == TEX_TYPE_2D ) {
+    mPreparedImages.push_back( Image() );
+    mPreparedImages.back().load( mName );
+  } else if( mTextureType == TEX_TYPE_CUBE_MAP ) {
+    String suffixes[6] = {"_rt", "_lf", "_up", "_dn", "_bk", "_fr"};
+
+    size_t pos = mName.find_last_of(".");
+    String baseName = mName.substr(0, pos);
+    String ext = mName.substr(pos);
+    for( unsigned int i = 0; i < 6; i++ ) {
+      mPreparedImages.push_back( Image() );
+      mPreparedImages.back().load( baseName + suffixes[i] + ext );
+    }
+  } else
+    Except( Exception::UNIMPLEMENTED_FEATURE, "**** Unknown texture type ****", "Texture::prepare" );
+}
+
 }
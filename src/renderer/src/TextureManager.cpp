@@ -66,7 +66,8 @@ Texture * TextureManager::loadImage(
   tex->setGamma( gamma );
   tex->loadImage( img );
 
-  mResources[ tex->getName() ] = tex;
+  // Can't be reloaded from the name, so must never be paged out
+  addLoaded( tex, 0 );
 
   return tex;
 }
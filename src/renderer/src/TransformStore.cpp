@@ -0,0 +1,266 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#include "TransformStore.h"
+
+#include "SceneNode.h"
+#include "MovableObject.h"
+
+#include <algorithm>
+
+namespace renderer {
+namespace {
+/// Sort key of a node when rebuilding the slot order
+struct DepthEntry {
+  unsigned int depth;
+  TransformStore::Handle handle;
+
+  bool operator<(const DepthEntry& rhs) const {
+    // Sort by handle within a level, so the order is stable
+    return depth < rhs.depth || (depth == rhs.depth && handle < rhs.handle);
+  }
+};
+}
+
+//-----------------------------------------------------------------------
+TransformStore::TransformStore()
+  : mHierarchyChanged(false) {
+}
+//-----------------------------------------------------------------------
+TransformStore::~TransformStore() {
+}
+//-----------------------------------------------------------------------
+TransformStore::Handle TransformStore::add(SceneNode* node) {
+  Handle handle;
+  if (mFreeHandles.empty()) {
+    handle = static_cast<Handle>(mNodeByHandle.size());
+    mNodeByHandle.push_back(node);
+    mSlotByHandle.push_back(0);
+    mQueued.push_back(0);
+  } else {
+    handle = mFreeHandles.back();
+    mFreeHandles.pop_back();
+    mNodeByHandle[handle] = node;
+  }
+
+  mHierarchyChanged = true;
+  return handle;
+}
+//-----------------------------------------------------------------------
+void TransformStore::remove(Handle handle) {
+  assert(handle < mNodeByHandle.size() && mNodeByHandle[handle]);
+
+  // The slots still refer to the node, but are rebuilt before they are
+  // used again
+  mNodeByHandle[handle] = 0;
+  mFreeHandles.push_back(handle);
+  mHierarchyChanged = true;
+}
+//-----------------------------------------------------------------------
+void TransformStore::_notifyTransformChanged(Handle handle) {
+  // Everything is derived after a rebuild anyway
+  if (mHierarchyChanged || mQueued[handle]) {
+    return;
+  }
+  mQueued[handle] = 1;
+  mDirtyList.push_back(handle);
+}
+//-----------------------------------------------------------------------
+void TransformStore::_notifyHierarchyChanged(void) {
+  mHierarchyChanged = true;
+}
+//-----------------------------------------------------------------------
+size_t TransformStore::getNumNodes(void) const {
+  return mNodeByHandle.size() - mFreeHandles.size();
+}
+//-----------------------------------------------------------------------
+const AxisAlignedBox& TransformStore::getWorldBounds(Handle handle) const {
+  assert(handle < mNodeByHandle.size() && mNodeByHandle[handle]);
+  return mWorldBounds[mSlotByHandle[handle]];
+}
+//-----------------------------------------------------------------------
+void TransformStore::rebuild(void) {
+  std::vector<DepthEntry> order;
+  order.reserve(getNumNodes());
+
+  Handle numHandles = static_cast<Handle>(mNodeByHandle.size());
+  for (Handle h = 0; h < numHandles; ++h) {
+    SceneNode* node = mNodeByHandle[h];
+    if (!node) {
+      continue;
+    }
+    DepthEntry e;
+    e.depth = 0;
+    e.handle = h;
+    for (Node* p = node->getParent(); p; p = p->getParent()) {
+      ++e.depth;
+    }
+    order.push_back(e);
+  }
+  std::sort(order.begin(), order.end());
+
+  size_t count = order.size();
+  mNodes.resize(count);
+  mParents.resize(count);
+  mFlags.assign(count, DIRTY_TRANSFORM | DIRTY_BOUNDS);
+  mInheritScales.resize(count);
+  mLocalOrientations.resize(count);
+  mLocalPositions.resize(count);
+  mLocalScales.resize(count);
+  mDerivedOrientations.resize(count);
+  mDerivedPositions.resize(count);
+  mDerivedScales.resize(count);
+  mWorldBounds.resize(count);
+  mChildBounds.resize(count);
+
+  for (size_t slot = 0; slot < count; ++slot) {
+    Handle h = order[slot].handle;
+    SceneNode* node = mNodeByHandle[h];
+    mSlotByHandle[h] = slot;
+    mNodes[slot] = node;
+
+    // Parents are shallower, so they already have their new slot. A
+    // parent which isn't in this store is treated like no parent.
+    mParents[slot] = NO_PARENT;
+    SceneNode* parent = static_cast<SceneNode*>(node->getParent());
+    if (parent) {
+      Handle ph = parent->mTransformHandle;
+      if (ph < numHandles && mNodeByHandle[ph] == parent) {
+        mParents[slot] = mSlotByHandle[ph];
+      }
+    }
+  }
+
+  // All slots are dirty now
+  std::fill(mQueued.begin(), mQueued.end(), 0);
+  mDirtyList.clear();
+  mHierarchyChanged = false;
+}
+//-----------------------------------------------------------------------
+void TransformStore::update(void) {
+  size_t first;
+  if (mHierarchyChanged) {
+    rebuild();
+    first = 0;
+  } else {
+    if (mDirtyList.empty()) {
+      return;
+    }
+    // Nothing before the first dirty slot can be affected
+    first = mNodes.size();
+    std::vector<Handle>::iterator i, iend = mDirtyList.end();
+    for (i = mDirtyList.begin(); i != iend; ++i) {
+      size_t slot = mSlotByHandle[*i];
+      mQueued[*i] = 0;
+      mFlags[slot] |= DIRTY_TRANSFORM;
+      first = std::min(first, slot);
+    }
+    mDirtyList.clear();
+  }
+
+  size_t count = mNodes.size();
+  size_t i;
+
+  // Forward sweep over the transforms. A parent always comes before its
+  // children, so its derived transform is final by the time they read it,
+  // and its dirty flag has already been passed down.
+  for (i = first; i < count; ++i) {
+    size_t parent = mParents[i];
+    if (!(mFlags[i] & DIRTY_TRANSFORM)) {
+      if (parent == NO_PARENT || !(mFlags[parent] & DIRTY_TRANSFORM)) {
+        continue;
+      }
+      mFlags[i] |= DIRTY_TRANSFORM;
+    }
+
+    SceneNode* node = mNodes[i];
+    mLocalOrientations[i] = node->mOrientation;
+    mLocalPositions[i] = node->mPosition;
+    mLocalScales[i] = node->mScale;
+    mInheritScales[i] = node->mInheritScale;
+
+    // Same as Node::_updateFromParent
+    if (parent != NO_PARENT) {
+      const Quaternion& parentQ = mDerivedOrientations[parent];
+      mDerivedOrientations[i] = parentQ * mLocalOrientations[i];
+      Vector3 pos = parentQ * mLocalPositions[i];
+      if (mInheritScales[i]) {
+        pos = pos * mDerivedScales[parent];
+        mDerivedScales[i] = mLocalScales[i] * mDerivedScales[parent];
+      } else {
+        mDerivedScales[i] = mLocalScales[i];
+      }
+      mDerivedPositions[i] = pos + mDerivedPositions[parent];
+    } else {
+      mDerivedOrientations[i] = mLocalOrientations[i];
+      mDerivedPositions[i] = mLocalPositions[i];
+      mDerivedScales[i] = mLocalScales[i];
+    }
+
+    node->mDerivedOrientation = mDerivedOrientations[i];
+    node->mDerivedPosition = mDerivedPositions[i];
+    node->mDerivedScale = mDerivedScales[i];
+    node->mCachedTransformOutOfDate = true;
+    node->mNeedParentUpdate = false;
+    node->mNeedChildUpdate = false;
+
+    mFlags[i] |= DIRTY_BOUNDS;
+  }
+
+  // Pass the bounds flag up to the ancestors. Walking backwards, every
+  // child of a slot has been seen by the time we reach it, so its flag is
+  // final and its children's merged bounds can be reset.
+  for (i = count; i-- > 0; ) {
+    if (mFlags[i] & DIRTY_BOUNDS) {
+      mChildBounds[i].setNull();
+      if (mParents[i] != NO_PARENT) {
+        mFlags[mParents[i]] |= DIRTY_BOUNDS;
+      }
+    }
+  }
+
+  // Backward sweep over the bounds; children merge into their parent
+  // before the parent itself is reached
+  for (i = count; i-- > 0; ) {
+    if (mFlags[i] & DIRTY_BOUNDS) {
+      SceneNode* node = mNodes[i];
+      AxisAlignedBox& bounds = mWorldBounds[i];
+      bounds = mChildBounds[i];
+
+      SceneNode::ObjectMap::iterator o, oend = node->mObjectsByName.end();
+      for (o = node->mObjectsByName.begin(); o != oend; ++o) {
+        bounds.merge(o->second->getWorldBoundingBox(true));
+      }
+      node->mWorldAABB = bounds;
+      mFlags[i] = 0;
+    }
+
+    size_t parent = mParents[i];
+    if (parent != NO_PARENT && (mFlags[parent] & DIRTY_BOUNDS)) {
+      mChildBounds[parent].merge(mWorldBounds[i]);
+    }
+  }
+}
+
+}
@@ -0,0 +1,606 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#include "VertexInfluenceStream.h"
+
+#include "Exception.h"
+#include "Matrix4.h"
+#include "MyMath.h"
+#include "SIMDHelper.h"
+#include "Skeleton.h"
+#include "Vector3.h"
+#include "WorkQueue.h"
+
+namespace renderer {
+namespace {
+/// Converts a quantised weight back to 0..1
+const Real WEIGHT_SCALE = 1.0f / 65535.0f;
+/// Meshes with fewer vertices than this are never split across threads
+const size_t PARALLEL_VERTEX_THRESHOLD = 2048;
+/// Smallest share of a mesh given to one task
+const size_t MIN_BLOCKS_PER_TASK = 256;
+/// Most tasks one mesh is split into
+const size_t MAX_SKIN_TASKS = 16;
+
+/** Picks the heaviest influences of one vertex and quantises their weights.
+    @returns The number of influences written
+*/
+size_t compactVertex(const RenderOperation::VertexBlendData* pSrc,
+                     unsigned short count, unsigned char* pIndex,
+                     unsigned short* pWeight) {
+  RenderOperation::VertexBlendData best[VertexInfluenceStream::MAX_INFLUENCES];
+  size_t numBest = 0;
+
+  for (unsigned short i = 0; i < count; ++i) {
+    if (pSrc[i].blendWeight <= 0)
+      continue;
+    if (pSrc[i].matrixIndex >= OGRE_MAX_NUM_BONES) {
+      Except(Exception::ERR_INVALIDPARAMS, "Bone index out of range",
+             "VertexInfluenceStream::VertexInfluenceStream");
+    }
+
+    // Insertion into the list, kept heaviest first
+    size_t pos = numBest;
+    while (pos > 0 && best[pos - 1].blendWeight < pSrc[i].blendWeight)
+      --pos;
+    if (pos == VertexInfluenceStream::MAX_INFLUENCES)
+      continue;
+    if (numBest < VertexInfluenceStream::MAX_INFLUENCES)
+      ++numBest;
+    for (size_t j = numBest - 1; j > pos; --j)
+      best[j] = best[j - 1];
+    best[pos] = pSrc[i];
+  }
+
+  if (numBest == 0) {
+    // Unassigned vertex; let it follow the root bone rather than
+    // collapsing to the origin
+    pIndex[0] = 0;
+    pWeight[0] = 65535;
+    return 1;
+  }
+
+  Real total = 0;
+  size_t i;
+  for (i = 0; i < numBest; ++i)
+    total += best[i].blendWeight;
+
+  // Quantise, then give the rounding error to the heaviest weight so
+  // the sum is exact
+  int sum = 0;
+  for (i = 0; i < numBest; ++i) {
+    int q = (int)(best[i].blendWeight / total * 65535.0f + 0.5f);
+    pIndex[i] = (unsigned char)best[i].matrixIndex;
+    pWeight[i] = (unsigned short)q;
+    sum += q;
+  }
+  pWeight[0] = (unsigned short)(pWeight[0] + (65535 - sum));
+
+  return numBest;
+}
+
+/// Skins one range of blocks of a stream
+class SkinTask : public WorkQueue::Task {
+public:
+  void run(void) {
+    if (pDualQuats) {
+      stream->skinBlocksDualQuaternion(firstBlock, endBlock, pDualQuats,
+                                       pSrcPos, srcPosStride, pSrcNorm, srcNormStride,
+                                       pDestPos, pDestNorm);
+    } else {
+      stream->skinBlocks(firstBlock, endBlock, pMatrices,
+                         pSrcPos, srcPosStride, pSrcNorm, srcNormStride,
+                         pDestPos, pDestNorm);
+    }
+  }
+
+  const VertexInfluenceStream* stream;
+  size_t firstBlock, endBlock;
+  const Matrix4* pMatrices;
+  const Real* pDualQuats;
+  const Real* pSrcPos;
+  unsigned short srcPosStride;
+  const Real* pSrcNorm;
+  unsigned short srcNormStride;
+  Real* pDestPos;
+  Real* pDestNorm;
+};
+
+#if OGRE_HAVE_SSE
+/// Stores the x, y and z lanes of v
+FORCEINLINE void storeXYZ(Real* p, __m128 v) {
+  _mm_storel_pi((__m64*)p, v);
+  _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+}
+#endif
+}
+//-----------------------------------------------------------------------
+VertexInfluenceStream::VertexInfluenceStream(
+  const RenderOperation::VertexBlendData* pBlend,
+  unsigned short numWeightsPerVertex, size_t numVertices)
+  : mNumVertices(numVertices) {
+  size_t numBlocks = getNumBlocks();
+  mBlockStart.reserve(numBlocks + 1);
+  // Most vertices have 1 or 2 influences
+  mIndices.reserve(numBlocks * BLOCK_SIZE * 2);
+  mWeights.reserve(numBlocks * BLOCK_SIZE * 2);
+
+  unsigned char index[BLOCK_SIZE][MAX_INFLUENCES];
+  unsigned short weight[BLOCK_SIZE][MAX_INFLUENCES];
+
+  for (size_t block = 0; block < numBlocks; ++block) {
+    mBlockStart.push_back((unsigned int)(mIndices.size() / BLOCK_SIZE));
+
+    memset(index, 0, sizeof(index));
+    memset(weight, 0, sizeof(weight));
+
+    size_t numSlots = 0;
+    for (size_t lane = 0; lane < BLOCK_SIZE; ++lane) {
+      size_t v = block * BLOCK_SIZE + lane;
+      if (v >= numVertices)
+        break;
+      size_t n = compactVertex(pBlend + v * numWeightsPerVertex,
+                               numWeightsPerVertex, index[lane], weight[lane]);
+      if (n > numSlots)
+        numSlots = n;
+    }
+
+    // Lanes with fewer influences are padded with zero weights
+    for (size_t slot = 0; slot < numSlots; ++slot) {
+      for (size_t lane = 0; lane < BLOCK_SIZE; ++lane) {
+        mIndices.push_back(index[lane][slot]);
+        mWeights.push_back(weight[lane][slot]);
+      }
+    }
+  }
+  mBlockStart.push_back((unsigned int)(mIndices.size() / BLOCK_SIZE));
+}
+//-----------------------------------------------------------------------
+size_t VertexInfluenceStream::getNumVertices(void) const {
+  return mNumVertices;
+}
+//-----------------------------------------------------------------------
+size_t VertexInfluenceStream::getNumBlocks(void) const {
+  return (mNumVertices + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
+//-----------------------------------------------------------------------
+void VertexInfluenceStream::skin(const Matrix4* pMatrices,
+                                 const Real* pSrcPos, unsigned short srcPosStride,
+                                 const Real* pSrcNorm, unsigned short srcNormStride,
+                                 Real* pDestPos, Real* pDestNorm) const {
+  dispatch(pMatrices, 0, pSrcPos, srcPosStride, pSrcNorm, srcNormStride,
+           pDestPos, pDestNorm);
+}
+//-----------------------------------------------------------------------
+void VertexInfluenceStream::skinDualQuaternion(const Real* pDualQuats,
+    const Real* pSrcPos, unsigned short srcPosStride,
+    const Real* pSrcNorm, unsigned short srcNormStride,
+    Real* pDestPos, Real* pDestNorm) const {
+  dispatch(0, pDualQuats, pSrcPos, srcPosStride, pSrcNorm, srcNormStride,
+           pDestPos, pDestNorm);
+}
+//-----------------------------------------------------------------------
+void VertexInfluenceStream::dispatch(const Matrix4* pMatrices, const Real* pDualQuats,
+                                     const Real* pSrcPos, unsigned short srcPosStride,
+                                     const Real* pSrcNorm, unsigned short srcNormStride,
+                                     Real* pDestPos, Real* pDestNorm) const {
+  size_t numBlocks = getNumBlocks();
+  size_t numTasks = 1;
+
+  WorkQueue* queue = WorkQueue::getSingletonPtr();
+  if (queue && mNumVertices >= PARALLEL_VERTEX_THRESHOLD) {
+    numTasks = std::min(queue->getNumWorkers() + 1, MAX_SKIN_TASKS);
+    numTasks = std::min(numTasks, numBlocks / MIN_BLOCKS_PER_TASK);
+  }
+
+  if (numTasks <= 1) {
+    if (pDualQuats) {
+      skinBlocksDualQuaternion(0, numBlocks, pDualQuats, pSrcPos, srcPosStride,
+                               pSrcNorm, srcNormStride, pDestPos, pDestNorm);
+    } else {
+      skinBlocks(0, numBlocks, pMatrices, pSrcPos, srcPosStride,
+                 pSrcNorm, srcNormStride, pDestPos, pDestNorm);
+    }
+    return;
+  }
+
+  SkinTask tasks[MAX_SKIN_TASKS];
+  WorkQueue::Task* taskList[MAX_SKIN_TASKS];
+  size_t blocksPerTask = (numBlocks + numTasks - 1) / numTasks;
+  size_t t;
+  for (t = 0; t < numTasks; ++t) {
+    SkinTask& task = tasks[t];
+    task.stream = this;
+    task.firstBlock = t * blocksPerTask;
+    task.endBlock = std::min(numBlocks, task.firstBlock + blocksPerTask);
+    task.pMatrices = pMatrices;
+    task.pDualQuats = pDualQuats;
+    task.pSrcPos = pSrcPos;
+    task.srcPosStride = srcPosStride;
+    task.pSrcNorm = pSrcNorm;
+    task.srcNormStride = srcNormStride;
+    task.pDestPos = pDestPos;
+    task.pDestNorm = pDestNorm;
+    taskList[t] = &task;
+  }
+
+  queue->runAndWait(taskList, numTasks);
+}
+//-----------------------------------------------------------------------
+void VertexInfluenceStream::skinBlocks(size_t firstBlock, size_t endBlock,
+                                       const Matrix4* pMatrices,
+                                       const Real* pSrcPos, unsigned short srcPosStride,
+                                       const Real* pSrcNorm, unsigned short srcNormStride,
+                                       Real* pDestPos, Real* pDestNorm) const {
+  size_t firstVert = firstBlock * BLOCK_SIZE;
+  size_t posStep = sizeof(Real) * 3 + srcPosStride;
+  size_t normStep = sizeof(Real) * 3 + srcNormStride;
+  const unsigned char* pSrcPosBytes =
+    reinterpret_cast<const unsigned char*>(pSrcPos) + firstVert * posStep;
+  const unsigned char* pSrcNormBytes = pSrcNorm ?
+    reinterpret_cast<const unsigned char*>(pSrcNorm) + firstVert * normStep : 0;
+  Real* pOutPos = pDestPos + firstVert * 3;
+  Real* pOutNorm = pSrcNorm ? pDestNorm + firstVert * 3 : 0;
+
+  for (size_t block = firstBlock; block < endBlock; ++block) {
+    const unsigned int slotBegin = mBlockStart[block];
+    const unsigned int slotEnd = mBlockStart[block + 1];
+    const size_t numLanes = std::min((size_t)BLOCK_SIZE,
+                                     mNumVertices - block * BLOCK_SIZE);
+
+#if OGRE_HAVE_SSE
+    __m128 pos[BLOCK_SIZE], norm[BLOCK_SIZE];
+    size_t lane;
+    for (lane = 0; lane < numLanes; ++lane) {
+      // Blend the top 3 rows of each influencing matrix
+      __m128 r0 = _mm_setzero_ps();
+      __m128 r1 = _mm_setzero_ps();
+      __m128 r2 = _mm_setzero_ps();
+      for (unsigned int slot = slotBegin; slot < slotEnd; ++slot) {
+        unsigned short w = mWeights[slot * BLOCK_SIZE + lane];
+        // Influences are heaviest first, the rest is padding
+        if (w == 0)
+          break;
+        const Matrix4& m = pMatrices[mIndices[slot * BLOCK_SIZE + lane]];
+        __m128 vw = _mm_set1_ps(w * WEIGHT_SCALE);
+        r0 = sse_madd(_mm_loadu_ps(m[0]), vw, r0);
+        r1 = sse_madd(_mm_loadu_ps(m[1]), vw, r1);
+        r2 = sse_madd(_mm_loadu_ps(m[2]), vw, r2);
+      }
+      // Turn the rows into columns, so each vertex is a sum of scaled columns
+      __m128 r3 = _mm_setzero_ps();
+      _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+      const Real* p = reinterpret_cast<const Real*>(pSrcPosBytes);
+      pos[lane] = sse_madd(r0, _mm_load1_ps(p),
+                           sse_madd(r1, _mm_load1_ps(p + 1),
+                                    sse_madd(r2, _mm_load1_ps(p + 2), r3)));
+      pSrcPosBytes += posStep;
+
+      if (pSrcNormBytes) {
+        const Real* n = reinterpret_cast<const Real*>(pSrcNormBytes);
+        norm[lane] = sse_madd(r0, _mm_load1_ps(n),
+                              sse_madd(r1, _mm_load1_ps(n + 1),
+                                       _mm_mul_ps(r2, _mm_load1_ps(n + 2))));
+        pSrcNormBytes += normStep;
+      }
+    }
+
+    for (lane = 0; lane < numLanes; ++lane) {
+      storeXYZ(pOutPos, pos[lane]);
+      pOutPos += 3;
+    }
+
+    if (pSrcNormBytes) {
+      // Keep the unused lanes of a partial block well defined
+      for (lane = numLanes; lane < BLOCK_SIZE; ++lane)
+        norm[lane] = _mm_set1_ps(1.0f);
+
+      // Renormalise all four normals at once, structure of arrays
+      __m128 x = norm[0], y = norm[1], z = norm[2], w = norm[3];
+      _MM_TRANSPOSE4_PS(x, y, z, w);
+      __m128 len2 = sse_madd(x, x, sse_madd(y, y, _mm_mul_ps(z, z)));
+      __m128 inv = sse_rsqrt_nr(_mm_max_ps(len2, _mm_set1_ps(1e-20f)));
+      x = _mm_mul_ps(x, inv);
+      y = _mm_mul_ps(y, inv);
+      z = _mm_mul_ps(z, inv);
+      _MM_TRANSPOSE4_PS(x, y, z, w);
+      norm[0] = x;
+      norm[1] = y;
+      norm[2] = z;
+      norm[3] = w;
+
+      for (lane = 0; lane < numLanes; ++lane) {
+        storeXYZ(pOutNorm, norm[lane]);
+        pOutNorm += 3;
+      }
+    }
+#else
+    for (size_t lane = 0; lane < numLanes; ++lane) {
+      // Blend the top 3 rows of each influencing matrix
+      Real r[3][4] = { { 0 } };
+      for (unsigned int slot = slotBegin; slot < slotEnd; ++slot) {
+        unsigned short w = mWeights[slot * BLOCK_SIZE + lane];
+        // Influences are heaviest first, the rest is padding
+        if (w == 0)
+          break;
+        const Matrix4& m = pMatrices[mIndices[slot * BLOCK_SIZE + lane]];
+        Real fw = w * WEIGHT_SCALE;
+        for (int row = 0; row < 3; ++row) {
+          r[row][0] += m[row][0] * fw;
+          r[row][1] += m[row][1] * fw;
+          r[row][2] += m[row][2] * fw;
+          r[row][3] += m[row][3] * fw;
+        }
+      }
+
+      const Real* p = reinterpret_cast<const Real*>(pSrcPosBytes);
+      for (int row = 0; row < 3; ++row)
+        pOutPos[row] = r[row][0] * p[0] + r[row][1] * p[1] + r[row][2] * p[2] + r[row][3];
+      pOutPos += 3;
+      pSrcPosBytes += posStep;
+
+      if (pSrcNormBytes) {
+        const Real* n = reinterpret_cast<const Real*>(pSrcNormBytes);
+        Real out[3];
+        for (int row = 0; row < 3; ++row)
+          out[row] = r[row][0] * n[0] + r[row][1] * n[1] + r[row][2] * n[2];
+        Real len2 = out[0] * out[0] + out[1] * out[1] + out[2] * out[2];
+        Real inv = len2 > 1e-20f ? Math::InvSqrt(len2) : 0;
+        pOutNorm[0] = out[0] * inv;
+        pOutNorm[1] = out[1] * inv;
+        pOutNorm[2] = out[2] * inv;
+        pOutNorm += 3;
+        pSrcNormBytes += normStep;
+      }
+    }
+#endif
+  }
+}
+//-----------------------------------------------------------------------
+void VertexInfluenceStream::skinBlocksDualQuaternion(size_t firstBlock, size_t endBlock,
+    const Real* pDualQuats,
+    const Real* pSrcPos, unsigned short srcPosStride,
+    const Real* pSrcNorm, unsigned short srcNormStride,
+    Real* pDestPos, Real* pDestNorm) const {
+  /*
+    Each bone is a unit dual quaternion q + e*d, stored qx qy qz qw dx dy dz dw.
+    Per vertex the weighted sum is normalised by |q|, then applied as
+      p' = p + 2 q.xyz x (q.xyz x p + q.w p) + 2 (q.w d.xyz - d.w q.xyz + q.xyz x d.xyz)
+      n' = n + 2 q.xyz x (q.xyz x n + q.w n)
+    Quaternions in the opposite hemisphere to the heaviest influence are
+    negated first, so the blend takes the short way round.
+  */
+  size_t firstVert = firstBlock * BLOCK_SIZE;
+  size_t posStep = sizeof(Real) * 3 + srcPosStride;
+  size_t normStep = sizeof(Real) * 3 + srcNormStride;
+  const unsigned char* pSrcPosBytes =
+    reinterpret_cast<const unsigned char*>(pSrcPos) + firstVert * posStep;
+  const unsigned char* pSrcNormBytes = pSrcNorm ?
+    reinterpret_cast<const unsigned char*>(pSrcNorm) + firstVert * normStep : 0;
+  Real* pOutPos = pDestPos + firstVert * 3;
+  Real* pOutNorm = pSrcNorm ? pDestNorm + firstVert * 3 : 0;
+
+  for (size_t block = firstBlock; block < endBlock; ++block) {
+    const unsigned int slotBegin = mBlockStart[block];
+    const unsigned int slotEnd = mBlockStart[block + 1];
+    const size_t numLanes = std::min((size_t)BLOCK_SIZE,
+                                     mNumVertices - block * BLOCK_SIZE);
+    size_t lane;
+
+#if OGRE_HAVE_SSE
+    // Blend the four lanes' dual quaternions side by side
+    __m128 qx = _mm_setzero_ps(), qy = _mm_setzero_ps();
+    __m128 qz = _mm_setzero_ps(), qw = _mm_setzero_ps();
+    __m128 dx = _mm_setzero_ps(), dy = _mm_setzero_ps();
+    __m128 dz = _mm_setzero_ps(), dw = _mm_setzero_ps();
+    __m128 pivotX, pivotY, pivotZ, pivotW;
+
+    for (unsigned int slot = slotBegin; slot < slotEnd; ++slot) {
+      const unsigned char* pIndex = &mIndices[slot * BLOCK_SIZE];
+      const unsigned short* pWeight = &mWeights[slot * BLOCK_SIZE];
+      const Real* dq0 = pDualQuats + pIndex[0] * 8;
+      const Real* dq1 = pDualQuats + pIndex[1] * 8;
+      const Real* dq2 = pDualQuats + pIndex[2] * 8;
+      const Real* dq3 = pDualQuats + pIndex[3] * 8;
+
+      __m128 bx = _mm_loadu_ps(dq0), by = _mm_loadu_ps(dq1);
+      __m128 bz = _mm_loadu_ps(dq2), bw = _mm_loadu_ps(dq3);
+      _MM_TRANSPOSE4_PS(bx, by, bz, bw);
+      __m128 ex = _mm_loadu_ps(dq0 + 4), ey = _mm_loadu_ps(dq1 + 4);
+      __m128 ez = _mm_loadu_ps(dq2 + 4), ew = _mm_loadu_ps(dq3 + 4);
+      _MM_TRANSPOSE4_PS(ex, ey, ez, ew);
+
+      if (slot == slotBegin) {
+        pivotX = bx;
+        pivotY = by;
+        pivotZ = bz;
+        pivotW = bw;
+      }
+
+      __m128 w = _mm_mul_ps(
+                   _mm_set_ps(pWeight[3], pWeight[2], pWeight[1], pWeight[0]),
+                   _mm_set1_ps(WEIGHT_SCALE));
+      __m128 dot = sse_madd(bx, pivotX, sse_madd(by, pivotY,
+                            sse_madd(bz, pivotZ, _mm_mul_ps(bw, pivotW))));
+      // Flip the weight's sign where the bone is in the other hemisphere
+      w = _mm_xor_ps(w, sse_signbit(dot));
+
+      qx = sse_madd(bx, w, qx);
+      qy = sse_madd(by, w, qy);
+      qz = sse_madd(bz, w, qz);
+      qw = sse_madd(bw, w, qw);
+      dx = sse_madd(ex, w, dx);
+      dy = sse_madd(ey, w, dy);
+      dz = sse_madd(ez, w, dz);
+      dw = sse_madd(ew, w, dw);
+    }
+
+    // Normalise
+    __m128 len2 = sse_madd(qx, qx, sse_madd(qy, qy, sse_madd(qz, qz, _mm_mul_ps(qw, qw))));
+    __m128 inv = sse_rsqrt_nr(_mm_max_ps(len2, _mm_set1_ps(1e-20f)));
+    qx = _mm_mul_ps(qx, inv);
+    qy = _mm_mul_ps(qy, inv);
+    qz = _mm_mul_ps(qz, inv);
+    qw = _mm_mul_ps(qw, inv);
+    dx = _mm_mul_ps(dx, inv);
+    dy = _mm_mul_ps(dy, inv);
+    dz = _mm_mul_ps(dz, inv);
+    dw = _mm_mul_ps(dw, inv);
+
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    // Translation: 2 (q.w d.xyz - d.w q.xyz + q.xyz x d.xyz)
+    __m128 tx = _mm_mul_ps(two, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(qw, dx), _mm_mul_ps(dw, qx)),
+                                           _mm_sub_ps(_mm_mul_ps(qy, dz), _mm_mul_ps(qz, dy))));
+    __m128 ty = _mm_mul_ps(two, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(qw, dy), _mm_mul_ps(dw, qy)),
+                                           _mm_sub_ps(_mm_mul_ps(qz, dx), _mm_mul_ps(qx, dz))));
+    __m128 tz = _mm_mul_ps(two, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(qw, dz), _mm_mul_ps(dw, qz)),
+                                           _mm_sub_ps(_mm_mul_ps(qx, dy), _mm_mul_ps(qy, dx))));
+
+    // Gather the block's positions into SoA form
+    OGRE_ALIGN16_DECL(Real, px[BLOCK_SIZE]);
+    OGRE_ALIGN16_DECL(Real, py[BLOCK_SIZE]);
+    OGRE_ALIGN16_DECL(Real, pz[BLOCK_SIZE]);
+    for (lane = 0; lane < BLOCK_SIZE; ++lane) {
+      if (lane < numLanes) {
+        const Real* p = reinterpret_cast<const Real*>(pSrcPosBytes);
+        px[lane] = p[0];
+        py[lane] = p[1];
+        pz[lane] = p[2];
+        pSrcPosBytes += posStep;
+      } else {
+        px[lane] = py[lane] = pz[lane] = 0;
+      }
+    }
+    __m128 vx = _mm_load_ps(px), vy = _mm_load_ps(py), vz = _mm_load_ps(pz);
+
+    // Rotate: v + 2 q.xyz x (q.xyz x v + q.w v)
+    __m128 cx = sse_madd(qw, vx, _mm_sub_ps(_mm_mul_ps(qy, vz), _mm_mul_ps(qz, vy)));
+    __m128 cy = sse_madd(qw, vy, _mm_sub_ps(_mm_mul_ps(qz, vx), _mm_mul_ps(qx, vz)));
+    __m128 cz = sse_madd(qw, vz, _mm_sub_ps(_mm_mul_ps(qx, vy), _mm_mul_ps(qy, vx)));
+    vx = _mm_add_ps(sse_madd(two, _mm_sub_ps(_mm_mul_ps(qy, cz), _mm_mul_ps(qz, cy)), vx), tx);
+    vy = _mm_add_ps(sse_madd(two, _mm_sub_ps(_mm_mul_ps(qz, cx), _mm_mul_ps(qx, cz)), vy), ty);
+    vz = _mm_add_ps(sse_madd(two, _mm_sub_ps(_mm_mul_ps(qx, cy), _mm_mul_ps(qy, cx)), vz), tz);
+
+    _mm_store_ps(px, vx);
+    _mm_store_ps(py, vy);
+    _mm_store_ps(pz, vz);
+    for (lane = 0; lane < numLanes; ++lane) {
+      pOutPos[0] = px[lane];
+      pOutPos[1] = py[lane];
+      pOutPos[2] = pz[lane];
+      pOutPos += 3;
+    }
+
+    if (pSrcNormBytes) {
+      for (lane = 0; lane < BLOCK_SIZE; ++lane) {
+        if (lane < numLanes) {
+          const Real* n = reinterpret_cast<const Real*>(pSrcNormBytes);
+          px[lane] = n[0];
+          py[lane] = n[1];
+          pz[lane] = n[2];
+          pSrcNormBytes += normStep;
+        } else {
+          px[lane] = py[lane] = pz[lane] = 0;
+        }
+      }
+      vx = _mm_load_ps(px);
+      vy = _mm_load_ps(py);
+      vz = _mm_load_ps(pz);
+
+      cx = sse_madd(qw, vx, _mm_sub_ps(_mm_mul_ps(qy, vz), _mm_mul_ps(qz, vy)));
+      cy = sse_madd(qw, vy, _mm_sub_ps(_mm_mul_ps(qz, vx), _mm_mul_ps(qx, vz)));
+      cz = sse_madd(qw, vz, _mm_sub_ps(_mm_mul_ps(qx, vy), _mm_mul_ps(qy, vx)));
+      vx = sse_madd(two, _mm_sub_ps(_mm_mul_ps(qy, cz), _mm_mul_ps(qz, cy)), vx);
+      vy = sse_madd(two, _mm_sub_ps(_mm_mul_ps(qz, cx), _mm_mul_ps(qx, cz)), vy);
+      vz = sse_madd(two, _mm_sub_ps(_mm_mul_ps(qx, cy), _mm_mul_ps(qy, cx)), vz);
+
+      _mm_store_ps(px, vx);
+      _mm_store_ps(py, vy);
+      _mm_store_ps(pz, vz);
+      for (lane = 0; lane < numLanes; ++lane) {
+        pOutNorm[0] = px[lane];
+        pOutNorm[1] = py[lane];
+        pOutNorm[2] = pz[lane];
+        pOutNorm += 3;
+      }
+    }
+#else
+    for (lane = 0; lane < numLanes; ++lane) {
+      Real q[4] = { 0, 0, 0, 0 };
+      Real d[4] = { 0, 0, 0, 0 };
+      const Real* pivot = 0;
+      for (unsigned int slot = slotBegin; slot < slotEnd; ++slot) {
+        unsigned short w = mWeights[slot * BLOCK_SIZE + lane];
+        // Influences are heaviest first, the rest is padding
+        if (w == 0)
+          break;
+        const Real* dq = pDualQuats + mIndices[slot * BLOCK_SIZE + lane] * 8;
+        if (!pivot)
+          pivot = dq;
+        Real fw = w * WEIGHT_SCALE;
+        if (dq[0] * pivot[0] + dq[1] * pivot[1] + dq[2] * pivot[2] + dq[3] * pivot[3] < 0)
+          fw = -fw;
+        for (int c = 0; c < 4; ++c) {
+          q[c] += dq[c] * fw;
+          d[c] += dq[c + 4] * fw;
+        }
+      }
+
+      Real len2 = q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3];
+      Real inv = len2 > 1e-20f ? Math::InvSqrt(len2) : 0;
+      for (int c = 0; c < 4; ++c) {
+        q[c] *= inv;
+        d[c] *= inv;
+      }
+
+      Vector3 axis(q[0], q[1], q[2]);
+      Vector3 dual(d[0], d[1], d[2]);
+      Vector3 trans = 2.0f * (q[3] * dual - d[3] * axis + axis.crossProduct(dual));
+
+      const Real* p = reinterpret_cast<const Real*>(pSrcPosBytes);
+      Vector3 v(p[0], p[1], p[2]);
+      v += 2.0f * axis.crossProduct(axis.crossProduct(v) + q[3] * v) + trans;
+      pOutPos[0] = v.x;
+      pOutPos[1] = v.y;
+      pOutPos[2] = v.z;
+      pOutPos += 3;
+      pSrcPosBytes += posStep;
+
+      if (pSrcNormBytes) {
+        const Real* n = reinterpret_cast<const Real*>(pSrcNormBytes);
+        Vector3 nv(n[0], n[1], n[2]);
+        nv += 2.0f * axis.crossProduct(axis.crossProduct(nv) + q[3] * nv);
+        pOutNorm[0] = nv.x;
+        pOutNorm[1] = nv.y;
+        pOutNorm[2] = nv.z;
+        pOutNorm += 3;
+        pSrcNormBytes += normStep;
+      }
+    }
+#endif
+  }
+}
+}
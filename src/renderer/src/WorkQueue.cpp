@@ -0,0 +1,183 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+#include "WorkQueue.h"
+
+#include "base/sys_info.h"
+
+#include "LogManager.h"
+#include "StringConverter.h"
+
+namespace renderer {
+//-----------------------------------------------------------------------
+template<> WorkQueue* Singleton<WorkQueue>::ms_Singleton = 0;
+//-----------------------------------------------------------------------
+WorkQueue::WorkQueue(int numWorkers)
+  : mWorkAvailable(true, false), mShuttingDown(false) {
+  if (numWorkers < 0)
+    numWorkers = base::SysInfo::NumberOfProcessors() - 1;
+
+  for (int i = 0; i < numWorkers; ++i) {
+    Worker* w = new Worker(this);
+    if (!base::PlatformThread::Create(0, w, &w->mHandle)) {
+      delete w;
+      break;
+    }
+    mWorkers.push_back(w);
+  }
+
+  LogManager::getSingleton().logMessage(
+    "WorkQueue started with " +
+    StringConverter::toString((int)mWorkers.size()) + " worker threads.");
+}
+//-----------------------------------------------------------------------
+WorkQueue::~WorkQueue() {
+  {
+    base::AutoLock l(mLock);
+    mShuttingDown = true;
+    mWorkAvailable.Signal();
+  }
+
+  std::vector<Worker*>::iterator i;
+  for (i = mWorkers.begin(); i != mWorkers.end(); ++i) {
+    base::PlatformThread::Join((*i)->mHandle);
+    delete *i;
+  }
+  mWorkers.clear();
+}
+//-----------------------------------------------------------------------
+void WorkQueue::addTask(Task* task) {
+  if (mWorkers.empty()) {
+    task->run();
+    return;
+  }
+
+  Entry e;
+  e.task = task;
+  e.batch = 0;
+
+  base::AutoLock l(mLock);
+  push(e);
+}
+//-----------------------------------------------------------------------
+void WorkQueue::addBackgroundTask(Task* task) {
+  if (mWorkers.empty()) {
+    task->run();
+    return;
+  }
+
+  base::AutoLock l(mLock);
+  mBackgroundEntries.push_back(task);
+  mWorkAvailable.Signal();
+}
+//-----------------------------------------------------------------------
+void WorkQueue::runAndWait(Task** tasks, size_t count) {
+  if (count == 0)
+    return;
+
+  // Nothing to gain from queueing a single task, or with no workers
+  if (count == 1 || mWorkers.empty()) {
+    for (size_t i = 0; i < count; ++i)
+      tasks[i]->run();
+    return;
+  }
+
+  Batch batch;
+  {
+    base::AutoLock l(mLock);
+    batch.pending = count;
+    for (size_t i = 0; i < count; ++i) {
+      Entry e;
+      e.task = tasks[i];
+      e.batch = &batch;
+      push(e);
+    }
+  }
+
+  // Help out rather than block, then wait for whatever the workers still
+  // have in flight
+  while (runOne(false))
+    ;
+  batch.done.Wait();
+
+  // The batch is signalled under the lock; taking it here makes sure the
+  // signalling thread is finished with the batch before it goes away
+  base::AutoLock l(mLock);
+}
+//-----------------------------------------------------------------------
+size_t WorkQueue::getNumWorkers(void) const {
+  return mWorkers.size();
+}
+//-----------------------------------------------------------------------
+void WorkQueue::push(const Entry& e) {
+  // Lock must be held
+  mEntries.push_back(e);
+  mWorkAvailable.Signal();
+}
+//-----------------------------------------------------------------------
+bool WorkQueue::runOne(bool background) {
+  Entry e;
+  {
+    base::AutoLock l(mLock);
+    if (!mEntries.empty()) {
+      e = mEntries.front();
+      mEntries.pop_front();
+    } else if (background && !mBackgroundEntries.empty()) {
+      e.task = mBackgroundEntries.front();
+      e.batch = 0;
+      mBackgroundEntries.pop_front();
+    } else {
+      // Keep the event set once shutting down so every worker wakes up,
+      // and while there is background work for the workers
+      if (!mShuttingDown && mBackgroundEntries.empty())
+        mWorkAvailable.Reset();
+      return false;
+    }
+  }
+
+  e.task->run();
+
+  if (e.batch) {
+    base::AutoLock l(mLock);
+    if (--e.batch->pending == 0)
+      e.batch->done.Signal();
+  }
+  return true;
+}
+//-----------------------------------------------------------------------
+void WorkQueue::Worker::ThreadMain() {
+  for (;;) {
+    mQueue->mWorkAvailable.Wait();
+    if (!mQueue->runOne(true)) {
+      base::AutoLock l(mQueue->mLock);
+      if (mQueue->mShuttingDown)
+        return;
+    }
+  }
+}
+//-----------------------------------------------------------------------
+WorkQueue& WorkQueue::getSingleton(void) {
+  return Singleton<WorkQueue>::getSingleton();
+}
+}
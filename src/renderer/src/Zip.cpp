@@ -28,52 +28,164 @@ http://www.gnu.org/copyleft/lesser.txt.
 #include "ArchiveManager.h"
 #include "LogManager.h"
 #include "Exception.h"
+#include "SDDataChunk.h"
 #include "ZipArchiveFactory.h"
 #include "StringVector.h"
 #include "Root.h"
 
+#include "zlib.h"
+
 namespace renderer {
 
-//-----------------------------------------------------------------------
-bool Zip::fileOpen( const String& strFile, FILE** ppFile ) const {
-  unz_file_info tagUFI;
-  FILE *pFile;
-
-  if( unzLocateFile( mArchive, strFile.c_str(), 2 ) == UNZ_OK ) {
-    //*ppFile = tmpfile();
-    pFile = *ppFile;
-
-    unzGetCurrentFileInfo( mArchive, &tagUFI, NULL, 0, NULL, 0, NULL, 0 );
-    unsigned char* pBuffer = new unsigned char[tagUFI.uncompressed_size];
-    unzOpenCurrentFile( mArchive );
-    unzReadCurrentFile( mArchive, (void*)pBuffer, tagUFI.uncompressed_size );
-    unzCloseCurrentFile( mArchive );
-    fwrite( (void*) pBuffer, 1, tagUFI.uncompressed_size, pFile );
-    delete[] pBuffer;
-
-    fseek( pFile, 0, SEEK_SET );
-    return true;
+namespace {
+// Record signatures and sizes, from the PKWARE application note
+const ulong LOCAL_HEADER_SIGNATURE = 0x04034b50;
+const ulong CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+const ulong END_RECORD_SIGNATURE = 0x06054b50;
+const size_t LOCAL_HEADER_SIZE = 30;
+const size_t CENTRAL_HEADER_SIZE = 46;
+const size_t END_RECORD_SIZE = 22;
+/// The end record may be followed by a comment of up to this many bytes
+const size_t MAX_COMMENT_SIZE = 0xFFFF;
+
+const ushort METHOD_STORED = 0;
+const ushort METHOD_DEFLATED = 8;
+
+/// Compressed bytes handed to zlib at a time, so huge entries never
+/// overflow its 32 bit counters
+const size_t INFLATE_CHUNK_SIZE = 1024 * 1024;
+
+ushort readShort(const uchar* p) {
+  return static_cast<ushort>(p[0] | (p[1] << 8));
+}
+
+ulong readLong(const uchar* p) {
+  return static_cast<ulong>(p[0]) | (static_cast<ulong>(p[1]) << 8) |
+         (static_cast<ulong>(p[2]) << 16) | (static_cast<ulong>(p[3]) << 24);
+}
+
+time_t dosToTime(ushort date, ushort time) {
+  struct tm tagTime;
+  memset(&tagTime, 0, sizeof(tagTime));
+  tagTime.tm_year = ((date >> 9) & 0x7F) + 80;
+  tagTime.tm_mon = ((date >> 5) & 0x0F) - 1;
+  tagTime.tm_mday = date & 0x1F;
+  tagTime.tm_hour = (time >> 11) & 0x1F;
+  tagTime.tm_min = (time >> 5) & 0x3F;
+  tagTime.tm_sec = (time & 0x1F) * 2;
+  tagTime.tm_isdst = -1;
+  return mktime(&tagTime);
+}
+
+/// Inflates raw deflate data; returns false if it is corrupt
+bool inflateData(const uchar* src, size_t srcSize, uchar* dest, size_t destSize) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // Negative window bits; zip entries have no zlib header
+  if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+    return false;
+
+  size_t written = 0;
+  int ret = Z_OK;
+  while (ret == Z_OK) {
+    if (stream.avail_in == 0 && srcSize > 0) {
+      size_t count = std::min(srcSize, INFLATE_CHUNK_SIZE);
+      stream.next_in = const_cast<Bytef*>(src);
+      stream.avail_in = static_cast<uInt>(count);
+      src += count;
+      srcSize -= count;
+    }
+    if (stream.avail_out == 0) {
+      size_t count = std::min(destSize - written, INFLATE_CHUNK_SIZE);
+      stream.next_out = dest + written;
+      stream.avail_out = static_cast<uInt>(count);
+      written += count;
+    }
+    // Stops with Z_BUF_ERROR if either side runs out early
+    ret = inflate(&stream, Z_NO_FLUSH);
   }
 
-  return false;
+  bool complete = ret == Z_STREAM_END &&
+                  written - stream.avail_out == destSize;
+  inflateEnd(&stream);
+  return complete;
+}
+}
+
+//-----------------------------------------------------------------------
+const Zip::Entry* Zip::findEntry( const String& strFile ) const {
+  EntryMap::const_iterator i = mEntries.find( StringToLowerASCII( strFile ) );
+  if( i == mEntries.end() )
+    return 0;
+  return &i->second;
+}
+
+//-----------------------------------------------------------------------
+const uchar* Zip::getEntryData( const Entry& entry ) const {
+  // The local header's extra field can differ from the central one's, so
+  // its length has to be read from here
+  const uchar* pBase = mFile->getPtr();
+  size_t size = mFile->getSize();
+  if( entry.offset + LOCAL_HEADER_SIZE > size ||
+      readLong( pBase + entry.offset ) != LOCAL_HEADER_SIGNATURE )
+    return 0;
+
+  const uchar* pHeader = pBase + entry.offset;
+  size_t dataOffset = entry.offset + LOCAL_HEADER_SIZE +
+                      readShort( pHeader + 26 ) + readShort( pHeader + 28 );
+  if( dataOffset + entry.compressedSize > size )
+    return 0;
+  return pBase + dataOffset;
+}
+
+//-----------------------------------------------------------------------
+bool Zip::fileOpen( const String& strFile, FILE** ppFile ) const {
+  SDDataChunk chunk;
+  DataChunk* pChunk = &chunk;
+  if( !fileRead( strFile, &pChunk ) )
+    return false;
+
+  FILE *pFile = *ppFile;
+  fwrite( (const void*)chunk.getPtr(), 1, chunk.getSize(), pFile );
+  fseek( pFile, 0, SEEK_SET );
+  return true;
 }
 
 //-----------------------------------------------------------------------
 bool Zip::fileRead( const String& strFile, DataChunk** ppChunk ) const {
+  const Entry* pEntry = findEntry( strFile );
+  if( !pEntry )
+    return false;
+
   DataChunk* pChunk = *ppChunk;
-  unz_file_info tagUFI;
+  const uchar* pData = getEntryData( *pEntry );
+  if( !pData )
+    Except( Exception::ERR_INTERNAL_ERROR, "Corrupt entry " + strFile + " in zip archive " + mName,
+            "Zip::fileRead" );
 
-  if( unzLocateFile( mArchive, strFile.c_str(), 2 ) == UNZ_OK ) {
-    unzGetCurrentFileInfo( mArchive, &tagUFI, NULL, 0, NULL, 0, NULL, 0 );
-    pChunk->allocate(tagUFI.uncompressed_size);
-    unzOpenCurrentFile( mArchive );
-    unzReadCurrentFile( mArchive, (void*)pChunk->getPtr(), tagUFI.uncompressed_size );
-    unzCloseCurrentFile( mArchive );
+  if( pEntry->uncompressedSize == 0 ) {
+    pChunk->clear();
+    return true;
+  }
 
+  if( pEntry->method == METHOD_STORED ) {
+    // Refer to the data in place
+    pChunk->map( mFile.get(), pData - mFile->getPtr(), pEntry->uncompressedSize );
     return true;
   }
 
-  return false;
+  if( pEntry->method != METHOD_DEFLATED )
+    Except( Exception::ERR_INVALIDPARAMS, "Unsupported compression method for " + strFile +
+            " in zip archive " + mName, "Zip::fileRead" );
+
+  pChunk->allocate( pEntry->uncompressedSize );
+  if( !inflateData( pData, pEntry->compressedSize, pChunk->getPtr(), pEntry->uncompressedSize ) ) {
+    pChunk->clear();
+    Except( Exception::ERR_INTERNAL_ERROR, "Corrupt entry " + strFile + " in zip archive " + mName,
+            "Zip::fileRead" );
+  }
+
+  return true;
 }
 
 //-----------------------------------------------------------------------
@@ -88,9 +200,7 @@ bool Zip::fileWrite( const DataChunk& refChunk, const String& strPath, bool bOve
 
 //-----------------------------------------------------------------------
 bool Zip::fileTest( const String& strFile ) const {
-  if( unzLocateFile( mArchive, strFile.c_str(), 2 ) == UNZ_OK )
-    return true;
-  return false;
+  return findEntry( strFile ) != 0;
 }
 
 //-----------------------------------------------------------------------
@@ -110,6 +220,17 @@ bool Zip::fileDele( const String& strFile ) {
 
 //-----------------------------------------------------------------------
 bool Zip::fileInfo( const String& strFile, FileInfo** ppInfo ) const {
+  const Entry* pEntry = findEntry( strFile );
+  if( !pEntry )
+    return false;
+
+  FileInfo* pInfo = *ppInfo;
+  pInfo->iCompSize = static_cast<int>( pEntry->compressedSize );
+  pInfo->iUncompSize = static_cast<int>( pEntry->uncompressedSize );
+  pInfo->iLastMod = pEntry->lastModified;
+  strncpy( pInfo->szFilename, strFile.c_str(), sizeof( pInfo->szFilename ) - 1 );
+  pInfo->szFilename[sizeof( pInfo->szFilename ) - 1] = '\0';
+
   return true;
 }
 
@@ -151,36 +272,11 @@ bool Zip::dirTest( const String& strDir ) const {
 //-----------------------------------------------------------------------
 StringVector Zip::getAllNamesLike( const String& strStartPath, const String& strPattern, bool bRecursive /* = true */ ) {
   StringVector retVec;
-  unz_file_info info;
-  String filename;
-  String szPattern;
-  char tmpFilename[260];
-  char extraField[260];
-  char comment[260];
-
-  szPattern = strPattern;
-  szPattern = StringToLowerASCII(szPattern);
-
-  int iRes = unzGoToFirstFile(mArchive);
-  while( iRes == UNZ_OK ) {
-
-    unzGetCurrentFileInfo( mArchive,
-                           &info,
-                           tmpFilename, 259,
-                           extraField, 259,
-                           comment, 259 );
+  String szPattern = StringToLowerASCII(strPattern);
 
-    filename = tmpFilename;
-
-    if( info.uncompressed_size > 0 ) {
-      filename = StringToLowerASCII(filename);
-
-      if( static_cast<int>(filename.find(szPattern)) >= 0 ) {
-        retVec.push_back( filename );
-      }
-    }
-
-    iRes = unzGoToNextFile( mArchive );
+  for( size_t i = 0; i < mNames.size(); ++i ) {
+    if( mNames[i].find( szPattern ) != String::npos )
+      retVec.push_back( mNames[i] );
   }
 
   return retVec;
@@ -188,22 +284,80 @@ StringVector Zip::getAllNamesLike( const String& strStartPath, const String& str
 
 //-----------------------------------------------------------------------
 void Zip::load() {
-  struct stat tagStat;
-  stat( mName.c_str(), &tagStat );
-
-  if( ( tagStat.st_mode & S_IFDIR ) )
+  mFile = MappedFile::open( mName );
+  if( !mFile )
     Except( Exception::ERR_FILE_NOT_FOUND, "Zip archive " + mName + " not found.",
             "Zip::load" );
-  else
-    mArchive = unzOpen( mName.c_str() );
+
+  const uchar* pBase = mFile->getPtr();
+  size_t size = mFile->getSize();
+
+  // Find the end of central directory record, searching back over the
+  // archive comment
+  const uchar* pEnd = 0;
+  if( size >= END_RECORD_SIZE ) {
+    size_t stop = size > END_RECORD_SIZE + MAX_COMMENT_SIZE ?
+                  size - END_RECORD_SIZE - MAX_COMMENT_SIZE : 0;
+    for( size_t pos = size - END_RECORD_SIZE + 1; pos-- > stop; ) {
+      if( readLong( pBase + pos ) == END_RECORD_SIGNATURE ) {
+        pEnd = pBase + pos;
+        break;
+      }
+    }
+  }
+  if( !pEnd )
+    Except( Exception::ERR_INTERNAL_ERROR, mName + " is not a zip archive.", "Zip::load" );
+
+  size_t numEntries = readShort( pEnd + 10 );
+  size_t dirSize = readLong( pEnd + 12 );
+  size_t dirOffset = readLong( pEnd + 16 );
+  if( dirOffset + dirSize > size )
+    Except( Exception::ERR_INTERNAL_ERROR, "Corrupt central directory in zip archive " + mName,
+            "Zip::load" );
+
+  // Index the central directory
+  const uchar* pHeader = pBase + dirOffset;
+  const uchar* pDirEnd = pHeader + dirSize;
+  mNames.reserve( numEntries );
+  for( size_t i = 0; i < numEntries; ++i ) {
+    if( pHeader + CENTRAL_HEADER_SIZE > pDirEnd ||
+        readLong( pHeader ) != CENTRAL_HEADER_SIGNATURE )
+      Except( Exception::ERR_INTERNAL_ERROR, "Corrupt central directory in zip archive " + mName,
+              "Zip::load" );
+
+    size_t nameLength = readShort( pHeader + 28 );
+    const uchar* pNext = pHeader + CENTRAL_HEADER_SIZE + nameLength +
+                         readShort( pHeader + 30 ) + readShort( pHeader + 32 );
+    if( pNext > pDirEnd )
+      Except( Exception::ERR_INTERNAL_ERROR, "Corrupt central directory in zip archive " + mName,
+              "Zip::load" );
+
+    String filename( reinterpret_cast<const char*>( pHeader + CENTRAL_HEADER_SIZE ), nameLength );
+    Entry entry;
+    entry.method = readShort( pHeader + 10 );
+    entry.lastModified = dosToTime( readShort( pHeader + 14 ), readShort( pHeader + 12 ) );
+    entry.compressedSize = readLong( pHeader + 20 );
+    entry.uncompressedSize = readLong( pHeader + 24 );
+    entry.offset = readLong( pHeader + 42 );
+    pHeader = pNext;
+
+    // Directories have no data
+    if( filename.empty() || filename[filename.size() - 1] == '/' )
+      continue;
+
+    filename = StringToLowerASCII( filename );
+    mEntries.insert( EntryMap::value_type( filename, entry ) );
+    if( entry.uncompressedSize > 0 )
+      mNames.push_back( filename );
+  }
 
   LogManager::getSingleton().logMessage( "Zip Archive codec for " + mName + " created.");
 };
 
 //-----------------------------------------------------------------------
 void Zip::unload() {
-  if( mArchive )
-    unzClose( mArchive );
+  // Chunks still referring to stored entries keep the file mapped
+  mFile = NULL;
 
   LogManager::getSingleton().logMessage( "Zip Archive Codec for " + mName + " unloaded." );
 
@@ -0,0 +1,243 @@
+// Builds an .ipak pack file from a directory tree; see Packer.h.
+//
+// Every file is compressed in chunks, and kept compressed only if that saves
+// at least an eighth of its size; media which is compressed already (images,
+// sound) ends up stored, and so is used in place at run time.
+
+#include "Packer.h"
+
+#include <io.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "zlib.h"
+
+using namespace renderer;
+
+namespace {
+
+/// Uncompressed size of each compressed chunk
+const uint32 CHUNK_SIZE = 256 * 1024;
+
+struct SourceFile {
+  std::string path;
+  /// Name in the pack; relative, lower case, '/' separated
+  std::string name;
+  time_t lastModified;
+};
+
+struct PackedFile {
+  PackEntry entry;
+  std::string name;
+};
+
+bool operator<(const SourceFile& a, const SourceFile& b) {
+  return a.name < b.name;
+}
+
+/// The order of the table of contents
+bool operator<(const PackedFile& a, const PackedFile& b) {
+  if (a.entry.hash != b.entry.hash)
+    return a.entry.hash < b.entry.hash;
+  return a.name < b.name;
+}
+
+std::string toLower(std::string str) {
+  for (size_t i = 0; i < str.size(); ++i)
+    str[i] = static_cast<char>(tolower(static_cast<uchar>(str[i])));
+  return str;
+}
+
+uint64 alignUp(uint64 pos, size_t alignment) {
+  return (pos + alignment - 1) / alignment * alignment;
+}
+
+void findFiles(const std::string& dir, const std::string& prefix,
+               std::vector<SourceFile>& files) {
+  struct _finddata_t data;
+  intptr_t handle = _findfirst((dir + "/*").c_str(), &data);
+  if (handle == -1)
+    return;
+
+  do {
+    std::string name = data.name;
+    if (name == "." || name == "..")
+      continue;
+
+    if (data.attrib & _A_SUBDIR) {
+      findFiles(dir + "/" + name, prefix + name + "/", files);
+    } else {
+      SourceFile file;
+      file.path = dir + "/" + name;
+      file.name = toLower(prefix + name);
+      file.lastModified = data.time_write;
+      files.push_back(file);
+    }
+  } while (_findnext(handle, &data) == 0);
+  _findclose(handle);
+}
+
+bool readFile(const std::string& path, std::vector<uchar>& data) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file)
+    return false;
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  data.resize(size);
+  bool ok = size == 0 || fread(&data[0], size, 1, file) == 1;
+  fclose(file);
+  return ok;
+}
+
+/// Compresses the data in the PACK_DEFLATED layout: chunk table, then chunks
+bool compressChunks(const std::vector<uchar>& src, std::vector<uchar>& dest) {
+  size_t numChunks = (src.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  std::vector<uint64> offsets(numChunks + 1);
+  dest.assign(offsets.size() * sizeof(uint64), 0);
+
+  std::vector<uchar> buffer(compressBound(CHUNK_SIZE));
+  for (size_t i = 0; i < numChunks; ++i) {
+    size_t size = std::min<size_t>(CHUNK_SIZE, src.size() - i * CHUNK_SIZE);
+    uLongf compressedSize = static_cast<uLongf>(buffer.size());
+    if (compress2(&buffer[0], &compressedSize, &src[i * CHUNK_SIZE],
+                  static_cast<uLong>(size), Z_BEST_COMPRESSION) != Z_OK)
+      return false;
+
+    offsets[i] = dest.size();
+    dest.insert(dest.end(), buffer.begin(), buffer.begin() + compressedSize);
+  }
+  offsets[numChunks] = dest.size();
+
+  memcpy(&dest[0], &offsets[0], offsets.size() * sizeof(uint64));
+  return true;
+}
+
+bool writeData(FILE* file, const void* data, size_t size, uint64& pos) {
+  if (size > 0 && fwrite(data, size, 1, file) != 1)
+    return false;
+  pos += size;
+  return true;
+}
+
+bool writePadding(FILE* file, size_t alignment, uint64& pos) {
+  static const uchar zeros[PACK_PAGE_ALIGNMENT] = { 0 };
+  size_t count = static_cast<size_t>(alignUp(pos, alignment) - pos);
+  return writeData(file, zeros, count, pos);
+}
+
+}  // namespace
+
+namespace packer {
+
+bool packDirectory(const std::string& dir, const std::string& packFile,
+                   PackStats& stats, std::string& error) {
+  error.clear();
+  std::vector<SourceFile> files;
+  findFiles(dir, "", files);
+  if (files.empty()) {
+    error = "No files found in " + dir;
+    return false;
+  }
+  // Keeps the output the same from one run to the next
+  std::sort(files.begin(), files.end());
+
+  // Lay out the name table, which fixes where the data starts
+  std::vector<PackedFile> packed(files.size());
+  std::string names;
+  for (size_t i = 0; i < files.size(); ++i) {
+    PackedFile& p = packed[i];
+    memset(&p.entry, 0, sizeof(p.entry));
+    p.name = files[i].name;
+    p.entry.hash = packNameHash(p.name.c_str(), p.name.size());
+    p.entry.nameOffset = static_cast<uint32>(names.size());
+    p.entry.nameLength = static_cast<uint32>(p.name.size());
+    p.entry.lastModified = static_cast<uint64>(files[i].lastModified);
+    names += p.name;
+  }
+
+  PackHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = PACK_MAGIC;
+  header.version = PACK_VERSION;
+  header.numEntries = static_cast<uint32>(files.size());
+  header.chunkSize = CHUNK_SIZE;
+  header.namesOffset = sizeof(PackHeader) + files.size() * sizeof(PackEntry);
+  header.namesSize = names.size();
+
+  FILE* out = fopen(packFile.c_str(), "wb");
+  if (!out) {
+    error = "Cannot create " + packFile;
+    return false;
+  }
+
+  // The tables are written last, once the entries are known; leave room
+  uint64 pos = 0;
+  std::vector<uchar> tables(static_cast<size_t>(header.namesOffset + header.namesSize));
+  bool ok = writeData(out, &tables[0], tables.size(), pos);
+
+  uint64 totalSize = 0;
+  std::vector<uchar> data, compressed;
+  for (size_t i = 0; ok && i < files.size(); ++i) {
+    PackEntry& entry = packed[i].entry;
+    if (!readFile(files[i].path, data)) {
+      error = "Cannot read " + files[i].path;
+      ok = false;
+      break;
+    }
+    entry.uncompressedSize = data.size();
+    totalSize += data.size();
+
+    const std::vector<uchar>* contents = &data;
+    entry.method = PACK_STORED;
+    if (!data.empty() && compressChunks(data, compressed) &&
+        compressed.size() * 8 < data.size() * 7) {
+      contents = &compressed;
+      entry.method = PACK_DEFLATED;
+    }
+
+    size_t alignment = entry.method == PACK_STORED &&
+                       data.size() >= PACK_PAGE_ALIGN_SIZE ?
+                       PACK_PAGE_ALIGNMENT : PACK_ALIGNMENT;
+    ok = writePadding(out, alignment, pos);
+    entry.offset = pos;
+    entry.size = contents->size();
+    ok = ok && writeData(out, contents->empty() ? 0 : &(*contents)[0],
+                         contents->size(), pos);
+  }
+
+  if (ok) {
+    std::sort(packed.begin(), packed.end());
+    std::vector<PackEntry> entries(packed.size());
+    for (size_t i = 0; i < packed.size(); ++i)
+      entries[i] = packed[i].entry;
+
+    uint64 end = pos;
+    pos = 0;
+    ok = fseek(out, 0, SEEK_SET) == 0 &&
+         writeData(out, &header, sizeof(header), pos) &&
+         writeData(out, &entries[0], entries.size() * sizeof(PackEntry), pos) &&
+         writeData(out, names.data(), names.size(), pos);
+    pos = end;
+  }
+
+  if (fclose(out) != 0 || !ok) {
+    if (error.empty())
+      error = "Failed writing " + packFile;
+    remove(packFile.c_str());
+    return false;
+  }
+
+  stats.numFiles = files.size();
+  stats.totalSize = totalSize;
+  stats.packSize = pos;
+  return true;
+}
+
+
+}  // namespace packer
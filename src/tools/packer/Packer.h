@@ -0,0 +1,28 @@
+// Builds .ipak pack files, as read by renderer::PackFile; see PackFileFormat.h
+// for the layout. Used by the packer tool, and by the tests to make packs.
+
+#ifndef TOOLS_PACKER_PACKER_H_
+#define TOOLS_PACKER_PACKER_H_
+
+#include <string>
+
+#include "PackFileFormat.h"
+
+namespace packer {
+
+struct PackStats {
+  size_t numFiles;
+  /// Of all the files before packing
+  renderer::uint64 totalSize;
+  /// Of the pack file
+  renderer::uint64 packSize;
+};
+
+/// Packs every file under dir into packFile. On failure returns false with a
+/// message in error, and leaves no pack file behind.
+bool packDirectory(const std::string& dir, const std::string& packFile,
+                   PackStats& stats, std::string& error);
+
+}  // namespace packer
+
+#endif  // TOOLS_PACKER_PACKER_H_
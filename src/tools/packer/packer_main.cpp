@@ -0,0 +1,28 @@
+// Builds an .ipak pack file, as read by renderer::PackFile, from a directory
+// tree. See PackFileFormat.h for the layout, and Packer.cpp for how files
+// are laid out in it.
+//
+// Usage: packer <directory> <pack file>
+
+#include "Packer.h"
+
+#include <stdio.h>
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: packer <directory> <pack file>\n");
+    return 1;
+  }
+
+  packer::PackStats stats;
+  std::string error;
+  if (!packer::packDirectory(argv[1], argv[2], stats, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  printf("Packed %u files, %.1f MB into %.1f MB\n",
+         static_cast<unsigned>(stats.numFiles),
+         stats.totalSize / (1024.0 * 1024.0), stats.packSize / (1024.0 * 1024.0));
+  return 0;
+}
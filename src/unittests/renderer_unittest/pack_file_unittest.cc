@@ -0,0 +1,231 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+
+#include "PackFile.h"
+
+#include <direct.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "Exception.h"
+#include "Packer.h"
+#include "SDDataChunk.h"
+#include "third_party/test/gtest/include/gtest/gtest.h"
+
+namespace renderer {
+namespace {
+
+const char kSourceDir[] = "pack_file_unittest";
+const char kSubDir[] = "pack_file_unittest/Sub";
+const char kPackName[] = "pack_file_unittest.ipak";
+
+bool WriteTestFile(const std::string& path, const std::string& data) {
+  FILE* file = fopen(path.c_str(), "wb");
+  if (!file)
+    return false;
+  bool ok = data.empty() || fwrite(data.data(), data.size(), 1, file) == 1;
+  return fclose(file) == 0 && ok;
+}
+
+bool ReadTestFile(const std::string& path, std::string& data) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file)
+    return false;
+  fseek(file, 0, SEEK_END);
+  data.resize(ftell(file));
+  fseek(file, 0, SEEK_SET);
+  bool ok = data.empty() || fread(&data[0], data.size(), 1, file) == 1;
+  fclose(file);
+  return ok;
+}
+
+class PackFileTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    _mkdir(kSourceDir);
+    _mkdir(kSubDir);
+
+    // Compresses well, over several chunks
+    for (int i = 0; i < 40000; ++i)
+      text_ += "line of text that repeats\n";
+    // Doesn't compress, so it is stored and page aligned
+    unsigned int seed = 12345;
+    noise_.resize(100 * 1024);
+    for (size_t i = 0; i < noise_.size(); ++i) {
+      seed = seed * 1103515245 + 12345;
+      noise_[i] = static_cast<char>(seed >> 16);
+    }
+
+    ASSERT_TRUE(WriteTestFile(std::string(kSourceDir) + "/small.txt", "hello"));
+    ASSERT_TRUE(WriteTestFile(std::string(kSourceDir) + "/empty.txt", ""));
+    ASSERT_TRUE(WriteTestFile(std::string(kSourceDir) + "/noise.bin", noise_));
+    ASSERT_TRUE(WriteTestFile(std::string(kSubDir) + "/Text.txt", text_));
+
+    packer::PackStats stats;
+    std::string error;
+    ASSERT_TRUE(packer::packDirectory(kSourceDir, kPackName, stats, error)) << error;
+    EXPECT_EQ(4u, stats.numFiles);
+  }
+
+  virtual void TearDown() {
+    remove((std::string(kSourceDir) + "/small.txt").c_str());
+    remove((std::string(kSourceDir) + "/empty.txt").c_str());
+    remove((std::string(kSourceDir) + "/noise.bin").c_str());
+    remove((std::string(kSubDir) + "/Text.txt").c_str());
+    _rmdir(kSubDir);
+    _rmdir(kSourceDir);
+    remove(kPackName);
+  }
+
+  // Rewrites part of the pack; it must not be loaded
+  void Patch(size_t offset, const void* data, size_t size) {
+    std::string pack;
+    ASSERT_TRUE(ReadTestFile(kPackName, pack));
+    ASSERT_LE(offset + size, pack.size());
+    memcpy(&pack[offset], data, size);
+    ASSERT_TRUE(WriteTestFile(kPackName, pack));
+  }
+
+  PackHeader ReadHeader() {
+    PackHeader header;
+    std::string pack;
+    EXPECT_TRUE(ReadTestFile(kPackName, pack));
+    memcpy(&header, pack.data(), sizeof(header));
+    return header;
+  }
+
+  PackEntry ReadEntry(uint32 index) {
+    PackEntry entry;
+    std::string pack;
+    EXPECT_TRUE(ReadTestFile(kPackName, pack));
+    memcpy(&entry, pack.data() + EntryOffset(index), sizeof(entry));
+    return entry;
+  }
+
+  static size_t EntryOffset(uint32 index) {
+    return sizeof(PackHeader) + index * sizeof(PackEntry);
+  }
+
+  static std::string Read(PackFile* pack, const String& name) {
+    SDDataChunk chunk;
+    DataChunk* pChunk = &chunk;
+    if (!pack->fileRead(name, &pChunk))
+      return "<missing>";
+    return std::string(reinterpret_cast<const char*>(chunk.getPtr()), chunk.getSize());
+  }
+
+  std::string text_;
+  std::string noise_;
+};
+
+TEST_F(PackFileTest, RoundTrip) {
+  PackFile* pack = new PackFile(kPackName);
+  pack->load();
+
+  EXPECT_EQ("hello", Read(pack, "small.txt"));
+  EXPECT_EQ("", Read(pack, "empty.txt"));
+  EXPECT_TRUE(noise_ == Read(pack, "noise.bin"));
+  EXPECT_TRUE(text_ == Read(pack, "sub/text.txt"));
+  // Names are not case sensitive
+  EXPECT_TRUE(text_ == Read(pack, "SUB/Text.TXT"));
+
+  EXPECT_TRUE(pack->fileTest("noise.bin"));
+  EXPECT_FALSE(pack->fileTest("missing.txt"));
+  EXPECT_FALSE(pack->fileTest("text.txt"));
+  EXPECT_EQ("<missing>", Read(pack, "missing.txt"));
+
+  ArchiveEx::FileInfo info;
+  ArchiveEx::FileInfo* pInfo = &info;
+  ASSERT_TRUE(pack->fileInfo("sub/text.txt", &pInfo));
+  EXPECT_EQ(static_cast<int>(text_.size()), info.iUncompSize);
+  EXPECT_LT(info.iCompSize, info.iUncompSize);
+  ASSERT_TRUE(pack->fileInfo("noise.bin", &pInfo));
+  EXPECT_EQ(static_cast<int>(noise_.size()), info.iUncompSize);
+  EXPECT_EQ(info.iUncompSize, info.iCompSize);
+
+  pack->unload();
+}
+
+TEST_F(PackFileTest, RejectsBadHeader) {
+  uint32 magic = 0;
+  Patch(0, &magic, sizeof(magic));
+
+  PackFile* pack = new PackFile(kPackName);
+  EXPECT_THROW(pack->load(), Exception);
+  delete pack;
+}
+
+TEST_F(PackFileTest, RejectsCorruptTableOfContents) {
+  PackHeader header = ReadHeader();
+
+  // Names beyond the end of the file
+  header.namesOffset = ~static_cast<uint64>(0) - 8;
+  Patch(0, &header, sizeof(header));
+  PackFile* pack = new PackFile(kPackName);
+  EXPECT_THROW(pack->load(), Exception);
+  delete pack;
+
+  // More entries than the file has room for
+  header = ReadHeader();
+  header.numEntries = 0x7fffffff;
+  Patch(0, &header, sizeof(header));
+  pack = new PackFile(kPackName);
+  EXPECT_THROW(pack->load(), Exception);
+  delete pack;
+}
+
+TEST_F(PackFileTest, RejectsCorruptEntries) {
+  PackHeader header = ReadHeader();
+  uint32 deflated = header.numEntries;
+  for (uint32 i = 0; i < header.numEntries; ++i) {
+    PackEntry entry = ReadEntry(i);
+    if (entry.method == PACK_DEFLATED) {
+      deflated = i;
+    } else {
+      // Data which runs past the end of the file
+      entry.size = ~static_cast<uint64>(0) - entry.offset + 1;
+      Patch(EntryOffset(i), &entry, sizeof(entry));
+    }
+  }
+  ASSERT_LT(deflated, header.numEntries);
+
+  // A chunk table pointing back into itself
+  PackEntry entry = ReadEntry(deflated);
+  uint64 chunkOffset = 0;
+  Patch(static_cast<size_t>(entry.offset), &chunkOffset, sizeof(chunkOffset));
+
+  PackFile* pack = new PackFile(kPackName);
+  pack->load();
+  EXPECT_THROW(Read(pack, "small.txt"), Exception);
+  EXPECT_THROW(Read(pack, "noise.bin"), Exception);
+  EXPECT_THROW(Read(pack, "sub/text.txt"), Exception);
+  // The entries themselves are still there
+  EXPECT_TRUE(pack->fileTest("sub/text.txt"));
+  pack->unload();
+}
+
+}  // namespace
+}  // namespace renderer
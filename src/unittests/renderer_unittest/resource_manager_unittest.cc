@@ -0,0 +1,178 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+
+#include "ResourceManager.h"
+
+#include "third_party/test/gtest/include/gtest/gtest.h"
+
+namespace renderer {
+namespace {
+
+const size_t kResourceSize = 100;
+
+class TestResource : public Resource {
+ public:
+  TestResource(const String& name) : loads_(0), unloads_(0) {
+    mName = name;
+  }
+
+  void load() {
+    if (mIsLoaded)
+      return;
+    mIsLoaded = true;
+    mSize = kResourceSize;
+    ++loads_;
+  }
+
+  void unload() {
+    if (!mIsLoaded)
+      return;
+    mIsLoaded = false;
+    ++unloads_;
+  }
+
+  // There is no Root in these tests, so the current frame is always 0 and
+  // anything touched counts as in use. Giving a resource a later frame
+  // marks it as not in use, and orders it for the pager.
+  void setLastAccess(unsigned long frame) {
+    mLastAccess = frame;
+  }
+
+  int loads() const { return loads_; }
+  int unloads() const { return unloads_; }
+
+ private:
+  int loads_;
+  int unloads_;
+};
+
+class TestResourceManager : public ResourceManager {
+ public:
+  Resource* create(const String& name) {
+    return new TestResource(name);
+  }
+
+  TestResource* add(const String& name, int priority, unsigned long lastAccess) {
+    TestResource* res = static_cast<TestResource*>(create(name));
+    load(res, priority);
+    res->setLastAccess(lastAccess);
+    return res;
+  }
+};
+
+TEST(ResourceManagerTest, PagesOutLeastRecentlyUsedFirst) {
+  TestResourceManager manager;
+  TestResource* newest = manager.add("newest", 1, 3);
+  TestResource* oldest = manager.add("oldest", 1, 1);
+  TestResource* middle = manager.add("middle", 1, 2);
+  EXPECT_EQ(3 * kResourceSize, manager.getMemoryUsage());
+
+  manager.setMemoryBudget(2 * kResourceSize);
+  EXPECT_TRUE(oldest->isPagedOut());
+  EXPECT_FALSE(oldest->isLoaded());
+  EXPECT_FALSE(middle->isPagedOut());
+  EXPECT_FALSE(newest->isPagedOut());
+  EXPECT_EQ(2 * kResourceSize, manager.getMemoryUsage());
+
+  manager.setMemoryBudget(kResourceSize);
+  EXPECT_TRUE(middle->isPagedOut());
+  EXPECT_FALSE(newest->isPagedOut());
+  EXPECT_EQ(kResourceSize, manager.getMemoryUsage());
+}
+
+TEST(ResourceManagerTest, GetByNameReloadsPagedOutResource) {
+  TestResourceManager manager;
+  TestResource* first = manager.add("first", 1, 1);
+  TestResource* second = manager.add("second", 1, 2);
+
+  manager.setMemoryBudget(kResourceSize);
+  ASSERT_TRUE(first->isPagedOut());
+  EXPECT_EQ(1, first->loads());
+
+  // Comes back loaded, and in use this frame; that puts the manager over
+  // budget again, so the other one goes instead
+  EXPECT_EQ(first, manager.getByName("first"));
+  EXPECT_FALSE(first->isPagedOut());
+  EXPECT_TRUE(first->isLoaded());
+  EXPECT_EQ(2, first->loads());
+  EXPECT_TRUE(first->isInUse());
+  EXPECT_TRUE(second->isPagedOut());
+  EXPECT_EQ(kResourceSize, manager.getMemoryUsage());
+
+  // Looking up a loaded resource doesn't load it again
+  EXPECT_EQ(first, manager.getByName("first"));
+  EXPECT_EQ(2, first->loads());
+  EXPECT_EQ(static_cast<Resource*>(0), manager.getByName("missing"));
+}
+
+TEST(ResourceManagerTest, PagesOutByPriorityThenAge) {
+  TestResourceManager manager;
+  TestResource* pinned = manager.add("pinned", 0, 1);
+  TestResource* important = manager.add("important", 2, 2);
+  TestResource* cheap = manager.add("cheap", 1, 3);
+
+  manager.setMemoryBudget(2 * kResourceSize);
+  EXPECT_TRUE(cheap->isPagedOut());
+  EXPECT_FALSE(important->isPagedOut());
+
+  // Priority 0 is never paged out, however old
+  manager.setMemoryBudget(0);
+  EXPECT_TRUE(important->isPagedOut());
+  EXPECT_FALSE(pinned->isPagedOut());
+  EXPECT_EQ(kResourceSize, manager.getMemoryUsage());
+}
+
+TEST(ResourceManagerTest, ResourcesInUseAreNotPagedOut) {
+  TestResourceManager manager;
+  TestResource* referenced = manager.add("referenced", 1, 1);
+  TestResource* touched = manager.add("touched", 1, 2);
+  TestResource* idle = manager.add("idle", 1, 3);
+
+  referenced->addReference();
+  touched->touch();
+  manager.setMemoryBudget(0);
+  EXPECT_FALSE(referenced->isPagedOut());
+  EXPECT_FALSE(touched->isPagedOut());
+  EXPECT_TRUE(idle->isPagedOut());
+  referenced->removeReference();
+}
+
+TEST(ResourceManagerTest, UnloadOfPagedOutResourceKeepsAccounting) {
+  TestResourceManager manager;
+  TestResource* res = manager.add("res", 1, 1);
+
+  manager.setMemoryBudget(0);
+  ASSERT_TRUE(res->isPagedOut());
+  EXPECT_EQ(0u, manager.getMemoryUsage());
+
+  manager.unload(res);
+  EXPECT_FALSE(res->isPagedOut());
+  EXPECT_EQ(0u, manager.getMemoryUsage());
+  EXPECT_EQ(static_cast<Resource*>(0), manager.getByName("res"));
+  res->destroy();
+}
+
+}  // namespace
+}  // namespace renderer
@@ -0,0 +1,274 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+
+#include "ScriptCache.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <map>
+
+#include "ArchiveEx.h"
+#include "DataChunk.h"
+#include "third_party/test/gtest/include/gtest/gtest.h"
+
+namespace renderer {
+namespace {
+
+const char kCacheName[] = "script_cache_unittest.cache";
+
+// Holds its files in memory, with whatever time stamps the test gives them.
+class MemoryArchive : public ArchiveEx {
+ public:
+  MemoryArchive() : ArchiveEx("memory"), reads_(0) {}
+
+  void setFile(const String& name, const std::string& data, time_t lastModified) {
+    files_[name].data = data;
+    files_[name].lastModified = lastModified;
+  }
+
+  int reads() const { return reads_; }
+
+  void load() {}
+  void unload() {}
+  bool fileOpen(const String& strFile, FILE** ppFile) const { return false; }
+
+  bool fileRead(const String& strFile, DataChunk** ppChunk) const {
+    FileMap::const_iterator i = files_.find(strFile);
+    if (i == files_.end())
+      return false;
+    ++reads_;
+    (*ppChunk)->allocate(i->second.data.size(),
+                         reinterpret_cast<const uchar*>(i->second.data.data()));
+    return true;
+  }
+
+  bool fileSave(FILE* pFile, const String& strPath, bool bOverwrite) { return false; }
+  bool fileWrite(const DataChunk& refChunk, const String& strPath, bool bOverwrite) {
+    return false;
+  }
+  bool fileDele(const String& strFile) { return false; }
+  bool fileMove(const String& strSrc, const String& strDest, bool bOverwrite) {
+    return false;
+  }
+
+  bool fileInfo(const String& strFile, FileInfo** ppInfo) const {
+    FileMap::const_iterator i = files_.find(strFile);
+    if (i == files_.end())
+      return false;
+    FileInfo* pInfo = *ppInfo;
+    strncpy(pInfo->szFilename, strFile.c_str(), sizeof(pInfo->szFilename) - 1);
+    pInfo->iCompSize = static_cast<int>(i->second.data.size());
+    pInfo->iUncompSize = static_cast<int>(i->second.data.size());
+    pInfo->iLastMod = i->second.lastModified;
+    return true;
+  }
+
+  bool fileCopy(const String& strSrc, const String& strDest, bool bOverwrite) {
+    return false;
+  }
+  bool fileTest(const String& strFile) const {
+    return files_.find(strFile) != files_.end();
+  }
+  std::vector<String> dirGetFiles(const String& strDir) const {
+    return std::vector<String>();
+  }
+  std::vector<String> dirGetSubs(const String& strDir) const {
+    return std::vector<String>();
+  }
+  bool dirDele(const String& strDir, bool bRecursive) { return false; }
+  bool dirMove(const String& strSrc, const String& strDest, bool bOverwrite) {
+    return false;
+  }
+  bool dirInfo(const String& strDir, FileInfo** ppInfo) const { return false; }
+  bool dirCopy(const String& strSrc, const String& strDest, bool bOverwrite) {
+    return false;
+  }
+  bool dirTest(const String& strDir) const { return false; }
+  std::vector<String> getAllNamesLike(const String& strStartPath,
+                                      const String& strPattern, bool bRecursive) {
+    return std::vector<String>();
+  }
+  bool _allowFileCaching() const { return true; }
+
+ private:
+  struct File {
+    std::string data;
+    time_t lastModified;
+  };
+  typedef std::map<String, File> FileMap;
+  FileMap files_;
+  mutable int reads_;
+};
+
+// Makes a node of each line. There is no WorkQueue in these tests, so it is
+// only called from the test thread.
+class CountingCompiler : public ScriptCache::Compiler {
+ public:
+  CountingCompiler() : compiles_(0) {}
+
+  virtual void compileScript(DataChunk& chunk, ScriptNodeList& nodes) {
+    ++compiles_;
+    while (!chunk.isEOF()) {
+      String line = chunk.getLine();
+      if (line.empty())
+        continue;
+      nodes.push_back(ScriptNode());
+      nodes.back().tokens.push_back(line);
+    }
+  }
+
+  int compiles() const { return compiles_; }
+
+ private:
+  int compiles_;
+};
+
+class ScriptCacheTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    remove(kCacheName);
+    cache_.setFileName(kCacheName);
+    archive_.setFile("a.material", "alpha\nbeta\n", 100);
+    archive_.setFile("b.material", "gamma\n", 100);
+  }
+
+  virtual void TearDown() {
+    remove(kCacheName);
+  }
+
+  // Gets the scripts of the files, joining the tokens of each with spaces
+  std::vector<std::string> GetScripts(const char* first, const char* second = 0) {
+    ScriptCache::SourceList sources;
+    sources.push_back(ScriptCache::Source(&archive_, first));
+    if (second)
+      sources.push_back(ScriptCache::Source(&archive_, second));
+
+    std::vector<const ScriptNodeList*> scripts;
+    cache_.getScripts(sources, &compiler_, scripts);
+    EXPECT_EQ(sources.size(), scripts.size());
+
+    std::vector<std::string> result;
+    for (size_t s = 0; s < scripts.size(); ++s) {
+      std::string text;
+      for (size_t n = 0; n < scripts[s]->size(); ++n) {
+        if (n > 0)
+          text += " ";
+        text += (*scripts[s])[n].tokens[0];
+      }
+      result.push_back(text);
+    }
+    cache_.save();
+    return result;
+  }
+
+  MemoryArchive archive_;
+  CountingCompiler compiler_;
+  ScriptCache cache_;
+};
+
+TEST_F(ScriptCacheTest, UnchangedScriptsAreNotCompiledAgain) {
+  std::vector<std::string> scripts = GetScripts("a.material", "b.material");
+  ASSERT_EQ(2u, scripts.size());
+  EXPECT_EQ("alpha beta", scripts[0]);
+  EXPECT_EQ("gamma", scripts[1]);
+  EXPECT_EQ(2, compiler_.compiles());
+  EXPECT_EQ(2, archive_.reads());
+
+  // Read back from the cache file, without even reading the scripts
+  scripts = GetScripts("a.material", "b.material");
+  ASSERT_EQ(2u, scripts.size());
+  EXPECT_EQ("alpha beta", scripts[0]);
+  EXPECT_EQ("gamma", scripts[1]);
+  EXPECT_EQ(2, compiler_.compiles());
+  EXPECT_EQ(2, archive_.reads());
+}
+
+TEST_F(ScriptCacheTest, ChangedScriptIsCompiledAgain) {
+  GetScripts("a.material", "b.material");
+
+  archive_.setFile("b.material", "delta\nepsilon\n", 200);
+  std::vector<std::string> scripts = GetScripts("a.material", "b.material");
+  ASSERT_EQ(2u, scripts.size());
+  EXPECT_EQ("alpha beta", scripts[0]);
+  EXPECT_EQ("delta epsilon", scripts[1]);
+  EXPECT_EQ(3, compiler_.compiles());
+
+  // And the new version is what gets cached
+  scripts = GetScripts("a.material", "b.material");
+  EXPECT_EQ("delta epsilon", scripts[1]);
+  EXPECT_EQ(3, compiler_.compiles());
+}
+
+TEST_F(ScriptCacheTest, TouchedButUnchangedScriptIsNotCompiled) {
+  GetScripts("a.material");
+
+  archive_.setFile("a.material", "alpha\nbeta\n", 300);
+  std::vector<std::string> scripts = GetScripts("a.material");
+  EXPECT_EQ("alpha beta", scripts[0]);
+  EXPECT_EQ(1, compiler_.compiles());
+  EXPECT_EQ(2, archive_.reads());
+
+  // The new time stamp was saved, so it isn't even read next time
+  GetScripts("a.material");
+  EXPECT_EQ(1, compiler_.compiles());
+  EXPECT_EQ(2, archive_.reads());
+}
+
+TEST_F(ScriptCacheTest, UnknownTimeStampsFallBackToHash) {
+  archive_.setFile("a.material", "alpha\nbeta\n", 0);
+  GetScripts("a.material");
+
+  // Has to be read every time, but is only compiled when it changes
+  GetScripts("a.material");
+  EXPECT_EQ(1, compiler_.compiles());
+  EXPECT_EQ(2, archive_.reads());
+
+  archive_.setFile("a.material", "alpha\nzeta\n", 0);
+  std::vector<std::string> scripts = GetScripts("a.material");
+  EXPECT_EQ("alpha zeta", scripts[0]);
+  EXPECT_EQ(2, compiler_.compiles());
+}
+
+TEST_F(ScriptCacheTest, ScriptsNotAskedForAreDropped) {
+  GetScripts("a.material", "b.material");
+  EXPECT_EQ(2, compiler_.compiles());
+
+  // b.material has gone away; saving drops it from the cache
+  GetScripts("a.material");
+  EXPECT_EQ(2, compiler_.compiles());
+
+  GetScripts("a.material", "b.material");
+  EXPECT_EQ(3, compiler_.compiles());
+}
+
+TEST_F(ScriptCacheTest, DisabledWithoutFileName) {
+  cache_.setFileName("");
+  GetScripts("a.material");
+  GetScripts("a.material");
+  EXPECT_EQ(2, compiler_.compiles());
+}
+
+}  // namespace
+}  // namespace renderer
@@ -0,0 +1,188 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://ogre.sourceforge.net/
+
+Copyright (c)2000-2002 The OGRE Team
+Also see acknowledgements in Readme.html
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+http://www.gnu.org/copyleft/lesser.txt.
+-----------------------------------------------------------------------------
+*/
+
+#include "WorkQueue.h"
+
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/basictypes.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "base/time.h"
+#include "third_party/test/gtest/include/gtest/gtest.h"
+
+namespace renderer {
+namespace {
+
+class CountingTask : public WorkQueue::Task {
+ public:
+  CountingTask() : count_(0), thread_(0) {}
+
+  virtual void run(void) {
+    base::subtle::Barrier_AtomicIncrement(&count_, 1);
+    thread_ = base::PlatformThread::CurrentId();
+  }
+
+  int count() const { return base::subtle::Acquire_Load(&count_); }
+  base::PlatformThreadId thread() const { return thread_; }
+
+ private:
+  volatile base::subtle::Atomic32 count_;
+  base::PlatformThreadId thread_;
+};
+
+// Runs a batch of its own from inside a task, as the particle and skinning
+// updates may when they are started from another task.
+class NestingTask : public WorkQueue::Task {
+ public:
+  NestingTask(WorkQueue* queue, size_t numInner)
+      : queue_(queue), inner_(numInner) {}
+
+  virtual void run(void) {
+    std::vector<WorkQueue::Task*> tasks;
+    for (size_t i = 0; i < inner_.size(); ++i)
+      tasks.push_back(&inner_[i]);
+    queue_->runAndWait(&tasks[0], tasks.size());
+  }
+
+  bool allRanOnce() const {
+    for (size_t i = 0; i < inner_.size(); ++i) {
+      if (inner_[i].count() != 1)
+        return false;
+    }
+    return true;
+  }
+
+ private:
+  WorkQueue* queue_;
+  std::vector<CountingTask> inner_;
+};
+
+class SignallingTask : public WorkQueue::Task {
+ public:
+  SignallingTask() : done_(true, false) {}
+
+  virtual void run(void) {
+    done_.Signal();
+  }
+
+  base::WaitableEvent& done() { return done_; }
+
+ private:
+  base::WaitableEvent done_;
+};
+
+void RunAndWaitOnce(WorkQueue& queue, std::vector<CountingTask>& tasks) {
+  std::vector<WorkQueue::Task*> ptrs;
+  for (size_t i = 0; i < tasks.size(); ++i)
+    ptrs.push_back(&tasks[i]);
+  queue.runAndWait(&ptrs[0], ptrs.size());
+}
+
+TEST(WorkQueueTest, RunAndWaitRunsEveryTaskOnce) {
+  WorkQueue queue(3);
+  EXPECT_EQ(3u, queue.getNumWorkers());
+
+  std::vector<CountingTask> tasks(64);
+  RunAndWaitOnce(queue, tasks);
+  for (size_t i = 0; i < tasks.size(); ++i)
+    EXPECT_EQ(1, tasks[i].count()) << "task " << i;
+
+  // The queue is reusable once a batch is done
+  RunAndWaitOnce(queue, tasks);
+  for (size_t i = 0; i < tasks.size(); ++i)
+    EXPECT_EQ(2, tasks[i].count()) << "task " << i;
+}
+
+TEST(WorkQueueTest, RunAndWaitWithoutWorkersRunsInline) {
+  WorkQueue queue(0);
+  EXPECT_EQ(0u, queue.getNumWorkers());
+
+  std::vector<CountingTask> tasks(8);
+  RunAndWaitOnce(queue, tasks);
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    EXPECT_EQ(1, tasks[i].count());
+    EXPECT_EQ(base::PlatformThread::CurrentId(), tasks[i].thread());
+  }
+}
+
+TEST(WorkQueueTest, SingleTaskRunsOnCaller) {
+  WorkQueue queue(2);
+
+  std::vector<CountingTask> tasks(1);
+  RunAndWaitOnce(queue, tasks);
+  EXPECT_EQ(1, tasks[0].count());
+  EXPECT_EQ(base::PlatformThread::CurrentId(), tasks[0].thread());
+}
+
+TEST(WorkQueueTest, NestedRunAndWait) {
+  // More outer tasks than threads, so every worker ends up waiting on a
+  // nested batch and has to help run it
+  const size_t kWorkerCounts[] = { 0, 1, 3 };
+  for (size_t w = 0; w < arraysize(kWorkerCounts); ++w) {
+    WorkQueue queue(static_cast<int>(kWorkerCounts[w]));
+
+    std::vector<NestingTask*> outer;
+    std::vector<WorkQueue::Task*> ptrs;
+    for (size_t i = 0; i < 16; ++i) {
+      outer.push_back(new NestingTask(&queue, 8));
+      ptrs.push_back(outer.back());
+    }
+    queue.runAndWait(&ptrs[0], ptrs.size());
+
+    for (size_t i = 0; i < outer.size(); ++i) {
+      EXPECT_TRUE(outer[i]->allRanOnce())
+          << kWorkerCounts[w] << " workers, task " << i;
+      delete outer[i];
+    }
+  }
+}
+
+TEST(WorkQueueTest, BackgroundTaskRuns) {
+  // Outlives the queue, in case the wait below times out
+  SignallingTask background;
+  WorkQueue queue(1);
+
+  queue.addBackgroundTask(&background);
+  // Per-frame batches still complete while it is queued or running
+  std::vector<CountingTask> tasks(8);
+  RunAndWaitOnce(queue, tasks);
+  for (size_t i = 0; i < tasks.size(); ++i)
+    EXPECT_EQ(1, tasks[i].count());
+
+  EXPECT_TRUE(background.done().TimedWait(base::TimeDelta::FromSeconds(10)));
+}
+
+TEST(WorkQueueTest, BackgroundTaskWithoutWorkersRunsInline) {
+  WorkQueue queue(0);
+
+  SignallingTask background;
+  queue.addBackgroundTask(&background);
+  EXPECT_TRUE(background.done().IsSignaled());
+}
+
+}  // namespace
+}  // namespace renderer